@@ -9,6 +9,11 @@
 #include <time.h>
 #include <cinttypes>
 
+#if AP_LOGGERFILEREADER_MMAP_ENABLED
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 #ifndef PRIu64
 #define PRIu64 "llu"
 #endif
@@ -19,10 +24,21 @@ AP_LoggerFileReader::AP_LoggerFileReader()
 AP_LoggerFileReader::~AP_LoggerFileReader()
 {
     ::printf("Replay counts: %" PRIu64 " bytes  %u entries\n", bytes_read, message_count);
+#if AP_LOGGERFILEREADER_MMAP_ENABLED
+    if (map_base != nullptr) {
+        munmap(map_base, map_len);
+    }
+    free(time_index);
+#endif
 }
 
 bool AP_LoggerFileReader::open_log(const char *logfile)
 {
+#if AP_LOGGERFILEREADER_MMAP_ENABLED
+    if (open_mmap(logfile)) {
+        return true;
+    }
+#endif
     fd = AP::FS().open(logfile, O_RDONLY);
     if (fd == -1) {
         return false;
@@ -52,6 +68,75 @@ void AP_LoggerFileReader::get_packet_counts(uint64_t dest[])
 }
 
 bool AP_LoggerFileReader::update()
+{
+#if AP_LOGGERFILEREADER_MMAP_ENABLED
+    if (map_base != nullptr) {
+        return update_mmap();
+    }
+#endif
+    return update_read();
+}
+
+bool AP_LoggerFileReader::set_time_window(uint64_t start_us, uint64_t end_us)
+{
+#if AP_LOGGERFILEREADER_MMAP_ENABLED
+    if (map_base == nullptr || start_us > end_us) {
+        return false;
+    }
+    window_start_ofs = find_offset(start_us);
+    window_end_ofs = end_us == UINT64_MAX ? SIZE_MAX : find_offset(end_us + 1);
+    fast_forward = map_ofs < window_start_ofs;
+    ::printf("Replay window: bytes %lu to %lu of %lu\n",
+             (unsigned long)window_start_ofs,
+             (unsigned long)MIN(window_end_ofs, index_end),
+             (unsigned long)index_end);
+    return true;
+#else
+    return false;
+#endif
+}
+
+int16_t AP_LoggerFileReader::find_type(const char *name) const
+{
+#if AP_LOGGERFILEREADER_MMAP_ENABLED
+    for (uint16_t type = 0; type < ARRAY_SIZE(index_name); type++) {
+        if (index_length[type] != 0 &&
+            strncmp(index_name[type], name, sizeof(index_name[type])) == 0) {
+            return type;
+        }
+    }
+#endif
+    return -1;
+}
+
+/*
+  only the messages between the first and last of the type are walked
+ */
+const uint8_t *AP_LoggerFileReader::find_message(uint8_t type, const uint8_t *prev) const
+{
+#if AP_LOGGERFILEREADER_MMAP_ENABLED
+    const struct type_index_entry &ti = type_index[type];
+    if (ti.count == 0) {
+        return nullptr;
+    }
+    size_t ofs = prev != nullptr ? (prev - map_base) + index_length[type] : window_start_ofs;
+    ofs = MAX(ofs, ti.first_ofs);
+    const size_t end = MIN(window_end_ofs, ti.last_ofs + 1);
+    while (ofs < end) {
+        const uint8_t *msg = &map_base[ofs];
+        if (msg[2] == type) {
+            return msg;
+        }
+        ofs += index_length[msg[2]];
+    }
+#endif
+    return nullptr;
+}
+
+/*
+  read one message at a time from the filesystem
+ */
+bool AP_LoggerFileReader::update_read()
 {
     uint8_t hdr[3];
     if (read_input(hdr, 3) != 3) {
@@ -100,3 +185,181 @@ bool AP_LoggerFileReader::update()
     message_count++;
     return handle_msg(f, msg);
 }
+
+#if AP_LOGGERFILEREADER_MMAP_ENABLED
+/*
+  map the whole log. The mapping is private and writable so handlers
+  may modify a message in place without touching the file
+ */
+bool AP_LoggerFileReader::open_mmap(const char *logfile)
+{
+    const int mfd = ::open(logfile, O_RDONLY|O_CLOEXEC);
+    if (mfd == -1) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(mfd, &st) != 0 || st.st_size <= 0) {
+        ::close(mfd);
+        return false;
+    }
+    void *p = mmap(nullptr, st.st_size, PROT_READ|PROT_WRITE, MAP_PRIVATE, mfd, 0);
+    ::close(mfd);
+    if (p == MAP_FAILED) {
+        return false;
+    }
+    madvise(p, st.st_size, MADV_SEQUENTIAL);
+    map_base = (uint8_t *)p;
+    map_len = st.st_size;
+    map_ofs = 0;
+
+    build_index();
+    return true;
+}
+
+bool AP_LoggerFileReader::message_time_us(const uint8_t *msg, uint64_t &time_us) const
+{
+    if (!index_has_time_us[msg[2]]) {
+        return false;
+    }
+    memcpy(&time_us, &msg[3], sizeof(time_us));
+    return true;
+}
+
+/*
+  walk the mapped log once, parsing FMT records as they appear, to
+  find the extent of the readable log and to build the time and
+  per-type indexes
+ */
+void AP_LoggerFileReader::build_index()
+{
+    uint64_t next_index_us = 0;
+    size_t ofs = 0;
+    while (ofs + 3 <= map_len) {
+        const uint8_t *msg = &map_base[ofs];
+        if (msg[0] != HEAD_BYTE1 || msg[1] != HEAD_BYTE2) {
+            break;
+        }
+        const uint8_t type = msg[2];
+        if (type == LOG_FORMAT_MSG) {
+            if (ofs + sizeof(struct log_Format) > map_len) {
+                break;
+            }
+            const struct log_Format &f = *(const struct log_Format *)msg;
+            index_length[f.type] = f.length;
+            memcpy(index_name[f.type], f.name, sizeof(index_name[f.type]));
+            index_has_time_us[f.type] =
+                f.format[0] == 'Q' && f.length >= 3 + sizeof(uint64_t) &&
+                strncmp(f.labels, "TimeUS", 6) == 0 &&
+                (f.labels[6] == ',' || f.labels[6] == 0);
+        }
+        const uint8_t length = index_length[type];
+        if (length == 0 || ofs + length > map_len) {
+            // update() reports unknown formats when it gets here
+            break;
+        }
+
+        struct type_index_entry &ti = type_index[type];
+        if (ti.count == 0) {
+            ti.first_ofs = ofs;
+        }
+        ti.last_ofs = ofs;
+        ti.count++;
+
+        uint64_t time_us;
+        if (message_time_us(msg, time_us) && time_us >= next_index_us) {
+            if (time_index_count == time_index_space) {
+                const uint32_t new_space = MAX(time_index_space * 2, 1024U);
+                void *n = realloc(time_index, new_space * sizeof(time_index[0]));
+                if (n == nullptr) {
+                    AP_HAL::panic("Out of memory for log index");
+                }
+                time_index = (struct time_index_entry *)n;
+                time_index_space = new_space;
+            }
+            time_index[time_index_count++] = { time_us, ofs };
+            next_index_us = (time_us / LOGREADER_TIME_INDEX_INTERVAL_US + 1) * LOGREADER_TIME_INDEX_INTERVAL_US;
+        }
+        ofs += length;
+    }
+    index_end = ofs;
+
+    ::printf("Indexed %lu bytes, %u time entries\n", (unsigned long)index_end, unsigned(time_index_count));
+}
+
+/*
+  find the offset of the first message with a TimeUS at or after
+  time_us. Only messages after the preceding index entry need to be
+  scanned
+ */
+size_t AP_LoggerFileReader::find_offset(uint64_t time_us) const
+{
+    if (time_index_count == 0 || time_us <= time_index[0].time_us) {
+        return 0;
+    }
+    // bisect for the last entry before time_us
+    uint32_t lo = 0, hi = time_index_count;
+    while (hi - lo > 1) {
+        const uint32_t mid = (lo + hi) / 2;
+        if (time_index[mid].time_us < time_us) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    size_t ofs = time_index[lo].ofs;
+    while (ofs < index_end) {
+        const uint8_t *msg = &map_base[ofs];
+        uint64_t t;
+        if (message_time_us(msg, t) && t >= time_us) {
+            break;
+        }
+        ofs += index_length[msg[2]];
+    }
+    return ofs;
+}
+
+/*
+  hand the next message to the handlers straight from the mapping
+ */
+bool AP_LoggerFileReader::update_mmap()
+{
+    if (map_ofs >= window_end_ofs) {
+        return false;
+    }
+    if (map_ofs + 3 > map_len) {
+        return false;
+    }
+    uint8_t *msg = &map_base[map_ofs];
+    if (msg[0] != HEAD_BYTE1 || msg[1] != HEAD_BYTE2) {
+        printf("bad log header\n");
+        return false;
+    }
+    fast_forward = map_ofs < window_start_ofs;
+    packet_counts[msg[2]]++;
+
+    if (msg[2] == LOG_FORMAT_MSG) {
+        if (map_ofs + sizeof(struct log_Format) > map_len) {
+            return false;
+        }
+        const struct log_Format &f = *(const struct log_Format *)msg;
+        memcpy(&formats[f.type], &f, sizeof(formats[f.type]));
+        map_ofs += sizeof(f);
+        bytes_read += sizeof(f);
+        message_count++;
+        return handle_log_format_msg(f);
+    }
+
+    const struct log_Format &f = formats[msg[2]];
+    if (f.length == 0) {
+        ::printf("No format defined for type (%d)\n", msg[2]);
+        exit(1);
+    }
+    if (map_ofs + f.length > map_len) {
+        return false;
+    }
+    map_ofs += f.length;
+    bytes_read += f.length;
+    message_count++;
+    return handle_msg(f, msg);
+}
+#endif // AP_LOGGERFILEREADER_MMAP_ENABLED
@@ -4,6 +4,18 @@
 
 #define LOGREADER_MAX_FORMATS 255 // must be >= highest MESSAGE
 
+/*
+  on hosts with mmap() the whole log is mapped and indexed by time and
+  by message type up front, and messages are handed to the handlers
+  straight from the mapping
+ */
+#ifndef AP_LOGGERFILEREADER_MMAP_ENABLED
+#define AP_LOGGERFILEREADER_MMAP_ENABLED (CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX)
+#endif
+
+// spacing of time index entries, in log microseconds
+#define LOGREADER_TIME_INDEX_INTERVAL_US 100000U
+
 class AP_LoggerFileReader
 {
 public:
@@ -20,6 +32,36 @@ public:
     void format_type(uint16_t type, char dest[5]);
     void get_packet_counts(uint64_t dest[]);
 
+    /*
+      restrict replay to messages between start_us and end_us of log
+      time. Messages before the window are still passed to the
+      handlers, with fast_forwarding() true, so that state carried in
+      the log is up to date when the window opens. Replay stops at
+      the end of the window. Needs the mmap reader
+     */
+    bool set_time_window(uint64_t start_us, uint64_t end_us);
+    bool fast_forwarding() const { return fast_forward; }
+
+    // type of the messages called name, or -1 if the log has no FMT
+    // for it. Needs the mmap reader
+    int16_t find_type(const char *name) const;
+
+    /*
+      return the first message of type in the replay window, or the
+      next one after prev, or nullptr if there are no more before the
+      end of the window. Needs the mmap reader
+     */
+    const uint8_t *find_message(uint8_t type, const uint8_t *prev=nullptr) const;
+
+    // true if the log is memory mapped rather than read from a file
+    bool is_mapped() const {
+#if AP_LOGGERFILEREADER_MMAP_ENABLED
+        return map_base != nullptr;
+#else
+        return false;
+#endif
+    }
+
 protected:
     int fd = -1;
 
@@ -33,4 +75,50 @@ private:
     uint64_t start_micros;
 
     uint64_t packet_counts[LOGREADER_MAX_FORMATS] = {};
+
+    bool update_read();
+
+#if AP_LOGGERFILEREADER_MMAP_ENABLED
+    bool open_mmap(const char *logfile);
+    bool update_mmap();
+    void build_index();
+
+    // find offset of the first message at or after time_us
+    size_t find_offset(uint64_t time_us) const;
+
+    // return the TimeUS field of a message if its format has one
+    bool message_time_us(const uint8_t *msg, uint64_t &time_us) const;
+
+    uint8_t *map_base = nullptr;
+    size_t map_len;
+    size_t map_ofs;
+    // end of the last complete message found by the index
+    size_t index_end;
+
+    // message lengths and which types start with TimeUS, as seen by
+    // the index; formats[] is only filled in as FMT is replayed
+    uint8_t index_length[256] {};
+    bool index_has_time_us[256] {};
+    char index_name[256][4] {};
+
+    // where the messages of each type are, so a type can be found
+    // without walking the rest of the log
+    struct type_index_entry {
+        uint32_t count;
+        size_t first_ofs;
+        size_t last_ofs;
+    } type_index[256] {};
+
+    struct time_index_entry {
+        uint64_t time_us;
+        size_t ofs;
+    };
+    struct time_index_entry *time_index = nullptr;
+    uint32_t time_index_count = 0;
+    uint32_t time_index_space = 0;
+#endif
+
+    bool fast_forward = false;
+    size_t window_start_ofs = 0;
+    size_t window_end_ofs = SIZE_MAX;
 };
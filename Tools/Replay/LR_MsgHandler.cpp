@@ -5,6 +5,7 @@
 #include <AP_DAL/AP_DAL.h>
 
 #include <cinttypes>
+#include <time.h>
 
 extern const AP_HAL::HAL& hal;
 
@@ -38,7 +39,32 @@ void LR_MsgHandler_RFRF::process_message(uint8_t *msgbytes)
         MAP_FLAG(AP_DAL::FrameType::LogWriteEKF2, AP_DAL::FrameType::LogWriteEKF3);
     }
 #undef MAP_FLAG
+    if (replay_fast_forward) {
+        // before the replay window the DAL keeps its state but the
+        // filters do not run; they initialise on the first frame
+        // inside the window
+        msg.frame_types = 0;
+    }
+    const uint8_t update_frames = uint8_t(AP_DAL::FrameType::UpdateFilterEKF2) | uint8_t(AP_DAL::FrameType::UpdateFilterEKF3);
+    if (!replay_ekf_timing.enabled || (msg.frame_types & update_frames) == 0) {
+        AP::dal().handle_message(msg, ekf2, ekf3);
+        if ((msg.frame_types & update_frames) != 0 && replay_batch.in_child()) {
+            replay_batch.update(ekf2, ekf3);
+        }
+        return;
+    }
+    // time on the host clock, independent of log time
+    struct timespec ts0, ts1;
+    clock_gettime(CLOCK_MONOTONIC, &ts0);
     AP::dal().handle_message(msg, ekf2, ekf3);
+    clock_gettime(CLOCK_MONOTONIC, &ts1);
+    const uint64_t dt_ns = (ts1.tv_sec - ts0.tv_sec) * 1000000000ULL + ts1.tv_nsec - ts0.tv_nsec;
+    replay_ekf_timing.frames++;
+    replay_ekf_timing.total_ns += dt_ns;
+    replay_ekf_timing.max_ns = MAX(replay_ekf_timing.max_ns, dt_ns);
+    if (replay_batch.in_child()) {
+        replay_batch.update(ekf2, ekf3);
+    }
 }
 
 void LR_MsgHandler_RFRN::process_message(uint8_t *msgbytes)
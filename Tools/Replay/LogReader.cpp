@@ -62,6 +62,7 @@ bool LogReader::handle_log_format_msg(const struct log_Format &f)
     // map from format name to a parser subclass:
 	if (streq(name, "PARM")) {
         msgparser[f.type] = new LR_MsgHandler_PARM(formats[f.type]);
+        parm_type = f.type;
     } else if (streq(name, "RFRH")) {
         msgparser[f.type] = new LR_MsgHandler_RFRH(formats[f.type]);
     } else if (streq(name, "RFRF")) {
@@ -132,8 +133,12 @@ bool LogReader::handle_log_format_msg(const struct log_Format &f)
 }
 
 bool LogReader::handle_msg(const struct log_Format &f, uint8_t *msg) {
-    // emit the output as we receive it:
-    AP::logger().WriteBlock(msg, f.length);
+    // emit the output as we receive it, other than while
+    // fast-forwarding to the start of a replay window:
+    replay_fast_forward = fast_forwarding();
+    if (!replay_fast_forward || f.type == parm_type) {
+        AP::logger().WriteBlock(msg, f.length);
+    }
 
     LR_MsgHandler *p = msgparser[f.type];
     if (p == NULL) {
@@ -31,6 +31,9 @@ private:
     uint8_t _log_structure_count;
 
     class LR_MsgHandler *msgparser[LOGREADER_MAX_FORMATS] {};
+
+    // PARM is still written out while fast-forwarding
+    int16_t parm_type = -1;
 };
 
 // some vars are difficult to get through the layers
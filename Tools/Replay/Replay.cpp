@@ -39,6 +39,9 @@ static ReplayVehicle replayvehicle;
 user_parameter *user_parameters;
 bool replay_force_ekf2;
 bool replay_force_ekf3;
+bool replay_fast_forward;
+struct replay_timing replay_ekf_timing;
+ReplayBatch replay_batch;
 
 #define GSCALAR(v, name, def) { replayvehicle.g.v.vtype, name, Parameters::k_param_ ## v, &replayvehicle.g.v, {def_value : def} }
 #define GOBJECT(v, name, class) { AP_PARAM_GROUP, name, Parameters::k_param_ ## v, &replayvehicle.v, {group_info : class::var_info} }
@@ -136,11 +139,21 @@ void Replay::usage(void)
     ::printf("\t--param-file FILENAME  load parameters from a file\n");
     ::printf("\t--force-ekf2 force enable EKF2\n");
     ::printf("\t--force-ekf3 force enable EKF3\n");
+    ::printf("\t--start-time SECONDS  only run the EKFs from this log time\n");
+    ::printf("\t--end-time SECONDS  stop replay at this log time\n");
+    ::printf("\t--time-ekf  report time spent in EKF updates\n");
+    ::printf("\t--batch FILENAME  replay once per line of NAME=VALUE parameters and summarise\n");
+    ::printf("\t--jobs N  number of batch replays to run at once\n");
 }
 
 enum param_key : uint8_t {
     FORCE_EKF2 = 1,
     FORCE_EKF3,
+    START_TIME,
+    END_TIME,
+    TIME_EKF,
+    BATCH,
+    JOBS,
 };
 
 void Replay::_parse_command_line(uint8_t argc, char * const argv[])
@@ -152,6 +165,11 @@ void Replay::_parse_command_line(uint8_t argc, char * const argv[])
         {"param-file",      true,   0, 'F'},
         {"force-ekf2",      false,  0, param_key::FORCE_EKF2},
         {"force-ekf3",      false,  0, param_key::FORCE_EKF3},
+        {"start-time",      true,   0, param_key::START_TIME},
+        {"end-time",        true,   0, param_key::END_TIME},
+        {"time-ekf",        false,  0, param_key::TIME_EKF},
+        {"batch",           true,   0, param_key::BATCH},
+        {"jobs",            true,   0, param_key::JOBS},
         {"help",            false,  0, 'h'},
         {0, false, 0, 0}
     };
@@ -187,6 +205,28 @@ void Replay::_parse_command_line(uint8_t argc, char * const argv[])
             replay_force_ekf3 = true;
             break;
 
+        case param_key::START_TIME:
+            start_time_us = atof(gopt.optarg) * 1.0e6;
+            break;
+
+        case param_key::END_TIME:
+            end_time_us = atof(gopt.optarg) * 1.0e6;
+            break;
+
+        case param_key::TIME_EKF:
+            replay_ekf_timing.enabled = true;
+            break;
+
+        case param_key::BATCH:
+            if (!replay_batch.load(gopt.optarg)) {
+                exit(1);
+            }
+            break;
+
+        case param_key::JOBS:
+            replay_batch.set_jobs(constrain_int32(atoi(gopt.optarg), 1, UINT8_MAX));
+            break;
+
         case 'h':
         default:
             usage();
@@ -215,17 +255,6 @@ void Replay::setup()
         _parse_command_line(argc, argv);
     }
 
-    _vehicle.setup();
-
-    set_user_parameters();
-
-    if (replay_force_ekf2) {
-        reader.set_parameter("EK2_ENABLE", 1, true);
-    }
-    if (replay_force_ekf3) {
-        reader.set_parameter("EK3_ENABLE", 1, true);
-    }
-
     if (replay_force_ekf2 && replay_force_ekf3) {
         ::printf("Cannot force both EKF types\n");
         exit(1);
@@ -245,11 +274,74 @@ void Replay::setup()
         ::printf("open(%s): %m\n", filename);
         exit(1);
     }
+    if (start_time_us != 0 || end_time_us != UINT64_MAX) {
+        if (!reader.set_time_window(start_time_us, end_time_us)) {
+            ::printf("Cannot replay a time window of this log\n");
+            exit(1);
+        }
+        // the filters only run on frames inside the window
+        const int16_t rfrh_type = reader.find_type("RFRH");
+        if (rfrh_type == -1 || reader.find_message(rfrh_type) == nullptr) {
+            ::printf("No replay frames in the time window\n");
+            exit(1);
+        }
+    }
+    if (replay_batch.count() > 0) {
+        // the children share the log mapping; a file offset can't be shared
+        if (!reader.is_mapped()) {
+            ::printf("Batch replay needs a memory mapped log\n");
+            exit(1);
+        }
+        /*
+          fork before the vehicle is set up so each child starts its
+          own logger, threads and file descriptors rather than
+          inheriting the parent's
+         */
+        if (!replay_batch.run()) {
+            exit(0);
+        }
+        // in a child, in its own directory with this configuration's
+        // parameters added to the user parameters
+    }
+
+    _vehicle.setup();
+
+    set_user_parameters();
+
+    if (replay_force_ekf2) {
+        reader.set_parameter("EK2_ENABLE", 1, true);
+    }
+    if (replay_force_ekf3) {
+        reader.set_parameter("EK3_ENABLE", 1, true);
+    }
+}
+
+/*
+  print EKF update timing. Covariance prediction dominates the cost of
+  an update so this is a good way to compare changes to it, and to
+  compare float and double precision builds
+ */
+void Replay::report_ekf_timing(void) const
+{
+    const struct replay_timing &t = replay_ekf_timing;
+    if (!t.enabled || t.frames == 0) {
+        return;
+    }
+    ::printf("EKF update (%s): %u frames, %.3f s total, %.2f us mean, %.2f us max\n",
+             sizeof(ftype) == sizeof(double) ? "double" : "float",
+             (unsigned)t.frames,
+             t.total_ns * 1.0e-9,
+             t.total_ns * 1.0e-3 / t.frames,
+             t.max_ns * 1.0e-3);
 }
 
 void Replay::loop()
 {
     if (!reader.update()) {
+        report_ekf_timing();
+        if (replay_batch.in_child()) {
+            replay_batch.finish();
+        }
 #if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
     // If we don't tear down the threads then they continue to access
     // global state during object destruction.
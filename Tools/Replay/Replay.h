@@ -16,6 +16,7 @@
 #include <AP_Vehicle/AP_Vehicle.h>
 
 #include "LogReader.h"
+#include "ReplayBatch.h"
 
 struct user_parameter {
     struct user_parameter *next;
@@ -26,6 +27,18 @@ struct user_parameter {
 extern user_parameter *user_parameters;
 extern bool replay_force_ekf2;
 extern bool replay_force_ekf3;
+extern bool replay_fast_forward;
+
+// wall clock time spent in EKF update frames, from --time-ekf
+struct replay_timing {
+    bool enabled;
+    uint32_t frames;
+    uint64_t total_ns;
+    uint64_t max_ns;
+};
+extern struct replay_timing replay_ekf_timing;
+
+extern ReplayBatch replay_batch;
 
 class ReplayVehicle : public AP_Vehicle {
 public:
@@ -84,6 +97,10 @@ private:
     const char *filename;
     ReplayVehicle &_vehicle;
 
+    // replay window in log time, from --start-time and --end-time
+    uint64_t start_time_us;
+    uint64_t end_time_us = UINT64_MAX;
+
     LogReader reader{_vehicle.log_structure, _vehicle.ekf2, _vehicle.ekf3};
 
     void _parse_command_line(uint8_t argc, char * const argv[]);
@@ -92,4 +109,5 @@ private:
     bool parse_param_line(char *line, char **vname, float &value);
     void load_param_file(const char *filename);
     void usage();
+    void report_ekf_timing(void) const;
 };
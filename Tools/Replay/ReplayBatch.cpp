@@ -0,0 +1,273 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ReplayBatch.h"
+#include "Replay.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+// directory each configuration is replayed in, relative to the start directory
+#define REPLAY_BATCH_DIRECTORY "batch"
+
+/*
+  load configurations, one per non-blank line. Lines starting with #
+  are comments
+ */
+bool ReplayBatch::load(const char *filename)
+{
+    FILE *f = fopen(filename, "r");
+    if (f == nullptr) {
+        ::printf("Failed to open batch file: %s\n", filename);
+        return false;
+    }
+    char line[512];
+    while (fgets(line, sizeof(line), f)) {
+        if (line[0] == '#') {
+            continue;
+        }
+        struct user_parameter *params = nullptr;
+        struct user_parameter **tail = &params;
+        char *saveptr = nullptr;
+        for (char *tok = strtok_r(line, ", \t\r\n", &saveptr);
+             tok != nullptr;
+             tok = strtok_r(nullptr, ", \t\r\n", &saveptr)) {
+            const char *eq = strchr(tok, '=');
+            if (eq == nullptr || eq == tok || size_t(eq - tok) > AP_MAX_NAME_SIZE) {
+                ::printf("Bad batch parameter: %s\n", tok);
+                fclose(f);
+                return false;
+            }
+            struct user_parameter *u = new user_parameter;
+            memset(u->name, 0, sizeof(u->name));
+            strncpy(u->name, tok, eq-tok);
+            u->value = atof(eq+1);
+            u->next = nullptr;
+            *tail = u;
+            tail = &u->next;
+        }
+        if (params == nullptr) {
+            continue;
+        }
+        struct config *c = (struct config *)realloc(configs, (num_configs+1) * sizeof(struct config));
+        if (c == nullptr) {
+            fclose(f);
+            return false;
+        }
+        configs = c;
+        memset(&configs[num_configs], 0, sizeof(struct config));
+        configs[num_configs++].params = params;
+    }
+    fclose(f);
+    if (num_configs == 0) {
+        ::printf("No configurations in batch file: %s\n", filename);
+        return false;
+    }
+    return true;
+}
+
+bool ReplayBatch::run(void)
+{
+    if (jobs == 0) {
+        jobs = constrain_int32(sysconf(_SC_NPROCESSORS_ONLN), 1, UINT8_MAX);
+    }
+    if (mkdir(REPLAY_BATCH_DIRECTORY, 0755) != 0 && errno != EEXIST) {
+        ::printf("mkdir(%s): %m\n", REPLAY_BATCH_DIRECTORY);
+        return false;
+    }
+
+    struct job {
+        pid_t pid;
+        int fd;
+        uint16_t idx;
+    } *running = new job[jobs];
+    uint8_t num_running = 0;
+    uint16_t next = 0;
+
+    ::printf("Replaying %u configurations, %u at a time\n", (unsigned)num_configs, (unsigned)jobs);
+
+    while (next < num_configs || num_running > 0) {
+        if (next < num_configs && num_running < jobs) {
+            const uint16_t idx = next++;
+            int fds[2];
+            if (pipe(fds) != 0) {
+                ::printf("pipe: %m\n");
+                continue;
+            }
+            // don't let the children repeat our buffered output
+            fflush(stdout);
+            const pid_t pid = fork();
+            if (pid == -1) {
+                ::printf("fork: %m\n");
+                close(fds[0]);
+                close(fds[1]);
+                continue;
+            }
+            if (pid == 0) {
+                close(fds[0]);
+                for (uint8_t i=0; i<num_running; i++) {
+                    close(running[i].fd);
+                }
+                delete[] running;
+                child_config = idx;
+                child_fd = fds[1];
+                if (!start_child()) {
+                    _exit(1);
+                }
+                return true;
+            }
+            close(fds[1]);
+            running[num_running++] = { pid, fds[0], idx };
+            continue;
+        }
+
+        int status;
+        const pid_t pid = waitpid(-1, &status, 0);
+        if (pid == -1) {
+            break;
+        }
+        for (uint8_t i=0; i<num_running; i++) {
+            if (running[i].pid != pid) {
+                continue;
+            }
+            struct config &c = configs[running[i].idx];
+            // a child that finished cleanly has already written its
+            // stats, which fit in the pipe buffer
+            c.ok = WIFEXITED(status) && WEXITSTATUS(status) == 0 &&
+                read(running[i].fd, &c.stats, sizeof(c.stats)) == sizeof(c.stats);
+            close(running[i].fd);
+            running[i] = running[--num_running];
+            break;
+        }
+    }
+    delete[] running;
+
+    print_summary();
+    return false;
+}
+
+/*
+  set up a child to replay its configuration. Each child runs in its
+  own directory so output logs and messages are kept apart
+ */
+bool ReplayBatch::start_child(void)
+{
+    char dir[32];
+    snprintf(dir, sizeof(dir), REPLAY_BATCH_DIRECTORY "/%u", (unsigned)child_config);
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST) {
+        return false;
+    }
+    if (chdir(dir) != 0) {
+        return false;
+    }
+    if (freopen("replay.txt", "w", stdout) == nullptr) {
+        return false;
+    }
+
+    // batch parameters take priority over the log, like --parm
+    struct user_parameter *u = configs[child_config].params;
+    while (u->next != nullptr) {
+        u = u->next;
+    }
+    u->next = user_parameters;
+    user_parameters = configs[child_config].params;
+    return true;
+}
+
+void ReplayBatch::update(const NavEKF2 &ekf2, const NavEKF3 &ekf3)
+{
+    float ratio[RATIO_COUNT];
+    Vector3f mag;
+    Vector2f offset;
+    bool ok;
+    bool healthy;
+    if (ekf3.activeCores() > 0) {
+        ok = ekf3.getVariances(ratio[RATIO_VEL], ratio[RATIO_POS], ratio[RATIO_HGT], mag, ratio[RATIO_TAS], offset);
+        healthy = ekf3.healthy();
+    } else {
+        ok = ekf2.activeCores() > 0 &&
+            ekf2.getVariances(ratio[RATIO_VEL], ratio[RATIO_POS], ratio[RATIO_HGT], mag, ratio[RATIO_TAS], offset);
+        healthy = ekf2.healthy();
+    }
+    if (!ok) {
+        return;
+    }
+    ratio[RATIO_MAG] = MAX(MAX(mag.x, mag.y), mag.z);
+
+    struct stats &s = configs[child_config].stats;
+    s.frames++;
+    if (!healthy) {
+        s.unhealthy++;
+    }
+    for (uint8_t i=0; i<RATIO_COUNT; i++) {
+        s.sum[i] += ratio[i];
+        s.max[i] = MAX(s.max[i], ratio[i]);
+        if (ratio[i] > 1) {
+            s.rejected[i]++;
+        }
+    }
+}
+
+void ReplayBatch::finish(void)
+{
+    fflush(stdout);
+    const struct stats &s = configs[child_config].stats;
+    if (write(child_fd, &s, sizeof(s)) != sizeof(s)) {
+        _exit(1);
+    }
+    _exit(0);
+}
+
+void ReplayBatch::print_summary(void) const
+{
+    static const char *names[RATIO_COUNT] { "vel", "pos", "hgt", "mag", "tas" };
+
+    ::printf("\nTest ratios of the primary core as mean/max (samples rejected)\n");
+    ::printf("%4s %8s %8s", "cfg", "frames", "unhlthy");
+    for (uint8_t i=0; i<RATIO_COUNT; i++) {
+        ::printf(" %20s", names[i]);
+    }
+    ::printf("  parameters\n");
+
+    for (uint16_t n=0; n<num_configs; n++) {
+        const struct config &c = configs[n];
+        const struct stats &s = c.stats;
+        if (!c.ok) {
+            ::printf("%4u %8s %8s", (unsigned)n, "failed", "-");
+            for (uint8_t i=0; i<RATIO_COUNT; i++) {
+                ::printf(" %20s", "-");
+            }
+        } else {
+            ::printf("%4u %8u %8u", (unsigned)n, (unsigned)s.frames, (unsigned)s.unhealthy);
+            for (uint8_t i=0; i<RATIO_COUNT; i++) {
+                char cell[32];
+                snprintf(cell, sizeof(cell), "%.2f/%.2f (%u)",
+                         s.frames ? s.sum[i] / s.frames : 0.0f,
+                         s.max[i],
+                         (unsigned)s.rejected[i]);
+                ::printf(" %20s", cell);
+            }
+        }
+        ::printf(" ");
+        for (const struct user_parameter *u = c.params; u; u = u->next) {
+            ::printf(" %s=%g", u->name, u->value);
+        }
+        ::printf("\n");
+    }
+}
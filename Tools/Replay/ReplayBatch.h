@@ -0,0 +1,99 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  batch replay of one log with many parameter sets
+
+  The EKFs, DAL and parameters are all singletons, so each
+  configuration is replayed in its own process. The log is mapped and
+  indexed once before forking, so every process shares the same
+  pages. Forking happens before the vehicle is set up, so each process
+  sets up its own logger and threads in its own directory. Each
+  process sends a summary of the primary core's innovation test
+  ratios back to the parent, which prints a table once all
+  configurations are done
+ */
+#pragma once
+
+#include <sys/types.h>
+
+#include <AP_NavEKF2/AP_NavEKF2.h>
+#include <AP_NavEKF3/AP_NavEKF3.h>
+
+struct user_parameter;
+
+class ReplayBatch {
+public:
+    /*
+      load configurations from a file. Each line is one configuration
+      given as NAME=VALUE pairs separated by spaces or commas
+     */
+    bool load(const char *filename);
+
+    // number of configurations replayed at once
+    void set_jobs(uint8_t n) { jobs = n; }
+
+    uint16_t count(void) const { return num_configs; }
+
+    /*
+      replay every configuration. In the parent this returns false
+      after printing the summary. In each child it returns true with
+      the configuration's parameters added to the user parameters,
+      and replay should carry on by setting up the vehicle
+     */
+    bool run(void);
+
+    // true in a child replaying one configuration
+    bool in_child(void) const { return child_config >= 0; }
+
+    // accumulate test ratios after an EKF update frame; child only
+    void update(const NavEKF2 &ekf2, const NavEKF3 &ekf3);
+
+    // send the summary to the parent and exit; child only
+    void finish(void);
+
+private:
+    enum {
+        RATIO_VEL,
+        RATIO_POS,
+        RATIO_HGT,
+        RATIO_MAG,
+        RATIO_TAS,
+        RATIO_COUNT
+    };
+
+    struct stats {
+        uint32_t frames;                // update frames with a running filter
+        uint32_t unhealthy;             // of which the filter was unhealthy
+        float sum[RATIO_COUNT];
+        float max[RATIO_COUNT];
+        uint32_t rejected[RATIO_COUNT]; // samples with a test ratio above 1
+    };
+
+    struct config {
+        struct user_parameter *params;
+        struct stats stats;
+        bool ok;
+    };
+
+    struct config *configs = nullptr;
+    uint16_t num_configs;
+    uint8_t jobs;
+
+    int16_t child_config = -1;
+    int child_fd = -1;
+
+    bool start_child(void);
+    void print_summary(void) const;
+};
@@ -7752,7 +7752,12 @@ class AutoTestCopter(AutoTest):
             self.start_subtest("%s" % name)
             self.test_replay_bit(func)
 
-    def test_replay_bit(self, bit):
+        # updating the EKF3 cores on worker threads must give exactly
+        # the same output as updating them in turn
+        self.start_subtest("GPS with EK3_THREADS")
+        self.test_replay_bit(self.test_replay_gps_bit, replay_args=['--parm', 'EK3_THREADS=2'])
+
+    def test_replay_bit(self, bit, replay_args=[]):
 
         self.context_push()
         current_log_filepath = bit()
@@ -7760,7 +7765,7 @@ class AutoTestCopter(AutoTest):
         self.progress("Running replay on (%s)" % current_log_filepath)
 
         util.run_cmd(
-            ['build/sitl/tool/Replay', current_log_filepath],
+            ['build/sitl/tool/Replay'] + replay_args + [current_log_filepath],
             directory=util.topdir(),
             checkfail=True,
             show=True,
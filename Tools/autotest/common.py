@@ -11861,6 +11861,10 @@ switch value'''
                  "Test Onboard Logging",
                  self.test_onboard_logging),
 
+            Test("BatchSamplerStreaming",
+                 "Test compressed IMU streaming",
+                 self.BatchSamplerStreaming),
+
             Test("GetCapabilities",
                  "Get Capabilities",
                  self.test_get_autopilot_capabilities),
@@ -12008,6 +12012,104 @@ switch value'''
 
         return psd
 
+    def isbc_decode(self, m):
+        '''return the list of (x, y, z) samples in an ISBC message, each
+        multiplied by m.mul'''
+        data = struct.pack("<32h", *m.D0) + struct.pack("<32h", *m.D1) + struct.pack("<32h", *m.D2)
+        data = bytearray(data[:m.len])
+        last = [0, 0, 0]
+        samples = []
+        pos = 0
+        for i in range(m.cnt):
+            for axis in range(3):
+                # little-endian base-128 varint of the zigzag encoded change
+                zigzag = 0
+                shift = 0
+                while True:
+                    if pos >= len(data):
+                        raise NotAchievedException("ISBC(%u) ran out of data after %u samples" % (m.N, i))
+                    b = data[pos]
+                    pos += 1
+                    zigzag |= (b & 0x7f) << shift
+                    shift += 7
+                    if b < 0x80:
+                        break
+                delta = (zigzag >> 1) ^ -(zigzag & 1)
+                # the changes are taken modulo 2^16
+                last[axis] = ((last[axis] + delta + 0x8000) & 0xffff) - 0x8000
+            samples.append(tuple(last))
+        if pos != len(data):
+            raise NotAchievedException("ISBC(%u) has %u bytes left over after %u samples" %
+                                       (m.N, len(data) - pos, m.cnt))
+        return samples
+
+    def BatchSamplerStreaming(self):
+        '''check the compressed continuous IMU stream decodes'''
+        self.set_parameters({
+            "INS_LOG_BAT_MASK": 1,
+            "INS_LOG_BAT_OPT": 4,
+        })
+        self.reboot_sitl()
+        self.wait_ready_to_arm()
+        self.delay_sim_time(10)
+
+        # per (instance, type): last seqno, first SampleUS and the
+        # number of samples and expected duration since then
+        streams = {}
+        accel_z = []
+        count = 0
+        dfreader = self.dfreader_for_current_onboard_log()
+        while True:
+            m = dfreader.recv_match(type="ISBC")
+            if m is None:
+                break
+            count += 1
+            if m.I != 0:
+                raise NotAchievedException("ISBC for instance %u not in INS_LOG_BAT_MASK" % m.I)
+            if m.cnt == 0 or m.smp_rate <= 0:
+                raise NotAchievedException("Bad ISBC(%u): cnt=%u smp_rate=%f" % (m.N, m.cnt, m.smp_rate))
+            samples = self.isbc_decode(m)
+            if len(samples) != m.cnt:
+                raise NotAchievedException("ISBC(%u) decoded %u samples, expected %u" %
+                                           (m.N, len(samples), m.cnt))
+            if m.type == 0:
+                accel_z.extend([s[2] / float(m.mul) for s in samples])
+            key = (m.I, m.type)
+            if key not in streams:
+                streams[key] = {
+                    "seqno": m.N,
+                    "start_us": m.SampleUS,
+                    "samples": m.cnt,
+                    "expected_us": m.cnt * 1.0e6 / m.smp_rate,
+                }
+                continue
+            stream = streams[key]
+            if m.N != (stream["seqno"] + 1) & 0xffff:
+                raise NotAchievedException("ISBC I=%u type=%u seqno jumped from %u to %u" %
+                                           (m.I, m.type, stream["seqno"], m.N))
+            stream["seqno"] = m.N
+            # each message starts where the samples of the last one ended
+            elapsed_us = m.SampleUS - stream["start_us"]
+            if abs(elapsed_us - stream["expected_us"]) > 0.05 * stream["expected_us"] + 5000:
+                raise NotAchievedException(
+                    "ISBC I=%u type=%u: %u samples took %uus, expected %uus at the logged rate" %
+                    (m.I, m.type, stream["samples"], elapsed_us, stream["expected_us"]))
+            stream["samples"] += m.cnt
+            stream["expected_us"] += m.cnt * 1.0e6 / m.smp_rate
+
+        self.progress("Decoded %u ISBC messages" % count)
+        if (0, 0) not in streams or (0, 1) not in streams:
+            raise NotAchievedException("Missing ISBC streams (got %s)" % str(streams.keys()))
+        for (key, stream) in streams.items():
+            self.progress("I=%u type=%u: %u samples" % (key[0], key[1], stream["samples"]))
+            if stream["samples"] < 1000:
+                raise NotAchievedException("Too few samples in ISBC stream I=%u type=%u" % key)
+
+        # the vehicle is sitting level, so the samples decode to gravity
+        mean_z = sum(accel_z) / len(accel_z)
+        if abs(abs(mean_z) - 9.81) > 1:
+            raise NotAchievedException("Decoded accel z %f is not gravity" % mean_z)
+
     def model_defaults_filepath(self, model):
         vehicle = self.vehicleinfo_key()
         vinfo = vehicleinfo.VehicleInfo()
@@ -547,7 +547,7 @@ bool AP_OABendyRuler::calc_margin_from_inclusion_and_exclusion_polygons(const Lo
         const Vector2f* boundary = fence->polyfence().get_inclusion_polygon(i, num_points);
      
         // if outside the fence margin is the closest distance but with negative sign
-        const float sign = Polygon_outside(start_NE, boundary, num_points) ? -1.0f : 1.0f;
+        const float sign = fence->polyfence().inclusion_polygon_outside(i, start_NE) ? -1.0f : 1.0f;
 
         // calculate min distance (in meters) from line to polygon
         float margin_new = (sign * Polygon_closest_distance_line(boundary, num_points, start_NE, end_NE) * 0.01f) - fence_margin;
@@ -563,7 +563,7 @@ bool AP_OABendyRuler::calc_margin_from_inclusion_and_exclusion_polygons(const Lo
         const Vector2f* boundary = fence->polyfence().get_exclusion_polygon(i, num_points);
    
         // if start is inside the polygon the margin's sign is reversed
-        const float sign = Polygon_outside(start_NE, boundary, num_points) ? 1.0f : -1.0f;
+        const float sign = fence->polyfence().exclusion_polygon_outside(i, start_NE) ? 1.0f : -1.0f;
 
         // calculate min distance (in meters) from line to polygon
         float margin_new = (sign * Polygon_closest_distance_line(boundary, num_points, start_NE, end_NE) * 0.01f) - fence_margin;
@@ -653,6 +653,7 @@ bool AP_OABendyRuler::calc_margin_from_inclusion_and_exclusion_circles(const Loc
 }
 
 // calculate minimum distance between a path and proximity sensor obstacles
+// obstacles further than _margin_max from the path are ignored
 // on success returns true and updates margin
 bool AP_OABendyRuler::calc_margin_from_object_database(const Location &start, const Location &end, float &margin) const
 {
@@ -671,9 +672,11 @@ bool AP_OABendyRuler::calc_margin_from_object_database(const Location &start, co
         return false;
     }
 
-    // check each obstacle's distance from segment
+    // check distance from segment of each obstacle near enough to give a margin below _margin_max
     float smallest_margin = FLT_MAX;
-    for (uint16_t i=0; i<oaDb->database_count(); i++) {
+    AP_OADatabase::NearbyItems nearby(*oaDb, start_NEU.xy() * 0.01f, end_NEU.xy() * 0.01f, _margin_max);
+    uint16_t i;
+    while (nearby.next(i)) {
         const AP_OADatabase::OA_DbItem& item = oaDb->get_item(i);
         const Vector3f point_cm = item.pos * 100.0f;
         // margin is distance between line segment and obstacle minus obstacle's radius
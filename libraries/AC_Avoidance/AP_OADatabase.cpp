@@ -35,6 +35,13 @@ extern const AP_HAL::HAL& hal;
     #define AP_OADATABASE_DISTANCE_FROM_HOME 3
 #endif
 
+#ifndef AP_OADATABASE_GRID_CELL_SIZE
+    #define AP_OADATABASE_GRID_CELL_SIZE 2.0f   // size in meters of the grid cells objects are hashed by
+#endif
+
+#define AP_OADATABASE_ITEM_NONE     UINT16_MAX  // end of a chain of objects
+#define AP_OADATABASE_QUEUE_BATCH   16          // number of objects taken from the queue at a time
+
 const AP_Param::GroupInfo AP_OADatabase::var_info[] = {
 
     // @Param: SIZE
@@ -127,6 +134,10 @@ void AP_OADatabase::init()
         gcs().send_text(MAV_SEVERITY_INFO, "DB init failed . Sizes queue:%u, db:%u", (unsigned int)_queue.size, (unsigned int)_database.size);
         delete _queue.items;
         delete[] _database.items;
+        delete[] _database.cell_head;
+        delete[] _database.cell_next;
+        delete[] _database.age_prev;
+        delete[] _database.age_next;
         return;
     }
 }
@@ -195,6 +206,27 @@ void AP_OADatabase::init_database()
         return;
     }
 
+    // hash table has a power of two number of buckets, at least half the number of objects
+    uint16_t num_buckets = 1;
+    while (num_buckets < _database.size / 2U) {
+        num_buckets <<= 1;
+    }
+    _database.cell_mask = num_buckets - 1;
+    _database.cell_head = new uint16_t[num_buckets];
+    _database.cell_next = new uint16_t[_database.size];
+    _database.age_prev = new uint16_t[_database.size];
+    _database.age_next = new uint16_t[_database.size];
+    if (_database.cell_head == nullptr || _database.cell_next == nullptr ||
+        _database.age_prev == nullptr || _database.age_next == nullptr) {
+        // report database as unhealthy
+        return;
+    }
+    for (uint16_t i=0; i<num_buckets; i++) {
+        _database.cell_head[i] = AP_OADATABASE_ITEM_NONE;
+    }
+    _database.age_oldest = AP_OADATABASE_ITEM_NONE;
+    _database.age_newest = AP_OADATABASE_ITEM_NONE;
+
     _database.items = new OA_DbItem[_database.size];
 }
 
@@ -241,32 +273,40 @@ bool AP_OADatabase::process_queue()
         return false;
     }
 
-    for (uint16_t queue_index=0; queue_index<queue_available; queue_index++) {
-        OA_DbItem item;
-
-        bool pop_success;
+    // take items from the queue in batches to limit how often the semaphore is taken
+    uint16_t queue_index = 0;
+    while (queue_index < queue_available) {
+        OA_DbItem batch[AP_OADATABASE_QUEUE_BATCH];
+        uint32_t batch_count;
         {
             WITH_SEMAPHORE(_queue.sem);
-            pop_success = _queue.items->pop(item);
+            batch_count = _queue.items->peek(batch, MIN(queue_available - queue_index, ARRAY_SIZE(batch)));
+            _queue.items->advance(batch_count);
         }
-        if (!pop_success) {
+        if (batch_count == 0) {
             return false;
         }
-
-        item.send_to_gcs = get_send_to_gcs_flags(item.importance);
-
-        // compare item to all items in database. If found a similar item, update the existing, else add it as a new one
-        bool found = false;
-        for (uint16_t i=0; i<_database.count; i++) {
-            if (is_close_to_item_in_database(i, item)) {
-                database_item_refresh(i, item.timestamp_ms, item.radius);
-                found = true;
-                break;
+        queue_index += batch_count;
+
+        for (uint8_t b=0; b<batch_count; b++) {
+            OA_DbItem &item = batch[b];
+            item.send_to_gcs = get_send_to_gcs_flags(item.importance);
+
+            // compare item to nearby items in database. If found a similar item, update the existing, else add it as a new one
+            bool found = false;
+            NearbyItems nearby(*this, item.pos.xy(), item.pos.xy(), item.radius);
+            uint16_t i;
+            while (nearby.next(i)) {
+                if (is_close_to_item_in_database(i, item)) {
+                    database_item_refresh(i, item.timestamp_ms, item.radius);
+                    found = true;
+                    break;
+                }
             }
-        }
 
-        if (!found) {
-            database_item_add(item);
+            if (!found) {
+                database_item_add(item);
+            }
         }
     }
     return (_queue.items->available() > 0);
@@ -277,9 +317,13 @@ void AP_OADatabase::database_item_add(const OA_DbItem &item)
     if (_database.count >= _database.size) {
         return;
     }
-    _database.items[_database.count] = item;
-    _database.items[_database.count].send_to_gcs = get_send_to_gcs_flags(_database.items[_database.count].importance);
+    const uint16_t index = _database.count;
+    _database.items[index] = item;
+    _database.items[index].send_to_gcs = get_send_to_gcs_flags(_database.items[index].importance);
     _database.count++;
+    _database.radius_max = MAX(_database.radius_max, item.radius);
+    cell_link(index);
+    age_link(index);
 }
 
 void AP_OADatabase::database_item_remove(const uint16_t index)
@@ -289,19 +333,42 @@ void AP_OADatabase::database_item_remove(const uint16_t index)
         return;
     }
 
+    cell_unlink(index);
+    age_unlink(index);
+
     // radius of 0 tells the GCS we don't care about it any more (aka it expired)
     _database.items[index].radius = 0;
     _database.items[index].send_to_gcs = get_send_to_gcs_flags(_database.items[index].importance);
 
     _database.count--;
     if (_database.count == 0) {
+        _database.radius_max = 0;
         return;
     }
 
     if (index != _database.count) {
         // copy last object in array over expired object
-        _database.items[index] = _database.items[_database.count];
+        const uint16_t last = _database.count;
+        cell_unlink(last);
+        _database.items[index] = _database.items[last];
         _database.items[index].send_to_gcs = get_send_to_gcs_flags(_database.items[index].importance);
+        cell_link(index);
+
+        // moved object keeps its place in the age list
+        const uint16_t prev = _database.age_prev[last];
+        const uint16_t next = _database.age_next[last];
+        _database.age_prev[index] = prev;
+        _database.age_next[index] = next;
+        if (prev != AP_OADATABASE_ITEM_NONE) {
+            _database.age_next[prev] = index;
+        } else {
+            _database.age_oldest = index;
+        }
+        if (next != AP_OADATABASE_ITEM_NONE) {
+            _database.age_prev[next] = index;
+        } else {
+            _database.age_newest = index;
+        }
     }
 }
 
@@ -322,12 +389,17 @@ void AP_OADatabase::database_item_refresh(const uint16_t index, const uint32_t t
         _database.items[index].timestamp_ms = timestamp_ms;
         _database.items[index].radius = radius;
         _database.items[index].send_to_gcs = get_send_to_gcs_flags(_database.items[index].importance);
+        _database.radius_max = MAX(_database.radius_max, radius);
+
+        // object is now the most recently updated
+        age_unlink(index);
+        age_link(index);
     }
 }
 
 void AP_OADatabase::database_items_remove_all_expired()
 {
-    // calculate age of all items in the _database
+    // remove items from the oldest end of the age list until one has not expired
 
     if (_database_expiry_seconds <= 0) {
         // zero means never expire. This is not normal behavior but perhaps you could send a static
@@ -337,12 +409,146 @@ void AP_OADatabase::database_items_remove_all_expired()
 
     const uint32_t now_ms = AP_HAL::millis();
     const uint32_t expiry_ms = (uint32_t)_database_expiry_seconds * 1000;
-    uint16_t index = 0;
-    while (index < _database.count) {
-        if (now_ms - _database.items[index].timestamp_ms > expiry_ms) {
-            database_item_remove(index);
+    while (_database.age_oldest != AP_OADATABASE_ITEM_NONE) {
+        const uint16_t index = _database.age_oldest;
+        if (now_ms - _database.items[index].timestamp_ms <= expiry_ms) {
+            break;
+        }
+        database_item_remove(index);
+    }
+}
+
+// get grid cell holding a position
+void AP_OADatabase::get_cell(const Vector3f &pos, int32_t &cell_x, int32_t &cell_y)
+{
+    cell_x = (int32_t)floorf(pos.x * (1.0f / AP_OADATABASE_GRID_CELL_SIZE));
+    cell_y = (int32_t)floorf(pos.y * (1.0f / AP_OADATABASE_GRID_CELL_SIZE));
+}
+
+// get hash table bucket of a grid cell
+uint16_t AP_OADatabase::cell_bucket(int32_t cell_x, int32_t cell_y) const
+{
+    return (((uint32_t)cell_x * 73856093U) ^ ((uint32_t)cell_y * 19349663U)) & _database.cell_mask;
+}
+
+// add object to the front of its cell's bucket
+void AP_OADatabase::cell_link(uint16_t index)
+{
+    int32_t cell_x, cell_y;
+    get_cell(_database.items[index].pos, cell_x, cell_y);
+    const uint16_t bucket = cell_bucket(cell_x, cell_y);
+    _database.cell_next[index] = _database.cell_head[bucket];
+    _database.cell_head[bucket] = index;
+}
+
+// remove object from its cell's bucket
+void AP_OADatabase::cell_unlink(uint16_t index)
+{
+    int32_t cell_x, cell_y;
+    get_cell(_database.items[index].pos, cell_x, cell_y);
+    uint16_t *link = &_database.cell_head[cell_bucket(cell_x, cell_y)];
+    while (*link != AP_OADATABASE_ITEM_NONE) {
+        if (*link == index) {
+            *link = _database.cell_next[index];
+            return;
+        }
+        link = &_database.cell_next[*link];
+    }
+}
+
+// add object to the newest end of the age list
+void AP_OADatabase::age_link(uint16_t index)
+{
+    _database.age_prev[index] = _database.age_newest;
+    _database.age_next[index] = AP_OADATABASE_ITEM_NONE;
+    if (_database.age_newest != AP_OADATABASE_ITEM_NONE) {
+        _database.age_next[_database.age_newest] = index;
+    } else {
+        _database.age_oldest = index;
+    }
+    _database.age_newest = index;
+}
+
+// remove object from the age list
+void AP_OADatabase::age_unlink(uint16_t index)
+{
+    const uint16_t prev = _database.age_prev[index];
+    const uint16_t next = _database.age_next[index];
+    if (prev != AP_OADATABASE_ITEM_NONE) {
+        _database.age_next[prev] = next;
+    } else {
+        _database.age_oldest = next;
+    }
+    if (next != AP_OADATABASE_ITEM_NONE) {
+        _database.age_prev[next] = prev;
+    } else {
+        _database.age_newest = prev;
+    }
+}
+
+AP_OADatabase::NearbyItems::NearbyItems(const AP_OADatabase &db, const Vector2f &start, const Vector2f &end, float margin) :
+    _db(db),
+    _start(start),
+    _end(end),
+    _margin(margin)
+{
+    // items may be in any cell within the margin plus the largest item radius of the segment
+    const float expand = MAX(margin, 0.0f) + db._database.radius_max;
+    int32_t cell_y_min;
+    get_cell(Vector3f{MIN(start.x, end.x) - expand, MIN(start.y, end.y) - expand, 0.0f}, _cell_x_min, cell_y_min);
+    get_cell(Vector3f{MAX(start.x, end.x) + expand, MAX(start.y, end.y) + expand, 0.0f}, _cell_x_max, _cell_y_max);
+
+    // search every item if there are more cells than items
+    const float num_cells = (float)(_cell_x_max - _cell_x_min + 1) * (float)(_cell_y_max - cell_y_min + 1);
+    _scan_all = (num_cells > db._database.count);
+    if (_scan_all) {
+        _item = 0;
+        return;
+    }
+
+    _cell_x = _cell_x_min;
+    _cell_y = cell_y_min;
+    _item = db._database.cell_head[db.cell_bucket(_cell_x, _cell_y)];
+}
+
+bool AP_OADatabase::NearbyItems::next(uint16_t &index)
+{
+    while (true) {
+        uint16_t candidate;
+        if (_scan_all) {
+            if (_item >= _db._database.count) {
+                return false;
+            }
+            candidate = _item++;
         } else {
-            index++;
+            // move on to the next cell at the end of each chain
+            while (_item == AP_OADATABASE_ITEM_NONE) {
+                if (_cell_x < _cell_x_max) {
+                    _cell_x++;
+                } else if (_cell_y < _cell_y_max) {
+                    _cell_x = _cell_x_min;
+                    _cell_y++;
+                } else {
+                    return false;
+                }
+                _item = _db._database.cell_head[_db.cell_bucket(_cell_x, _cell_y)];
+            }
+            candidate = _item;
+            _item = _db._database.cell_next[candidate];
+
+            // skip items from other cells which share the bucket
+            int32_t cell_x, cell_y;
+            get_cell(_db._database.items[candidate].pos, cell_x, cell_y);
+            if (cell_x != _cell_x || cell_y != _cell_y) {
+                continue;
+            }
+        }
+
+        const OA_DbItem &item = _db._database.items[candidate];
+        const float dist = Vector2f::closest_distance_between_line_and_point(_start, _end, item.pos.xy());
+        if (dist - item.radius <= _margin) {
+            index = candidate;
+            return true;
         }
     }
 }
@@ -50,6 +50,32 @@ public:
     // send ADSB_VEHICLE mavlink messages
     void send_adsb_vehicle(mavlink_channel_t chan, uint16_t interval_ms);
 
+    /*
+      iterate over the items which come within margin (in meters) of
+      the horizontal segment from start to end, allowing for each
+      item's radius. start and end are offsets in meters from the EKF
+      origin, and may be the same point. Only the grid cells around
+      the segment are searched. The database must not be changed
+      while iterating
+     */
+    class NearbyItems {
+    public:
+        NearbyItems(const AP_OADatabase &db, const Vector2f &start, const Vector2f &end, float margin);
+
+        // get the index of the next item, returns false when there are no more
+        bool next(uint16_t &index);
+
+    private:
+        const AP_OADatabase &_db;
+        const Vector2f _start;
+        const Vector2f _end;
+        const float _margin;
+        bool _scan_all;             // true if scanning every item is quicker than searching the cells
+        int32_t _cell_x_min, _cell_x_max, _cell_y_max;
+        int32_t _cell_x, _cell_y;   // cell being searched
+        uint16_t _item;             // next item in cell's chain or, if scanning every item, next index
+    };
+
     static const struct AP_Param::GroupInfo var_info[];
 
 private:
@@ -64,6 +90,18 @@ private:
     void database_item_remove(const uint16_t index);
     void database_items_remove_all_expired();
 
+    // grid cell holding a position and the hash table bucket of a cell
+    static void get_cell(const Vector3f &pos, int32_t &cell_x, int32_t &cell_y);
+    uint16_t cell_bucket(int32_t cell_x, int32_t cell_y) const;
+
+    // add or remove an item from its cell's chain
+    void cell_link(uint16_t index);
+    void cell_unlink(uint16_t index);
+
+    // add an item to the newest end of the age list or remove it from the list
+    void age_link(uint16_t index);
+    void age_unlink(uint16_t index);
+
     // get bitmask of gcs channels item should be sent to based on its importance
     // returns 0xFF (send to all channels) if should be sent or 0 if it should not be sent
     uint8_t get_send_to_gcs_flags(const OA_DbItemImportance importance);
@@ -100,6 +138,18 @@ private:
         OA_DbItem       *items;                             // array of objects in the database
         uint16_t        count;                              // number of objects in the items array
         uint16_t        size;                               // cached value of _database_size_param that sticks after initialized
+        float           radius_max;                         // largest radius of any object added since the database was last empty
+
+        // objects are hashed by the horizontal grid cell they are in
+        uint16_t        *cell_head;                         // first object in each hash table bucket
+        uint16_t        *cell_next;                         // next object in the same bucket for each object
+        uint16_t        cell_mask;                          // number of buckets less one
+
+        // objects are linked in order of last update so that expired objects can be found without a full scan
+        uint16_t        *age_prev;                          // next older object for each object
+        uint16_t        *age_next;                          // next newer object for each object
+        uint16_t        age_oldest;                         // least recently updated object
+        uint16_t        age_newest;                         // most recently updated object
     } _database;
 
     uint16_t _next_index_to_send[MAVLINK_COMM_NUM_BUFFERS]; // index of next object in _database to send to GCS
@@ -19,9 +19,10 @@
 #include <AC_Fence/AC_Fence.h>
 #include <AP_AHRS/AP_AHRS.h>
 #include <AP_Logger/AP_Logger.h>
+#include <AP_Math/crc.h>
 
 #define OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK  32      // expanding arrays for fence points and paths to destination will grow in increments of 20 elements
-#define OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX        255     // index use to indicate we do not have a tentative short path for a node
+#define OA_DIJKSTRA_FENCE_POINTS_MAX                    1000    // fence points must be fewer than this, larger fences have too many pairs of points to hold in a visgraph
 #define OA_DIJKSTRA_ERROR_REPORTING_INTERVAL_MS         5000    // failure messages sent to GCS every 5 seconds
 
 /// Constructor
@@ -30,7 +31,6 @@ AP_OADijkstra::AP_OADijkstra(AP_Int16 &options) :
         _inclusion_polygon_pts(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
         _exclusion_polygon_pts(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
         _exclusion_circle_pts(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
-        _short_path_data(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
         _path(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK)
 {
 }
@@ -317,10 +317,10 @@ bool AP_OADijkstra::create_inclusion_polygon_with_margin(float margin_cm, AP_OAD
 
             // find final point which is outside the inside polygon
             Vector2f temp_point = boundary[j] + intermediate_pt;
-            if (Polygon_outside(temp_point, boundary, num_points)) {
+            if (fence->polyfence().inclusion_polygon_outside(i, temp_point)) {
                 intermediate_pt *= -1.0;
                 temp_point = boundary[j] + intermediate_pt;
-                if (Polygon_outside(temp_point, boundary, num_points)) {
+                if (fence->polyfence().inclusion_polygon_outside(i, temp_point)) {
                     // could not find a point on either side that was outside the exclusion polygon so fail
                     // this may happen if the exclusion polygon has overlapping lines
                     err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OVERLAPPING_POLYGON_LINES;
@@ -418,10 +418,10 @@ bool AP_OADijkstra::create_exclusion_polygon_with_margin(float margin_cm, AP_OAD
 
             // find final point which is outside the original polygon
             Vector2f temp_point = boundary[j] + intermediate_pt;
-            if (!Polygon_outside(temp_point, boundary, num_points)) {
+            if (!fence->polyfence().exclusion_polygon_outside(i, temp_point)) {
                 intermediate_pt *= -1;
                 temp_point = boundary[j] + intermediate_pt;
-                if (!Polygon_outside(temp_point, boundary, num_points)) {
+                if (!fence->polyfence().exclusion_polygon_outside(i, temp_point)) {
                     // could not find a point on either side that was outside the exclusion polygon so fail
                     // this may happen if the exclusion polygon has overlapping lines
                     err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OVERLAPPING_POLYGON_LINES;
@@ -556,6 +556,17 @@ bool AP_OADijkstra::get_point(uint16_t index, Vector2f &point) const
 
 // returns true if line segment intersects polygon or circular fence
 bool AP_OADijkstra::intersects_fence(const Vector2f &seg_start, const Vector2f &seg_end) const
+{
+    for (uint8_t layer = 0; layer < FENCE_LAYER_COUNT; layer++) {
+        if (intersects_fence_layer(layer, seg_start, seg_end)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// returns true if line segment intersects any of the fences in a layer
+bool AP_OADijkstra::intersects_fence_layer(uint8_t layer, const Vector2f &seg_start, const Vector2f &seg_end) const
 {
     // return immediately if fence is not enabled
     const AC_Fence *fence = AC_Fence::get_singleton();
@@ -563,62 +574,116 @@ bool AP_OADijkstra::intersects_fence(const Vector2f &seg_start, const Vector2f &
         return false;
     }
 
-    // determine if segment crosses any of the inclusion polygons
-    uint16_t num_points = 0;
-    for (uint8_t i = 0; i < fence->polyfence().get_inclusion_polygon_count(); i++) {
-        const Vector2f* boundary = fence->polyfence().get_inclusion_polygon(i, num_points);
-        if (boundary != nullptr) {
+    switch (layer) {
+    case FENCE_LAYER_INCLUSION:
+        // determine if segment crosses any of the inclusion polygons
+        for (uint8_t i = 0; i < fence->polyfence().get_inclusion_polygon_count(); i++) {
             Vector2f intersection;
-            if (Polygon_intersects(boundary, num_points, seg_start, seg_end, intersection)) {
+            if (fence->polyfence().inclusion_polygon_intersects(i, seg_start, seg_end, intersection)) {
                 return true;
             }
         }
-    }
 
-    // determine if segment crosses any of the exclusion polygons
-    for (uint8_t i = 0; i < fence->polyfence().get_exclusion_polygon_count(); i++) {
-        const Vector2f* boundary = fence->polyfence().get_exclusion_polygon(i, num_points);
-        if (boundary != nullptr) {
+        // determine if segment crosses any of the inclusion circles
+        for (uint8_t i = 0; i < fence->polyfence().get_inclusion_circle_count(); i++) {
+            Vector2f center_pos_cm;
+            float radius;
+            if (fence->polyfence().get_inclusion_circle(i, center_pos_cm, radius)) {
+                // intersects circle if either start or end is further from the center than the radius
+                const float radius_cm_sq = sq(radius * 100.0f) ;
+                if ((seg_start - center_pos_cm).length_squared() > radius_cm_sq) {
+                    return true;
+                }
+                if ((seg_end - center_pos_cm).length_squared() > radius_cm_sq) {
+                    return true;
+                }
+            }
+        }
+        break;
+
+    case FENCE_LAYER_EXCLUSION_POLYGON:
+        // determine if segment crosses any of the exclusion polygons
+        for (uint8_t i = 0; i < fence->polyfence().get_exclusion_polygon_count(); i++) {
             Vector2f intersection;
-            if (Polygon_intersects(boundary, num_points, seg_start, seg_end, intersection)) {
+            if (fence->polyfence().exclusion_polygon_intersects(i, seg_start, seg_end, intersection)) {
                 return true;
             }
         }
+        break;
+
+    case FENCE_LAYER_EXCLUSION_CIRCLE:
+        // determine if segment crosses any of the exclusion circles
+        for (uint8_t i = 0; i < fence->polyfence().get_exclusion_circle_count(); i++) {
+            Vector2f center_pos_cm;
+            float radius;
+            if (fence->polyfence().get_exclusion_circle(i, center_pos_cm, radius)) {
+                // calculate distance between circle's center and segment
+                const float dist_cm = Vector2f::closest_distance_between_line_and_point(seg_start, seg_end, center_pos_cm);
+
+                // intersects if distance is less than radius
+                if (dist_cm <= (radius * 100.0f)) {
+                    return true;
+                }
+            }
+        }
+        break;
     }
 
-    // determine if segment crosses any of the inclusion circles
-    for (uint8_t i = 0; i < fence->polyfence().get_inclusion_circle_count(); i++) {
-        Vector2f center_pos_cm;
-        float radius;
-        if (fence->polyfence().get_inclusion_circle(i, center_pos_cm, radius)) {
-            // intersects circle if either start or end is further from the center than the radius
-            const float radius_cm_sq = sq(radius * 100.0f) ;
-            if ((seg_start - center_pos_cm).length_squared() > radius_cm_sq) {
-                return true;
+    // if we got this far then no intersection
+    return false;
+}
+
+// returns checksum of the fences in a layer
+// the fence reports a single load time for all fence types so this is used to find which layers have actually changed
+uint32_t AP_OADijkstra::fence_layer_crc(uint8_t layer) const
+{
+    const AC_Fence *fence = AC_Fence::get_singleton();
+    if (fence == nullptr) {
+        return 0;
+    }
+
+    uint32_t crc = 0;
+    uint16_t num_points = 0;
+    Vector2f center_pos_cm;
+    float radius;
+    switch (layer) {
+    case FENCE_LAYER_INCLUSION:
+        for (uint8_t i = 0; i < fence->polyfence().get_inclusion_polygon_count(); i++) {
+            const Vector2f* boundary = fence->polyfence().get_inclusion_polygon(i, num_points);
+            if (boundary != nullptr) {
+                crc = crc_crc32(crc, (const uint8_t *)&num_points, sizeof(num_points));
+                crc = crc_crc32(crc, (const uint8_t *)boundary, num_points * sizeof(Vector2f));
             }
-            if ((seg_end - center_pos_cm).length_squared() > radius_cm_sq) {
-                return true;
+        }
+        for (uint8_t i = 0; i < fence->polyfence().get_inclusion_circle_count(); i++) {
+            if (fence->polyfence().get_inclusion_circle(i, center_pos_cm, radius)) {
+                crc = crc_crc32(crc, (const uint8_t *)&center_pos_cm, sizeof(center_pos_cm));
+                crc = crc_crc32(crc, (const uint8_t *)&radius, sizeof(radius));
             }
         }
-    }
+        break;
 
-    // determine if segment crosses any of the exclusion circles
-    for (uint8_t i = 0; i < fence->polyfence().get_exclusion_circle_count(); i++) {
-        Vector2f center_pos_cm;
-        float radius;
-        if (fence->polyfence().get_exclusion_circle(i, center_pos_cm, radius)) {
-            // calculate distance between circle's center and segment
-            const float dist_cm = Vector2f::closest_distance_between_line_and_point(seg_start, seg_end, center_pos_cm);
+    case FENCE_LAYER_EXCLUSION_POLYGON:
+        for (uint8_t i = 0; i < fence->polyfence().get_exclusion_polygon_count(); i++) {
+            const Vector2f* boundary = fence->polyfence().get_exclusion_polygon(i, num_points);
+            if (boundary != nullptr) {
+                crc = crc_crc32(crc, (const uint8_t *)&num_points, sizeof(num_points));
+                crc = crc_crc32(crc, (const uint8_t *)boundary, num_points * sizeof(Vector2f));
+            }
+        }
+        break;
 
-            // intersects if distance is less than radius
-            if (dist_cm <= (radius * 100.0f)) {
-                return true;
+    case FENCE_LAYER_EXCLUSION_CIRCLE:
+        for (uint8_t i = 0; i < fence->polyfence().get_exclusion_circle_count(); i++) {
+            if (fence->polyfence().get_exclusion_circle(i, center_pos_cm, radius)) {
+                crc = crc_crc32(crc, (const uint8_t *)&center_pos_cm, sizeof(center_pos_cm));
+                crc = crc_crc32(crc, (const uint8_t *)&radius, sizeof(radius));
             }
         }
+        break;
     }
 
-    // if we got this far then no intersection
-    return false;
+    return crc;
 }
 
 // create visibility graph for all fence (with margin) points
@@ -634,36 +699,32 @@ bool AP_OADijkstra::create_fence_visgraph(AP_OADijkstra_Error &err_id)
     }
 
     // fail if more fence points than algorithm can handle
-    if (total_numpoints() >= OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX) {
+    if (total_numpoints() >= OA_DIJKSTRA_FENCE_POINTS_MAX) {
         err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_TOO_MANY_FENCE_POINTS;
         return false;
     }
 
-    // clear fence points visibility graph
-    _fence_visgraph.clear();
-
-    // calculate distance from each point to all other points
-    for (uint8_t i = 0; i < total_numpoints() - 1; i++) {
-        Vector2f start_seg;
-        if (get_point(i, start_seg)) {
-            for (uint8_t j = i + 1; j < total_numpoints(); j++) {
-                Vector2f end_seg;
-                if (get_point(j, end_seg)) {
-                    // if line segment does not intersect with any inclusion or exclusion zones add to visgraph
-                    if (!intersects_fence(start_seg, end_seg)) {
-                        if (!_fence_visgraph.add_item({AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT, i},
-                                                      {AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT, j},
-                                                      (start_seg - end_seg).length())) {
-                            // failure to add a point can only be caused by out-of-memory
-                            err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OUT_OF_MEMORY;
-                            return false;
-                        }
-                    }
-                }
-            }
+    // find which layers have changed since the visibility graph was last updated
+    uint32_t layer_crc[FENCE_LAYER_COUNT];
+    uint8_t changed_layers = 0;
+    for (uint8_t layer = 0; layer < FENCE_LAYER_COUNT; layer++) {
+        layer_crc[layer] = fence_layer_crc(layer);
+        if (layer_crc[layer] != _fence_layer_crc[layer]) {
+            changed_layers |= 1U << layer;
         }
     }
 
+    // calculate distance from each point to all other points, only retesting pairs which may be affected by the changed layers
+    const AP_ExpandingArray<Vector2f> *layer_pts[FENCE_LAYER_COUNT] = {&_inclusion_polygon_pts, &_exclusion_polygon_pts, &_exclusion_circle_pts};
+    const uint16_t layer_numpoints[FENCE_LAYER_COUNT] = {_inclusion_polygon_numpoints, _exclusion_polygon_numpoints, _exclusion_circle_numpoints};
+    if (!_fence_graph.update(layer_pts, layer_numpoints, FENCE_LAYER_COUNT, changed_layers,
+                             FUNCTOR_BIND_MEMBER(&AP_OADijkstra::intersects_fence_layer_cb, bool, uint8_t, const Vector2f&, const Vector2f&))) {
+        // failure to update the graph can only be caused by out-of-memory
+        err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OUT_OF_MEMORY;
+        return false;
+    }
+    memcpy(_fence_layer_crc, layer_crc, sizeof(_fence_layer_crc));
+
     return true;
 }
 
@@ -677,7 +738,7 @@ bool AP_OADijkstra::update_visgraph(AP_OAVisGraph& visgraph, const AP_OAVisGraph
     visgraph.clear();
 
     // calculate distance from position to all inclusion/exclusion fence points
-    for (uint8_t i = 0; i < total_numpoints(); i++) {
+    for (uint16_t i = 0; i < total_numpoints(); i++) {
         Vector2f seg_end;
         if (get_point(i, seg_end)) {
             if (!intersects_fence(position, seg_end)) {
@@ -701,123 +762,6 @@ bool AP_OADijkstra::update_visgraph(AP_OAVisGraph& visgraph, const AP_OAVisGraph
     return true;
 }
 
-// update total distance for all nodes visible from current node
-// curr_node_idx is an index into the _short_path_data array
-void AP_OADijkstra::update_visible_node_distances(node_index curr_node_idx)
-{
-    // sanity check
-    if (curr_node_idx >= _short_path_data_numpoints) {
-        return;
-    }
-
-    // get current node for convenience
-    const ShortPathNode &curr_node = _short_path_data[curr_node_idx];
-
-    // for each visibility graph
-    const AP_OAVisGraph* visgraphs[] = {&_fence_visgraph, &_destination_visgraph};
-    for (uint8_t v=0; v<ARRAY_SIZE(visgraphs); v++) {
-
-        // skip if empty
-        const AP_OAVisGraph &curr_visgraph = *visgraphs[v];
-        if (curr_visgraph.num_items() == 0) {
-            continue;
-        }
-
-        // search visibility graph for items visible from current_node
-        for (uint16_t i = 0; i < curr_visgraph.num_items(); i++) {
-            const AP_OAVisGraph::VisGraphItem &item = curr_visgraph[i];
-            // match if current node's id matches either of the id's in the graph (i.e. either end of the vector)
-            if ((curr_node.id == item.id1) || (curr_node.id == item.id2)) {
-                AP_OAVisGraph::OAItemID matching_id = (curr_node.id == item.id1) ? item.id2 : item.id1;
-                // find item's id in node array
-                node_index item_node_idx;
-                if (find_node_from_id(matching_id, item_node_idx)) {
-                    // if current node's distance + distance to item is less than item's current distance, update item's distance
-                    const float dist_to_item_via_current_node = _short_path_data[curr_node_idx].distance_cm + item.distance_cm;
-                    if (dist_to_item_via_current_node < _short_path_data[item_node_idx].distance_cm) {
-                        // update item's distance and set "distance_from_idx" to current node's index
-                        _short_path_data[item_node_idx].distance_cm = dist_to_item_via_current_node;
-                        _short_path_data[item_node_idx].distance_from_idx = curr_node_idx;
-                    }
-                }
-            }
-        }
-    }
-}
-
-// find a node's index into _short_path_data array from it's id (i.e. id type and id number)
-// returns true if successful and node_idx is updated
-bool AP_OADijkstra::find_node_from_id(const AP_OAVisGraph::OAItemID &id, node_index &node_idx) const
-{
-    switch (id.id_type) {
-    case AP_OAVisGraph::OATYPE_SOURCE:
-        // source node is always the first node
-        if (_short_path_data_numpoints > 0) {
-            node_idx = 0;
-            return true;
-        }
-        break;
-    case AP_OAVisGraph::OATYPE_DESTINATION:
-        // destination is always the 2nd node
-        if (_short_path_data_numpoints > 1) {
-            node_idx = 1;
-            return true;
-        }
-        break;
-    case AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT:
-        // intermediate nodes start from 3rd node
-        if (_short_path_data_numpoints > id.id_num + 2) {
-            node_idx = id.id_num + 2;
-            return true;
-        }
-        break;
-    }
-
-    // could not find node
-    return false;
-}
-
-// find index of node with lowest tentative distance (ignore visited nodes)
-// returns true if successful and node_idx argument is updated
-bool AP_OADijkstra::find_closest_node_idx(node_index &node_idx) const
-{
-    node_index lowest_idx = 0;
-    float lowest_dist = FLT_MAX;
-
-    // scan through all nodes looking for closest
-    for (node_index i=0; i<_short_path_data_numpoints; i++) {
-        const ShortPathNode &node = _short_path_data[i];
-        if (node.visited || is_equal(_short_path_data[i].distance_cm, FLT_MAX)) {
-            // if node is already visited OR cannot be reached yet, we can't use it
-            continue;
-        }
-        // figure out the pos of this node
-        Vector2f node_pos;
-        float dist_with_heuristics = FLT_MAX;
-        if (convert_node_to_point(node.id, node_pos)) {
-            // heuristics is is simple Euclidean distance from the node to the destination
-            // This should be admissible, therefore optimal path is guaranteed
-            const float heuristics = (node_pos-_path_destination).length();
-            dist_with_heuristics = node.distance_cm + heuristics;
-        } else {
-            // shouldn't happen
-            return false;
-        }
-        if (dist_with_heuristics < lowest_dist) {
-            // for NOW, this is the closest node
-            lowest_idx = i;
-            lowest_dist = dist_with_heuristics;
-        }
-    }
-
-    if (lowest_dist < FLT_MAX) {
-        // found the closest node
-        node_idx = lowest_idx;
-        return true;
-    }
-    return false;
-}
-
 // calculate shortest path from origin to destination
 // returns true on success.  returns false on failure and err_id is updated
 // requires these functions to have been run: create_inclusion_polygon_with_margin, create_exclusion_polygon_with_margin, create_exclusion_circle_with_margin, create_polygon_fence_visgraph
@@ -840,96 +784,24 @@ bool AP_OADijkstra::calc_shortest_path(const Location &origin, const Location &d
         return false;
     }
 
-    // expand _short_path_data if necessary
-    if (!_short_path_data.expand_to_hold(2 + total_numpoints())) {
+    // search for the shortest path through the fence points
+    switch (_fence_graph.find_path(_source_visgraph, _destination_visgraph, _path_source, _path_destination, _path, _path_numpoints)) {
+    case AP_OAFenceGraph::SearchResult::SUCCESS:
+        return true;
+    case AP_OAFenceGraph::SearchResult::OUT_OF_MEMORY:
         err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OUT_OF_MEMORY;
         return false;
+    case AP_OAFenceGraph::SearchResult::NO_PATH:
+        break;
     }
 
-    // add origin and destination (node_type, id, visited, distance_from_idx, distance_cm) to short_path_data array
-    _short_path_data[0] = {{AP_OAVisGraph::OATYPE_SOURCE, 0}, false, 0, 0};
-    _short_path_data[1] = {{AP_OAVisGraph::OATYPE_DESTINATION, 0}, false, OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX, FLT_MAX};
-    _short_path_data_numpoints = 2;
-
-    // add all inclusion and exclusion fence points to short_path_data array (node_type, id, visited, distance_from_idx, distance_cm)
-    for (uint8_t i=0; i<total_numpoints(); i++) {
-        _short_path_data[_short_path_data_numpoints++] = {{AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT, i}, false, OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX, FLT_MAX};
-    }
-
-    // start algorithm from source point
-    node_index current_node_idx = 0;
-
-    // update nodes visible from source point
-    for (uint16_t i = 0; i < _source_visgraph.num_items(); i++) {
-        node_index node_idx;
-        if (find_node_from_id(_source_visgraph[i].id2, node_idx)) {
-            _short_path_data[node_idx].distance_cm = _source_visgraph[i].distance_cm;
-            _short_path_data[node_idx].distance_from_idx = current_node_idx;
-        } else {
-            err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_COULD_NOT_FIND_PATH;
-            return false;
-        }
-    }
-    // mark source node as visited
-    _short_path_data[current_node_idx].visited = true;
-
-    // move current_node_idx to node with lowest distance
-    while (find_closest_node_idx(current_node_idx)) {
-        node_index dest_node;
-        // See if this next "closest" node is actually the destination
-        if (find_node_from_id({AP_OAVisGraph::OATYPE_DESTINATION,0}, dest_node) && current_node_idx == dest_node) {
-            // We have discovered destination.. Don't bother with the rest of the graph
-            break;
-        }
-        // update distances to all neighbours of current node
-        update_visible_node_distances(current_node_idx);
-
-        // mark current node as visited
-        _short_path_data[current_node_idx].visited = true;
-    }
-
-    // extract path starting from destination
-    bool success = false;
-    node_index nidx;
-    if (!find_node_from_id({AP_OAVisGraph::OATYPE_DESTINATION,0}, nidx)) {
-        err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_COULD_NOT_FIND_PATH;
-        return false;
-    }
-    _path_numpoints = 0;
-    while (true) {
-        if (!_path.expand_to_hold(_path_numpoints + 1)) {
-            err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OUT_OF_MEMORY;
-            return false;
-        }
-        // fail if newest node has invalid distance_from_index
-        if ((_short_path_data[nidx].distance_from_idx == OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX) ||
-            (_short_path_data[nidx].distance_cm >= FLT_MAX)) {
-            break;
-        } else {
-            // add node's id to path array
-            _path[_path_numpoints] = _short_path_data[nidx].id;
-            _path_numpoints++;
-
-            // we are done if node is the source
-            if (_short_path_data[nidx].id.id_type == AP_OAVisGraph::OATYPE_SOURCE) {
-                success = true;
-                break;
-            } else {
-                // follow node's "distance_from_idx" to previous node on path
-                nidx = _short_path_data[nidx].distance_from_idx;
-            }
-        }
-    }
     // report error incase path not found
-    if (!success) {
-        err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_COULD_NOT_FIND_PATH;
-    }
-
-    return success;
+    err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_COULD_NOT_FIND_PATH;
+    return false;
 }
 
 // return point from final path as an offset (in cm) from the ekf origin
-bool AP_OADijkstra::get_shortest_path_point(uint8_t point_num, Vector2f& pos)
+bool AP_OADijkstra::get_shortest_path_point(uint16_t point_num, Vector2f& pos)
 {
     if ((_path_numpoints == 0) || (point_num >= _path_numpoints)) {
         return false;
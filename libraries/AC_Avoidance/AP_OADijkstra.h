@@ -4,6 +4,7 @@
 #include <AP_Common/Location.h>
 #include <AP_Math/AP_Math.h>
 #include "AP_OAVisGraph.h"
+#include "AP_OAFenceGraph.h"
 
 /*
  * Dijkstra's algorithm for path planning around polygon fence
@@ -103,9 +104,26 @@ private:
     // also returns the type of point
     bool get_point(uint16_t index, Vector2f& point) const;
 
+    // fences are split into layers so the visibility graph can be updated when only some of them change
+    // fence points are numbered in layer order
+    enum FenceLayer : uint8_t {
+        FENCE_LAYER_INCLUSION = 0,      // inclusion polygons and circles
+        FENCE_LAYER_EXCLUSION_POLYGON,  // exclusion polygons
+        FENCE_LAYER_EXCLUSION_CIRCLE,   // exclusion circles
+        FENCE_LAYER_COUNT
+    };
+
     // returns true if line segment intersects polygon or circular fence
     bool intersects_fence(const Vector2f &seg_start, const Vector2f &seg_end) const;
 
+    // returns true if line segment intersects any of the fences in a layer
+    bool intersects_fence_layer(uint8_t layer, const Vector2f &seg_start, const Vector2f &seg_end) const;
+    // non-const version of the above for binding as a functor
+    bool intersects_fence_layer_cb(uint8_t layer, const Vector2f &seg_start, const Vector2f &seg_end) { return intersects_fence_layer(layer, seg_start, seg_end); }
+
+    // returns checksum of the fences in a layer (used to detect which layers have changed)
+    uint32_t fence_layer_crc(uint8_t layer) const;
+
     // create visibility graph for all fence (with margin) points
     // returns true on success.  returns false on failure and err_id is updated
     bool create_fence_visgraph(AP_OADijkstra_Error &err_id);
@@ -124,26 +142,27 @@ private:
     bool _shortest_path_ok;
 
     Location _destination_prev;     // destination of previous iterations (used to determine if path should be re-calculated)
-    uint8_t _path_idx_returned;     // index into _path array which gives location vehicle should be currently moving towards
+    uint16_t _path_idx_returned;    // index into _path array which gives location vehicle should be currently moving towards
 
     // inclusion polygon (with margin) related variables
     float _polyfence_margin = 10;           // margin around polygon defaults to 10m but is overriden with set_fence_margin
     AP_ExpandingArray<Vector2f> _inclusion_polygon_pts; // array of nodes corresponding to inclusion polygon points plus a margin
-    uint8_t _inclusion_polygon_numpoints;   // number of points held in above array
+    uint16_t _inclusion_polygon_numpoints;  // number of points held in above array
     uint32_t _inclusion_polygon_update_ms;  // system time of boundary update from AC_Fence (used to detect changes to polygon fence)
 
     // exclusion polygon related variables
     AP_ExpandingArray<Vector2f> _exclusion_polygon_pts; // array of nodes corresponding to exclusion polygon points plus a margin
-    uint8_t _exclusion_polygon_numpoints;   // number of points held in above array
+    uint16_t _exclusion_polygon_numpoints;  // number of points held in above array
     uint32_t _exclusion_polygon_update_ms;  // system time exclusion polygon was updated (used to detect changes)
 
     // exclusion circle related variables
     AP_ExpandingArray<Vector2f> _exclusion_circle_pts; // array of nodes surrounding exclusion circles plus a margin
-    uint8_t _exclusion_circle_numpoints;    // number of points held in above array
+    uint16_t _exclusion_circle_numpoints;   // number of points held in above array
     uint32_t _exclusion_circle_update_ms;   // system time exclusion circles were updated (used to detect changes)
 
     // visibility graphs
-    AP_OAVisGraph _fence_visgraph;          // holds distances between all inclusion/exclusion fence points (with margin)
+    AP_OAFenceGraph _fence_graph;           // holds distances between all inclusion/exclusion fence points (with margin)
+    uint32_t _fence_layer_crc[FENCE_LAYER_COUNT];   // checksum of each fence layer when _fence_graph was last updated
     AP_OAVisGraph _source_visgraph;         // holds distances from source point to all other nodes
     AP_OAVisGraph _destination_visgraph;    // holds distances from the destination to all other nodes
 
@@ -153,36 +172,14 @@ private:
     // returns true on success
     bool update_visgraph(AP_OAVisGraph& visgraph, const AP_OAVisGraph::OAItemID& oaid, const Vector2f &position, bool add_extra_position = false, Vector2f extra_position = Vector2f(0,0));
 
-    typedef uint8_t node_index;         // indices into short path data
-    struct ShortPathNode {
-        AP_OAVisGraph::OAItemID id;     // unique id for node (combination of type and id number)
-        bool visited;                   // true if all this node's neighbour's distances have been updated
-        node_index distance_from_idx;   // index into _short_path_data from where distance was updated (or 255 if not set)
-        float distance_cm;              // distance from source (number is tentative until this node is the current node and/or visited = true)
-    };
-    AP_ExpandingArray<ShortPathNode> _short_path_data;
-    node_index _short_path_data_numpoints;  // number of elements in _short_path_data array
-
-    // update total distance for all nodes visible from current node
-    // curr_node_idx is an index into the _short_path_data array
-    void update_visible_node_distances(node_index curr_node_idx);
-
-    // find a node's index into _short_path_data array from it's id (i.e. id type and id number)
-    // returns true if successful and node_idx is updated
-    bool find_node_from_id(const AP_OAVisGraph::OAItemID &id, node_index &node_idx) const;
-
-    // find index of node with lowest tentative distance (ignore visited nodes)
-    // returns true if successful and node_idx argument is updated
-    bool find_closest_node_idx(node_index &node_idx) const;
-
     // final path variables and functions
     AP_ExpandingArray<AP_OAVisGraph::OAItemID> _path;   // ids of points on return path in reverse order (i.e. destination is first element)
-    uint8_t _path_numpoints;                            // number of points on return path
+    uint16_t _path_numpoints;                           // number of points on return path
     Vector2f _path_source;                              // source point used in shortest path calculations (offset in cm from EKF origin)
     Vector2f _path_destination;                         // destination position used in shortest path calculations (offset in cm from EKF origin)
 
     // return point from final path as an offset (in cm) from the ekf origin
-    bool get_shortest_path_point(uint8_t point_num, Vector2f& pos);
+    bool get_shortest_path_point(uint16_t point_num, Vector2f& pos);
 
     // find the position of a node as an offset (in cm) from the ekf origin
     // returns true if successful and pos is updated
@@ -192,9 +189,9 @@ private:
     uint32_t _error_last_report_ms;                     // last time an error message was sent to GCS
 
     // Logging functions
-    void Write_OADijkstra(const uint8_t state, const uint8_t error_id, const uint8_t curr_point, const uint8_t tot_points, const Location &final_dest, const Location &oa_dest) const;
-    void Write_Visgraph_point(const uint8_t version, const uint8_t point_num, const int32_t Lat, const int32_t Lon) const;
-    uint8_t _log_num_points;
+    void Write_OADijkstra(const uint8_t state, const uint8_t error_id, const uint16_t curr_point, const uint16_t tot_points, const Location &final_dest, const Location &oa_dest) const;
+    void Write_Visgraph_point(const uint8_t version, const uint16_t point_num, const int32_t Lat, const int32_t Lon) const;
+    uint16_t _log_num_points;
     uint8_t _log_visgraph_version;
 
     // refernce to AP_OAPathPlanner options param
@@ -0,0 +1,462 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AP_OAFenceGraph.h"
+
+#define OA_FENCEGRAPH_SOURCE_NODE       0   // source is always the first node
+#define OA_FENCEGRAPH_DESTINATION_NODE  1   // destination is always the 2nd node
+#define OA_FENCEGRAPH_FIRST_POINT_NODE  2   // fence points start from the 3rd node
+
+AP_OAFenceGraph::AP_OAFenceGraph()
+{
+}
+
+AP_OAFenceGraph::~AP_OAFenceGraph()
+{
+    delete[] _points;
+    delete[] _blocked;
+    delete[] _first_item;
+    delete[] _second_start;
+    delete[] _second_items;
+    delete[] _nodes;
+    delete[] _heap;
+}
+
+// update visibility graph between all fence points
+// returns false if out of memory
+bool AP_OAFenceGraph::update(const AP_ExpandingArray<Vector2f> *const layer_pts[], const uint16_t layer_numpoints[], uint8_t num_layers, uint8_t changed_layers, intersects_fn_t intersects)
+{
+    if (num_layers > MAX_LAYERS) {
+        return false;
+    }
+
+    // the index is out of date as soon as the visgraph is cleared
+    _index_ok = false;
+    _visgraph.clear();
+
+    // work out the new layout of the points
+    uint16_t layer_first[MAX_LAYERS] {};
+    uint16_t numpoints = 0;
+    for (uint8_t l = 0; l < num_layers; l++) {
+        layer_first[l] = numpoints;
+        numpoints += layer_numpoints[l];
+    }
+    const uint8_t all_layers = (1U << num_layers) - 1;
+
+    // every pair must be tested if we have no record of the previous pairs
+    if (!_blocked_ok || (num_layers != _num_layers)) {
+        changed_layers = all_layers;
+    }
+
+    // copy points, checking for any layers whose points have moved
+    Vector2f *points = nullptr;
+    if (numpoints > 0) {
+        points = new Vector2f[numpoints];
+        if (points == nullptr) {
+            return false;
+        }
+    }
+    for (uint8_t l = 0; l < num_layers; l++) {
+        bool layer_changed = (changed_layers & (1U << l)) || (layer_numpoints[l] != _layer_numpoints[l]);
+        for (uint16_t k = 0; k < layer_numpoints[l]; k++) {
+            points[layer_first[l] + k] = (*layer_pts[l])[k];
+            if (!layer_changed && (points[layer_first[l] + k] != _points[_layer_first[l] + k])) {
+                layer_changed = true;
+            }
+        }
+        if (layer_changed) {
+            changed_layers |= 1U << l;
+        }
+    }
+
+    // record of blocked pairs.  If it cannot be allocated the graph is still built but the next update must test every pair
+    const uint32_t num_pairs = (numpoints > 1) ? (uint32_t)numpoints * (numpoints - 1U) / 2U : 0;
+    uint8_t *blocked = nullptr;
+    if (num_pairs > 0) {
+        blocked = new uint8_t[(num_pairs + 3U) / 4U];
+    }
+
+    // calculate visibility between each point and all following points
+    uint8_t layer_i = 0;
+    for (uint16_t i = 0; i + 1 < numpoints; i++) {
+        while (i >= layer_first[layer_i] + layer_numpoints[layer_i]) {
+            layer_i++;
+        }
+        uint8_t layer_j = layer_i;
+        for (uint16_t j = i + 1; j < numpoints; j++) {
+            while (j >= layer_first[layer_j] + layer_numpoints[layer_j]) {
+                layer_j++;
+            }
+
+            // by default test against all layers
+            uint8_t test_layers = all_layers;
+            uint8_t code = 0;
+            if ((changed_layers & ((1U << layer_i) | (1U << layer_j))) == 0) {
+                // both points are unchanged so look up what blocked this pair last time
+                const uint16_t old_i = i - layer_first[layer_i] + _layer_first[layer_i];
+                const uint16_t old_j = j - layer_first[layer_j] + _layer_first[layer_j];
+                const uint8_t old_code = get_blocked(_blocked, pair_index(old_i, old_j, _numpoints));
+                if (old_code == 0) {
+                    // pair was visible so only changed layers can block it now
+                    test_layers = changed_layers;
+                } else if ((changed_layers & (1U << (old_code - 1))) == 0) {
+                    // still blocked by the same layer
+                    code = old_code;
+                    test_layers = 0;
+                } else {
+                    // layers before the blocking layer were clear so only need testing if they have changed
+                    test_layers = changed_layers | (all_layers & ~((1U << (old_code - 1)) - 1U));
+                }
+            }
+            if (test_layers != 0) {
+                code = first_blocking_layer(points[i], points[j], test_layers, intersects);
+            }
+            if (blocked != nullptr) {
+                set_blocked(blocked, pair_index(i, j, numpoints), code);
+            }
+
+            // if line segment does not intersect with any inclusion or exclusion zones add to visgraph
+            if (code == 0) {
+                if (!_visgraph.add_item({AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT, (AP_OAVisGraph::oaid_num)i},
+                                        {AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT, (AP_OAVisGraph::oaid_num)j},
+                                        (points[i] - points[j]).length())) {
+                    // previous points and pairs are kept so the next update may still be incremental
+                    _visgraph.clear();
+                    delete[] points;
+                    delete[] blocked;
+                    return false;
+                }
+            }
+        }
+    }
+
+    // replace previous points and pairs
+    delete[] _points;
+    _points = points;
+    delete[] _blocked;
+    _blocked = blocked;
+    _blocked_ok = (blocked != nullptr) || (num_pairs == 0);
+    _numpoints = numpoints;
+    _num_layers = num_layers;
+    for (uint8_t l = 0; l < MAX_LAYERS; l++) {
+        _layer_first[l] = (l < num_layers) ? layer_first[l] : numpoints;
+        _layer_numpoints[l] = (l < num_layers) ? layer_numpoints[l] : 0;
+    }
+
+    return build_index();
+}
+
+void AP_OAFenceGraph::set_blocked(uint8_t *blocked, uint32_t pair, uint8_t code)
+{
+    const uint8_t shift = (pair & 3) << 1;
+    blocked[pair >> 2] = (blocked[pair >> 2] & ~(3U << shift)) | (code << shift);
+}
+
+// return first layer (plus one) in layer_mask whose fences block the segment between the given points, zero if none
+uint8_t AP_OAFenceGraph::first_blocking_layer(const Vector2f &seg_start, const Vector2f &seg_end, uint8_t layer_mask, intersects_fn_t intersects) const
+{
+    for (uint8_t l = 0; l < MAX_LAYERS; l++) {
+        if ((layer_mask & (1U << l)) && intersects(l, seg_start, seg_end)) {
+            return l + 1;
+        }
+    }
+    return 0;
+}
+
+// build index of visgraph items by point and allocate search nodes
+// returns false if out of memory
+bool AP_OAFenceGraph::build_index()
+{
+    // expand arrays if required
+    if (_numpoints + 1U > _index_space) {
+        delete[] _first_item;
+        delete[] _second_start;
+        _index_space = 0;
+        _first_item = new uint16_t[_numpoints + 1];
+        _second_start = new uint16_t[_numpoints + 1];
+        if ((_first_item == nullptr) || (_second_start == nullptr)) {
+            return false;
+        }
+        _index_space = _numpoints + 1;
+    }
+    const uint16_t num_items = _visgraph.num_items();
+    if (num_items > _second_items_space) {
+        delete[] _second_items;
+        _second_items_space = 0;
+        _second_items = new uint16_t[num_items];
+        if (_second_items == nullptr) {
+            return false;
+        }
+        _second_items_space = num_items;
+    }
+    if (_numpoints + 2U > _nodes_space) {
+        delete[] _nodes;
+        delete[] _heap;
+        _nodes_space = 0;
+        _nodes = new SearchNode[_numpoints + 2];
+        _heap = new node_index[_numpoints + 2];
+        if ((_nodes == nullptr) || (_heap == nullptr)) {
+            return false;
+        }
+        _nodes_space = _numpoints + 2;
+    }
+
+    // items are ordered by their first point so each point's items start where the previous point's end
+    uint16_t item = 0;
+    for (uint16_t k = 0; k < _numpoints; k++) {
+        _first_item[k] = item;
+        while ((item < num_items) && (_visgraph[item].id1.id_num == k)) {
+            item++;
+        }
+    }
+    _first_item[_numpoints] = item;
+
+    // sort items by their second point
+    memset(_second_start, 0, sizeof(_second_start[0]) * (_numpoints + 1));
+    for (uint16_t i = 0; i < num_items; i++) {
+        _second_start[_visgraph[i].id2.id_num + 1]++;
+    }
+    for (uint16_t k = 0; k < _numpoints; k++) {
+        _second_start[k + 1] += _second_start[k];
+    }
+    for (uint16_t i = 0; i < num_items; i++) {
+        // use the following point's start as a cursor, it is moved back to this point's end once all items are placed
+        _second_items[_second_start[_visgraph[i].id2.id_num]++] = i;
+    }
+    for (uint16_t k = _numpoints; k > 0; k--) {
+        _second_start[k] = _second_start[k - 1];
+    }
+    _second_start[0] = 0;
+
+    _index_ok = true;
+    return true;
+}
+
+// find shortest path from source to destination using visibility graphs from the source and destination to the fence points
+AP_OAFenceGraph::SearchResult AP_OAFenceGraph::find_path(const AP_OAVisGraph &source_visgraph, const AP_OAVisGraph &destination_visgraph,
+                                                         const Vector2f &source, const Vector2f &destination,
+                                                         AP_ExpandingArray<AP_OAVisGraph::OAItemID> &path, uint16_t &path_numpoints)
+{
+    path_numpoints = 0;
+    if (!_index_ok) {
+        return SearchResult::NO_PATH;
+    }
+
+    // initialise nodes. heuristic is simple Euclidean distance from the node to the destination
+    // which is admissible, therefore optimal path is guaranteed
+    const node_index num_nodes = _numpoints + OA_FENCEGRAPH_FIRST_POINT_NODE;
+    for (node_index n = 0; n < num_nodes; n++) {
+        SearchNode &node = _nodes[n];
+        node.distance_cm = FLT_MAX;
+        node.distance_from_idx = NODE_NOTSET;
+        node.heap_idx = NODE_NOTSET;
+        node.destination_item = UINT16_MAX;
+        if (n >= OA_FENCEGRAPH_FIRST_POINT_NODE) {
+            node.heuristic_cm = (_points[n - OA_FENCEGRAPH_FIRST_POINT_NODE] - destination).length();
+        } else if (n == OA_FENCEGRAPH_SOURCE_NODE) {
+            node.heuristic_cm = (source - destination).length();
+        } else {
+            node.heuristic_cm = 0;
+        }
+    }
+
+    // note which points can see the destination
+    for (uint16_t i = 0; i < destination_visgraph.num_items(); i++) {
+        const AP_OAVisGraph::VisGraphItem &item = destination_visgraph[i];
+        const AP_OAVisGraph::OAItemID &other_id = (item.id1.id_type == AP_OAVisGraph::OATYPE_DESTINATION) ? item.id2 : item.id1;
+        node_index node_idx;
+        if (node_from_id(other_id, node_idx)) {
+            _nodes[node_idx].destination_item = i;
+        }
+    }
+
+    // start algorithm from source point
+    _nodes[OA_FENCEGRAPH_SOURCE_NODE].distance_cm = 0;
+    _nodes[OA_FENCEGRAPH_SOURCE_NODE].heap_idx = 0;
+    _heap[0] = OA_FENCEGRAPH_SOURCE_NODE;
+    _heap_numitems = 1;
+
+    // move to node with lowest distance plus heuristic until the destination is reached
+    while (_heap_numitems > 0) {
+        const node_index curr_idx = heap_pop();
+        if (curr_idx == OA_FENCEGRAPH_DESTINATION_NODE) {
+            // We have discovered destination.. Don't bother with the rest of the graph
+            break;
+        }
+
+        if (curr_idx == OA_FENCEGRAPH_SOURCE_NODE) {
+            // update nodes visible from source point
+            for (uint16_t i = 0; i < source_visgraph.num_items(); i++) {
+                const AP_OAVisGraph::VisGraphItem &item = source_visgraph[i];
+                const AP_OAVisGraph::OAItemID &other_id = (item.id1.id_type == AP_OAVisGraph::OATYPE_SOURCE) ? item.id2 : item.id1;
+                node_index node_idx;
+                if (node_from_id(other_id, node_idx)) {
+                    relax(curr_idx, node_idx, item.distance_cm);
+                }
+            }
+            continue;
+        }
+
+        // update distances to all neighbours of current fence point
+        const uint16_t k = curr_idx - OA_FENCEGRAPH_FIRST_POINT_NODE;
+        for (uint16_t i = _first_item[k]; i < _first_item[k + 1]; i++) {
+            const AP_OAVisGraph::VisGraphItem &item = _visgraph[i];
+            relax(curr_idx, item.id2.id_num + OA_FENCEGRAPH_FIRST_POINT_NODE, item.distance_cm);
+        }
+        for (uint16_t s = _second_start[k]; s < _second_start[k + 1]; s++) {
+            const AP_OAVisGraph::VisGraphItem &item = _visgraph[_second_items[s]];
+            relax(curr_idx, item.id1.id_num + OA_FENCEGRAPH_FIRST_POINT_NODE, item.distance_cm);
+        }
+        const uint16_t dest_item = _nodes[curr_idx].destination_item;
+        if (dest_item != UINT16_MAX) {
+            relax(curr_idx, OA_FENCEGRAPH_DESTINATION_NODE, destination_visgraph[dest_item].distance_cm);
+        }
+    }
+
+    // extract path starting from destination
+    if (_nodes[OA_FENCEGRAPH_DESTINATION_NODE].distance_from_idx == NODE_NOTSET) {
+        return SearchResult::NO_PATH;
+    }
+    node_index node_idx = OA_FENCEGRAPH_DESTINATION_NODE;
+    while (true) {
+        if ((path_numpoints == UINT16_MAX) || !path.expand_to_hold(path_numpoints + 1)) {
+            return SearchResult::OUT_OF_MEMORY;
+        }
+        path[path_numpoints++] = id_from_node(node_idx);
+
+        // we are done if node is the source
+        if (node_idx == OA_FENCEGRAPH_SOURCE_NODE) {
+            return SearchResult::SUCCESS;
+        }
+        // follow node's "distance_from_idx" to previous node on path
+        node_idx = _nodes[node_idx].distance_from_idx;
+        if (node_idx == NODE_NOTSET) {
+            // we should never get here but just in case
+            return SearchResult::NO_PATH;
+        }
+    }
+}
+
+// find a node's index from it's id (i.e. id type and id number)
+// returns true if successful and node_idx is updated
+bool AP_OAFenceGraph::node_from_id(const AP_OAVisGraph::OAItemID &id, node_index &node_idx) const
+{
+    switch (id.id_type) {
+    case AP_OAVisGraph::OATYPE_SOURCE:
+        node_idx = OA_FENCEGRAPH_SOURCE_NODE;
+        return true;
+    case AP_OAVisGraph::OATYPE_DESTINATION:
+        node_idx = OA_FENCEGRAPH_DESTINATION_NODE;
+        return true;
+    case AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT:
+        if (id.id_num < _numpoints) {
+            node_idx = id.id_num + OA_FENCEGRAPH_FIRST_POINT_NODE;
+            return true;
+        }
+        break;
+    }
+
+    // could not find node
+    return false;
+}
+
+// convert a node's index to its id
+AP_OAVisGraph::OAItemID AP_OAFenceGraph::id_from_node(node_index node_idx) const
+{
+    switch (node_idx) {
+    case OA_FENCEGRAPH_SOURCE_NODE:
+        return {AP_OAVisGraph::OATYPE_SOURCE, 0};
+    case OA_FENCEGRAPH_DESTINATION_NODE:
+        return {AP_OAVisGraph::OATYPE_DESTINATION, 0};
+    default:
+        return {AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT, (AP_OAVisGraph::oaid_num)(node_idx - OA_FENCEGRAPH_FIRST_POINT_NODE)};
+    }
+}
+
+// move node at heap_idx towards the top of the heap until its parent is closer
+void AP_OAFenceGraph::heap_sift_up(node_index heap_idx)
+{
+    const node_index node_idx = _heap[heap_idx];
+    const float key = heap_key(node_idx);
+    while (heap_idx > 0) {
+        const node_index parent = (heap_idx - 1) / 2;
+        if (heap_key(_heap[parent]) <= key) {
+            break;
+        }
+        _heap[heap_idx] = _heap[parent];
+        _nodes[_heap[heap_idx]].heap_idx = heap_idx;
+        heap_idx = parent;
+    }
+    _heap[heap_idx] = node_idx;
+    _nodes[node_idx].heap_idx = heap_idx;
+}
+
+// move node at heap_idx towards the bottom of the heap until both its children are further away
+void AP_OAFenceGraph::heap_sift_down(node_index heap_idx)
+{
+    const node_index node_idx = _heap[heap_idx];
+    const float key = heap_key(node_idx);
+    while (true) {
+        node_index child = 2 * heap_idx + 1;
+        if (child >= _heap_numitems) {
+            break;
+        }
+        if ((child + 1 < _heap_numitems) && (heap_key(_heap[child + 1]) < heap_key(_heap[child]))) {
+            child++;
+        }
+        if (key <= heap_key(_heap[child])) {
+            break;
+        }
+        _heap[heap_idx] = _heap[child];
+        _nodes[_heap[heap_idx]].heap_idx = heap_idx;
+        heap_idx = child;
+    }
+    _heap[heap_idx] = node_idx;
+    _nodes[node_idx].heap_idx = heap_idx;
+}
+
+// remove and return the node with the lowest distance plus heuristic, marking it as visited
+AP_OAFenceGraph::node_index AP_OAFenceGraph::heap_pop()
+{
+    const node_index top = _heap[0];
+    _nodes[top].heap_idx = NODE_VISITED;
+    _heap_numitems--;
+    if (_heap_numitems > 0) {
+        _heap[0] = _heap[_heap_numitems];
+        heap_sift_down(0);
+    }
+    return top;
+}
+
+// update distance to a node if it is shorter via from_idx
+void AP_OAFenceGraph::relax(node_index from_idx, node_index node_idx, float edge_cm)
+{
+    SearchNode &node = _nodes[node_idx];
+    if (node.heap_idx == NODE_VISITED) {
+        return;
+    }
+    const float dist_via_from = _nodes[from_idx].distance_cm + edge_cm;
+    if (dist_via_from >= node.distance_cm) {
+        return;
+    }
+    node.distance_cm = dist_via_from;
+    node.distance_from_idx = from_idx;
+    if (node.heap_idx == NODE_NOTSET) {
+        // add to bottom of heap
+        node.heap_idx = _heap_numitems++;
+        _heap[node.heap_idx] = node_idx;
+    }
+    heap_sift_up(node.heap_idx);
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <AP_Common/AP_Common.h>
+#include <AP_Common/AP_ExpandingArray.h>
+#include <AP_HAL/utility/functor.h>
+#include <AP_Math/AP_Math.h>
+#include "AP_OAVisGraph.h"
+
+/*
+ * Visibility graph between fence points (with margin) and A* search through it, used by Dijkstra's path planner
+ *
+ * Fence points are grouped into up to three layers (e.g. inclusion fences, exclusion polygons and exclusion circles).
+ * For every pair of points the graph remembers the first layer whose fences block the segment between them,
+ * so when only some layers change, pairs which are still blocked by an unchanged layer are not retested and
+ * pairs which were visible are only tested against the changed layers
+ *
+ * Nodes are numbered with the source first, the destination second and then the fence points in order
+ */
+class AP_OAFenceGraph {
+public:
+    AP_OAFenceGraph();
+    ~AP_OAFenceGraph();
+
+    CLASS_NO_COPY(AP_OAFenceGraph);  /* Do not allow copies */
+
+    // maximum number of fence layers
+    static const uint8_t MAX_LAYERS = 3;
+
+    // returns true if the segment between two points crosses any of the fences in a layer
+    FUNCTOR_TYPEDEF(intersects_fn_t, bool, uint8_t, const Vector2f&, const Vector2f&);
+
+    // update visibility graph between all fence points
+    // layer_pts and layer_numpoints hold the points in each layer, changed_layers is a bitmask of layers whose fences have changed
+    // since the last successful update.  Layers whose points have changed are detected automatically
+    // returns false if out of memory
+    bool update(const AP_ExpandingArray<Vector2f> *const layer_pts[], const uint16_t layer_numpoints[], uint8_t num_layers, uint8_t changed_layers, intersects_fn_t intersects);
+
+    // forget all pairs so the next update tests every pair against every layer
+    void reset() { _blocked_ok = false; }
+
+    // visibility graph between fence points, valid after a successful update
+    const AP_OAVisGraph& visgraph() const { return _visgraph; }
+
+    // number of fence points in graph
+    uint16_t num_points() const { return _numpoints; }
+
+    enum class SearchResult : uint8_t {
+        SUCCESS = 0,
+        OUT_OF_MEMORY,
+        NO_PATH
+    };
+
+    // find shortest path from source to destination using visibility graphs from the source and destination to the fence points
+    // path is filled in with the ids of the points on the path in reverse order (i.e. destination is the first element)
+    SearchResult find_path(const AP_OAVisGraph &source_visgraph, const AP_OAVisGraph &destination_visgraph,
+                           const Vector2f &source, const Vector2f &destination,
+                           AP_ExpandingArray<AP_OAVisGraph::OAItemID> &path, uint16_t &path_numpoints);
+
+private:
+
+    // first layer blocking a pair of points (plus one), or zero if the points are visible from each other
+    // two bits are held per pair of points
+    static uint8_t get_blocked(const uint8_t *blocked, uint32_t pair) { return (blocked[pair >> 2] >> ((pair & 3) << 1)) & 3; }
+    static void set_blocked(uint8_t *blocked, uint32_t pair, uint8_t code);
+
+    // index of pair of points i and j where i < j, ordered by i then j
+    static uint32_t pair_index(uint16_t i, uint16_t j, uint16_t numpoints) { return (uint32_t)i * (2U * numpoints - i - 1U) / 2U + (j - i - 1U); }
+
+    // return first layer (plus one) in layer_mask whose fences block the segment between the given points, zero if none
+    uint8_t first_blocking_layer(const Vector2f &seg_start, const Vector2f &seg_end, uint8_t layer_mask, intersects_fn_t intersects) const;
+
+    // build index of visgraph items by point and allocate search nodes
+    // returns false if out of memory
+    bool build_index();
+
+    // fence points and layer layout
+    Vector2f *_points = nullptr;                      // copy of all fence points
+    uint16_t _numpoints = 0;                // number of points in above array
+    uint8_t _num_layers = 0;                // number of layers
+    uint16_t _layer_first[MAX_LAYERS] {};   // index of each layer's first point
+    uint16_t _layer_numpoints[MAX_LAYERS] {};   // number of points in each layer
+
+    uint8_t *_blocked = nullptr;            // first layer blocking each pair of points (plus one), two bits per pair
+    bool _blocked_ok = false;               // true if _blocked is valid for the points above
+
+    AP_OAVisGraph _visgraph;                // visibility graph between fence points, items are ordered by their first point
+
+    // index into _visgraph by point
+    uint16_t *_first_item = nullptr;        // index of first item whose first point is each point (numpoints+1 elements)
+    uint16_t *_second_start = nullptr;      // start of each point's items in _second_items (numpoints+1 elements)
+    uint16_t *_second_items = nullptr;      // indices of items ordered by their second point
+    uint16_t _index_space = 0;              // number of points the first two arrays above can hold
+    uint16_t _second_items_space = 0;       // number of items _second_items can hold
+    bool _index_ok = false;                 // true if above index matches _visgraph
+
+    // search nodes
+    typedef uint16_t node_index;
+    static const node_index NODE_NOTSET = UINT16_MAX;      // no previous node, or node not yet added to heap
+    static const node_index NODE_VISITED = UINT16_MAX - 1; // node has been removed from heap
+    struct SearchNode {
+        float distance_cm;                  // distance from source (tentative until node is visited)
+        float heuristic_cm;                 // straight line distance to the destination
+        node_index distance_from_idx;       // previous node on shortest path found so far, or NODE_NOTSET
+        node_index heap_idx;                // position in heap, NODE_NOTSET if not yet reached, NODE_VISITED once visited
+        uint16_t destination_item;          // index into destination visgraph of item for this node, UINT16_MAX if not visible
+    };
+    SearchNode *_nodes = nullptr;
+    node_index *_heap = nullptr;            // binary heap of nodes ordered by distance plus heuristic
+    node_index _heap_numitems = 0;
+    uint16_t _nodes_space = 0;              // number of nodes above arrays can hold
+
+    // convert between search nodes and visgraph ids
+    bool node_from_id(const AP_OAVisGraph::OAItemID &id, node_index &node_idx) const;
+    AP_OAVisGraph::OAItemID id_from_node(node_index node_idx) const;
+
+    // heap operations
+    float heap_key(node_index node_idx) const { return _nodes[node_idx].distance_cm + _nodes[node_idx].heuristic_cm; }
+    void heap_sift_up(node_index heap_idx);
+    void heap_sift_down(node_index heap_idx);
+    node_index heap_pop();
+
+    // update distance to a node if it is shorter via from_idx
+    void relax(node_index from_idx, node_index node_idx, float edge_cm);
+};
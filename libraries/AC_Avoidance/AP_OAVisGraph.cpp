@@ -15,9 +15,13 @@
 
 #include "AP_OAVisGraph.h"
 
+#define OA_VISGRAPH_CHUNK_SIZE  20  // number of items allocated at a time
+// the expanding array's size must fit in 16 bits so it can only hold whole chunks up to this
+#define OA_VISGRAPH_MAX_ITEMS   ((UINT16_MAX / OA_VISGRAPH_CHUNK_SIZE) * OA_VISGRAPH_CHUNK_SIZE)
+
 // constructor initialises expanding array to use 20 elements per chunk
 AP_OAVisGraph::AP_OAVisGraph() :
-    _items(20)
+    _items(OA_VISGRAPH_CHUNK_SIZE)
 {
 }
 
@@ -25,7 +29,7 @@ AP_OAVisGraph::AP_OAVisGraph() :
 bool AP_OAVisGraph::add_item(const OAItemID &id1, const OAItemID &id2, float distance_cm)
 {
     // no more than 65k items
-    if (_num_items == UINT16_MAX) {
+    if (_num_items >= OA_VISGRAPH_MAX_ITEMS) {
         return false;
     }
 
@@ -0,0 +1,328 @@
+#include <AP_gbenchmark.h>
+
+#include <AC_Avoidance/AP_OAFenceGraph.h>
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Math/AP_Math.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+/*
+  Dijkstra's fence graph around a jagged inclusion fence of N vertices
+  with a square exclusion zone in the middle. As in AP_OADijkstra only
+  the inner corners of the inclusion fence become graph points, moved
+  in by the margin, so a fence of N vertices gives N/2 + 4 points.
+  Distances are in cm
+ */
+static const float fence_radius_cm = 100000;
+static const float fence_tooth_cm = 5000;
+static const float exclusion_half_width_cm = 10000;
+static const float margin_cm = 500;
+
+enum {
+    LAYER_INCLUSION = 0,
+    LAYER_EXCLUSION_POLYGON,
+    LAYER_EXCLUSION_CIRCLE,
+    LAYER_COUNT
+};
+
+class BenchFence {
+public:
+    BenchFence(uint16_t num_vertices) :
+        inclusion_pts(32),
+        exclusion_pts(32),
+        circle_pts(32),
+        num_inclusion(num_vertices)
+    {
+        inclusion = new Vector2f[num_inclusion];
+        for (uint16_t i = 0; i < num_inclusion; i++) {
+            const float angle = M_2PI * i / num_inclusion;
+            const float radius = (i & 1) ? fence_radius_cm - fence_tooth_cm : fence_radius_cm;
+            inclusion[i] = Vector2f{cosf(angle), sinf(angle)} * radius;
+            if (i & 1) {
+                inclusion_pts.expand_to_hold(numpoints[LAYER_INCLUSION] + 1);
+                inclusion_pts[numpoints[LAYER_INCLUSION]++] = Vector2f{cosf(angle), sinf(angle)} * (radius - margin_cm);
+            }
+        }
+        exclusion_pts.expand_to_hold(4);
+        numpoints[LAYER_EXCLUSION_POLYGON] = 4;
+        set_exclusion_center(Vector2f{0, 0});
+    }
+
+    ~BenchFence()
+    {
+        delete[] inclusion;
+    }
+
+    // move the exclusion zone and its points
+    void set_exclusion_center(const Vector2f &center)
+    {
+        static const Vector2f corners[4] {{1, 1}, {1, -1}, {-1, -1}, {-1, 1}};
+        for (uint8_t i = 0; i < 4; i++) {
+            exclusion[i] = center + corners[i] * exclusion_half_width_cm;
+            exclusion_pts[i] = center + corners[i] * (exclusion_half_width_cm + margin_cm);
+        }
+    }
+
+    bool intersects(uint8_t layer, const Vector2f &seg_start, const Vector2f &seg_end)
+    {
+        Vector2f intersection;
+        switch (layer) {
+        case LAYER_INCLUSION:
+            return Polygon_intersects(inclusion, num_inclusion, seg_start, seg_end, intersection);
+        case LAYER_EXCLUSION_POLYGON:
+            return Polygon_intersects(exclusion, 4, seg_start, seg_end, intersection);
+        }
+        return false;
+    }
+
+    bool intersects_any(const Vector2f &seg_start, const Vector2f &seg_end)
+    {
+        for (uint8_t l = 0; l < LAYER_COUNT; l++) {
+            if (intersects(l, seg_start, seg_end)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    AP_OAFenceGraph::intersects_fn_t intersects_fn()
+    {
+        return FUNCTOR_BIND(this, &BenchFence::intersects, bool, uint8_t, const Vector2f&, const Vector2f&);
+    }
+
+    bool update(AP_OAFenceGraph &graph, uint8_t changed_layers)
+    {
+        const AP_ExpandingArray<Vector2f> *layer_pts[LAYER_COUNT] {&inclusion_pts, &exclusion_pts, &circle_pts};
+        return graph.update(layer_pts, numpoints, LAYER_COUNT, changed_layers, intersects_fn());
+    }
+
+    // visgraph from a position to all fence points, as AP_OADijkstra::update_visgraph
+    void update_visgraph(AP_OAVisGraph &visgraph, const AP_OAVisGraph::OAItemID &oaid, const Vector2f &position, bool add_extra_position = false, const Vector2f &extra_position = Vector2f{})
+    {
+        visgraph.clear();
+        uint16_t idx = 0;
+        const AP_ExpandingArray<Vector2f> *layer_pts[LAYER_COUNT] {&inclusion_pts, &exclusion_pts, &circle_pts};
+        for (uint8_t l = 0; l < LAYER_COUNT; l++) {
+            for (uint16_t i = 0; i < numpoints[l]; i++, idx++) {
+                const Vector2f &pt = (*layer_pts[l])[i];
+                if (!intersects_any(position, pt)) {
+                    visgraph.add_item(oaid, {AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT, (AP_OAVisGraph::oaid_num)idx}, (position - pt).length());
+                }
+            }
+        }
+        if (add_extra_position && !intersects_any(position, extra_position)) {
+            visgraph.add_item(oaid, {AP_OAVisGraph::OATYPE_DESTINATION, 0}, (position - extra_position).length());
+        }
+    }
+
+    Vector2f point(uint16_t idx) const
+    {
+        if (idx < numpoints[LAYER_INCLUSION]) {
+            return inclusion_pts[idx];
+        }
+        return exclusion_pts[idx - numpoints[LAYER_INCLUSION]];
+    }
+
+    uint16_t total_numpoints() const
+    {
+        return numpoints[LAYER_INCLUSION] + numpoints[LAYER_EXCLUSION_POLYGON] + numpoints[LAYER_EXCLUSION_CIRCLE];
+    }
+
+private:
+    AP_ExpandingArray<Vector2f> inclusion_pts;
+    AP_ExpandingArray<Vector2f> exclusion_pts;
+    AP_ExpandingArray<Vector2f> circle_pts;
+    uint16_t numpoints[LAYER_COUNT] {};
+
+    Vector2f *inclusion;
+    uint16_t num_inclusion;
+    Vector2f exclusion[4];
+};
+
+static const Vector2f source{-80000, 0};
+static const Vector2f destination{80000, 0};
+static const uint8_t all_layers = (1U << LAYER_COUNT) - 1;
+
+/*
+  fence, graph and visgraphs for a search from source to
+  destination. Always allocated with new, as the planner relies on new
+  returning zeroed memory
+ */
+struct BenchPlanner {
+    BenchPlanner(uint16_t num_vertices) :
+        fence(num_vertices),
+        path(32)
+    {
+        fence.update(graph, all_layers);
+        fence.update_visgraph(source_visgraph, {AP_OAVisGraph::OATYPE_SOURCE, 0}, source, true, destination);
+        fence.update_visgraph(destination_visgraph, {AP_OAVisGraph::OATYPE_DESTINATION, 0}, destination);
+    }
+
+    BenchFence fence;
+    AP_OAFenceGraph graph;
+    AP_OAVisGraph source_visgraph;
+    AP_OAVisGraph destination_visgraph;
+    AP_ExpandingArray<AP_OAVisGraph::OAItemID> path;
+    uint16_t path_numpoints;
+};
+
+static void set_path_label(benchmark::State& state, uint16_t numpoints, uint16_t path_numpoints)
+{
+    char label[32];
+    snprintf(label, sizeof(label), "points=%u path=%u", numpoints, path_numpoints);
+    state.SetLabel(label);
+}
+
+// build the graph from scratch, testing every pair against every layer
+static void BM_FenceGraphBuild(benchmark::State& state)
+{
+    BenchPlanner *planner = new BenchPlanner(state.range(0));
+    while (state.KeepRunning()) {
+        planner->graph.reset();
+        if (!planner->fence.update(planner->graph, all_layers)) {
+            state.SkipWithError("update failed");
+            break;
+        }
+    }
+    delete planner;
+}
+
+// move the exclusion zone so only pairs it may affect are retested
+static void BM_FenceGraphMoveExclusion(benchmark::State& state)
+{
+    BenchPlanner *planner = new BenchPlanner(state.range(0));
+    bool moved = false;
+    while (state.KeepRunning()) {
+        moved = !moved;
+        planner->fence.set_exclusion_center(moved ? Vector2f{2000, 0} : Vector2f{0, 0});
+        if (!planner->fence.update(planner->graph, 1U << LAYER_EXCLUSION_POLYGON)) {
+            state.SkipWithError("update failed");
+            break;
+        }
+    }
+    delete planner;
+}
+
+// A* search using a binary heap and an index of each point's visgraph items
+static void BM_FindPathHeap(benchmark::State& state)
+{
+    BenchPlanner *planner = new BenchPlanner(state.range(0));
+    while (state.KeepRunning()) {
+        if (planner->graph.find_path(planner->source_visgraph, planner->destination_visgraph, source, destination,
+                                     planner->path, planner->path_numpoints) != AP_OAFenceGraph::SearchResult::SUCCESS) {
+            state.SkipWithError("no path");
+            break;
+        }
+    }
+    set_path_label(state, planner->fence.total_numpoints(), planner->path_numpoints);
+    delete planner;
+}
+
+/*
+  the search AP_OADijkstra used before, which scans every node for the
+  closest one and every visgraph item for its neighbours
+ */
+struct LinearNode {
+    AP_OAVisGraph::OAItemID id;
+    bool visited;
+    uint16_t distance_from_idx;
+    float distance_cm;
+};
+
+static bool linear_find_node(const AP_OAVisGraph::OAItemID &id, uint16_t numnodes, uint16_t &node_idx)
+{
+    switch (id.id_type) {
+    case AP_OAVisGraph::OATYPE_SOURCE:
+        node_idx = 0;
+        return true;
+    case AP_OAVisGraph::OATYPE_DESTINATION:
+        node_idx = 1;
+        return true;
+    case AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT:
+        node_idx = id.id_num + 2;
+        return node_idx < numnodes;
+    }
+    return false;
+}
+
+static uint16_t linear_find_path(BenchFence &fence, const AP_OAVisGraph &fence_visgraph, const AP_OAVisGraph &source_visgraph, const AP_OAVisGraph &destination_visgraph, LinearNode *nodes)
+{
+    const uint16_t numnodes = fence.total_numpoints() + 2;
+    nodes[0] = {{AP_OAVisGraph::OATYPE_SOURCE, 0}, true, 0, 0};
+    nodes[1] = {{AP_OAVisGraph::OATYPE_DESTINATION, 0}, false, UINT16_MAX, FLT_MAX};
+    for (uint16_t i = 2; i < numnodes; i++) {
+        nodes[i] = {{AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT, (AP_OAVisGraph::oaid_num)(i - 2)}, false, UINT16_MAX, FLT_MAX};
+    }
+    for (uint16_t i = 0; i < source_visgraph.num_items(); i++) {
+        uint16_t node_idx;
+        if (linear_find_node(source_visgraph[i].id2, numnodes, node_idx)) {
+            nodes[node_idx].distance_cm = source_visgraph[i].distance_cm;
+            nodes[node_idx].distance_from_idx = 0;
+        }
+    }
+    while (true) {
+        uint16_t curr = 0;
+        float lowest = FLT_MAX;
+        for (uint16_t i = 0; i < numnodes; i++) {
+            if (nodes[i].visited || nodes[i].distance_cm >= FLT_MAX) {
+                continue;
+            }
+            const Vector2f pos = (i == 1) ? destination : fence.point(i - 2);
+            const float dist = nodes[i].distance_cm + (pos - destination).length();
+            if (dist < lowest) {
+                lowest = dist;
+                curr = i;
+            }
+        }
+        if ((lowest >= FLT_MAX) || (curr == 1)) {
+            break;
+        }
+        const AP_OAVisGraph *visgraphs[] {&fence_visgraph, &destination_visgraph};
+        for (const AP_OAVisGraph *visgraph : visgraphs) {
+            for (uint16_t i = 0; i < visgraph->num_items(); i++) {
+                const AP_OAVisGraph::VisGraphItem &item = (*visgraph)[i];
+                if ((nodes[curr].id == item.id1) || (nodes[curr].id == item.id2)) {
+                    uint16_t node_idx;
+                    if (linear_find_node((nodes[curr].id == item.id1) ? item.id2 : item.id1, numnodes, node_idx)) {
+                        const float dist = nodes[curr].distance_cm + item.distance_cm;
+                        if (dist < nodes[node_idx].distance_cm) {
+                            nodes[node_idx].distance_cm = dist;
+                            nodes[node_idx].distance_from_idx = curr;
+                        }
+                    }
+                }
+            }
+        }
+        nodes[curr].visited = true;
+    }
+
+    // count points on path
+    uint16_t path_numpoints = 0;
+    for (uint16_t n = 1; nodes[n].distance_from_idx != UINT16_MAX; n = nodes[n].distance_from_idx) {
+        path_numpoints++;
+        if (n == 0) {
+            break;
+        }
+    }
+    return path_numpoints;
+}
+
+static void BM_FindPathLinearScan(benchmark::State& state)
+{
+    BenchPlanner *planner = new BenchPlanner(state.range(0));
+    LinearNode *nodes = new LinearNode[planner->fence.total_numpoints() + 2];
+    uint16_t path_numpoints = 0;
+    while (state.KeepRunning()) {
+        path_numpoints = linear_find_path(planner->fence, planner->graph.visgraph(), planner->source_visgraph, planner->destination_visgraph, nodes);
+    }
+    set_path_label(state, planner->fence.total_numpoints(), path_numpoints);
+    delete[] nodes;
+    delete planner;
+}
+
+BENCHMARK(BM_FenceGraphBuild)->Arg(50)->Arg(100)->Arg(200)->Arg(500);
+BENCHMARK(BM_FenceGraphMoveExclusion)->Arg(50)->Arg(100)->Arg(200)->Arg(500);
+BENCHMARK(BM_FindPathHeap)->Arg(50)->Arg(100)->Arg(200)->Arg(500);
+BENCHMARK(BM_FindPathLinearScan)->Arg(50)->Arg(100)->Arg(200)->Arg(500);
+
+BENCHMARK_MAIN();
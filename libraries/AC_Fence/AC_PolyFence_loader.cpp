@@ -218,7 +218,7 @@ bool AC_PolyFence_loader::breached(const Location& loc) const
     // check we are inside each inclusion zone:
     for (uint8_t i=0; i<_num_loaded_inclusion_boundaries; i++) {
         const InclusionBoundary &boundary = _loaded_inclusion_boundary[i];
-        if (Polygon_outside(pos, boundary.points_lla, boundary.count)) {
+        if (boundary.index_lla.outside(pos)) {
             return true;
         }
     }
@@ -226,7 +226,7 @@ bool AC_PolyFence_loader::breached(const Location& loc) const
     // check we are outside each exclusion zone:
     for (uint8_t i=0; i<_num_loaded_exclusion_boundaries; i++) {
         const ExclusionBoundary &boundary = _loaded_exclusion_boundary[i];
-        if (!Polygon_outside(pos, boundary.points_lla, boundary.count)) {
+        if (!boundary.index_lla.outside(pos)) {
             return true;
         }
     }
@@ -759,6 +759,12 @@ bool AC_PolyFence_loader::load_from_eeprom()
                 storage_valid = false;
                 break;
             }
+            // index the edges for breach and crossing checks.  If
+            // this fails the checks fall back to testing every edge
+            if (!boundary.index.init(boundary.points, boundary.count) ||
+                !boundary.index_lla.init(boundary.points_lla, boundary.count)) {
+                Debug("polyfence: no memory for edge index");
+            }
             _num_loaded_inclusion_boundaries++;
             break;
         }
@@ -778,6 +784,12 @@ bool AC_PolyFence_loader::load_from_eeprom()
                 storage_valid = false;
                 break;
             }
+            // index the edges for breach and crossing checks.  If
+            // this fails the checks fall back to testing every edge
+            if (!boundary.index.init(boundary.points, boundary.count) ||
+                !boundary.index_lla.init(boundary.points_lla, boundary.count)) {
+                Debug("polyfence: no memory for edge index");
+            }
             _num_loaded_exclusion_boundaries++;
             break;
         }
@@ -905,6 +917,46 @@ Vector2f* AC_PolyFence_loader::get_inclusion_polygon(uint16_t index, uint16_t &n
     return boundary.points;
 }
 
+/// returns true if point is outside the specified exclusion polygon
+/// point is an offset in cm from EKF origin in NE frame
+bool AC_PolyFence_loader::exclusion_polygon_outside(uint16_t index, const Vector2f &point) const
+{
+    if (index >= _num_loaded_exclusion_boundaries) {
+        return true;
+    }
+    return _loaded_exclusion_boundary[index].index.outside(point);
+}
+
+/// returns true if the segment from p1 to p2 crosses an edge of the specified exclusion polygon
+/// intersection is filled in with the crossing closest to p1
+bool AC_PolyFence_loader::exclusion_polygon_intersects(uint16_t index, const Vector2f &p1, const Vector2f &p2, Vector2f &intersection) const
+{
+    if (index >= _num_loaded_exclusion_boundaries) {
+        return false;
+    }
+    return _loaded_exclusion_boundary[index].index.intersects(p1, p2, intersection);
+}
+
+/// returns true if point is outside the specified inclusion polygon
+/// point is an offset in cm from EKF origin in NE frame
+bool AC_PolyFence_loader::inclusion_polygon_outside(uint16_t index, const Vector2f &point) const
+{
+    if (index >= _num_loaded_inclusion_boundaries) {
+        return true;
+    }
+    return _loaded_inclusion_boundary[index].index.outside(point);
+}
+
+/// returns true if the segment from p1 to p2 crosses an edge of the specified inclusion polygon
+/// intersection is filled in with the crossing closest to p1
+bool AC_PolyFence_loader::inclusion_polygon_intersects(uint16_t index, const Vector2f &p1, const Vector2f &p2, Vector2f &intersection) const
+{
+    if (index >= _num_loaded_inclusion_boundaries) {
+        return false;
+    }
+    return _loaded_inclusion_boundary[index].index.intersects(p1, p2, intersection);
+}
+
 /// returns the specified exclusion circle
 /// circle center offsets in cm from EKF origin in NE frame, radius is in meters
 bool AC_PolyFence_loader::get_exclusion_circle(uint8_t index, Vector2f &center_pos_cm, float &radius) const
@@ -67,6 +67,14 @@ public:
     /// points are offsets in cm from EKF origin in NE frame
     Vector2f* get_exclusion_polygon(uint16_t index, uint16_t &num_points) const;
 
+    /// returns true if point is outside the specified exclusion polygon
+    /// point is an offset in cm from EKF origin in NE frame
+    bool exclusion_polygon_outside(uint16_t index, const Vector2f &point) const;
+
+    /// returns true if the segment from p1 to p2 crosses an edge of the specified exclusion polygon
+    /// intersection is filled in with the crossing closest to p1.  points are offsets in cm from EKF origin in NE frame
+    bool exclusion_polygon_intersects(uint16_t index, const Vector2f &p1, const Vector2f &p2, Vector2f &intersection) const;
+
     /// return system time of last update to the exclusion polygon points
     uint32_t get_exclusion_polygon_update_ms() const {
         return _load_time_ms;
@@ -84,6 +92,14 @@ public:
     /// points are offsets in cm from EKF origin in NE frame
     Vector2f* get_inclusion_polygon(uint16_t index, uint16_t &num_points) const;
 
+    /// returns true if point is outside the specified inclusion polygon
+    /// point is an offset in cm from EKF origin in NE frame
+    bool inclusion_polygon_outside(uint16_t index, const Vector2f &point) const;
+
+    /// returns true if the segment from p1 to p2 crosses an edge of the specified inclusion polygon
+    /// intersection is filled in with the crossing closest to p1.  points are offsets in cm from EKF origin in NE frame
+    bool inclusion_polygon_intersects(uint16_t index, const Vector2f &p1, const Vector2f &p2, Vector2f &intersection) const;
+
     /// return system time of last update to the inclusion polygon points
     uint32_t get_inclusion_polygon_update_ms() const {
         return _load_time_ms;
@@ -281,6 +297,8 @@ private:
         Vector2f *points; // pointer into the _loaded_offsets_from_origin array
         Vector2l *points_lla; // pointer into the _loaded_points_lla array
         uint8_t count; // count of points in the boundary
+        PolygonIndex<float> index; // edge index over points
+        PolygonIndex<int32_t> index_lla; // edge index over points_lla
     };
     InclusionBoundary *_loaded_inclusion_boundary;
 
@@ -291,6 +309,8 @@ private:
         Vector2f *points; // pointer into the _loaded_offsets_from_origin array
         Vector2l *points_lla; // pointer into the _loaded_points_lla_lla array
         uint8_t count; // count of points in the boundary
+        PolygonIndex<float> index; // edge index over points
+        PolygonIndex<int32_t> index_lla; // edge index over points_lla
     };
     ExclusionBoundary *_loaded_exclusion_boundary;
 
@@ -339,6 +339,8 @@ void AP_ADSB::update(void)
         }
     }
 
+    update_nearest();
+
     if (out_state.cfg.squawk_octal_param != out_state.cfg.squawk_octal) {
         // param changed, check that it's a valid octal
         if (!is_valid_callsign(out_state.cfg.squawk_octal_param)) {
@@ -406,6 +408,72 @@ void AP_ADSB::determine_furthest_aircraft(void)
     in_state.furthest_vehicle_distance = max_distance;
 }
 
+/*
+ * rebuild the list of vehicles nearest to us, sorted by distance.
+ * Candidates are compared by squared distance on a flat-earth
+ * approximation around our own location, which needs no trig per
+ * vehicle, and kept in order with an insertion sort
+ */
+void AP_ADSB::update_nearest(void)
+{
+    nearest_vehicle_t nearest[ADSB_NEAREST_MAX];
+    uint8_t count = 0;
+
+    if (!_my_loc.is_zero()) {
+        const float lng_scale = Location::longitude_scale(_my_loc.lat);
+        for (uint16_t index = 0; index < in_state.vehicle_count; index++) {
+            const adsb_vehicle_t &vehicle = in_state.vehicle_list[index];
+            const float dlat = vehicle.info.lat - _my_loc.lat;
+            const float dlng = Location::diff_longitude(vehicle.info.lon, _my_loc.lng) * lng_scale;
+            const float dist_sq = sq(dlat) + sq(dlng);
+            if (count == ADSB_NEAREST_MAX && dist_sq >= nearest[count-1].distance) {
+                continue;
+            }
+            uint8_t i = count;
+            if (count < ADSB_NEAREST_MAX) {
+                count++;
+            } else {
+                // drop the furthest entry
+                i--;
+            }
+            while (i > 0 && nearest[i-1].distance > dist_sq) {
+                nearest[i] = nearest[i-1];
+                i--;
+            }
+            nearest[i].icao = vehicle.info.ICAO_address;
+            nearest[i].distance = dist_sq;
+            nearest[i].loc = get_location(vehicle);
+        }
+        for (uint8_t i = 0; i < count; i++) {
+            nearest[i].distance = sqrtf(nearest[i].distance) * LATLON_TO_M;
+        }
+    }
+
+    WITH_SEMAPHORE(in_state.nearest_sem);
+    for (uint8_t i = 0; i < count; i++) {
+        in_state.nearest[i] = nearest[i];
+    }
+    in_state.nearest_count = count;
+}
+
+uint8_t AP_ADSB::get_nearest_count()
+{
+    WITH_SEMAPHORE(in_state.nearest_sem);
+    return in_state.nearest_count;
+}
+
+bool AP_ADSB::get_nearest(uint8_t n, uint32_t &icao, float &distance, Location &loc)
+{
+    WITH_SEMAPHORE(in_state.nearest_sem);
+    if (n >= in_state.nearest_count) {
+        return false;
+    }
+    icao = in_state.nearest[n].icao;
+    distance = in_state.nearest[n].distance;
+    loc = in_state.nearest[n].loc;
+    return true;
+}
+
 /*
  * Convert/Extract a Location from a vehicle
  */
@@ -35,6 +35,10 @@
 
 #define ADSB_MAX_INSTANCES             1   // Maximum number of ADSB sensor instances available on this platform
 
+#ifndef ADSB_NEAREST_MAX
+#define ADSB_NEAREST_MAX               10  // number of vehicles kept in the sorted nearest vehicle list
+#endif
+
 #define ADSB_BITBASK_RF_CAPABILITIES_UAT_IN         (1 << 0)
 #define ADSB_BITBASK_RF_CAPABILITIES_1090ES_IN      (1 << 1)
 
@@ -144,6 +148,14 @@ public:
     // when true, a vehicle with that ICAO was found in database and the vehicle is populated.
     bool get_vehicle_by_ICAO(const uint32_t icao, adsb_vehicle_t &vehicle) const;
 
+    // number of vehicles in the nearest vehicle list, at most ADSB_NEAREST_MAX
+    uint8_t get_nearest_count();
+
+    // get the n'th nearest vehicle to us (0 is nearest) as of the last
+    // update(). distance is horizontal, in metres. Returns false if
+    // there are not that many vehicles in the nearest list
+    bool get_nearest(uint8_t n, uint32_t &icao, float &distance, Location &loc);
+
     uint32_t get_special_ICAO_target() const { return (uint32_t)_special_ICAO_target; };
     void set_special_ICAO_target(const uint32_t new_icao_target) { _special_ICAO_target = (int32_t)new_icao_target; };
     bool is_special_vehicle(uint32_t icao) const { return _special_ICAO_target != 0 && (_special_ICAO_target == (int32_t)icao); }
@@ -175,6 +187,9 @@ private:
     // compares current vector against vehicle_list to detect threats
     void determine_furthest_aircraft(void);
 
+    // rebuild the sorted list of vehicles nearest to us
+    void update_nearest(void);
+
     // return index of given vehicle if ICAO_ADDRESS matches. return -1 if no match
     bool find_index(const adsb_vehicle_t &vehicle, uint16_t *index) const;
 
@@ -206,6 +221,13 @@ private:
 
     bool _init_failed;
 
+    // entry in the nearest vehicle list
+    struct nearest_vehicle_t {
+        uint32_t icao;
+        float    distance;  // metres, horizontal
+        Location loc;
+    };
+
     // ADSB-IN state. Maintains list of external vehicles
     struct {
         // list management
@@ -223,6 +245,12 @@ private:
         // streamrate stuff
         uint32_t    send_start_ms[MAVLINK_COMM_NUM_BUFFERS];
         uint16_t    send_index[MAVLINK_COMM_NUM_BUFFERS];
+
+        // vehicles nearest to us, sorted by distance. This is a copy
+        // so it can be read from other threads without the vehicle list
+        nearest_vehicle_t nearest[ADSB_NEAREST_MAX];
+        uint8_t     nearest_count;
+        HAL_Semaphore nearest_sem;
     } in_state;
 
     // ADSB-OUT state. Maintains export data
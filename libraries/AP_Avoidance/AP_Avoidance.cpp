@@ -385,6 +385,66 @@ void AP_Avoidance::update_threat_level(const Location &my_loc,
     }
 }
 
+/*
+  screen an obstacle before the full threat level calculation.
+
+  Relative to us the obstacle moves along p(t) = p0 + dv*t, so the
+  time to closest approach is -p0.dv/|dv|^2, limited to [0,T]. The
+  obstacle can only be a threat if that closest point is within the
+  larger of the warn and fail distances, and if the vertical closest
+  approach, which can't be less than |dz| - |dvz|*T, is within the
+  larger vertical distance. Using the longest horizon makes these
+  lower bounds of what update_threat_level() computes, so an obstacle
+  rejected here would always have been assessed as no threat.
+ */
+bool AP_Avoidance::screen_obstacle(const Location &my_loc,
+                                   const Vector3f &my_vel,
+                                   AP_Avoidance::Obstacle &obstacle) const
+{
+    const Location &obstacle_loc = obstacle._location;
+    const Vector3f &obstacle_vel = obstacle._velocity;
+
+    const uint32_t obstacle_age = AP_HAL::millis() - obstacle.timestamp_ms;
+    const float horizon = MAX(_fail_time_horizon.get(), _warn_time_horizon.get()) + obstacle_age/1000;
+    // pad by a metre so rounding can't reject a boundary case
+    const float radius_xy = MAX(float(_fail_distance_xy.get()), _warn_distance_xy.get()) + 1.0f;
+    const float radius_z = MAX(float(_fail_distance_z.get()), _warn_distance_z.get()) + 1.0f;
+
+    const Vector2f delta_vel_ne = Vector2f(obstacle_vel[0] - my_vel[0], obstacle_vel[1] - my_vel[1]);
+    const Vector2f delta_pos_ne = my_loc.get_distance_NE(obstacle_loc);
+
+    bool reject = obstacle_age > MAX_OBSTACLE_AGE_MS;
+
+    // same units as closest_approach_z()
+    const float delta_vel_d = obstacle_vel[2] - my_vel[2];
+    const float delta_pos_d = obstacle_loc.alt - my_loc.alt;
+    if ((fabsf(delta_pos_d) - fabsf(delta_vel_d) * horizon) * 0.01f > radius_z) {
+        reject = true;
+    }
+
+    // time to closest approach, limited to the horizon
+    const float vel_sq = delta_vel_ne.length_squared();
+    float t_cpa = 0.0f;
+    if (!is_zero(vel_sq)) {
+        t_cpa = constrain_float(-(delta_pos_ne * delta_vel_ne) / vel_sq, 0.0f, horizon);
+    }
+    const float closest_xy = (delta_pos_ne + delta_vel_ne * t_cpa).length();
+    if (closest_xy > radius_xy) {
+        reject = true;
+    }
+
+    if (!reject) {
+        return true;
+    }
+
+    obstacle.threat_level = MAV_COLLISION_THREAT_LEVEL_NONE;
+    obstacle.closest_approach_xy = closest_xy;
+    obstacle.closest_approach_z = closest_approach_z(my_loc, my_vel, obstacle_loc, obstacle_vel, _warn_time_horizon + obstacle_age/1000);
+    obstacle.distance_to_closest_approach = delta_pos_ne.length() - closest_xy;
+    obstacle.time_to_closest_approach = t_cpa;
+    return false;
+}
+
 MAV_COLLISION_THREAT_LEVEL AP_Avoidance::current_threat_level() const {
     if (_obstacles == nullptr) {
         return MAV_COLLISION_THREAT_LEVEL_NONE;
@@ -480,7 +540,9 @@ void AP_Avoidance::check_for_threats()
         const uint32_t obstacle_age = AP_HAL::millis() - obstacle.timestamp_ms;
         debug("i=%d src_id=%d timestamp=%u age=%d", i, obstacle.src_id, obstacle.timestamp_ms, obstacle_age);
 
-        update_threat_level(my_loc, my_vel, obstacle);
+        if (screen_obstacle(my_loc, my_vel, obstacle)) {
+            update_threat_level(my_loc, my_vel, obstacle);
+        }
         debug("   threat-level=%d", obstacle.threat_level);
 
         // ignore any really old data:
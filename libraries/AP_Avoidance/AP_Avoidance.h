@@ -176,6 +176,13 @@ private:
                              const Vector3f &my_vel,
                              AP_Avoidance::Obstacle &obstacle);
 
+    // cheap first pass over an obstacle.  Returns true if the
+    // obstacle may be a threat and needs update_threat_level(),
+    // otherwise marks it as no threat with estimated approach values
+    bool screen_obstacle(const Location &my_loc,
+                         const Vector3f &my_vel,
+                         AP_Avoidance::Obstacle &obstacle) const;
+
     // calls into the AP_ADSB library to retrieve vehicle data
     void get_adsb_samples();
 
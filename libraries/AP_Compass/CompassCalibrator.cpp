@@ -553,26 +553,21 @@ bool CompassCalibrator::accept_sample(const CompassSample& sample, uint16_t skip
     return accept_sample(sample.get(), skip_index);
 }
 
-float CompassCalibrator::calc_residual(const Vector3f& sample, const param_t& params) const
-{
-    Matrix3f softiron(
-        params.diag.x    , params.offdiag.x , params.offdiag.y,
-        params.offdiag.x , params.diag.y    , params.offdiag.z,
-        params.offdiag.y , params.offdiag.z , params.diag.z
-    );
-    return params.radius - (softiron*(sample+params.offset)).length();
-}
-
 // calc the fitness given a set of parameters (offsets, diagonals, off diagonals)
 float CompassCalibrator::calc_mean_squared_residuals(const param_t& params) const
 {
     if (_sample_buffer == nullptr || _samples_collected == 0) {
         return 1.0e30f;
     }
+    const Matrix3f softiron(
+        params.diag.x    , params.offdiag.x , params.offdiag.y,
+        params.offdiag.x , params.diag.y    , params.offdiag.z,
+        params.offdiag.y , params.offdiag.z , params.diag.z
+    );
     float sum = 0.0f;
     for (uint16_t i=0; i < _samples_collected; i++) {
-        Vector3f sample = _sample_buffer[i].get();
-        float resid = calc_residual(sample, params);
+        const Vector3f sample = _sample_buffer[i].get();
+        const float resid = params.radius - (softiron*(sample+params.offset)).length();
         sum += sq(resid);
     }
     sum /= _samples_collected;
@@ -590,28 +585,92 @@ void CompassCalibrator::calc_initial_offset()
     _params.offset /= _samples_collected;
 }
 
-void CompassCalibrator::calc_sphere_jacob(const Vector3f& sample, const param_t& params, float* ret) const
+/*
+  accumulate the Gauss-Newton normal equations J^T*J and J^T*residuals
+  for the sphere (N=4: radius, offsets) or ellipsoid (N=9: offsets,
+  diagonals, off-diagonals) fit.
+
+  Samples are processed in small blocks: the first pass computes the
+  residual and jacobian row of each sample in the block, sharing the
+  soft-iron corrected vector between them, and the second pass
+  accumulates the upper triangle of J^T*J with the samples as the
+  inner loop. The lower triangle is mirrored at the end.
+ */
+template <uint8_t N>
+void CompassCalibrator::calc_normal_equations(const param_t& params, float *JTJ, float *JTFI) const
 {
+    static_assert(N == COMPASS_CAL_NUM_SPHERE_PARAMS || N == COMPASS_CAL_NUM_ELLIPSOID_PARAMS, "invalid number of fit parameters");
+
+    // kept small as this runs on the compass cal thread stack
+    const uint8_t block_size = 8;
+
     const Vector3f &offset = params.offset;
     const Vector3f &diag = params.diag;
     const Vector3f &offdiag = params.offdiag;
-    Matrix3f softiron(
-        diag.x    , offdiag.x , offdiag.y,
-        offdiag.x , diag.y    , offdiag.z,
-        offdiag.y , offdiag.z , diag.z
-    );
 
-    float A =  (diag.x    * (sample.x + offset.x)) + (offdiag.x * (sample.y + offset.y)) + (offdiag.y * (sample.z + offset.z));
-    float B =  (offdiag.x * (sample.x + offset.x)) + (diag.y    * (sample.y + offset.y)) + (offdiag.z * (sample.z + offset.z));
-    float C =  (offdiag.y * (sample.x + offset.x)) + (offdiag.z * (sample.y + offset.y)) + (diag.z    * (sample.z + offset.z));
-    float length = (softiron*(sample+offset)).length();
+    memset(JTJ, 0, N*N*sizeof(float));
+    memset(JTFI, 0, N*sizeof(float));
+
+    float jacob[N][block_size];
+    float resid[block_size];
+
+    for (uint16_t base = 0; base < _samples_collected; base += block_size) {
+        const uint8_t count = MIN(block_size, _samples_collected - base);
 
-    // 0: partial derivative (radius wrt fitness fn) fn operated on sample
-    ret[0] = 1.0f;
-    // 1-3: partial derivative (offsets wrt fitness fn) fn operated on sample
-    ret[1] = -1.0f * (((diag.x    * A) + (offdiag.x * B) + (offdiag.y * C))/length);
-    ret[2] = -1.0f * (((offdiag.x * A) + (diag.y    * B) + (offdiag.z * C))/length);
-    ret[3] = -1.0f * (((offdiag.y * A) + (offdiag.z * B) + (diag.z    * C))/length);
+        for (uint8_t k = 0; k < count; k++) {
+            const Vector3f sample = _sample_buffer[base+k].get() + offset;
+
+            const float A = (diag.x    * sample.x) + (offdiag.x * sample.y) + (offdiag.y * sample.z);
+            const float B = (offdiag.x * sample.x) + (diag.y    * sample.y) + (offdiag.z * sample.z);
+            const float C = (offdiag.y * sample.x) + (offdiag.z * sample.y) + (diag.z    * sample.z);
+            const float length = norm(A, B, C);
+
+            resid[k] = params.radius - length;
+
+            // partial derivatives of the residual wrt each parameter
+            float *ret = &jacob[0][k];
+            if (N == COMPASS_CAL_NUM_SPHERE_PARAMS) {
+                // radius
+                *ret = 1.0f;
+                ret += block_size;
+            }
+            // offsets
+            ret[0*block_size] = -1.0f * (((diag.x    * A) + (offdiag.x * B) + (offdiag.y * C))/length);
+            ret[1*block_size] = -1.0f * (((offdiag.x * A) + (diag.y    * B) + (offdiag.z * C))/length);
+            ret[2*block_size] = -1.0f * (((offdiag.y * A) + (offdiag.z * B) + (diag.z    * C))/length);
+            if (N == COMPASS_CAL_NUM_ELLIPSOID_PARAMS) {
+                // diagonals
+                ret[3*block_size] = -1.0f * (sample.x * A)/length;
+                ret[4*block_size] = -1.0f * (sample.y * B)/length;
+                ret[5*block_size] = -1.0f * (sample.z * C)/length;
+                // off-diagonals
+                ret[6*block_size] = -1.0f * ((sample.y * A) + (sample.x * B))/length;
+                ret[7*block_size] = -1.0f * ((sample.z * A) + (sample.x * C))/length;
+                ret[8*block_size] = -1.0f * ((sample.z * B) + (sample.y * C))/length;
+            }
+        }
+
+        for (uint8_t i = 0; i < N; i++) {
+            for (uint8_t j = i; j < N; j++) {
+                float sum = 0.0f;
+                for (uint8_t k = 0; k < count; k++) {
+                    sum += jacob[i][k] * jacob[j][k];
+                }
+                JTJ[i*N+j] += sum;
+            }
+            float sum = 0.0f;
+            for (uint8_t k = 0; k < count; k++) {
+                sum += jacob[i][k] * resid[k];
+            }
+            JTFI[i] += sum;
+        }
+    }
+
+    for (uint8_t i = 1; i < N; i++) {
+        for (uint8_t j = 0; j < i; j++) {
+            JTJ[i*N+j] = JTJ[j*N+i];
+        }
+    }
 }
 
 // run sphere fit to calculate diagonals and offdiagonals
@@ -629,28 +688,13 @@ void CompassCalibrator::run_sphere_fit()
     param_t fit1_params, fit2_params;
     fit1_params = fit2_params = _params;
 
-    float JTJ[COMPASS_CAL_NUM_SPHERE_PARAMS*COMPASS_CAL_NUM_SPHERE_PARAMS] = { };
-    float JTJ2[COMPASS_CAL_NUM_SPHERE_PARAMS*COMPASS_CAL_NUM_SPHERE_PARAMS] = { };
-    float JTFI[COMPASS_CAL_NUM_SPHERE_PARAMS] = { };
+    float JTJ[COMPASS_CAL_NUM_SPHERE_PARAMS*COMPASS_CAL_NUM_SPHERE_PARAMS];
+    float JTJ2[COMPASS_CAL_NUM_SPHERE_PARAMS*COMPASS_CAL_NUM_SPHERE_PARAMS];
+    float JTFI[COMPASS_CAL_NUM_SPHERE_PARAMS];
 
     // Gauss Newton Part common for all kind of extensions including LM
-    for (uint16_t k = 0; k<_samples_collected; k++) {
-        Vector3f sample = _sample_buffer[k].get();
-
-        float sphere_jacob[COMPASS_CAL_NUM_SPHERE_PARAMS];
-
-        calc_sphere_jacob(sample, fit1_params, sphere_jacob);
-
-        for (uint8_t i = 0;i < COMPASS_CAL_NUM_SPHERE_PARAMS; i++) {
-            // compute JTJ
-            for (uint8_t j = 0; j < COMPASS_CAL_NUM_SPHERE_PARAMS; j++) {
-                JTJ[i*COMPASS_CAL_NUM_SPHERE_PARAMS+j] += sphere_jacob[i] * sphere_jacob[j];
-                JTJ2[i*COMPASS_CAL_NUM_SPHERE_PARAMS+j] += sphere_jacob[i] * sphere_jacob[j];   //a backup JTJ for LM
-            }
-            // compute JTFI
-            JTFI[i] += sphere_jacob[i] * calc_residual(sample, fit1_params);
-        }
-    }
+    calc_normal_equations<COMPASS_CAL_NUM_SPHERE_PARAMS>(fit1_params, JTJ, JTFI);
+    memcpy(JTJ2, JTJ, sizeof(JTJ2));    //a backup JTJ for LM
 
     //------------------------Levenberg-Marquardt-part-starts-here---------------------------------//
     // refer: http://en.wikipedia.org/wiki/Levenberg%E2%80%93Marquardt_algorithm#Choice_of_damping_parameter
@@ -745,28 +789,13 @@ void CompassCalibrator::run_ellipsoid_fit()
     param_t fit1_params, fit2_params;
     fit1_params = fit2_params = _params;
 
-    float JTJ[COMPASS_CAL_NUM_ELLIPSOID_PARAMS*COMPASS_CAL_NUM_ELLIPSOID_PARAMS] = { };
-    float JTJ2[COMPASS_CAL_NUM_ELLIPSOID_PARAMS*COMPASS_CAL_NUM_ELLIPSOID_PARAMS] = { };
-    float JTFI[COMPASS_CAL_NUM_ELLIPSOID_PARAMS] = { };
+    float JTJ[COMPASS_CAL_NUM_ELLIPSOID_PARAMS*COMPASS_CAL_NUM_ELLIPSOID_PARAMS];
+    float JTJ2[COMPASS_CAL_NUM_ELLIPSOID_PARAMS*COMPASS_CAL_NUM_ELLIPSOID_PARAMS];
+    float JTFI[COMPASS_CAL_NUM_ELLIPSOID_PARAMS];
 
     // Gauss Newton Part common for all kind of extensions including LM
-    for (uint16_t k = 0; k<_samples_collected; k++) {
-        Vector3f sample = _sample_buffer[k].get();
-
-        float ellipsoid_jacob[COMPASS_CAL_NUM_ELLIPSOID_PARAMS];
-
-        calc_ellipsoid_jacob(sample, fit1_params, ellipsoid_jacob);
-
-        for (uint8_t i = 0;i < COMPASS_CAL_NUM_ELLIPSOID_PARAMS; i++) {
-            // compute JTJ
-            for (uint8_t j = 0; j < COMPASS_CAL_NUM_ELLIPSOID_PARAMS; j++) {
-                JTJ [i*COMPASS_CAL_NUM_ELLIPSOID_PARAMS+j] += ellipsoid_jacob[i] * ellipsoid_jacob[j];
-                JTJ2[i*COMPASS_CAL_NUM_ELLIPSOID_PARAMS+j] += ellipsoid_jacob[i] * ellipsoid_jacob[j];
-            }
-            // compute JTFI
-            JTFI[i] += ellipsoid_jacob[i] * calc_residual(sample, fit1_params);
-        }
-    }
+    calc_normal_equations<COMPASS_CAL_NUM_ELLIPSOID_PARAMS>(fit1_params, JTJ, JTFI);
+    memcpy(JTJ2, JTJ, sizeof(JTJ2));
 
     //------------------------Levenberg-Marquardt-part-starts-here---------------------------------//
     //refer: http://en.wikipedia.org/wiki/Levenberg%E2%80%93Marquardt_algorithm#Choice_of_damping_parameter
@@ -169,9 +169,6 @@ private:
     // thins out samples between step one and step two
     void thin_samples();
 
-    // calc the fitness of a single sample vs a set of parameters (offsets, diagonals, off diagonals)
-    float calc_residual(const Vector3f& sample, const param_t& params) const;
-
     // calc the fitness of the parameters (offsets, diagonals, off diagonals) vs all the samples collected
     // returns 1.0e30f if the sample buffer is empty
     float calc_mean_squared_residuals(const param_t& params) const;
@@ -179,12 +176,15 @@ private:
     // calculate initial offsets by simply taking the average values of the samples
     void calc_initial_offset();
 
+    // accumulate J^T*J and J^T*residuals over all samples for the
+    // sphere (N=4) or ellipsoid (N=9) parameters
+    template <uint8_t N>
+    void calc_normal_equations(const param_t& params, float *JTJ, float *JTFI) const;
+
     // run sphere fit to calculate diagonals and offdiagonals
-    void calc_sphere_jacob(const Vector3f& sample, const param_t& params, float* ret) const;
     void run_sphere_fit();
 
     // run ellipsoid fit to calculate diagonals and offdiagonals
-    void calc_ellipsoid_jacob(const Vector3f& sample, const param_t& params, float* ret) const;
     void run_ellipsoid_fit();
 
     // update the completion mask based on a single sample
@@ -142,6 +142,12 @@ int32_t AP_Filesystem::write(int fd, const void *buf, uint32_t count)
     return backend.fs.write(fd, buf, count);
 }
 
+int32_t AP_Filesystem::writev(int fd, const ByteBuffer::IoVec *vec, uint8_t count)
+{
+    const Backend &backend = backend_by_fd(fd);
+    return backend.fs.writev(fd, vec, count);
+}
+
 int AP_Filesystem::fsync(int fd)
 {
     const Backend &backend = backend_by_fd(fd);
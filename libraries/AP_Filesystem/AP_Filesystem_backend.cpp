@@ -18,6 +18,26 @@
 
 extern const AP_HAL::HAL& hal;
 
+/*
+  gather write for backends without a native writev(). Stops at the
+  first short write so the caller sees a contiguous byte count
+*/
+int32_t AP_Filesystem_Backend::writev(int fd, const ByteBuffer::IoVec *vec, uint8_t count)
+{
+    int32_t total = 0;
+    for (uint8_t i=0; i<count; i++) {
+        const int32_t ret = write(fd, vec[i].data, vec[i].len);
+        if (ret < 0) {
+            return total > 0 ? total : ret;
+        }
+        total += ret;
+        if (uint32_t(ret) < vec[i].len) {
+            break;
+        }
+    }
+    return total;
+}
+
 /*
   load a full file. Use delete to free the data
 */
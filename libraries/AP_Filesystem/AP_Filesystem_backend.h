@@ -19,6 +19,7 @@
 
 #include <stdint.h>
 #include <AP_HAL/AP_HAL_Boards.h>
+#include <AP_HAL/utility/RingBuffer.h>
 
 #include "AP_Filesystem_Available.h"
 
@@ -49,6 +50,8 @@ public:
     virtual int close(int fd) { return -1; }
     virtual int32_t read(int fd, void *buf, uint32_t count) { return -1; }
     virtual int32_t write(int fd, const void *buf, uint32_t count) { return -1; }
+    // gather write; the default implementation calls write() for each part
+    virtual int32_t writev(int fd, const ByteBuffer::IoVec *vec, uint8_t count);
     virtual int fsync(int fd) { return 0; }
     virtual int32_t lseek(int fd, int32_t offset, int whence) { return -1; }
     virtual int stat(const char *pathname, struct stat *stbuf) { return -1; }
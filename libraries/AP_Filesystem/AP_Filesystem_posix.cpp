@@ -27,6 +27,7 @@
 #include <sys/vfs.h>
 #endif
 #include <utime.h>
+#include <sys/uio.h>
 
 extern const AP_HAL::HAL& hal;
 
@@ -77,6 +78,21 @@ int32_t AP_Filesystem_Posix::write(int fd, const void *buf, uint32_t count)
     return ::write(fd, buf, count);
 }
 
+int32_t AP_Filesystem_Posix::writev(int fd, const ByteBuffer::IoVec *vec, uint8_t count)
+{
+    FS_CHECK_ALLOWED(-1);
+    const uint8_t max_iov = 4;
+    struct iovec iov[max_iov];
+    if (count > max_iov) {
+        return AP_Filesystem_Backend::writev(fd, vec, count);
+    }
+    for (uint8_t i=0; i<count; i++) {
+        iov[i].iov_base = vec[i].data;
+        iov[i].iov_len = vec[i].len;
+    }
+    return ::writev(fd, iov, count);
+}
+
 int AP_Filesystem_Posix::fsync(int fd)
 {
     FS_CHECK_ALLOWED(-1);
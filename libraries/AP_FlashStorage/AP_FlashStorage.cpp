@@ -95,12 +95,14 @@ bool AP_FlashStorage::init(void)
         first_sector = 0;
     }
 
-    // load data from any current sectors
+    // load data from any current sectors, noting which blocks the
+    // in-use sector holds
+    Bitmask<num_blocks> in_use_blocks;
     for (uint8_t i=0; i<2; i++) {
         uint8_t sector = (first_sector + i) & 1;
         if (states[sector] == SECTOR_STATE_IN_USE ||
             states[sector] == SECTOR_STATE_FULL) {
-            if (!load_sector(sector)) {
+            if (!load_sector(sector, states[sector] == SECTOR_STATE_IN_USE ? &in_use_blocks : nullptr)) {
                 return erase_all();
             }
         }
@@ -110,10 +112,16 @@ bool AP_FlashStorage::init(void)
     write_error = false;
     reserved_space = 0;
     
-    // if the first sector is full then write out all data so we can erase it
+    /*
+      if the first sector is full then write out all data the in-use
+      sector doesn't already hold so we can erase it. Compaction may
+      have copied some or all of mem_buffer into the in-use sector
+      before we lost power, and the space reserved in that sector only
+      covers the rest of the copy, not a full write_all()
+     */
     if (states[first_sector] == SECTOR_STATE_FULL) {
         current_sector = first_sector ^ 1;
-        if (!write_all()) {
+        if (!write_missing(in_use_blocks)) {
             return erase_all();
         }
     }
@@ -160,17 +168,107 @@ bool AP_FlashStorage::protected_switch_full_sector(void)
 {
     // clear any write error
     write_error = false;
-    reserved_space = 0;
-    
-    if (!write_all()) {
+
+    // finish copying mem_buffer into the current sector and erase the
+    // full sector if compact_step() hasn't already done so
+    if (reserved_space != 0) {
+        while (compact_offset < storage_size) {
+            if (!compact_chunk()) {
+                return false;
+            }
+        }
+        if (!erase_full_sector()) {
+            return false;
+        }
+    }
+
+    return switch_sectors();
+}
+
+/*
+  background compaction. After a sector switch the other sector is
+  marked full and still holds data that has not been re-written since
+  the switch, so it can't be erased until the current sector holds a
+  complete copy of mem_buffer. Doing that copy and the erase in one go
+  from write() stalls the caller for the whole of write_all() plus a
+  sector erase, so instead we copy a few chunks per call and leave the
+  erase until the copy is done and erasing is allowed. While erasing
+  is not allowed (when armed) only one chunk is copied per call, so a
+  call stalls the flash no longer than a single write.
+ */
+bool AP_FlashStorage::compact_step(uint8_t max_chunks)
+{
+    if (write_error || reserved_space == 0 || in_switch_full_sector) {
+        // nothing to compact
         return false;
     }
+    if (!flash_erase_ok()) {
+        max_chunks = MIN(max_chunks, 1U);
+    }
+    while (max_chunks > 0 && compact_offset < storage_size) {
+        if (!compact_chunk()) {
+            return false;
+        }
+        max_chunks--;
+    }
+    if (compact_offset < storage_size) {
+        return true;
+    }
+    if (!flash_erase_ok()) {
+        // wait until we can erase
+        return true;
+    }
+    if (!erase_full_sector()) {
+        // try again on the next call, writes can still switch
+        // sectors as the full sector erase is retried there too
+        return false;
+    }
+    return false;
+}
 
-    if (!erase_sector(current_sector ^ 1, true)) {
+// amount of space needed to copy the rest of mem_buffer from compact_offset
+uint32_t AP_FlashStorage::compact_reserve(void) const
+{
+    const uint16_t remaining = storage_size - compact_offset;
+    return ((remaining + max_write - 1) / max_write) * (sizeof(block_header) + max_write) + max_write;
+}
+
+/*
+  copy the next chunk of mem_buffer into the current sector. The
+  reserved space is reduced by one chunk before the write so the copy
+  can use the space reserved for it, while other writes are still kept
+  out of the space needed for the rest of the copy
+ */
+bool AP_FlashStorage::compact_chunk(void)
+{
+    const uint16_t ofs = compact_offset;
+    // local variable needed to overcome problem with MIN() macro and -O0
+    const uint8_t max_write_local = max_write;
+    const uint8_t n = MIN(max_write_local, storage_size-ofs);
+
+    compact_offset += n;
+    reserved_space = compact_reserve();
+
+    if (!all_zero(ofs, n) && !write(ofs, n)) {
+        compact_offset = ofs;
+        reserved_space = compact_reserve();
         return false;
     }
+    return true;
+}
 
-    return switch_sectors();
+/*
+  erase the full sector now that the current sector holds all data,
+  making it available for the next switch
+ */
+bool AP_FlashStorage::erase_full_sector(void)
+{
+    debug("erasing full sector %u\n", current_sector ^ 1);
+    if (!erase_sector(current_sector ^ 1, true)) {
+        return false;
+    }
+    reserved_space = 0;
+    return true;
 }
 
 // write some data to virtual EEPROM
@@ -261,7 +359,7 @@ bool AP_FlashStorage::write(uint16_t offset, uint16_t length)
 /*
   load all data from a flash sector into mem_buffer
  */
-bool AP_FlashStorage::load_sector(uint8_t sector)
+bool AP_FlashStorage::load_sector(uint8_t sector, Bitmask<num_blocks> *loaded_blocks)
 {
     uint32_t ofs = sizeof(sector_header);
     while (ofs < flash_sector_size - sizeof(struct block_header)) {
@@ -302,6 +400,11 @@ bool AP_FlashStorage::load_sector(uint8_t sector)
             if (!flash_read(sector, ofs+sizeof(header), &mem_buffer[block_ofs], block_nbytes)) {
                 return false;
             }
+            if (loaded_blocks != nullptr) {
+                for (uint16_t b=0; b<=header.num_blocks_minus_one; b++) {
+                    loaded_blocks->set(header.block_num + b);
+                }
+            }
             //debug("read at %u for %u\n", block_ofs, block_nbytes);
             ofs += block_nbytes + sizeof(header);
             break;
@@ -344,6 +447,7 @@ bool AP_FlashStorage::erase_sector(uint8_t sector, bool mark_available)
 bool AP_FlashStorage::erase_all(void)
 {
     write_error = false;
+    reserved_space = 0;
 
     current_sector = 0;
     write_offset = sizeof(struct sector_header);
@@ -381,6 +485,35 @@ bool AP_FlashStorage::write_all()
     return true;
 }
 
+/*
+  write the chunks of mem_buffer that have non-zero data in blocks
+  not held by the current sector. A chunk copied by compaction has all
+  its blocks held, so this only writes the chunks the copy hadn't
+  reached and fits in the space reserved for the rest of the copy
+ */
+bool AP_FlashStorage::write_missing(const Bitmask<num_blocks> &held_blocks)
+{
+    debug("write_missing to sector %u at %u\n", current_sector, write_offset);
+    for (uint16_t ofs=0; ofs<storage_size; ofs += max_write) {
+        // local variable needed to overcome problem with MIN() macro and -O0
+        const uint8_t max_write_local = max_write;
+        uint8_t n = MIN(max_write_local, storage_size-ofs);
+        bool missing = false;
+        for (uint16_t b=ofs/block_size; b*block_size < ofs+n; b++) {
+            const uint16_t bofs = b*block_size;
+            const uint16_t nbytes = MIN(uint16_t(block_size), uint16_t(storage_size - bofs));
+            if (!held_blocks.get(b) && !all_zero(bofs, nbytes)) {
+                missing = true;
+                break;
+            }
+        }
+        if (missing && !write(ofs, n)) {
+            return false;
+        }
+    }
+    return true;
+}
+
 // return true if all bytes are zero
 bool AP_FlashStorage::all_zero(uint16_t ofs, uint16_t size)
 {
@@ -439,8 +572,10 @@ bool AP_FlashStorage::switch_sectors(void)
     current_sector = new_sector;
         
     // we need to reserve some space in next sector to ensure we can successfully do a
-    // full write out on init()
+    // full write out on init(), and to copy mem_buffer in before the
+    // old sector is erased
     reserved_space = reserve_size;
+    compact_offset = 0;
     
     write_offset = sizeof(header);
     return true;    
@@ -19,8 +19,13 @@
   backend for any HAL. The basic methodology is to use a log based
   storage system over two flash sectors. Key design elements:
 
-  - erase of sectors only called on init, as erase will lock the flash
-    and prevent code execution
+  - erase of sectors only called on init, from compact_step() or when
+    a write can't otherwise proceed, as erase will lock the flash and
+    prevent code execution
+
+  - after a sector switch the live data is copied into the new sector
+    a few blocks at a time by compact_step(), so the full sector can be
+    erased later without a long stall in the write path
 
   - write using log based system
 
@@ -38,6 +43,7 @@
 #pragma once
 
 #include <AP_HAL/AP_HAL.h>
+#include <AP_Common/Bitmask.h>
 
 /*
   we support 3 different types of flash which have different restrictions
@@ -98,7 +104,8 @@ public:
     // caller provided function to read from a flash sector. Only called on init()
     FUNCTOR_TYPEDEF(FlashRead, bool, uint8_t , uint32_t , uint8_t *, uint16_t );
     
-    // caller provided function to erase a flash sector. Only called from init()
+    // caller provided function to erase a flash sector. Called from
+    // init(), compact_step() and when switching a full sector
     FUNCTOR_TYPEDEF(FlashErase, bool, uint8_t );
 
     // caller provided function to indicate if erasing is allowed
@@ -127,6 +134,13 @@ public:
     // offline for considerable periods as an erase will be needed
     bool switch_full_sector(void) WARN_IF_UNUSED;
 
+    // do a bounded amount of background compaction, copying at most
+    // max_chunks chunks of mem_buffer into the current sector, or one
+    // chunk while erasing is not allowed. Once the copy is complete
+    // the full sector is erased if erasing is allowed. Returns true if
+    // there is more compaction to do
+    bool compact_step(uint8_t max_chunks);
+
     // write some data to storage from mem_buffer
     bool write(uint16_t offset, uint16_t length) WARN_IF_UNUSED;
 
@@ -146,6 +160,10 @@ private:
     uint32_t reserved_space;
     bool write_error;
 
+    // offset in mem_buffer of the next chunk to copy into the current
+    // sector while the other sector is full
+    uint16_t compact_offset;
+
     // 24 bit signature
 #if AP_FLASHSTORAGE_TYPE == AP_FLASHSTORAGE_TYPE_F4
     static const uint32_t signature = 0x51685B;
@@ -215,10 +233,20 @@ private:
     };
 
     // amount of space needed to write full storage
-    static const uint32_t reserve_size = (storage_size / max_write) * (sizeof(block_header) + max_write) + max_write;
-        
-    // load data from a sector
-    bool load_sector(uint8_t sector) WARN_IF_UNUSED;
+    static const uint32_t reserve_size = ((storage_size + max_write - 1) / max_write) * (sizeof(block_header) + max_write) + max_write;
+
+    // amount of space needed to copy the rest of mem_buffer from
+    // compact_offset
+    uint32_t compact_reserve(void) const;
+
+    // copy the next chunk of mem_buffer into the current sector
+    bool compact_chunk(void) WARN_IF_UNUSED;
+
+    // erase the full sector once the current sector holds all data
+    bool erase_full_sector(void) WARN_IF_UNUSED;
+
+    // load data from a sector, optionally marking the blocks it holds
+    bool load_sector(uint8_t sector, Bitmask<num_blocks> *loaded_blocks=nullptr) WARN_IF_UNUSED;
 
     // erase a sector and write header
     bool erase_sector(uint8_t sector, bool mark_available) WARN_IF_UNUSED;
@@ -229,6 +257,10 @@ private:
     // write all of mem_buffer to current sector
     bool write_all() WARN_IF_UNUSED;
 
+    // write the chunks of mem_buffer with data in blocks not already
+    // held by the current sector
+    bool write_missing(const Bitmask<num_blocks> &held_blocks) WARN_IF_UNUSED;
+
     // return true if all bytes are zero
     bool all_zero(uint16_t ofs, uint16_t size) WARN_IF_UNUSED;
 
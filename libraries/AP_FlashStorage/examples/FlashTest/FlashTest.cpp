@@ -19,6 +19,13 @@ public:
 private:
     static const uint32_t flash_sector_size = 32U * 1024U;
 
+    /*
+      simulated flash timing, roughly that of a STM32F4 programming
+      32 bits at a time, with the MCU stalled during a sector erase
+     */
+    static const uint32_t flash_write_us_per_byte = 4;
+    static const uint32_t flash_erase_us = 400000;
+
     uint8_t mem_buffer[AP_FlashStorage::storage_size];
     uint8_t mem_mirror[AP_FlashStorage::storage_size];
 
@@ -40,7 +47,41 @@ private:
     // write to storage and mem_mirror
     void write(uint16_t offset, const uint8_t *data, uint16_t length);
 
+    // write random data at a random offset
+    void random_write(void);
+
+    // run a step of background compaction, returning true if there is more to do
+    bool compact(void);
+
+    // lines holding writes that failed, kept to retry as the HAL storage does
+    static const uint16_t line_size = 32;
+    Bitmask<AP_FlashStorage::storage_size / line_size> failed_lines;
+
+    // print simulated worst case latency
+    void print_latency(void);
+
+    // re-init with the full sector not yet erased
+    void test_init_pending_erase(bool copy_done);
+
     bool erase_ok;
+
+    // simulated time spent in flash operations
+    uint64_t flash_time_us;
+    uint32_t erase_count;
+
+    // worst case simulated latency of calls into storage
+    struct latency {
+        uint32_t calls;
+        uint32_t worst_us;
+        void update(uint32_t dt_us) {
+            calls++;
+            worst_us = MAX(worst_us, dt_us);
+        }
+    };
+    latency write_latency;
+    latency write_erase_latency;
+    latency compact_latency;
+    latency compact_erase_latency;
 };
 
 bool FlashTest::flash_write(uint8_t sector, uint32_t offset, const uint8_t *data, uint16_t length)
@@ -84,6 +125,7 @@ bool FlashTest::flash_write(uint8_t sector, uint32_t offset, const uint8_t *data
         v2 &= v;
         put_le16_ptr(&b[i*2], v2);
     }
+    flash_time_us += length * flash_write_us_per_byte;
     return true;
 }
 
@@ -108,6 +150,8 @@ bool FlashTest::flash_erase(uint8_t sector)
         AP_HAL::panic("FATAL: erase sector %u\n", (unsigned)sector);
     }
     memset(&flash[sector][0], 0xFF, flash_sector_size);
+    flash_time_us += flash_erase_us;
+    erase_count++;
     return true;
 }
 
@@ -120,10 +164,121 @@ void FlashTest::write(uint16_t offset, const uint8_t *data, uint16_t length)
 {
     memcpy(&mem_mirror[offset], data, length);
     memcpy(&mem_buffer[offset], data, length);
+    const uint64_t t0 = flash_time_us;
+    const uint32_t erases = erase_count;
     if (!storage.write(offset, length)) {
         if (erase_ok) {
             printf("Failed to write at %u for %u\n", offset, length);
         }
+        for (uint16_t line = offset / line_size; line <= (offset + length - 1) / line_size; line++) {
+            failed_lines.set(line);
+        }
+    }
+    if (erase_count != erases) {
+        write_erase_latency.update(flash_time_us - t0);
+    } else {
+        write_latency.update(flash_time_us - t0);
+    }
+}
+
+/*
+  run one step of background compaction as the HAL storage tick does,
+  which retries a failed write instead while there are any
+ */
+bool FlashTest::compact(void)
+{
+    const int16_t line = failed_lines.first_set();
+    if (line != -1) {
+        const uint64_t t0 = flash_time_us;
+        const uint32_t erases = erase_count;
+        if (storage.write(line * line_size, line_size)) {
+            failed_lines.clear(line);
+        }
+        if (erase_count != erases) {
+            write_erase_latency.update(flash_time_us - t0);
+        } else {
+            write_latency.update(flash_time_us - t0);
+        }
+        return true;
+    }
+
+    const uint64_t t0 = flash_time_us;
+    const uint32_t erases = erase_count;
+    const bool ret = storage.compact_step(4);
+    if (erase_count != erases) {
+        compact_erase_latency.update(flash_time_us - t0);
+    } else {
+        compact_latency.update(flash_time_us - t0);
+    }
+    return ret;
+}
+
+void FlashTest::random_write(void)
+{
+    uint16_t ofs = get_random16() % sizeof(mem_buffer);
+    uint16_t length = get_random16() & 0x1F;
+    length = MIN(length, sizeof(mem_buffer) - ofs);
+    uint8_t data[length];
+    for (uint8_t j=0; j<length; j++) {
+        data[j] = get_random16() & 0xFF;
+    }
+    write(ofs, data, length);
+}
+
+void FlashTest::print_latency(void)
+{
+    hal.console->printf("write: %u calls worst %uus, %u with erase worst %uus\n",
+                        (unsigned)write_latency.calls, (unsigned)write_latency.worst_us,
+                        (unsigned)write_erase_latency.calls, (unsigned)write_erase_latency.worst_us);
+    hal.console->printf("compact: %u steps worst %uus, %u with erase worst %uus\n",
+                        (unsigned)compact_latency.calls, (unsigned)compact_latency.worst_us,
+                        (unsigned)compact_erase_latency.calls, (unsigned)compact_erase_latency.worst_us);
+}
+
+/*
+  fill the in-use sector while erase is not allowed, with compaction
+  either part way through or with the copy done, then check init()
+  recovers all data without erasing both sectors
+ */
+void FlashTest::test_init_pending_erase(bool copy_done)
+{
+    // write until a sector switch leaves a full sector to compact
+    erase_ok = true;
+    while (!storage.compact_step(0)) {
+        random_write();
+    }
+
+    erase_ok = false;
+    const uint16_t steps = copy_done ? AP_FlashStorage::storage_size / 16 : AP_FlashStorage::storage_size / 512;
+    for (uint16_t i=0; i<steps; i++) {
+        compact();
+    }
+
+    // fill the sector with single byte writes until one fails. The
+    // caller keeps a failed write to retry, so it is undone here
+    while (true) {
+        const uint16_t ofs = get_random16() % sizeof(mem_buffer);
+        const uint8_t old_value = mem_buffer[ofs];
+        const uint8_t value = get_random16() & 0xFF;
+        mem_buffer[ofs] = value;
+        if (!storage.write(ofs, 1)) {
+            mem_buffer[ofs] = old_value;
+            break;
+        }
+        mem_mirror[ofs] = value;
+    }
+
+    // init() leaves the loaded data in mem_buffer even if it has to
+    // erase both sectors, so init twice to check what is in flash
+    for (uint8_t i=0; i<2; i++) {
+        memset(mem_buffer, 0, sizeof(mem_buffer));
+        if (!storage.init()) {
+            AP_HAL::panic("Failed init() with erase pending");
+        }
+        if (memcmp(mem_buffer, mem_mirror, sizeof(mem_buffer)) != 0) {
+            AP_HAL::panic("FATAL: data mis-match after init with %s",
+                          copy_done ? "copy done" : "copy part done");
+        }
     }
 }
 
@@ -148,16 +303,9 @@ void FlashTest::loop(void)
 
     // fill with 10k random writes
     for (uint32_t i=0; i<5000000; i++) {
-        uint16_t ofs = get_random16() % sizeof(mem_buffer);
-        uint16_t length = get_random16() & 0x1F;
-        length = MIN(length, sizeof(mem_buffer) - ofs);
-        uint8_t data[length];
-        for (uint8_t j=0; j<length; j++) {
-            data[j] = get_random16() & 0xFF;
-        }
-
         erase_ok = (i % 1000 == 0);
-        write(ofs, data, length);
+        random_write();
+        compact();
 
         if (erase_ok) {
             if (memcmp(mem_buffer, mem_mirror, sizeof(mem_buffer)) != 0) {
@@ -170,6 +318,11 @@ void FlashTest::loop(void)
     erase_ok = true;
     uint8_t b = 42;
     write(37, &b, 1);
+
+    // writes that failed while erase was not allowed are only in
+    // mem_buffer until compaction copies them into the new sector
+    while (compact()) {
+    }
     
     if (memcmp(mem_buffer, mem_mirror, sizeof(mem_buffer)) != 0) {
         AP_HAL::panic("FATAL: data mis-match before re-init");
@@ -185,6 +338,47 @@ void FlashTest::loop(void)
     if (memcmp(mem_buffer, mem_mirror, sizeof(mem_buffer)) != 0) {
         AP_HAL::panic("FATAL: data mis-match");
     }
+
+    /*
+      measure simulated worst case time spent in flash per call with
+      erase allowed, as when disarmed, and a compaction step after
+      each write as the HAL storage tick does when idle
+     */
+    write_latency = {};
+    write_erase_latency = {};
+    compact_latency = {};
+    compact_erase_latency = {};
+    for (uint32_t i=0; i<200000; i++) {
+        random_write();
+        compact();
+    }
+    print_latency();
+
+    /*
+      and with erase not allowed, as when armed, where a compaction
+      step copies a single chunk
+     */
+    erase_ok = false;
+    write_latency = {};
+    write_erase_latency = {};
+    compact_latency = {};
+    compact_erase_latency = {};
+    for (uint32_t i=0; i<200000; i++) {
+        random_write();
+        compact();
+    }
+    print_latency();
+    erase_ok = true;
+    while (compact()) {
+    }
+
+    if (memcmp(mem_buffer, mem_mirror, sizeof(mem_buffer)) != 0) {
+        AP_HAL::panic("FATAL: data mis-match after timing");
+    }
+
+    test_init_pending_erase(false);
+    test_init_pending_erase(true);
+
     while (true) {
         hal.console->printf("TEST PASSED");
         hal.scheduler->delay(20000);
@@ -416,15 +416,32 @@ uint16_t AP_GyroFFT::run_cycle()
         return 0;
     }
 
+    // analyse every axis that has a full window available in one wakeup rather
+    // than sleeping between axes, the gyro windows fill at the same rate so the
+    // axes are usually ready together
+    uint16_t remaining_samples = 0;
+    for (uint8_t i = 0; i < XYZ_AXIS_COUNT; i++) {
+        if (!run_axis_cycle(remaining_samples)) {
+            break;
+        }
+    }
+    return remaining_samples;
+}
+
+// run a single FFT cycle on the current axis
+// returns false if there were insufficient samples to run the cycle
+bool AP_GyroFFT::run_axis_cycle(uint16_t &remaining_samples)
+{
     if (!_sem.take(HAL_SEMAPHORE_BLOCK_FOREVER)) {
-        return 0;
+        remaining_samples = 0;
+        return false;
     }
 
     // do we have enough samples for another pass?
     if (!start_analysis()) {
-        uint16_t new_sample_count =  get_available_samples(_update_axis);
+        remaining_samples = get_available_samples(_update_axis);
         _sem.give();
-        return new_sample_count;
+        return false;
     }
 
     // take a copy of the config inside the semaphore
@@ -464,7 +481,8 @@ uint16_t AP_GyroFFT::run_cycle()
     _thread_state._analysis_started = false;
 
     // samples remaining in the next axis
-    return get_available_samples(_update_axis);
+    remaining_samples = get_available_samples(_update_axis);
+    return true;
 }
 
 // whether analysis can be run again or not
@@ -0,0 +1,45 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Math/AP_Math.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if HAL_WITH_DSP
+/*
+  time a single axis FFT cycle of the given window size, as run by
+  AP_GyroFFT on each axis, on a 1kHz gyro with a 120Hz motor noise
+  peak and half window overlap
+ */
+static const uint16_t sample_rate_hz = 1000;
+static const float noise_freq_hz = 120;
+
+static void BM_FFTCycle(benchmark::State& state)
+{
+    const uint16_t window_size = state.range(0);
+    AP_HAL::DSP::FFTWindowState* fft = hal.dsp->fft_init(window_size, sample_rate_hz, 0);
+    if (fft == nullptr) {
+        state.SkipWithError("fft_init failed");
+        return;
+    }
+    FloatBuffer samples(window_size * 2);
+    const uint16_t start_bin = 1;
+    const uint16_t end_bin = window_size / 2 - 1;
+
+    uint32_t n = 0;
+    while (state.KeepRunning()) {
+        while (samples.available() < window_size) {
+            samples.push(sinf(2 * M_PI * noise_freq_hz * n++ / sample_rate_hz));
+        }
+        hal.dsp->fft_start(fft, samples, window_size / 2);
+        uint16_t peak_bin = hal.dsp->fft_analyse(fft, start_bin, end_bin, 0.5f);
+        gbenchmark_escape(&peak_bin);
+    }
+
+    delete fft;
+}
+
+BENCHMARK(BM_FFTCycle)->RangeMultiplier(2)->Range(32, 512);
+#endif
+
+BENCHMARK_MAIN();
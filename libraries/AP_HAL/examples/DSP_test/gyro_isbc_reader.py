@@ -0,0 +1,110 @@
+#!/usr/bin/env python
+
+'''
+extract ISBC messages from AP_Logging files and produce C++ arrays for consumption by the DSP subsystem
+'''
+from __future__ import print_function
+
+import sys
+import struct
+import numpy
+
+from argparse import ArgumentParser
+
+parser = ArgumentParser(description=__doc__)
+parser.add_argument("--condition", default=None, help="select packets by condition")
+parser.add_argument("--instance", type=int, default=0, help="IMU instance to extract")
+parser.add_argument("--frame-size", type=int, default=1024, help="number of samples in each frame")
+parser.add_argument("logs", metavar="LOG", nargs="+")
+
+args = parser.parse_args()
+
+from pymavlink import mavutil
+
+
+def isbc_decode(m):
+    '''return the list of (x, y, z) samples in an ISBC message, each multiplied by mul'''
+    data = struct.pack("<32h", *m.D0) + struct.pack("<32h", *m.D1) + struct.pack("<32h", *m.D2)
+    data = bytearray(data[:m.len])
+    last = [0, 0, 0]
+    samples = []
+    pos = 0
+    for i in range(m.cnt):
+        for axis in range(3):
+            # little-endian base-128 varint
+            zigzag = 0
+            shift = 0
+            while True:
+                if pos >= len(data):
+                    raise ValueError("ISBC(%u) ran out of data after %u samples" % (m.N, i))
+                b = data[pos]
+                pos += 1
+                zigzag |= (b & 0x7f) << shift
+                shift += 7
+                if b < 0x80:
+                    break
+            delta = (zigzag >> 1) ^ -(zigzag & 1)
+            # the deltas are taken modulo 2^16
+            last[axis] = ((last[axis] + delta + 0x8000) & 0xffff) - 0x8000
+        samples.append(tuple(last))
+    if pos != len(data):
+        raise ValueError("ISBC(%u) has %u bytes left over" % (m.N, len(data) - pos))
+    return samples
+
+
+def isbc_parser(logfile):
+    '''extract the gyro stream of one IMU from logfile'''
+    mlog = mavutil.mavlink_connection(logfile)
+
+    frames = []
+    frame = {"X": [], "Y": [], "Z": []}
+    seqno = None
+    sample_rate = None
+    msgcount = 0
+    gaps = 0
+    while True:
+        m = mlog.recv_match(type="ISBC", condition=args.condition)
+        if m is None:
+            break
+        if m.type != 1 or m.I != args.instance:
+            continue
+        msgcount += 1
+        if msgcount % 1000 == 0:
+            sys.stderr.write(".")
+        if seqno is not None and m.N != (seqno + 1) & 0xffff:
+            # a frame must not span dropped messages
+            print("ISBC(%u) follows ISBC(%u), dropping partial frame" % (m.N, seqno), file=sys.stderr)
+            frame = {"X": [], "Y": [], "Z": []}
+            gaps += 1
+        seqno = m.N
+        if sample_rate is None:
+            sample_rate = m.smp_rate
+        for (x, y, z) in isbc_decode(m):
+            frame["X"].append(x)
+            frame["Y"].append(y)
+            frame["Z"].append(z)
+            if len(frame["X"]) == args.frame_size:
+                frames.append(frame)
+                frame = {"X": [], "Y": [], "Z": []}
+
+    print("", file=sys.stderr)
+    print("Extracted %u frames from %u messages with %u gaps" % (len(frames), msgcount, gaps), file=sys.stderr)
+    if sample_rate is None:
+        print("No ISBC gyro data for instance %u" % args.instance, file=sys.stderr)
+        return
+
+    print("#include \"GyroFrame.h\"")
+    print("const uint32_t NUM_FRAMES = %d;" % len(frames))
+    print("const GyroFrame gyro_frames[] = {")
+    for frame in frames:
+        print("    {")
+        for axis in ["X", "Y", "Z"]:
+            d = numpy.array(frame[axis])
+            print("        { " + ", ".join(d.astype(numpy.dtype(str))) + " },")
+        print("    },")
+    print("};")
+    print("const uint16_t SAMPLE_RATE = %d;" % sample_rate)
+
+
+for filename in args.logs:
+    isbc_parser(filename)
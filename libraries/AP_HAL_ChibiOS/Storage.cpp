@@ -47,6 +47,12 @@ extern const AP_HAL::HAL& hal;
 
 #define STORAGE_FLASH_RETRIES 5
 
+// number of chunks of flash compaction to do per idle storage tick
+// while disarmed, AP_FlashStorage copies only one when armed
+#ifndef STORAGE_FLASH_COMPACT_CHUNKS
+#define STORAGE_FLASH_COMPACT_CHUNKS 4
+#endif
+
 // by default don't allow fallback to sdcard for storage
 #ifndef HAL_RAMTRON_ALLOW_FALLBACK
 #define HAL_RAMTRON_ALLOW_FALLBACK 0
@@ -251,6 +257,13 @@ void Storage::_timer_tick(void)
     }
     if (_dirty_mask.empty()) {
         _last_empty_ms = AP_HAL::millis();
+#ifdef STORAGE_FLASH_PAGE
+        if (_initialisedType == StorageBackend::Flash) {
+            // use idle ticks to compact flash so a sector switch
+            // doesn't need a full copy and erase in the write path
+            _flash.compact_step(STORAGE_FLASH_COMPACT_CHUNKS);
+        }
+#endif
         return;
     }
 
@@ -92,6 +92,8 @@ void Storage::_timer_tick(void)
     }
     if (_dirty_mask.empty()) {
         _last_empty_ms = AP_HAL::millis();
+        // use idle ticks to compact flash
+        _flash.compact_step(4);
         return;
     }
 
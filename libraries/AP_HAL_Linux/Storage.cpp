@@ -3,12 +3,15 @@
 #include <assert.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <limits.h>
 #include <stdio.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
 
 #include <AP_HAL/AP_HAL.h>
+#include <AP_Common/ExpandingString.h>
+#include <AP_Math/AP_Math.h>
 #include <AP_Vehicle/AP_Vehicle_Type.h>
 
 using namespace Linux;
@@ -16,11 +19,24 @@ using namespace Linux;
 /*
   This stores 'eeprom' data on the SD card, with a 4k size, and a
   in-memory buffer. This keeps the latency down.
+
+  Changes are not written in place. Dirty lines are collected for
+  LINUX_STORAGE_FLUSH_DELAY_MS and then appended to a journal with a
+  single write and sync. Once there have been no flushes for
+  LINUX_STORAGE_COMPACT_IDLE_MS, or the journal reaches
+  LINUX_STORAGE_JOURNAL_MAX, the whole buffer is written to the storage
+  file and the journal is emptied. On startup the journal is replayed
+  on top of the storage file up to the first incomplete entry and then
+  compacted, so a power loss at any point loses at most the last flush
+  and the journal does not grow across reboots.
  */
 
 // name the storage file after the sketch so you can use the same board
 // card for ArduCopter and ArduPlane
 #define STORAGE_FILE SKETCHNAME ".stg"
+#define STORAGE_JOURNAL_FILE STORAGE_FILE ".jnl"
+
+#define STORAGE_JOURNAL_MAGIC 0x4a53
 
 extern const AP_HAL::HAL& hal;
 
@@ -141,7 +157,7 @@ void Storage::init()
         return;
     }
 
-    _dirty_mask = 0;
+    _dirty_mask.clearall();
 
     dpath = hal.util->get_custom_storage_directory();
     if (!dpath) {
@@ -171,26 +187,84 @@ void Storage::init()
     }
 
     _fd = fd;
+
+    // apply the changes made since the journal was last compacted
+    _journal_fd = _journal_open(dpath);
+    if (_journal_fd == -1) {
+        AP_HAL::panic("Failed to open storage journal in %s (%m)", dpath);
+    }
+    if (_journal_size != 0) {
+        _compact();
+    }
+
     _initialised = true;
 }
 
 /*
-  mark some lines as dirty. Note that there is no attempt to avoid
-  the race condition between this code and the _timer_tick() code
-  below, which both update _dirty_mask. If we lose the race then the
-  result is that a line is written more than once, but it won't result
-  in a line not being written.
+  open the journal and replay it into the buffer, truncating any
+  partially written entry at the end
+ */
+int Storage::_journal_open(const char *dpath)
+{
+    char path[PATH_MAX];
+    if (is_dir(dpath) > 0) {
+        snprintf(path, sizeof(path), "%s/%s", dpath, STORAGE_JOURNAL_FILE);
+    } else {
+        snprintf(path, sizeof(path), "%s.jnl", dpath);
+    }
+
+    int fd = open(path, O_RDWR|O_CREAT|O_APPEND|O_CLOEXEC, 0666);
+    if (fd == -1) {
+        return -1;
+    }
+
+    uint32_t ofs = 0;
+    journal_header hdr;
+    while (read(fd, &hdr, sizeof(hdr)) == sizeof(hdr)) {
+        if (hdr.magic != STORAGE_JOURNAL_MAGIC ||
+            hdr.length == 0 || hdr.length > sizeof(_journal_buffer) ||
+            hdr.offset + hdr.length > sizeof(_buffer)) {
+            break;
+        }
+        if (read(fd, _journal_buffer, hdr.length) != hdr.length ||
+            _journal_crc(hdr, _journal_buffer) != hdr.crc) {
+            break;
+        }
+        memcpy(&_buffer[hdr.offset], _journal_buffer, hdr.length);
+        ofs += sizeof(hdr) + hdr.length;
+    }
+
+    if (ftruncate(fd, ofs) == -1) {
+        close(fd);
+        return -1;
+    }
+    _journal_size = ofs;
+
+    return fd;
+}
+
+uint16_t Storage::_journal_crc(const journal_header &hdr, const uint8_t *data) const
+{
+    const uint16_t crc = crc16_ccitt((const uint8_t *)&hdr.offset, sizeof(hdr.offset) + sizeof(hdr.length), 0);
+    return crc16_ccitt(data, hdr.length, crc);
+}
+
+/*
+  mark some lines as dirty, called with the semaphore held
  */
 void Storage::_mark_dirty(uint16_t loc, uint16_t length)
 {
     if (length == 0) {
         return;
     }
+    if (_dirty_mask.empty()) {
+        _first_dirty_ms = AP_HAL::millis();
+    }
     uint16_t end = loc + length - 1;
-    for (uint8_t line=loc>>LINUX_STORAGE_LINE_SHIFT;
+    for (uint16_t line=loc>>LINUX_STORAGE_LINE_SHIFT;
          line <= end>>LINUX_STORAGE_LINE_SHIFT;
          line++) {
-        _dirty_mask |= 1U << line;
+        _dirty_mask.set(line);
     }
 }
 
@@ -210,6 +284,7 @@ void Storage::write_block(uint16_t loc, const void *src, size_t n)
     }
     if (memcmp(src, &_buffer[loc], n) != 0) {
         init();
+        WITH_SEMAPHORE(_sem);
         memcpy(&_buffer[loc], src, n);
         _mark_dirty(loc, n);
     }
@@ -217,54 +292,138 @@ void Storage::write_block(uint16_t loc, const void *src, size_t n)
 
 void Storage::_timer_tick(void)
 {
-    if (!_initialised || _dirty_mask == 0 || _fd == -1) {
+    if (!_initialised || _fd == -1 || _journal_fd == -1) {
         return;
     }
 
-    // write out the first dirty set of lines. We don't write more
-    // than one to keep the latency of this call to a minimum
-    uint8_t i, n;
-    for (i=0; i<LINUX_STORAGE_NUM_LINES; i++) {
-        if (_dirty_mask & (1<<i)) {
-            break;
+    if (_dirty_mask.empty()) {
+        // only compact when there is nothing waiting to be flushed,
+        // and while writes are still coming in only once the journal
+        // is full
+        if (_journal_size != 0 &&
+            (_journal_size >= LINUX_STORAGE_JOURNAL_MAX ||
+             AP_HAL::millis() - _last_flush_ms >= LINUX_STORAGE_COMPACT_IDLE_MS)) {
+            _compact();
         }
-    }
-    if (i == LINUX_STORAGE_NUM_LINES) {
-        // this shouldn't be possible
         return;
     }
-    uint32_t write_mask = (1U<<i);
-    // see how many lines to write
-    for (n=1; (i+n) < LINUX_STORAGE_NUM_LINES &&
-             n < (LINUX_STORAGE_MAX_WRITE>>LINUX_STORAGE_LINE_SHIFT); n++) {
-        if (!(_dirty_mask & (1<<(n+i)))) {
-            break;
-        }
-        // mark that line clean
-        write_mask |= (1<<(n+i));
+
+    // let writes to the same lines coalesce before flushing them
+    if (AP_HAL::millis() - _first_dirty_ms < LINUX_STORAGE_FLUSH_DELAY_MS) {
+        return;
     }
 
-    /*
-      write the lines. This also updates _dirty_mask. Note that
-      because this is a SCHED_FIFO thread it will not be preempted
-      by the main task except during blocking calls. This means we
-      don't need a semaphore around the _dirty_mask updates.
-     */
-    if (lseek(_fd, i<<LINUX_STORAGE_LINE_SHIFT, SEEK_SET) == (i<<LINUX_STORAGE_LINE_SHIFT)) {
-        _dirty_mask &= ~write_mask;
-        if (write(_fd, &_buffer[i<<LINUX_STORAGE_LINE_SHIFT], n<<LINUX_STORAGE_LINE_SHIFT) != n<<LINUX_STORAGE_LINE_SHIFT) {
-            // write error - likely EINTR
-            _dirty_mask |= write_mask;
-            close(_fd);
-            _fd = -1;
-        }
-        if (_dirty_mask == 0) {
-            if (fsync(_fd) != 0) {
-                close(_fd);
-                _fd = -1;
+    _flush();
+}
+
+/*
+  append runs of dirty lines to the journal with a single write and
+  sync. Lines which don't fit are left dirty for the next flush
+ */
+void Storage::_flush(void)
+{
+    const uint32_t start_us = AP_HAL::micros();
+
+    uint16_t length = 0;
+    {
+        // the lines are marked clean as they are copied with the
+        // semaphore held, so any later change dirties them again
+        WITH_SEMAPHORE(_sem);
+        uint16_t line = 0;
+        while (line < LINUX_STORAGE_NUM_LINES) {
+            if (!_dirty_mask.get(line)) {
+                line++;
+                continue;
+            }
+            const uint16_t space = sizeof(_journal_buffer) - length;
+            if (space < sizeof(journal_header) + LINUX_STORAGE_LINE_SIZE) {
+                break;
             }
+            uint16_t n = 0;
+            while (line + n < LINUX_STORAGE_NUM_LINES && _dirty_mask.get(line + n) &&
+                   sizeof(journal_header) + ((n + 1) << LINUX_STORAGE_LINE_SHIFT) <= space) {
+                _dirty_mask.clear(line + n);
+                n++;
+            }
+            journal_header hdr;
+            hdr.magic = STORAGE_JOURNAL_MAGIC;
+            hdr.offset = line << LINUX_STORAGE_LINE_SHIFT;
+            hdr.length = n << LINUX_STORAGE_LINE_SHIFT;
+            hdr.crc = _journal_crc(hdr, &_buffer[hdr.offset]);
+            memcpy(&_journal_buffer[length], &hdr, sizeof(hdr));
+            memcpy(&_journal_buffer[length + sizeof(hdr)], &_buffer[hdr.offset], hdr.length);
+            length += sizeof(hdr) + hdr.length;
+            line += n;
+        }
+        if (!_dirty_mask.empty()) {
+            // flush the rest straight away
+            _first_dirty_ms = AP_HAL::millis() - LINUX_STORAGE_FLUSH_DELAY_MS;
         }
     }
+
+    if (write(_journal_fd, _journal_buffer, length) != length ||
+        fdatasync(_journal_fd) != 0) {
+        // write error - likely EINTR
+        _write_failed();
+        return;
+    }
+    _journal_size += length;
+    _last_flush_ms = AP_HAL::millis();
+
+    const uint32_t dt = AP_HAL::micros() - start_us;
+    _stats.flushes++;
+    _stats.bytes_written += length;
+    _stats.last_flush_us = dt;
+    _stats.max_flush_us = MAX(_stats.max_flush_us, dt);
+}
+
+/*
+  write the whole buffer to the storage file and empty the journal. The
+  journal is only emptied once the storage file has been synced, and
+  replaying it over a partly written storage file gives the same
+  result, so this is safe against power loss
+ */
+void Storage::_compact(void)
+{
+    bool ok;
+    {
+        // hold the semaphore so the file gets a consistent copy of
+        // each line. The write only reaches the page cache, so this
+        // does not hold up writers for long; the sync is done after
+        // releasing it
+        WITH_SEMAPHORE(_sem);
+        ok = pwrite(_fd, _buffer, sizeof(_buffer), 0) == sizeof(_buffer);
+    }
+    if (!ok ||
+        fsync(_fd) != 0 ||
+        ftruncate(_journal_fd, 0) != 0 ||
+        fsync(_journal_fd) != 0) {
+        _write_failed();
+        return;
+    }
+    _journal_size = 0;
+    _stats.compactions++;
+    _stats.bytes_written += sizeof(_buffer);
+}
+
+/*
+  stop writing after an error. Storage carries on working from memory
+ */
+void Storage::_write_failed(void)
+{
+    close(_journal_fd);
+    _journal_fd = -1;
+    close(_fd);
+    _fd = -1;
+}
+
+void Storage::storage_info(ExpandingString &str)
+{
+    str.printf("Journal: %u bytes\n", unsigned(_journal_size));
+    str.printf("Flushes: %u\n", unsigned(_stats.flushes));
+    str.printf("Compactions: %u\n", unsigned(_stats.compactions));
+    str.printf("Written: %u bytes\n", unsigned(_stats.bytes_written));
+    str.printf("Flush time: %uus (max %uus)\n", unsigned(_stats.last_flush_us), unsigned(_stats.max_flush_us));
 }
 
 /*
@@ -1,19 +1,37 @@
 #pragma once
 
 #include <AP_HAL/AP_HAL.h>
+#include <AP_Common/AP_Common.h>
+#include <AP_Common/Bitmask.h>
 
 #define LINUX_STORAGE_SIZE HAL_STORAGE_SIZE
-#define LINUX_STORAGE_MAX_WRITE 512
-#define LINUX_STORAGE_LINE_SHIFT 9
+// most bytes appended to the journal in one flush
+#define LINUX_STORAGE_MAX_WRITE 4096
+#define LINUX_STORAGE_LINE_SHIFT 6
 #define LINUX_STORAGE_LINE_SIZE (1<<LINUX_STORAGE_LINE_SHIFT)
 #define LINUX_STORAGE_NUM_LINES (LINUX_STORAGE_SIZE/LINUX_STORAGE_LINE_SIZE)
+// time to let writes accumulate before flushing them
+#define LINUX_STORAGE_FLUSH_DELAY_MS 100
+// time without flushes after which the journal is compacted into the
+// storage file
+#define LINUX_STORAGE_COMPACT_IDLE_MS 5000
+// journal size at which it is compacted even if writes are still going on
+#define LINUX_STORAGE_JOURNAL_MAX (4*LINUX_STORAGE_SIZE)
+
+static_assert(LINUX_STORAGE_SIZE % LINUX_STORAGE_LINE_SIZE == 0,
+              "Storage is not multiple of line size");
 
 namespace Linux {
 
+/*
+  storage is held in memory and written out as an append-only journal
+  of changed lines, which is periodically compacted into the storage
+  file
+ */
 class Storage : public AP_HAL::Storage
 {
 public:
-    Storage() : _fd(-1),_dirty_mask(0) { }
+    Storage() : _fd(-1), _journal_fd(-1) { }
 
     static Storage *from(AP_HAL::Storage *storage) {
         return static_cast<Storage*>(storage);
@@ -36,14 +54,45 @@ public:
 
     virtual void _timer_tick(void) override;
 
+    void storage_info(ExpandingString &str) override;
+
+    struct Stats {
+        uint32_t flushes;
+        uint32_t compactions;
+        uint32_t bytes_written;     // to the journal and storage file
+        uint32_t last_flush_us;     // time taken by the last flush
+        uint32_t max_flush_us;
+    };
+    const Stats &get_stats() const { return _stats; }
+
 protected:
+    // each journal entry is a header followed by length bytes of storage
+    struct PACKED journal_header {
+        uint16_t magic;
+        uint16_t offset;
+        uint16_t length;
+        uint16_t crc;   // crc16_ccitt of offset, length and the data
+    };
+
     void _mark_dirty(uint16_t loc, uint16_t length);
     int _storage_create(const char *dpath);
+    int _journal_open(const char *dpath);
+    uint16_t _journal_crc(const journal_header &hdr, const uint8_t *data) const;
+    void _flush(void);
+    void _compact(void);
+    void _write_failed(void);
 
     int _fd;
+    int _journal_fd;
+    uint32_t _journal_size;
     volatile bool _initialised;
-    volatile uint32_t _dirty_mask;
+    Bitmask<LINUX_STORAGE_NUM_LINES> _dirty_mask;
+    uint32_t _first_dirty_ms;
+    uint32_t _last_flush_ms;
+    HAL_Semaphore _sem;
+    Stats _stats;
     uint8_t _buffer[LINUX_STORAGE_SIZE];
+    uint8_t _journal_buffer[LINUX_STORAGE_MAX_WRITE];
 };
 
 }
@@ -38,7 +38,8 @@ extern const AP_HAL::HAL& hal;
 AP_HAL::DSP::FFTWindowState* DSP::fft_init(uint16_t window_size, uint16_t sample_rate, uint8_t sliding_window_size)
 {
     DSP::FFTWindowStateSITL* fft = new DSP::FFTWindowStateSITL(window_size, sample_rate, sliding_window_size);
-    if (fft == nullptr || fft->_hanning_window == nullptr || fft->_rfft_data == nullptr || fft->_freq_bins == nullptr || fft->_derivative_freq_bins == nullptr) {
+    if (fft == nullptr || fft->_hanning_window == nullptr || fft->_rfft_data == nullptr || fft->_freq_bins == nullptr || fft->_derivative_freq_bins == nullptr
+        || fft->buf == nullptr || fft->twiddle == nullptr || fft->bitrev == nullptr) {
         delete fft;
         return nullptr;
     }
@@ -69,12 +70,42 @@ DSP::FFTWindowStateSITL::FFTWindowStateSITL(uint16_t window_size, uint16_t sampl
         return;
     }
 
-    buf = new complexf[window_size];
+    // a real FFT of window_size is calculated as a complex FFT of half the size
+    const uint16_t half_size = window_size / 2;
+    buf = new complexf[half_size];
+    twiddle = new complexf[half_size];
+    bitrev = new uint16_t[half_size];
+    if (buf == nullptr || twiddle == nullptr || bitrev == nullptr) {
+        GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "Failed to allocate window for DSP");
+        return;
+    }
+
+    // calculate the twiddle factors once rather than on every FFT
+    for (uint16_t k = 0; k < half_size; k++) {
+        const double angle = 2.0 * M_PI * k / window_size;
+        twiddle[k] = complexf(cos(angle), sin(angle));
+    }
+
+    // likewise the bit reversed addressing
+    uint16_t m = 0;
+    while ((1U << m) < half_size) {
+        m++;
+    }
+    for (uint16_t k = 0; k < half_size; k++) {
+        uint16_t ki = k, kr = 0;
+        for (uint16_t i = 0; i < m; i++) {
+            kr = (kr << 1) | (ki & 1);
+            ki >>= 1;
+        }
+        bitrev[k] = kr;
+    }
 }
 
 DSP::FFTWindowStateSITL::~FFTWindowStateSITL()
 {
     delete[] buf;
+    delete[] twiddle;
+    delete[] bitrev;
 }
 
 // step 1: filter the incoming samples through a Hanning window
@@ -92,22 +123,32 @@ void DSP::step_hanning(FFTWindowStateSITL* fft, FloatBuffer& samples, uint16_t a
 }
 
 // step 2: perform an in-place FFT on the windowed data
+// the real input is packed as even/odd pairs into a complex FFT of half the
+// window size and the two interleaved spectra are then separated
 void DSP::step_fft(FFTWindowStateSITL* fft)
 {
-    for (uint16_t i = 0; i < fft->_window_size; i++) {
-        fft->buf[i] = complexf(fft->_freq_bins[i], 0);
-    }
+    const uint16_t half_size = fft->_window_size / 2;
 
-    calculate_fft(fft->buf, fft->_window_size);
-
-    for (uint16_t i = 0; i < fft->_bin_count; i++) {
-        fft->_freq_bins[i] = std::norm(fft->buf[i]);
+    for (uint16_t i = 0; i < half_size; i++) {
+        fft->buf[i] = complexf(fft->_freq_bins[2 * i], fft->_freq_bins[2 * i + 1]);
     }
 
+    calculate_fft(fft);
+
     // components at the nyquist frequency are real only
-    for (uint16_t i = 0, j = 0; i <= fft->_bin_count; i++, j += 2) {
-        fft->_rfft_data[j] = fft->buf[i].real();
-        fft->_rfft_data[j+1] = fft->buf[i].imag();
+    for (uint16_t k = 0; k <= half_size; k++) {
+        const complexf zk = fft->buf[k % half_size];
+        const complexf zc = std::conj(fft->buf[(half_size - k) % half_size]);
+        const complexf even = (zk + zc) * 0.5f;
+        const complexf odd = (zk - zc) * complexf(0, -0.5f);
+        const complexf w = k < half_size ? fft->twiddle[k] : complexf(-1, 0);
+        const complexf x = even + w * odd;
+
+        fft->_rfft_data[2 * k] = x.real();
+        fft->_rfft_data[2 * k + 1] = x.imag();
+        if (k < fft->_bin_count) {
+            fft->_freq_bins[k] = std::norm(x);
+        }
     }
 }
 
@@ -154,33 +195,17 @@ float DSP::vector_mean_float(const float* vin, uint16_t len) const
     return mean_value;
 }
 
-// simple integer log2
-static uint16_t fft_log2(uint16_t n)
-{
-    uint16_t k = n, i = 0;
-    while (k) {
-        k >>= 1;
-        i++;
-    }
-    return i - 1;
-}
-
-// calculate the in-place FFT of the input using the Cooley–Tukey algorithm
+// calculate the in-place FFT of the packed input using the Cooley–Tukey algorithm
 // this is a translation of Ron Nicholson's version in http://www.nicholson.com/dsp.fft1.html
-void DSP::calculate_fft(complexf *samples, uint16_t fftlen)
+// with the bit reversal and twiddle factors precalculated
+void DSP::calculate_fft(FFTWindowStateSITL* fft)
 {
-    uint16_t m = fft_log2(fftlen);
+    complexf* samples = fft->buf;
+    const uint16_t fftlen = fft->_window_size / 2;
+
     // shuffle data using bit reversed addressing ***
     for (uint16_t k = 0; k < fftlen; k++) {
-        // generate a bit reversed address for samples[k] ***
-        uint16_t ki = k, kr = 0;
-        for (uint16_t i=1; i<=m; i++) {
-            kr <<= 1; //  left shift result kr by 1 bit
-            if (ki % 2 == 1) {
-                kr++;
-            }
-            ki >>= 1; // right shift temp ki by 1 bit
-        }
+        const uint16_t kr = fft->bitrev[k];
         // swap data samples[k] to bit reversed address samples[kr]
         if (kr > k) {
             complexf t = samples[kr];
@@ -195,8 +220,8 @@ void DSP::calculate_fft(complexf *samples, uint16_t fftlen)
         uint16_t is2 = istep / 2;
         uint16_t astep = fftlen / istep;
         for (uint16_t km = 0; km < is2; km++) { // outer row loop
-            uint16_t a  = km * astep; // twiddle angle index
-            complexf w(sinf(2 * M_PI * (a+(fftlen/4)) / fftlen), sinf(2 * M_PI * a / fftlen));
+            // twiddle table is for the full window, so twice the angle index
+            const complexf w = fft->twiddle[2 * km * astep];
             for (uint16_t ki = 0; ki <= (fftlen - istep); ki += istep) { // inner column loop
                 uint16_t i = km + ki;
                 uint16_t j = is2 + i;
@@ -42,7 +42,12 @@ public:
         virtual ~FFTWindowStateSITL();
 
     private:
-        complexf* buf;
+        // packed even/odd samples, half the window size
+        complexf* buf = nullptr;
+        // twiddle factors for the full window size, first half only
+        complexf* twiddle = nullptr;
+        // bit reversed addresses for the half size complex FFT
+        uint16_t* bitrev = nullptr;
     };
 
 private:
@@ -53,5 +58,5 @@ private:
     void vector_scale_float(const float* vin, float scale, float* vout, uint16_t len) const override;
     float vector_mean_float(const float* vin, uint16_t len) const override;
     void vector_add_float(const float* vin1, const float* vin2, float* vout, uint16_t len) const override;
-    void calculate_fft(complexf* f, uint16_t length);
+    void calculate_fft(FFTWindowStateSITL* fft);
 };
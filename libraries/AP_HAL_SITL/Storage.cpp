@@ -167,6 +167,12 @@ void Storage::_timer_tick(void)
     }
     if (_dirty_mask.empty()) {
         _last_empty_ms = AP_HAL::millis();
+#if STORAGE_USE_FLASH
+        if (hal.get_storage_flash_enabled()) {
+            // use idle ticks to compact flash
+            _flash.compact_step(4);
+        }
+#endif
         return;
     }
 
@@ -54,6 +54,7 @@
 #include <Filter/LowPassFilter.h>
 #include <Filter/HarmonicNotchFilter.h>
 #include <AP_Math/polyfit.h>
+#include "LogStructure.h"
 
 #ifndef AP_SIM_INS_ENABLED
 #define AP_SIM_INS_ENABLED AP_SIM_ENABLED
@@ -370,10 +371,29 @@ public:
         enum batch_opt_t {
             BATCH_OPT_SENSOR_RATE = (1<<0),
             BATCH_OPT_POST_FILTER = (1<<1),
+            BATCH_OPT_STREAM = (1<<2),
         };
 
         void rotate_to_next_sensor();
         void update_doing_sensor_rate_logging();
+        float get_sample_rate_hz(uint8_t _instance, IMU_SENSOR_TYPE _type, bool sensor_rate) const;
+        uint16_t get_multiplier(uint8_t _instance, IMU_SENSOR_TYPE _type) const;
+
+        // continuous streaming of delta encoded samples, one stream
+        // per sensor instance and type
+        struct stream_t {
+            uint64_t sample_us; // time of first sample in data
+            uint16_t seqno;
+            uint8_t sample_count;
+            uint8_t length;     // bytes used in data
+            bool sensor_rate;   // samples in data are at sensor rate
+            int16_t last[3];    // previous sample, deltas are from this
+            uint8_t data[ISBC_DATA_LEN];
+        };
+        void init_streaming();
+        void stream_sample(uint8_t _instance, IMU_SENSOR_TYPE _type, uint64_t sample_us, const Vector3f &sample) __RAMFUNC__;
+        void write_stream(uint8_t _instance, IMU_SENSOR_TYPE _type, stream_t &stream) __RAMFUNC__;
+        void restart_stream(stream_t &stream) __RAMFUNC__;
 
         bool should_log(uint8_t instance, IMU_SENSOR_TYPE type) __RAMFUNC__;
         void push_data_to_log();
@@ -381,6 +401,7 @@ public:
         // Logging functions
         bool Write_ISBH(const float sample_rate_hz) const;
         bool Write_ISBD() const;
+        bool Write_ISBC(uint8_t _instance, IMU_SENSOR_TYPE _type, const stream_t &stream) const;
 
         uint64_t measurement_started_us;
 
@@ -388,12 +409,14 @@ public:
         bool isbh_sent : 1;
         bool _doing_sensor_rate_logging : 1;
         bool _doing_post_filter_logging : 1;
+        bool streaming : 1;
         uint8_t instance : 3; // instance we are sending data for
         AP_InertialSensor::IMU_SENSOR_TYPE type : 1;
         uint16_t isb_seqnum;
         int16_t *data_x;
         int16_t *data_y;
         int16_t *data_z;
+        stream_t *streams; // INS_MAX_INSTANCES*2 when streaming
         uint16_t data_write_offset; // units: samples
         uint16_t data_read_offset; // units: samples
         uint32_t last_sent_ms;
@@ -129,6 +129,27 @@ bool AP_InertialSensor::BatchSampler::Write_ISBD() const
     return AP::logger().WriteBlock_first_succeed(&pkt, sizeof(pkt));
 }
 
+// Write a compressed series of IMU readings to log:
+bool AP_InertialSensor::BatchSampler::Write_ISBC(uint8_t _instance, IMU_SENSOR_TYPE _type, const stream_t &stream) const
+{
+    struct log_ISBC pkt {
+        LOG_PACKET_HEADER_INIT(LOG_ISBC_MSG),
+        time_us        : AP_HAL::micros64(),
+        instance       : _instance,
+        sensor_type    : (uint8_t)_type,
+        seqno          : stream.seqno,
+        sample_us      : stream.sample_us,
+        sample_rate_hz : get_sample_rate_hz(_instance, _type, stream.sensor_rate),
+        multiplier     : get_multiplier(_instance, _type),
+        sample_count   : stream.sample_count,
+        length         : stream.length,
+    };
+    memcpy(pkt.data, stream.data, stream.length);
+    memset(&pkt.data[stream.length], 0, sizeof(pkt.data) - stream.length);
+
+    return AP::logger().WriteBlock_first_succeed(&pkt, sizeof(pkt));
+}
+
 // @LoggerMessage: FTN
 // @Description: Filter Tuning Messages
 // @Field: TimeUS: microseconds since system startup
@@ -24,8 +24,8 @@ const AP_Param::GroupInfo AP_InertialSensor::BatchSampler::var_info[] = {
 
     // @Param: BAT_OPT
     // @DisplayName: Batch Logging Options Mask
-    // @Description: Options for the BatchSampler. Post-filter and sensor-rate logging cannot be used at the same time.
-    // @Bitmask: 0:Sensor-Rate Logging (sample at full sensor rate seen by AP), 1: Sample post-filtering
+    // @Description: Options for the BatchSampler. Post-filter and sensor-rate logging cannot be used at the same time. Continuous streaming logs every sample from all IMUs in BAT_MASK as compressed ISBC messages instead of batches, and takes effect on the next reboot.
+    // @Bitmask: 0:Sensor-Rate Logging (sample at full sensor rate seen by AP), 1: Sample post-filtering, 2: Continuous streaming
     // @User: Advanced
     AP_GROUPINFO("BAT_OPT",  3, AP_InertialSensor::BatchSampler, _batch_options_mask, 0),
 
@@ -56,6 +56,11 @@ void AP_InertialSensor::BatchSampler::init()
         return;
     }
 
+    if ((batch_opt_t)(_batch_options_mask.get()) & BATCH_OPT_STREAM) {
+        init_streaming();
+        return;
+    }
+
     _required_count -= _required_count % 32; // round down to nearest multiple of 32
 
     const uint32_t total_allocation = 3*_required_count*sizeof(uint16_t);
@@ -80,11 +85,32 @@ void AP_InertialSensor::BatchSampler::init()
     initialised = true;
 }
 
+void AP_InertialSensor::BatchSampler::init_streaming()
+{
+    const uint32_t total_allocation = INS_MAX_INSTANCES*2*sizeof(stream_t);
+    streams = (stream_t*)calloc(INS_MAX_INSTANCES*2, sizeof(stream_t));
+    if (streams == nullptr) {
+        GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "Failed to allocate %u bytes for IMU batch sampling", (unsigned int)total_allocation);
+        return;
+    }
+
+    streaming = true;
+    update_doing_sensor_rate_logging();
+
+    initialised = true;
+}
+
 void AP_InertialSensor::BatchSampler::periodic()
 {
     if (_sensor_mask == 0) {
         return;
     }
+    if (streaming) {
+        // samples are written as they are encoded, just keep up with
+        // backends changing their sensor rate sampling
+        update_doing_sensor_rate_logging();
+        return;
+    }
     push_data_to_log();
 }
 
@@ -101,6 +127,15 @@ void AP_InertialSensor::BatchSampler::update_doing_sensor_rate_logging()
         _doing_sensor_rate_logging = false;
         return;
     }
+    if (streaming) {
+        // all streams must be at sensor rate, or none of them are
+        const uint8_t _count = MIN(_imu._accel_count, _imu._gyro_count);
+        const uint8_t mask = _sensor_mask & ((1U<<_count)-1);
+        _doing_sensor_rate_logging = mask != 0 &&
+            (_imu._gyro_sensor_rate_sampling_enabled & mask) == mask &&
+            (_imu._accel_sensor_rate_sampling_enabled & mask) == mask;
+        return;
+    }
     const uint8_t bit = (1<<instance);
     switch (type) {
     case IMU_SENSOR_TYPE_GYRO:
@@ -195,22 +230,7 @@ void AP_InertialSensor::BatchSampler::push_data_to_log()
 
     // possibly send isb header:
     if (!isbh_sent && data_read_offset == 0) {
-        float sample_rate = 0; // avoid warning about uninitialised values
-        switch(type) {
-        case IMU_SENSOR_TYPE_GYRO:
-            sample_rate = _imu._gyro_raw_sample_rates[instance];
-            if (_doing_sensor_rate_logging) {
-                sample_rate *= _imu._gyro_over_sampling[instance];
-            }
-            break;
-        case IMU_SENSOR_TYPE_ACCEL:
-            sample_rate = _imu._accel_raw_sample_rates[instance];
-            if (_doing_sensor_rate_logging) {
-                sample_rate *= _imu._accel_over_sampling[instance];
-            }
-            break;
-        }
-        if (!Write_ISBH(sample_rate)) {
+        if (!Write_ISBH(get_sample_rate_hz(instance, type, _doing_sensor_rate_logging))) {
             // buffer full?
             return;
         }
@@ -235,6 +255,37 @@ void AP_InertialSensor::BatchSampler::push_data_to_log()
     }
 }
 
+float AP_InertialSensor::BatchSampler::get_sample_rate_hz(uint8_t _instance, IMU_SENSOR_TYPE _type, bool sensor_rate) const
+{
+    float sample_rate = 0; // avoid warning about uninitialised values
+    switch(_type) {
+    case IMU_SENSOR_TYPE_GYRO:
+        sample_rate = _imu._gyro_raw_sample_rates[_instance];
+        if (sensor_rate) {
+            sample_rate *= _imu._gyro_over_sampling[_instance];
+        }
+        break;
+    case IMU_SENSOR_TYPE_ACCEL:
+        sample_rate = _imu._accel_raw_sample_rates[_instance];
+        if (sensor_rate) {
+            sample_rate *= _imu._accel_over_sampling[_instance];
+        }
+        break;
+    }
+    return sample_rate;
+}
+
+uint16_t AP_InertialSensor::BatchSampler::get_multiplier(uint8_t _instance, IMU_SENSOR_TYPE _type) const
+{
+    switch(_type) {
+    case IMU_SENSOR_TYPE_GYRO:
+        return _imu._gyro_raw_sampling_multiplier[_instance];
+    case IMU_SENSOR_TYPE_ACCEL:
+        return _imu._accel_raw_sampling_multiplier[_instance];
+    }
+    return 0;
+}
+
 bool AP_InertialSensor::BatchSampler::should_log(uint8_t _instance, IMU_SENSOR_TYPE _type)
 {
     if (_sensor_mask == 0) {
@@ -243,14 +294,20 @@ bool AP_InertialSensor::BatchSampler::should_log(uint8_t _instance, IMU_SENSOR_T
     if (!initialised) {
         return false;
     }
-    if (_instance != instance) {
-        return false;
-    }
-    if (_type != type) {
-        return false;
-    }
-    if (data_write_offset >= _required_count) {
-        return false;
+    if (streaming) {
+        if (!(_sensor_mask & (1U<<_instance))) {
+            return false;
+        }
+    } else {
+        if (_instance != instance) {
+            return false;
+        }
+        if (_type != type) {
+            return false;
+        }
+        if (data_write_offset >= _required_count) {
+            return false;
+        }
     }
     AP_Logger *logger = AP_Logger::get_singleton();
     if (logger == nullptr) {
@@ -266,6 +323,14 @@ bool AP_InertialSensor::BatchSampler::should_log(uint8_t _instance, IMU_SENSOR_T
 void AP_InertialSensor::BatchSampler::sample(uint8_t _instance, AP_InertialSensor::IMU_SENSOR_TYPE _type, uint64_t sample_us, const Vector3f &_sample)
 {
     if (!should_log(_instance, _type)) {
+        if (streaming && streams[_instance*2 + uint8_t(_type)].sample_count != 0) {
+            // don't join up the samples either side of a gap in logging
+            restart_stream(streams[_instance*2 + uint8_t(_type)]);
+        }
+        return;
+    }
+    if (streaming) {
+        stream_sample(_instance, _type, sample_us, _sample);
         return;
     }
     if (data_write_offset == 0) {
@@ -278,4 +343,78 @@ void AP_InertialSensor::BatchSampler::sample(uint8_t _instance, AP_InertialSenso
 
     data_write_offset++; // may unblock the reading process
 }
+
+/*
+  append the change from the previous value as a zigzag encoded
+  base-128 varint, returning the number of bytes used.  The change is
+  taken modulo 2^16 so never needs more than three bytes
+ */
+static inline uint8_t encode_delta(uint8_t *buf, int16_t value, int16_t &last)
+{
+    const int16_t delta = int16_t(uint16_t(value) - uint16_t(last));
+    last = value;
+    uint16_t zigzag = uint16_t(uint16_t(delta) << 1) ^ uint16_t(delta >> 15);
+    uint8_t len = 0;
+    while (zigzag >= 0x80) {
+        buf[len++] = uint8_t(zigzag) | 0x80;
+        zigzag >>= 7;
+    }
+    buf[len++] = uint8_t(zigzag);
+    return len;
+}
+
+/*
+  encode a sample into the stream for this sensor, writing the stream
+  out once it is full. This runs in the backend thread for each IMU so
+  streams are never shared between threads and the main loop does no
+  work at all
+ */
+void AP_InertialSensor::BatchSampler::stream_sample(uint8_t _instance, IMU_SENSOR_TYPE _type, uint64_t sample_us, const Vector3f &_sample)
+{
+    // largest encoding of a sample
+    const uint8_t max_sample_len = 9;
+
+    stream_t &stream = streams[_instance*2 + uint8_t(_type)];
+
+    // a message has a single sample rate, so write out what we have
+    // when sensor rate logging is turned on or off
+    const bool sensor_rate = _doing_sensor_rate_logging;
+    if (stream.sample_count != 0 && stream.sensor_rate != sensor_rate) {
+        write_stream(_instance, _type, stream);
+    }
+    if (stream.sample_count == 0) {
+        stream.sample_us = sample_us;
+        stream.sensor_rate = sensor_rate;
+    }
+
+    const uint16_t mul = get_multiplier(_instance, _type);
+    uint8_t *buf = &stream.data[stream.length];
+    buf += encode_delta(buf, mul*_sample.x, stream.last[0]);
+    buf += encode_delta(buf, mul*_sample.y, stream.last[1]);
+    buf += encode_delta(buf, mul*_sample.z, stream.last[2]);
+    stream.length = buf - stream.data;
+    stream.sample_count++;
+
+    if (stream.length > ISBC_DATA_LEN - max_sample_len) {
+        write_stream(_instance, _type, stream);
+    }
+}
+
+// write out the samples in a stream and start a new message
+void AP_InertialSensor::BatchSampler::write_stream(uint8_t _instance, IMU_SENSOR_TYPE _type, stream_t &stream)
+{
+    // a failed write is visible in the log as a gap in seqno
+    Write_ISBC(_instance, _type, stream);
+    stream.seqno++;
+    restart_stream(stream);
+}
+
+// discard any samples in a stream
+void AP_InertialSensor::BatchSampler::restart_stream(stream_t &stream)
+{
+    stream.sample_count = 0;
+    stream.length = 0;
+    // each message decodes without reference to earlier messages
+    memset(stream.last, 0, sizeof(stream.last));
+}
 #endif //#if HAL_INS_ENABLED
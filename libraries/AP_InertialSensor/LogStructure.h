@@ -8,6 +8,7 @@
     LOG_IMU_MSG, \
     LOG_ISBH_MSG, \
     LOG_ISBD_MSG, \
+    LOG_ISBC_MSG, \
     LOG_VIBE_MSG
 
 // @LoggerMessage: ACC
@@ -95,6 +96,38 @@ struct PACKED log_ISBD {
 };
 static_assert(sizeof(log_ISBD) < 256, "log_ISBD is over-size");
 
+// bytes of encoded samples in each ISBC message
+#define ISBC_DATA_LEN 192
+
+// @LoggerMessage: ISBC
+// @Description: Compressed continuous stream of IMU readings.  Each of x, y and z is the change from the previous sample in the message (from zero for the first sample), zigzag encoded and written as a little-endian base-128 varint.  The encoded bytes are packed across D0, D1 and D2.
+// @Field: TimeUS: Time since system startup
+// @Field: I: IMU instance
+// @Field: type: sensor type, 0 for accelerometer and 1 for gyroscope
+// @Field: N: sequence number, gaps indicate dropped messages
+// @Field: SampleUS: time since system startup the first sample was taken
+// @Field: smp_rate: sample rate
+// @Field: mul: all samples have been multiplied by this
+// @Field: cnt: number of samples in this message
+// @Field: len: number of encoded bytes in this message
+// @Field: D0: encoded sample bytes 0-63
+// @Field: D1: encoded sample bytes 64-127
+// @Field: D2: encoded sample bytes 128-191
+struct PACKED log_ISBC {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    uint8_t instance;
+    uint8_t sensor_type;
+    uint16_t seqno;
+    uint64_t sample_us;
+    float sample_rate_hz;
+    uint16_t multiplier;
+    uint8_t sample_count;
+    uint8_t length;
+    uint8_t data[ISBC_DATA_LEN];
+};
+static_assert(sizeof(log_ISBC) < 256, "log_ISBC is over-size");
+
 // @LoggerMessage: VIBE
 // @Description: Processed (acceleration) vibration information
 // @Field: TimeUS: Time since system startup
@@ -123,4 +156,6 @@ struct PACKED log_Vibe {
     { LOG_ISBH_MSG, sizeof(log_ISBH), \
       "ISBH", "QHBBHHQf", "TimeUS,N,type,instance,mul,smp_cnt,SampleUS,smp_rate", "s-----sz", "F-----F-" },  \
     { LOG_ISBD_MSG, sizeof(log_ISBD), \
-      "ISBD", "QHHaaa", "TimeUS,N,seqno,x,y,z", "s--ooo", "F--???" },
+      "ISBD", "QHHaaa", "TimeUS,N,seqno,x,y,z", "s--ooo", "F--???" },  \
+    { LOG_ISBC_MSG, sizeof(log_ISBC), \
+      "ISBC", "QBBHQfHBBaaa", "TimeUS,I,type,N,SampleUS,smp_rate,mul,cnt,len,D0,D1,D2", "s#--sz------", "F---F-------" },
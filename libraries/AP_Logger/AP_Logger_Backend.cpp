@@ -635,6 +635,25 @@ void AP_Logger_Backend::df_stats_gather(const uint16_t bytes_written, uint32_t s
     stats.blocks++;
 }
 
+// gather statistics for a batch of blocks, sampling buffer space once
+// for the whole batch
+void AP_Logger_Backend::df_stats_gather(const uint32_t blocks, const uint32_t bytes_written, uint32_t space_remaining)
+{
+    if (blocks == 0) {
+        return;
+    }
+    if (space_remaining < stats.buf_space_min) {
+        stats.buf_space_min = space_remaining;
+    }
+    if (space_remaining > stats.buf_space_max) {
+        stats.buf_space_max = space_remaining;
+    }
+    stats.buf_space_sigma += space_remaining * blocks;
+    stats.bytes += bytes_written;
+    _log_file_size_bytes += bytes_written;
+    stats.blocks += blocks;
+}
+
 void AP_Logger_Backend::df_stats_clear() {
     memset(&stats, '\0', sizeof(stats));
     stats.buf_space_min = -1;
@@ -228,6 +228,7 @@ protected:
     bool _initialised;
 
     void df_stats_gather(uint16_t bytes_written, uint32_t space_remaining);
+    void df_stats_gather(uint32_t blocks, uint32_t bytes_written, uint32_t space_remaining);
     void df_stats_log();
     void df_stats_clear();
 
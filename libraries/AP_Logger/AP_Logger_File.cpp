@@ -451,56 +451,52 @@ bool AP_Logger_File::StartNewLogOK() const
     return AP_Logger_Backend::StartNewLogOK();
 }
 
-/* Write a block of data at current offset */
+/*
+  Write a block of data at current offset. This may be called from
+  any thread; the block is copied straight into the write ring
+  without taking a lock.
+ */
 bool AP_Logger_File::_WritePrioritisedBlock(const void *pBuffer, uint16_t size, bool is_critical)
 {
-    WITH_SEMAPHORE(semaphore);
-
     if (! WriteBlockCheckStartupMessages()) {
-        _dropped++;
+        _dropped_pending++;
         return false;
     }
 
 #if APM_BUILD_TYPE(APM_BUILD_Replay)
+    // EKF cores may log from several threads at once
+    WITH_SEMAPHORE(write_fd_semaphore);
     if (AP::FS().write(_write_fd, pBuffer, size) != size) {
         AP_HAL::panic("Short write");
     }
     return true;
 #endif
 
-
-    uint32_t space = _writebuf.space();
-
     if (_writing_startup_messages &&
         _startup_messagewriter->fmt_done()) {
         // the state machine has called us, and it has finished
         // writing format messages out.  It can always get back to us
         // with more messages later, so let's leave room for other
-        // things:
+        // things.  Only the main thread writes startup messages so
+        // last_messagewrite_message_sent needs no locking:
         const uint32_t now = AP_HAL::millis();
         const bool must_dribble = (now - last_messagewrite_message_sent) > 100;
-        if (!must_dribble &&
-            space < non_messagewriter_message_reserved_space(_writebuf.get_size())) {
+        const uint32_t min_space = must_dribble ? 0 : non_messagewriter_message_reserved_space(_writebuf.get_size());
+        if (!_writebuf.write(pBuffer, size, min_space)) {
             // this message isn't dropped, it will be sent again...
             return false;
         }
         last_messagewrite_message_sent = now;
-    } else {
-        // we reserve some amount of space for critical messages:
-        if (!is_critical && space < critical_message_reserved_space(_writebuf.get_size())) {
-            _dropped++;
-            return false;
-        }
+        return true;
     }
 
-    // if no room for entire message - drop it:
-    if (space < size) {
-        _dropped++;
+    // we reserve some amount of space for critical messages, and if
+    // there is no room for the entire message we drop it:
+    const uint32_t min_space = is_critical ? 0 : critical_message_reserved_space(_writebuf.get_size());
+    if (!_writebuf.write(pBuffer, size, min_space)) {
+        _dropped_pending++;
         return false;
     }
-
-    _writebuf.write((uint8_t*)pBuffer, size);
-    df_stats_gather(size, _writebuf.space());
     return true;
 }
 
@@ -876,7 +872,7 @@ void AP_Logger_File::flush(void)
 #if APM_BUILD_TYPE(APM_BUILD_Replay) || APM_BUILD_TYPE(APM_BUILD_UNKNOWN)
 {
     uint32_t tnow = AP_HAL::millis();
-    while (_write_fd != -1 && _initialised && !recent_open_error() && _writebuf.available()) {
+    while (_write_fd != -1 && _initialised && !recent_open_error() && writebuf_available()) {
         // convince the IO timer that it really is OK to write out
         // less than _writebuf_chunk bytes:
         if (tnow > 2001) { // avoid resetting _last_write_time to 0
@@ -900,11 +896,30 @@ void AP_Logger_File::flush(void)
 #endif // APM_BUILD_TYPE(APM_BUILD_Replay) || APM_BUILD_TYPE(APM_BUILD_UNKNOWN)
 #endif
 
+/*
+  bytes in the write buffer ready to be written out
+ */
+uint32_t AP_Logger_File::writebuf_available(void)
+{
+    if (!write_fd_semaphore.take(1)) {
+        return 0;
+    }
+    const uint32_t ret = _writebuf.available();
+    write_fd_semaphore.give();
+    return ret;
+}
+
 void AP_Logger_File::io_timer(void)
 {
     uint32_t tnow = AP_HAL::millis();
     _io_timer_heartbeat = tnow;
 
+    // writers only touch atomics; fold their counts in from here
+    _dropped += _dropped_pending.exchange(0);
+    uint32_t blocks, bytes;
+    _writebuf.take_stats(blocks, bytes);
+    df_stats_gather(blocks, bytes, _writebuf.space());
+
     if (start_new_log_pending) {
         start_new_log();
         start_new_log_pending = false;
@@ -920,7 +935,7 @@ void AP_Logger_File::io_timer(void)
         return;
     }
 
-    uint32_t nbytes = _writebuf.available();
+    uint32_t nbytes = writebuf_available();
     if (nbytes == 0) {
         return;
     }
@@ -949,10 +964,6 @@ void AP_Logger_File::io_timer(void)
         nbytes = _writebuf_chunk;
     }
 
-    uint32_t size;
-    const uint8_t *head = _writebuf.readptr(size);
-    nbytes = MIN(nbytes, size);
-
     // try to align writes on a 512 byte boundary to avoid filesystem reads
     if ((nbytes + _write_offset) % 512 != 0) {
         uint32_t ofs = (nbytes + _write_offset) % 512;
@@ -969,7 +980,16 @@ void AP_Logger_File::io_timer(void)
         write_fd_semaphore.give();
         return;
     }
-    ssize_t nwritten = AP::FS().write(_write_fd, head, nbytes);
+    // hand both halves of a wrapped span to the OS in one call
+    ByteBuffer::IoVec vec[2];
+    const uint8_t nvec = _writebuf.peekiovec(vec, nbytes);
+    if (nvec == 0) {
+        // start_new_log() cleared the buffer since we looked
+        last_io_operation = "";
+        write_fd_semaphore.give();
+        return;
+    }
+    ssize_t nwritten = AP::FS().writev(_write_fd, vec, nvec);
     last_io_operation = "";
     if (nwritten <= 0) {
         if ((tnow - _last_write_ms)/1000U > unsigned(_front._params.file_timeout)) {
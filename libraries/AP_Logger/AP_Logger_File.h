@@ -10,6 +10,7 @@
 
 #include <AP_HAL/utility/RingBuffer.h>
 #include "AP_Logger_Backend.h"
+#include "AP_Logger_WriteRing.h"
 
 #if HAL_LOGGING_FILESYSTEM_ENABLED
 
@@ -102,8 +103,14 @@ private:
 
     bool dirent_to_log_num(const dirent *de, uint16_t &log_num) const;
 
-    // write buffer
-    ByteBuffer _writebuf{0};
+    // write buffer; writers copy into this without taking a lock,
+    // see AP_Logger_WriteRing. start_new_log() can clear it from a
+    // writer thread, so the consumer side is only used with
+    // write_fd_semaphore held
+    AP_Logger_WriteRing _writebuf;
+    uint32_t writebuf_available(void);
+    // drops counted by writers, folded into _dropped by the io thread
+    std::atomic<uint32_t> _dropped_pending{0};
     const uint16_t _writebuf_chunk = HAL_LOGGER_WRITE_CHUNK_SIZE;
     uint32_t _last_write_time;
 
@@ -126,11 +133,9 @@ private:
     const uint32_t _free_space_check_interval = 1000UL; // milliseconds
     const uint32_t _free_space_min_avail = 8388608; // bytes
 
-    // semaphore mediates access to the ringbuffer
-    HAL_Semaphore semaphore;
     // write_fd_semaphore mediates access to write_fd so the frontend
     // can open/close files without causing the backend to write to a
-    // bad fd
+    // bad fd. It also serialises the consumer side of _writebuf
     HAL_Semaphore write_fd_semaphore;
 
     // async erase state
@@ -0,0 +1,172 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <AP_Math/AP_Math.h>
+
+#include "AP_Logger_WriteRing.h"
+
+AP_Logger_WriteRing::~AP_Logger_WriteRing(void)
+{
+    free(buf);
+}
+
+bool AP_Logger_WriteRing::set_size(uint32_t _size)
+{
+    head = 0;
+    reserved = 0;
+    committed = 0;
+    readable = 0;
+    if (_size != size || buf == nullptr) {
+        free(buf);
+        buf = (uint8_t*)calloc(1, _size);
+        if (buf == nullptr) {
+            size = 0;
+            return false;
+        }
+        size = _size;
+        wrap = size * ((1U<<31) / size);
+    }
+    return true;
+}
+
+uint32_t AP_Logger_WriteRing::space(void) const
+{
+    if (size == 0) {
+        return 0;
+    }
+    while (true) {
+        // see write() for why this can need a retry
+        const uint32_t _head = head.load(std::memory_order_acquire);
+        const uint32_t used = distance(_head, reserved.load(std::memory_order_acquire));
+        if (used <= size) {
+            return size - used;
+        }
+    }
+}
+
+bool AP_Logger_WriteRing::write(const void *data, uint32_t len, uint32_t min_space)
+{
+    if (size == 0) {
+        return false;
+    }
+    const uint32_t need = MAX(len, min_space);
+
+    // claim [start, start+len)
+    uint32_t start;
+    while (true) {
+        const uint32_t _head = head.load(std::memory_order_acquire);
+        start = reserved.load(std::memory_order_relaxed);
+        const uint32_t used = distance(_head, start);
+        if (used > size) {
+            // the consumer moved on and writers followed it between
+            // our two loads; try again with a fresh head
+            continue;
+        }
+        if (size - used < need) {
+            return false;
+        }
+        if (reserved.compare_exchange_weak(start, cursor_add(start, len),
+                                           std::memory_order_acq_rel,
+                                           std::memory_order_relaxed)) {
+            break;
+        }
+    }
+
+    // copy in, as two parts if we wrap
+    const uint32_t ofs = start % size;
+    const uint32_t n = MIN(len, size - ofs);
+    memcpy(&buf[ofs], data, n);
+    if (len > n) {
+        memcpy(&buf[0], (const uint8_t *)data + n, len - n);
+    }
+
+    // publish
+    uint32_t c = committed.load(std::memory_order_relaxed);
+    while (!committed.compare_exchange_weak(c, cursor_add(c, len),
+                                            std::memory_order_release,
+                                            std::memory_order_relaxed)) {
+    }
+
+    blocks_written.fetch_add(1, std::memory_order_relaxed);
+    bytes_written.fetch_add(len, std::memory_order_relaxed);
+    return true;
+}
+
+void AP_Logger_WriteRing::take_stats(uint32_t &blocks, uint32_t &bytes)
+{
+    blocks = blocks_written.exchange(0, std::memory_order_relaxed);
+    bytes = bytes_written.exchange(0, std::memory_order_relaxed);
+}
+
+/*
+  move the readable point forward if no writer is part way through a
+  copy. The commit cursor must be loaded before the reservation cursor
+ */
+void AP_Logger_WriteRing::update_readable(void)
+{
+    const uint32_t _committed = committed.load(std::memory_order_acquire);
+    const uint32_t _reserved = reserved.load(std::memory_order_acquire);
+    if (_committed == _reserved) {
+        readable = _reserved;
+    }
+}
+
+uint32_t AP_Logger_WriteRing::available(void)
+{
+    if (size == 0) {
+        return 0;
+    }
+    update_readable();
+    return distance(head.load(std::memory_order_relaxed), readable);
+}
+
+uint8_t AP_Logger_WriteRing::peekiovec(ByteBuffer::IoVec vec[2], uint32_t len)
+{
+    len = MIN(len, available());
+    if (len == 0) {
+        return 0;
+    }
+    const uint32_t _head = head.load(std::memory_order_relaxed);
+    const uint32_t ofs = _head % size;
+    const uint32_t n = MIN(len, size - ofs);
+    vec[0].data = &buf[ofs];
+    vec[0].len = n;
+    if (len == n) {
+        return 1;
+    }
+    vec[1].data = &buf[0];
+    vec[1].len = len - n;
+    return 2;
+}
+
+bool AP_Logger_WriteRing::advance(uint32_t n)
+{
+    const uint32_t _head = head.load(std::memory_order_relaxed);
+    if (n > distance(_head, readable)) {
+        return false;
+    }
+    // release so writers see our reads complete before reusing space
+    head.store(cursor_add(_head, n), std::memory_order_release);
+    return true;
+}
+
+void AP_Logger_WriteRing::clear(void)
+{
+    update_readable();
+    head.store(readable, std::memory_order_release);
+}
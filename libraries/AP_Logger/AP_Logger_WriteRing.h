@@ -0,0 +1,118 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  multi-producer, single-consumer byte ring used by AP_Logger_File
+
+  Writers claim space with a compare-and-swap on the reservation
+  cursor and then copy their message straight into the ring without
+  holding any lock. Once the copy is complete the message is
+  published by advancing the commit cursor by its length.
+
+  Commits can complete out of order, so the consumer only reads up to
+  a reservation point at which every reservation has been committed.
+  It finds one by loading the commit cursor before the reservation
+  cursor: if they are equal then nothing was in flight at that
+  moment. Writers only hold a reservation for the length of a memcpy,
+  so such points come around very often even under heavy load.
+
+  The consumer side is not thread safe; only one thread may use it at
+  a time.
+
+  Cursors run modulo a large multiple of the buffer size, so a full
+  ring can be told apart from an empty one without giving up a byte,
+  and a writer that is preempted between loading the reservation
+  cursor and swapping it cannot be fooled by the cursor coming back
+  round to the same value.
+ */
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+#include <AP_Common/AP_Common.h>
+#include <AP_HAL/utility/RingBuffer.h>
+
+class AP_Logger_WriteRing {
+public:
+    AP_Logger_WriteRing() {}
+    ~AP_Logger_WriteRing(void);
+
+    CLASS_NO_COPY(AP_Logger_WriteRing);
+
+    // set size of ring, discarding contents. Must not be called
+    // while any writer may be active
+    bool set_size(uint32_t size);
+
+    // return size of ring
+    uint32_t get_size(void) const { return size; }
+
+    // number of bytes free for writers
+    uint32_t space(void) const;
+
+    /*
+      copy len bytes into the ring. The write fails unless at least
+      MAX(len, min_space) bytes are free before it, so min_space is
+      the free space a caller must see, not space left after the
+      write. Safe to call from any number of threads concurrently with
+      each other and the consumer
+     */
+    bool write(const void *data, uint32_t len, uint32_t min_space=0);
+
+    // total number of blocks and bytes written since the last call;
+    // consumer only
+    void take_stats(uint32_t &blocks, uint32_t &bytes);
+
+    // number of bytes which the consumer may read; consumer only
+    uint32_t available(void);
+
+    /*
+      fill out vec with up to len readable bytes as one or two
+      contiguous parts. Returns the number of parts. Consumer only
+     */
+    uint8_t peekiovec(ByteBuffer::IoVec vec[2], uint32_t len);
+
+    // release n bytes back to the writers; consumer only
+    bool advance(uint32_t n);
+
+    // discard all published data; consumer only, so callers on
+    // other threads must hold whatever lock the consumer reads under
+    void clear(void);
+
+private:
+    uint8_t *buf = nullptr;
+    uint32_t size = 0;
+    uint32_t wrap = 0;
+
+    // cursors, in the range [0, wrap)
+    std::atomic<uint32_t> head{0};      // consumer read position
+    std::atomic<uint32_t> reserved{0};  // end of space claimed by writers
+    std::atomic<uint32_t> committed{0}; // total published, modulo wrap
+
+    // last known point below which all data is published
+    uint32_t readable = 0;
+
+    std::atomic<uint32_t> blocks_written{0};
+    std::atomic<uint32_t> bytes_written{0};
+
+    // distance from cursor a forward to cursor b
+    uint32_t distance(uint32_t a, uint32_t b) const {
+        return b >= a ? b - a : wrap - a + b;
+    }
+    uint32_t cursor_add(uint32_t a, uint32_t n) const {
+        a += n;
+        return a >= wrap ? a - wrap : a;
+    }
+
+    void update_readable(void);
+};
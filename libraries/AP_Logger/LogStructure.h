@@ -139,6 +139,7 @@ const struct MultiplierStructure log_Multipliers[] = {
 #include <AP_AIS/LogStructure.h>
 #include <AP_HAL_ChibiOS/LogStructure.h>
 #include <AP_RPM/LogStructure.h>
+#include <AP_Scheduler/LogStructure.h>
 
 // structure used to define logging format
 // It is packed on ChibiOS to save flash space; however, this causes problems
@@ -496,6 +497,22 @@ struct PACKED log_TERRAIN {
     float reference_offset;
 };
 
+/*
+  terrain cache log structure
+ */
+struct PACKED log_TERRAIN_CACHE {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    uint16_t size;
+    uint16_t valid;
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t prefetched;
+    uint32_t prefetch_used;
+    uint16_t read_avg_ms;
+    uint16_t read_max_ms;
+};
+
 struct PACKED log_CSRV {
     LOG_PACKET_HEADER;
     uint64_t time_us;     
@@ -1138,6 +1155,18 @@ struct PACKED log_VER {
 // @Field: Loaded: Number of tiles in memory
 // @Field: ROfs: terrain reference offset for arming altitude
 
+// @LoggerMessage: TERC
+// @Description: Terrain cache performance
+// @Field: TimeUS: Time since system startup
+// @Field: Size: Number of tiles the cache can hold
+// @Field: Valid: Number of tiles in memory
+// @Field: Hit: Lookups found in the cache since startup
+// @Field: Miss: Lookups which needed a tile loading since startup
+// @Field: PF: Tiles loaded ahead of the vehicle since startup
+// @Field: PFUse: Prefetched tiles which were later used
+// @Field: RdAvg: Average time from a tile being requested to being read from SD card
+// @Field: RdMax: Longest time from a tile being requested to being read from SD card
+
 // @LoggerMessage: TSYN
 // @Description: Time synchronisation response information
 // @Field: TimeUS: Time since system startup
@@ -1289,6 +1318,7 @@ LOG_STRUCTURE_FROM_CAMERA \
     LOG_STRUCTURE_FROM_PROXIMITY                                    \
     { LOG_PERFORMANCE_MSG, sizeof(log_Performance),                     \
       "PM",  "QHHIIHHIIIIII", "TimeUS,NLon,NLoop,MaxT,Mem,Load,ErrL,IntE,ErrC,SPIC,I2CC,I2CI,Ex", "s---b%------s", "F---0A------F" }, \
+LOG_STRUCTURE_FROM_SCHEDULER \
     { LOG_SRTL_MSG, sizeof(log_SRTL), \
       "SRTL", "QBHHBfff", "TimeUS,Active,NumPts,MaxPts,Action,N,E,D", "s----mmm", "F----000" }, \
 LOG_STRUCTURE_FROM_AVOIDANCE \
@@ -1296,6 +1326,8 @@ LOG_STRUCTURE_FROM_AVOIDANCE \
       "SIM","QccCfLLffff","TimeUS,Roll,Pitch,Yaw,Alt,Lat,Lng,Q1,Q2,Q3,Q4", "sddhmDU????", "FBBB0GG????", true }, \
     { LOG_TERRAIN_MSG, sizeof(log_TERRAIN), \
       "TERR","QBLLHffHHf","TimeUS,Status,Lat,Lng,Spacing,TerrH,CHeight,Pending,Loaded,ROfs", "s-DU-mm--m", "F-GG-00--0", true }, \
+    { LOG_TERRAIN_CACHE_MSG, sizeof(log_TERRAIN_CACHE), \
+      "TERC","QHHIIIIHH","TimeUS,Size,Valid,Hit,Miss,PF,PFUse,RdAvg,RdMax", "s------ss", "F------CC", true }, \
 LOG_STRUCTURE_FROM_ESC_TELEM \
     { LOG_CSRV_MSG, sizeof(log_CSRV), \
       "CSRV","QBfffB","TimeUS,Id,Pos,Force,Speed,Pow", "s#---%", "F-0000", true }, \
@@ -1424,6 +1456,7 @@ enum LogMessages : uint8_t {
     LOG_DF_FILE_STATS,
     LOG_SRTL_MSG,
     LOG_PERFORMANCE_MSG,
+    LOG_IDS_FROM_SCHEDULER,
     LOG_OPTFLOW_MSG,
     LOG_EVENT_MSG,
     LOG_WHEELENCODER_MSG,
@@ -1446,6 +1479,7 @@ enum LogMessages : uint8_t {
     LOG_RCOUT2_MSG,
     LOG_RCOUT3_MSG,
     LOG_OVERACTUATED_MSG,
+    LOG_TERRAIN_CACHE_MSG,
     _LOG_LAST_MSG_
 };
 
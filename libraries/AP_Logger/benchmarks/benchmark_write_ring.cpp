@@ -0,0 +1,198 @@
+#include <AP_gbenchmark.h>
+
+#include <stdio.h>
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_HAL/utility/RingBuffer.h>
+#include <AP_Logger/AP_Logger_WriteRing.h>
+#include <AP_Math/AP_Math.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+/*
+  compare the lock-free logger write ring against the semaphore
+  protected ByteBuffer it replaced. Messages are IMU sized, and the
+  buffer and chunk sizes match the AP_Logger_File defaults
+ */
+static const uint32_t msg_len = 43;
+static const uint32_t buf_size = 16*1024;
+static const uint32_t chunk_size = 4096;
+static const uint32_t reserved_space = 1024;
+
+static void BM_ByteBufferLockedWrite(benchmark::State& state)
+{
+    ByteBuffer buf{buf_size};
+    HAL_Semaphore sem;
+    uint8_t msg[msg_len] {};
+    while (state.KeepRunning()) {
+        {
+            WITH_SEMAPHORE(sem);
+            if (buf.space() >= msg_len) {
+                buf.write(msg, msg_len);
+            }
+        }
+        if (buf.space() < chunk_size) {
+            buf.advance(chunk_size);
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_WriteRingWrite(benchmark::State& state)
+{
+    AP_Logger_WriteRing ring;
+    ring.set_size(buf_size);
+    uint8_t msg[msg_len] {};
+    while (state.KeepRunning()) {
+        ring.write(msg, msg_len);
+        if (ring.space() < chunk_size) {
+            ring.advance(MIN(ring.available(), chunk_size));
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+/*
+  several writer threads sharing one ring, with the first thread also
+  acting as the io thread
+ */
+static AP_Logger_WriteRing shared_ring;
+static const bool shared_ring_ok = shared_ring.set_size(buf_size);
+static ByteBuffer shared_buf{buf_size};
+static HAL_Semaphore shared_sem;
+
+static void set_drop_label(benchmark::State& state, uint64_t sent, uint64_t dropped)
+{
+    char label[32];
+    snprintf(label, sizeof(label), "drop=%.2f%%", 100.0 * dropped / MAX(sent + dropped, 1U));
+    state.SetLabel(label);
+}
+
+static void BM_ByteBufferLockedContended(benchmark::State& state)
+{
+    uint8_t msg[msg_len] {};
+    uint64_t dropped = 0;
+    while (state.KeepRunning()) {
+        {
+            WITH_SEMAPHORE(shared_sem);
+            if (shared_buf.space() >= msg_len) {
+                shared_buf.write(msg, msg_len);
+            } else {
+                dropped++;
+            }
+        }
+        if (state.thread_index == 0) {
+            WITH_SEMAPHORE(shared_sem);
+            uint32_t n;
+            shared_buf.readptr(n);
+            shared_buf.advance(MIN(n, chunk_size));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() - dropped);
+    if (state.thread_index == 0) {
+        set_drop_label(state, state.iterations() - dropped, dropped);
+    }
+}
+
+static void BM_WriteRingContended(benchmark::State& state)
+{
+    if (!shared_ring_ok) {
+        state.SkipWithError("allocation failed");
+    }
+    uint8_t msg[msg_len] {};
+    uint64_t dropped = 0;
+    while (state.KeepRunning()) {
+        if (!shared_ring.write(msg, msg_len)) {
+            dropped++;
+        }
+        if (state.thread_index == 0) {
+            ByteBuffer::IoVec vec[2];
+            const uint8_t n = shared_ring.peekiovec(vec, chunk_size);
+            uint32_t len = 0;
+            for (uint8_t i = 0; i < n; i++) {
+                len += vec[i].len;
+            }
+            shared_ring.advance(len);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() - dropped);
+    if (state.thread_index == 0) {
+        set_drop_label(state, state.iterations() - dropped, dropped);
+    }
+}
+
+/*
+  synthetic 400kB/s load in simulated time. Each iteration is one
+  millisecond of flight: 400 bytes of messages go in and the io
+  thread may write one chunk, except for a 150ms stall each second
+  which is typical of a microSD card doing housekeeping. The old path
+  only ever wrote the contiguous part of the buffer each tick; the
+  ring hands both parts of a wrapped span over at once
+ */
+static bool io_stalled(uint32_t now_ms)
+{
+    return (now_ms % 1000) >= 850;
+}
+
+static void BM_ByteBuffer400kBps(benchmark::State& state)
+{
+    ByteBuffer buf{uint32_t(state.range(0)*1024)};
+    uint8_t msg[40] {};
+    uint32_t now_ms = 0;
+    uint64_t sent = 0, dropped = 0;
+    while (state.KeepRunning()) {
+        for (uint8_t i = 0; i < 10; i++) {
+            if (buf.space() >= sizeof(msg) + reserved_space) {
+                buf.write(msg, sizeof(msg));
+                sent++;
+            } else {
+                dropped++;
+            }
+        }
+        if (!io_stalled(now_ms++)) {
+            uint32_t n;
+            buf.readptr(n);
+            buf.advance(MIN(n, chunk_size));
+        }
+    }
+    state.SetItemsProcessed(sent);
+    set_drop_label(state, sent, dropped);
+}
+
+static void BM_WriteRing400kBps(benchmark::State& state)
+{
+    AP_Logger_WriteRing ring;
+    ring.set_size(state.range(0)*1024);
+    uint8_t msg[40] {};
+    uint32_t now_ms = 0;
+    uint64_t sent = 0, dropped = 0;
+    while (state.KeepRunning()) {
+        for (uint8_t i = 0; i < 10; i++) {
+            if (ring.write(msg, sizeof(msg), reserved_space)) {
+                sent++;
+            } else {
+                dropped++;
+            }
+        }
+        if (!io_stalled(now_ms++)) {
+            ByteBuffer::IoVec vec[2];
+            const uint8_t n = ring.peekiovec(vec, chunk_size);
+            uint32_t len = 0;
+            for (uint8_t i = 0; i < n; i++) {
+                len += vec[i].len;
+            }
+            ring.advance(len);
+        }
+    }
+    state.SetItemsProcessed(sent);
+    set_drop_label(state, sent, dropped);
+}
+
+BENCHMARK(BM_ByteBufferLockedWrite);
+BENCHMARK(BM_WriteRingWrite);
+BENCHMARK(BM_ByteBufferLockedContended)->Threads(4);
+BENCHMARK(BM_WriteRingContended)->Threads(4);
+BENCHMARK(BM_ByteBuffer400kBps)->Arg(16)->Arg(64);
+BENCHMARK(BM_WriteRing400kBps)->Arg(16)->Arg(64);
+
+BENCHMARK_MAIN();
@@ -26,6 +26,56 @@
  */
 
 
+/*
+ *  return true if a ray from P in the positive x direction crosses
+ *  the edge from A to B.  Edges are counted if P.y is in the half
+ *  open range between A.y and B.y, so a ray through a vertex crosses
+ *  just one of the edges sharing it
+ */
+template <typename T>
+static inline bool Polygon_edge_crosses_ray(const Vector2<T> &P, const Vector2<T> &A, const Vector2<T> &B)
+{
+    if ((A.y > P.y) == (B.y > P.y)) {
+        return false;
+    }
+    const T dx1 = P.x - A.x;
+    const T dx2 = B.x - A.x;
+    const T dy1 = P.y - A.y;
+    const T dy2 = B.y - A.y;
+    const int8_t dx1s = (dx1 < 0) ? -1 : 1;
+    const int8_t dx2s = (dx2 < 0) ? -1 : 1;
+    const int8_t dy1s = (dy1 < 0) ? -1 : 1;
+    const int8_t dy2s = (dy2 < 0) ? -1 : 1;
+    const int8_t m1 = dx1s * dy2s;
+    const int8_t m2 = dx2s * dy1s;
+    // we avoid the 64 bit multiplies if we can based on sign checks.
+    if (dy2 < 0) {
+        if (m1 > m2) {
+            return true;
+        } else if (m1 < m2) {
+            return false;
+        } else {
+            if (std::is_floating_point<T>::value) {
+                return dx1 * dy2 > dx2 * dy1;
+            } else {
+                return dx1 * (int64_t)dy2 > dx2 * (int64_t)dy1;
+            }
+        }
+    } else {
+        if (m1 < m2) {
+            return true;
+        } else if (m1 > m2) {
+            return false;
+        } else {
+            if (std::is_floating_point<T>::value) {
+                return dx1 * dy2 < dx2 * dy1;
+            } else {
+                return dx1 * (int64_t)dy2 < dx2 * (int64_t)dy1;
+            }
+        }
+    }
+}
+
 /*
  *  Polygon_outside(): test for a point in a polygon
  *     Input:   P = a point,
@@ -54,52 +104,8 @@ bool Polygon_outside(const Vector2<T> &P, const Vector2<T> *V, unsigned n)
         if (j >= n) {
             j = 0;
         }
-        if ((V[i].y > P.y) == (V[j].y > P.y)) {
-            continue;
-        }
-        const T dx1 = P.x - V[i].x;
-        const T dx2 = V[j].x - V[i].x;
-        const T dy1 = P.y - V[i].y;
-        const T dy2 = V[j].y - V[i].y;
-        const int8_t dx1s = (dx1 < 0) ? -1 : 1;
-        const int8_t dx2s = (dx2 < 0) ? -1 : 1;
-        const int8_t dy1s = (dy1 < 0) ? -1 : 1;
-        const int8_t dy2s = (dy2 < 0) ? -1 : 1;
-        const int8_t m1 = dx1s * dy2s;
-        const int8_t m2 = dx2s * dy1s;
-        // we avoid the 64 bit multiplies if we can based on sign checks.
-        if (dy2 < 0) {
-            if (m1 > m2) {
-                outside = !outside;
-            } else if (m1 < m2) {
-                continue;
-            } else {
-                if (std::is_floating_point<T>::value) {
-                    if ( dx1 * dy2 > dx2 * dy1 ) {
-                        outside = !outside;
-                    }
-                } else {
-                    if ( dx1 * (int64_t)dy2 > dx2 * (int64_t)dy1 ) {
-                        outside = !outside;
-                    }
-                }
-            }
-        } else {
-            if (m1 < m2) {
-                outside = !outside;
-            } else if (m1 > m2) {
-                continue;
-            } else {
-                if (std::is_floating_point<T>::value) {
-                    if ( dx1 * dy2 < dx2 * dy1 ) {
-                        outside = !outside;
-                    }
-                } else {
-                    if ( dx1 * (int64_t)dy2 < dx2 * (int64_t)dy1 ) {
-                        outside = !outside;
-                    }
-                }
-            }
+        if (Polygon_edge_crosses_ray(P, V[i], V[j])) {
+            outside = !outside;
         }
     }
     return outside;
@@ -125,6 +131,28 @@ template bool Polygon_outside<float>(const Vector2f &P, const Vector2f *V, unsig
 template bool Polygon_complete<float>(const Vector2f *V, unsigned n);
 
 
+/*
+  return true if the edge from v1 to v2 is intersected by a line from
+  p1 to p2
+ */
+static inline bool Polygon_edge_intersects(const Vector2f &v1, const Vector2f &v2, const Vector2f &p1, const Vector2f &p2, Vector2f &intersection)
+{
+    // optimisations for common cases
+    if (v1.x > p1.x && v2.x > p1.x && v1.x > p2.x && v2.x > p2.x) {
+        return false;
+    }
+    if (v1.y > p1.y && v2.y > p1.y && v1.y > p2.y && v2.y > p2.y) {
+        return false;
+    }
+    if (v1.x < p1.x && v2.x < p1.x && v1.x < p2.x && v2.x < p2.x) {
+        return false;
+    }
+    if (v1.y < p1.y && v2.y < p1.y && v1.y < p2.y && v2.y < p2.y) {
+        return false;
+    }
+    return Vector2f::segment_intersection(v1, v2, p1, p2, intersection);
+}
+
 /*
   determine if the polygon of N verticies defined by points V is
   intersected by a line from point p1 to point p2
@@ -140,28 +168,13 @@ bool Polygon_intersects(const Vector2f *V, unsigned N, const Vector2f &p1, const
     }
 
     float intersect_dist_sq = FLT_MAX;
-    for (uint8_t i=0; i<N; i++) {
-        uint8_t j = i+1;
+    for (unsigned i=0; i<N; i++) {
+        unsigned j = i+1;
         if (j >= N) {
             j = 0;
         }
-        const Vector2f &v1 = V[i];
-        const Vector2f &v2 = V[j];
-        // optimisations for common cases
-        if (v1.x > p1.x && v2.x > p1.x && v1.x > p2.x && v2.x > p2.x) {
-            continue;
-        }
-        if (v1.y > p1.y && v2.y > p1.y && v1.y > p2.y && v2.y > p2.y) {
-            continue;
-        }
-        if (v1.x < p1.x && v2.x < p1.x && v1.x < p2.x && v2.x < p2.x) {
-            continue;
-        }
-        if (v1.y < p1.y && v2.y < p1.y && v1.y < p2.y && v2.y < p2.y) {
-            continue;
-        }
         Vector2f intersect_tmp;
-        if (Vector2f::segment_intersection(v1,v2,p1,p2,intersect_tmp)) {
+        if (Polygon_edge_intersects(V[i], V[j], p1, p2, intersect_tmp)) {
             float dist_sq = sq(intersect_tmp.x - p1.x) + sq(intersect_tmp.y - p1.y);
             if (dist_sq < intersect_dist_sq) {
                 intersect_dist_sq = dist_sq;
@@ -184,7 +197,7 @@ float Polygon_closest_distance_line(const Vector2f *V, unsigned N, const Vector2
         return -sqrtf(sq(intersection.x - p2.x) + sq(intersection.y - p2.y));
     }
     float closest_sq = FLT_MAX;
-    for (uint8_t i=0; i<N-1; i++) {
+    for (unsigned i=0; i<N-1; i++) {
         const Vector2f &v1 = V[i];
         const Vector2f &v2 = V[i+1];
 
@@ -203,7 +216,7 @@ float Polygon_closest_distance_line(const Vector2f *V, unsigned N, const Vector2
 float Polygon_closest_distance_point(const Vector2f *V, unsigned N, const Vector2f &p)
 {
     float closest_sq = FLT_MAX;
-    for (uint8_t i=0; i<N-1; i++) {
+    for (unsigned i=0; i<N-1; i++) {
         const Vector2f &v1 = V[i];
         const Vector2f &v2 = V[i+1];
 
@@ -214,3 +227,255 @@ float Polygon_closest_distance_point(const Vector2f *V, unsigned N, const Vector
     }
     return sqrtf(closest_sq);
 }
+
+/*
+  PolygonIndex sizing. Polygons with fewer edges than this are not
+  worth indexing. The grid has at most MAX_CELLS_PER_SIDE cells on a
+  side, and is made coarser if long edges would otherwise be entered
+  in more than MAX_CELLS_PER_EDGE cells on average
+ */
+#define POLYGON_INDEX_MIN_EDGES             16
+#define POLYGON_INDEX_MAX_CELLS_PER_SIDE    16
+#define POLYGON_INDEX_MAX_CELLS_PER_EDGE    4
+
+// offset of a coordinate from the bounding box minimum, without overflowing for int32_t
+static inline float PolygonIndex_offset(int32_t v, int32_t min)
+{
+    return (float)((int64_t)v - min);
+}
+static inline float PolygonIndex_offset(float v, float min)
+{
+    return v - min;
+}
+
+/*
+  the cell of a coordinate only needs to be monotonic in the
+  coordinate: an edge is entered in every cell between those of its
+  end points, so any point on the edge maps to one of its cells
+ */
+template <typename T>
+uint8_t PolygonIndex<T>::cell(T v, T min, float scale) const
+{
+    const float c = PolygonIndex_offset(v, min) * scale;
+    if (!(c > 0)) {
+        return 0;
+    }
+    if (c >= _cells_per_side) {
+        return _cells_per_side - 1;
+    }
+    return (uint8_t)c;
+}
+
+template <typename T>
+void PolygonIndex<T>::edge_cells(uint16_t i, uint8_t &x0, uint8_t &x1, uint8_t &y0, uint8_t &y1) const
+{
+    const Vector2<T> &v1 = _V[i];
+    const Vector2<T> &v2 = _V[edge_end(i)];
+    x0 = cell(MIN(v1.x, v2.x), _min.x, _scale_x);
+    x1 = cell(MAX(v1.x, v2.x), _min.x, _scale_x);
+    y0 = cell(MIN(v1.y, v2.y), _min.y, _scale_y);
+    y1 = cell(MAX(v1.y, v2.y), _min.y, _scale_y);
+}
+
+template <typename T>
+void PolygonIndex<T>::clear()
+{
+    delete[] _cell_start;
+    _cell_start = nullptr;
+    delete[] _cell_edges;
+    _cell_edges = nullptr;
+    _cells_per_side = 0;
+    _V = nullptr;
+    _num_points = 0;
+    _num_edges = 0;
+}
+
+template <typename T>
+bool PolygonIndex<T>::init(const Vector2<T> *V, unsigned n)
+{
+    clear();
+    _V = V;
+    _num_points = n;
+
+    if (Polygon_complete(V, n)) {
+        n--;
+    }
+    if (n < POLYGON_INDEX_MIN_EDGES || n > UINT16_MAX) {
+        // queries will test every edge
+        return true;
+    }
+    _num_edges = n;
+
+    _min = _max = V[0];
+    for (uint16_t i = 1; i < _num_edges; i++) {
+        _min.x = MIN(_min.x, V[i].x);
+        _min.y = MIN(_min.y, V[i].y);
+        _max.x = MAX(_max.x, V[i].x);
+        _max.y = MAX(_max.y, V[i].y);
+    }
+
+    // aim for a few edges per occupied cell
+    uint8_t cells_per_side = constrain_int16(ceilf(sqrtf(_num_edges)), 2, POLYGON_INDEX_MAX_CELLS_PER_SIDE);
+    uint32_t num_entries;
+    while (true) {
+        _cells_per_side = cells_per_side;
+        const float range_x = PolygonIndex_offset(_max.x, _min.x);
+        const float range_y = PolygonIndex_offset(_max.y, _min.y);
+        _scale_x = is_positive(range_x) ? cells_per_side / range_x : 0;
+        _scale_y = is_positive(range_y) ? cells_per_side / range_y : 0;
+
+        num_entries = 0;
+        for (uint16_t i = 0; i < _num_edges; i++) {
+            uint8_t x0, x1, y0, y1;
+            edge_cells(i, x0, x1, y0, y1);
+            num_entries += (x1 - x0 + 1U) * (y1 - y0 + 1U);
+        }
+        if (num_entries <= POLYGON_INDEX_MAX_CELLS_PER_EDGE * (uint32_t)_num_edges || cells_per_side <= 2) {
+            break;
+        }
+        cells_per_side /= 2;
+    }
+    if (num_entries > UINT16_MAX) {
+        _cells_per_side = 0;
+        return true;
+    }
+
+    const uint16_t num_cells = _cells_per_side * _cells_per_side;
+    _cell_start = new uint16_t[num_cells + 1];
+    _cell_edges = new uint16_t[num_entries];
+    if (_cell_start == nullptr || _cell_edges == nullptr) {
+        delete[] _cell_start;
+        _cell_start = nullptr;
+        delete[] _cell_edges;
+        _cell_edges = nullptr;
+        _cells_per_side = 0;
+        return false;
+    }
+
+    // count entries in each cell and turn the counts into the end of each cell's entries
+    memset(_cell_start, 0, (num_cells + 1) * sizeof(_cell_start[0]));
+    for (uint16_t i = 0; i < _num_edges; i++) {
+        uint8_t x0, x1, y0, y1;
+        edge_cells(i, x0, x1, y0, y1);
+        for (uint8_t y = y0; y <= y1; y++) {
+            for (uint8_t x = x0; x <= x1; x++) {
+                _cell_start[y * _cells_per_side + x]++;
+            }
+        }
+    }
+    for (uint16_t c = 1; c <= num_cells; c++) {
+        _cell_start[c] += _cell_start[c - 1];
+    }
+
+    // fill in entries from the back, leaving each cell's start in _cell_start
+    for (int32_t i = _num_edges - 1; i >= 0; i--) {
+        uint8_t x0, x1, y0, y1;
+        edge_cells(i, x0, x1, y0, y1);
+        for (uint8_t y = y0; y <= y1; y++) {
+            for (uint8_t x = x0; x <= x1; x++) {
+                _cell_edges[--_cell_start[y * _cells_per_side + x]] = i;
+            }
+        }
+    }
+
+    return true;
+}
+
+template <typename T>
+bool PolygonIndex<T>::outside(const Vector2<T> &P) const
+{
+    if (!indexed()) {
+        if (_V == nullptr) {
+            return true;
+        }
+        return Polygon_outside(P, _V, _num_points);
+    }
+
+    // the ray can only cross edges spanning P.y
+    if (P.y < _min.y || P.y > _max.y) {
+        return true;
+    }
+
+    // count crossings with edges in the cells from P along the ray
+    const uint8_t row = cell(P.y, _min.y, _scale_y);
+    const uint8_t first_col = cell(P.x, _min.x, _scale_x);
+    bool outside = true;
+    for (uint8_t col = first_col; col < _cells_per_side; col++) {
+        const uint16_t c = row * _cells_per_side + col;
+        for (uint16_t k = _cell_start[c]; k < _cell_start[c + 1]; k++) {
+            const uint16_t i = _cell_edges[k];
+            const uint16_t j = edge_end(i);
+            // edges spanning several cells are only counted in the first of them along the ray
+            if (col != first_col && cell(MIN(_V[i].x, _V[j].x), _min.x, _scale_x) != col) {
+                continue;
+            }
+            if (Polygon_edge_crosses_ray(P, _V[i], _V[j])) {
+                outside = !outside;
+            }
+        }
+    }
+    return outside;
+}
+
+template <>
+bool PolygonIndex<float>::intersects(const Vector2f &p1, const Vector2f &p2, Vector2f &intersection) const
+{
+    if (!indexed()) {
+        if (_V == nullptr) {
+            return false;
+        }
+        return Polygon_intersects(_V, _num_points, p1, p2, intersection);
+    }
+
+    // no intersection if the segment is outside the bounding box
+    const float seg_min_y = MIN(p1.y, p2.y);
+    const float seg_max_y = MAX(p1.y, p2.y);
+    if (MAX(p1.x, p2.x) < _min.x || MIN(p1.x, p2.x) > _max.x || seg_max_y < _min.y || seg_min_y > _max.y) {
+        return false;
+    }
+
+    // test edges in the cells the segment passes through, row by row.
+    // Edges spanning several cells may be tested more than once, which
+    // does not change the closest intersection
+    const uint8_t first_row = cell(seg_min_y, _min.y, _scale_y);
+    const uint8_t last_row = cell(seg_max_y, _min.y, _scale_y);
+    float intersect_dist_sq = FLT_MAX;
+    for (uint8_t row = first_row; row <= last_row; row++) {
+        // x extent of the part of the segment within this row
+        float x_lo = MIN(p1.x, p2.x);
+        float x_hi = MAX(p1.x, p2.x);
+        if (first_row != last_row) {
+            const float y_lo = (row == first_row) ? seg_min_y : _min.y + row / _scale_y;
+            const float y_hi = (row == last_row) ? seg_max_y : _min.y + (row + 1) / _scale_y;
+            const float x_at_lo = p1.x + (p2.x - p1.x) * (y_lo - p1.y) / (p2.y - p1.y);
+            const float x_at_hi = p1.x + (p2.x - p1.x) * (y_hi - p1.y) / (p2.y - p1.y);
+            x_lo = MIN(x_at_lo, x_at_hi);
+            x_hi = MAX(x_at_lo, x_at_hi);
+        }
+        // widen by a cell to allow for rounding
+        const uint8_t first_col = MAX(cell(x_lo, _min.x, _scale_x), 1) - 1;
+        const uint8_t last_col = MIN(cell(x_hi, _min.x, _scale_x) + 1, _cells_per_side - 1);
+        for (uint8_t col = first_col; col <= last_col; col++) {
+            const uint16_t c = row * _cells_per_side + col;
+            for (uint16_t k = _cell_start[c]; k < _cell_start[c + 1]; k++) {
+                const uint16_t i = _cell_edges[k];
+                Vector2f intersect_tmp;
+                if (Polygon_edge_intersects(_V[i], _V[edge_end(i)], p1, p2, intersect_tmp)) {
+                    const float dist_sq = sq(intersect_tmp.x - p1.x) + sq(intersect_tmp.y - p1.y);
+                    if (dist_sq < intersect_dist_sq) {
+                        intersect_dist_sq = dist_sq;
+                        intersection = intersect_tmp;
+                    }
+                }
+            }
+        }
+    }
+    return (intersect_dist_sq < FLT_MAX);
+}
+
+template bool PolygonIndex<int32_t>::init(const Vector2l *V, unsigned n);
+template void PolygonIndex<int32_t>::clear();
+template bool PolygonIndex<int32_t>::outside(const Vector2l &P) const;
+template bool PolygonIndex<float>::init(const Vector2f *V, unsigned n);
+template void PolygonIndex<float>::clear();
+template bool PolygonIndex<float>::outside(const Vector2f &P) const;
@@ -44,3 +44,61 @@ float Polygon_closest_distance_line(const Vector2f *V, unsigned N, const Vector2
   closed polygon V, defined by N points
  */
 float Polygon_closest_distance_point(const Vector2f *V, unsigned N, const Vector2f &p);
+
+/*
+  uniform grid index of the edges of a polygon, so that point in
+  polygon and segment crossing tests only look at edges near the
+  point or segment. Results are the same as Polygon_outside and
+  Polygon_intersects on the whole polygon. The vertices are not
+  copied and must stay valid while the index is in use
+ */
+template <typename T>
+class PolygonIndex {
+public:
+    PolygonIndex() {}
+    ~PolygonIndex() { clear(); }
+
+    CLASS_NO_COPY(PolygonIndex);
+
+    // index the polygon V of n vertices.  Small polygons are not
+    // indexed.  Returns false if out of memory, in which case queries
+    // fall back to testing every edge
+    bool init(const Vector2<T> *V, unsigned n);
+
+    // free the index and forget the polygon
+    void clear();
+
+    // true if the polygon's edges are indexed
+    bool indexed() const { return _cells_per_side != 0; }
+
+    // return true if P is outside the polygon, as Polygon_outside()
+    bool outside(const Vector2<T> &P) const WARN_IF_UNUSED;
+
+    // return true if the segment from p1 to p2 crosses an edge of the
+    // polygon, as Polygon_intersects().  Only available for float
+    bool intersects(const Vector2<T> &p1, const Vector2<T> &p2, Vector2<T> &intersection) const WARN_IF_UNUSED;
+
+private:
+    // cell column or row of a coordinate, clamped to the grid
+    uint8_t cell(T v, T min, float scale) const;
+
+    // cells covered by the bounding box of the edge starting at vertex i
+    void edge_cells(uint16_t i, uint8_t &x0, uint8_t &x1, uint8_t &y0, uint8_t &y1) const;
+
+    // vertex at the end of the edge starting at vertex i
+    uint16_t edge_end(uint16_t i) const { return (i + 1U < _num_edges) ? i + 1U : 0U; }
+
+    const Vector2<T> *_V = nullptr;
+    unsigned _num_points = 0;       // number of vertices as passed to init
+    uint16_t _num_edges = 0;        // number of edges, i.e. vertices less any closing point
+    uint8_t _cells_per_side = 0;    // zero if not indexed
+    Vector2<T> _min;                // bounding box of the polygon
+    Vector2<T> _max;
+    float _scale_x;                 // cells per unit of x and y
+    float _scale_y;
+    uint16_t *_cell_start = nullptr;    // start of each cell's edges in _cell_edges, row major, plus one past the end
+    uint16_t *_cell_edges = nullptr;    // first vertex of each edge overlapping each cell
+};
+
+template <>
+bool PolygonIndex<float>::intersects(const Vector2f &p1, const Vector2f &p2, Vector2f &intersection) const;
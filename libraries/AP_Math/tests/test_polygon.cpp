@@ -356,6 +356,91 @@ TEST(Polygon, simple)
     TEST_POLYGON_POINTS(SIMPLE_boundary, SIMPLE_test_points);
 }
 
+/*
+  a star shaped polygon with enough vertices to be indexed, closed if
+  requested. Returns the number of points
+ */
+template <typename T>
+static unsigned make_star(Vector2<T> *v, unsigned num_vertices, float outer, float inner, bool closed)
+{
+    for (unsigned i=0; i<num_vertices; i++) {
+        const float angle = radians(360.0f * i / num_vertices);
+        const float radius = (i & 1) ? inner : outer;
+        v[i] = Vector2<T>{T(radius * cosf(angle)), T(radius * sinf(angle))};
+    }
+    if (closed) {
+        v[num_vertices] = v[0];
+        return num_vertices + 1;
+    }
+    return num_vertices;
+}
+
+TEST(Polygon, index_outside)
+{
+    for (bool closed : {false, true}) {
+        Vector2f v[101];
+        const unsigned n = make_star(v, 100, 1000.0f, 600.0f, closed);
+        PolygonIndex<float> index;
+        EXPECT_TRUE(index.init(v, n));
+        EXPECT_TRUE(index.indexed());
+        for (int16_t x=-1100; x<=1100; x+=17) {
+            for (int16_t y=-1100; y<=1100; y+=13) {
+                const Vector2f p{float(x), float(y)};
+                EXPECT_EQ(Polygon_outside(p, v, n), index.outside(p));
+            }
+        }
+        // points on vertices
+        for (unsigned i=0; i<n; i++) {
+            EXPECT_EQ(Polygon_outside(v[i], v, n), index.outside(v[i]));
+        }
+    }
+}
+
+TEST(Polygon, index_outside_long)
+{
+    Vector2l v[100];
+    const unsigned n = make_star(v, 100, 1.0e9f, 6.0e8f, false);
+    PolygonIndex<int32_t> index;
+    EXPECT_TRUE(index.init(v, n));
+    EXPECT_TRUE(index.indexed());
+    for (int32_t x=-1100000000; x<=1100000000; x+=17000000) {
+        for (int32_t y=-1100000000; y<=1100000000; y+=13000000) {
+            const Vector2l p{x, y};
+            EXPECT_EQ(Polygon_outside(p, v, n), index.outside(p));
+        }
+    }
+}
+
+TEST(Polygon, index_intersects)
+{
+    Vector2f v[100];
+    const unsigned n = make_star(v, 100, 1000.0f, 600.0f, false);
+    PolygonIndex<float> index;
+    EXPECT_TRUE(index.init(v, n));
+    for (uint16_t i=0; i<360; i+=7) {
+        for (uint16_t j=0; j<360; j+=11) {
+            const Vector2f p1{1200.0f * cosf(radians(i)), 700.0f * sinf(radians(i))};
+            const Vector2f p2{300.0f * cosf(radians(j)), 1300.0f * sinf(radians(j))};
+            Vector2f expected, intersection;
+            const bool result = Polygon_intersects(v, n, p1, p2, expected);
+            EXPECT_EQ(result, index.intersects(p1, p2, intersection));
+            if (result) {
+                EXPECT_FLOAT_EQ(expected.x, intersection.x);
+                EXPECT_FLOAT_EQ(expected.y, intersection.y);
+            }
+        }
+    }
+    // small polygons are not indexed but give the same answers
+    const Vector2f square[] {{0,0}, {0,10}, {10,10}, {10,0}};
+    PolygonIndex<float> small;
+    EXPECT_TRUE(small.init(square, 4));
+    EXPECT_FALSE(small.indexed());
+    EXPECT_FALSE(small.outside(Vector2f{5,5}));
+    Vector2f intersection;
+    EXPECT_TRUE(small.intersects(Vector2f{5,5}, Vector2f{15,5}, intersection));
+    EXPECT_FLOAT_EQ(10.0f, intersection.x);
+}
+
 AP_GTEST_MAIN()
 
 
@@ -54,6 +54,10 @@ void AP_Mission::init()
     // command list will be cleared if they do not match
     check_eeprom_version();
 
+#if AP_MISSION_CMD_CACHE_ENABLED
+    init_cmd_cache();
+#endif
+
     // If Mission Clear bit is set then it should clear the mission, otherwise retain the mission.
     if (AP_MISSION_MASK_MISSION_CLEAR & _options) {
         gcs().send_text(MAV_SEVERITY_INFO, "Clearing Mission");
@@ -419,8 +423,22 @@ bool AP_Mission::is_nav_cmd(const Mission_Command& cmd)
 ///     accounts for do_jump commands but never increments the jump's num_times_run (advance_current_nav_cmd is responsible for this)
 bool AP_Mission::get_next_nav_cmd(uint16_t start_index, Mission_Command& cmd)
 {
+#if AP_MISSION_CMD_CACHE_ENABLED
+    WITH_SEMAPHORE(_rsem);
+    const bool use_index = update_next_nav_index();
+#endif
+
     // search until the end of the mission command list
     for (uint16_t cmd_index = start_index; cmd_index < (unsigned)_cmd_total; cmd_index++) {
+#if AP_MISSION_CMD_CACHE_ENABLED
+        // skip over "do" commands, they would be passed over below
+        if (use_index) {
+            cmd_index = _next_nav.index[cmd_index];
+            if (cmd_index >= (unsigned)_cmd_total) {
+                return false;
+            }
+        }
+#endif
         // get next command
         if (!get_next_cmd(cmd_index, cmd, false)) {
             // no more commands so return failure
@@ -688,6 +706,15 @@ bool AP_Mission::read_cmd_from_storage(uint16_t index, Mission_Command& cmd) con
         return false;
     }
 
+#if AP_MISSION_CMD_CACHE_ENABLED
+    // use decoded copy if we have one
+    const bool cacheable = index < _cmd_cache.size;
+    if (cacheable && (_cmd_cache.valid[index / 32] & (1U << (index % 32)))) {
+        cmd = _cmd_cache.cmds[index];
+        return true;
+    }
+#endif
+
     // ensure all bytes of cmd are zeroed
     cmd = {};
 
@@ -742,6 +769,13 @@ bool AP_Mission::read_cmd_from_storage(uint16_t index, Mission_Command& cmd) con
     // set command's index to it's position in eeprom
     cmd.index = index;
 
+#if AP_MISSION_CMD_CACHE_ENABLED
+    if (cacheable) {
+        _cmd_cache.cmds[index] = cmd;
+        _cmd_cache.valid[index / 32] |= (1U << (index % 32));
+    }
+#endif
+
     // return success
     return true;
 }
@@ -818,6 +852,11 @@ bool AP_Mission::write_cmd_to_storage(uint16_t index, const Mission_Command& cmd
         _storage.write_block(pos_in_storage+5, packed.bytes, 10);
     }
 
+#if AP_MISSION_CMD_CACHE_ENABLED
+    // the command is decoded again from storage on the next read as not all of it is stored
+    invalidate_cmd_cache(index);
+#endif
+
     // remember when the mission last changed
     _last_change_time_ms = AP_HAL::millis();
 
@@ -825,6 +864,73 @@ bool AP_Mission::write_cmd_to_storage(uint16_t index, const Mission_Command& cmd
     return true;
 }
 
+#if AP_MISSION_CMD_CACHE_ENABLED
+/// init_cmd_cache - allocate the decoded command cache, runs without it if out of memory
+void AP_Mission::init_cmd_cache()
+{
+    WITH_SEMAPHORE(_rsem);
+
+    if (_cmd_cache.cmds != nullptr) {
+        return;
+    }
+
+    const uint16_t size = num_commands_max();
+    _cmd_cache.cmds = new Mission_Command[size];
+    _cmd_cache.valid = new uint32_t[(size + 31) / 32];
+    _next_nav.index = new uint16_t[size + 1];
+    if (_cmd_cache.cmds == nullptr || _cmd_cache.valid == nullptr || _next_nav.index == nullptr) {
+        delete[] _cmd_cache.cmds;
+        delete[] _cmd_cache.valid;
+        delete[] _next_nav.index;
+        _cmd_cache.cmds = nullptr;
+        _cmd_cache.valid = nullptr;
+        _next_nav.index = nullptr;
+        return;
+    }
+    _cmd_cache.size = size;
+    _next_nav.valid = false;
+}
+
+/// invalidate_cmd_cache - forget the cached copy of a command, called whenever it is written
+void AP_Mission::invalidate_cmd_cache(uint16_t index)
+{
+    if (index < _cmd_cache.size) {
+        _cmd_cache.valid[index / 32] &= ~(1U << (index % 32));
+    }
+    _next_nav.valid = false;
+}
+
+/// update_next_nav_index - rebuild the next nav index if the mission has changed
+///     returns false if the index is not available
+bool AP_Mission::update_next_nav_index()
+{
+    const uint16_t cmd_total = _cmd_total;
+    if (_next_nav.index == nullptr || cmd_total > _cmd_cache.size) {
+        return false;
+    }
+    if (_next_nav.valid && _next_nav.cmd_total == cmd_total) {
+        return true;
+    }
+
+    // work backwards from the end of the mission, which also fills the cache
+    uint16_t next = cmd_total;
+    _next_nav.index[cmd_total] = cmd_total;
+    for (int32_t i = cmd_total - 1; i >= 0; i--) {
+        Mission_Command cmd;
+        if (!read_cmd_from_storage(i, cmd)) {
+            return false;
+        }
+        if (cmd.id == MAV_CMD_DO_JUMP || is_nav_cmd(cmd)) {
+            next = i;
+        }
+        _next_nav.index[i] = next;
+    }
+    _next_nav.cmd_total = cmd_total;
+    _next_nav.valid = true;
+    return true;
+}
+#endif
+
 /// write_home_to_storage - writes the special purpose cmd 0 (home) to storage
 ///     home is taken directly from ahrs
 void AP_Mission::write_home_to_storage()
@@ -37,6 +37,10 @@
 #endif
 #endif
 
+#ifndef AP_MISSION_CMD_CACHE_ENABLED
+#define AP_MISSION_CMD_CACHE_ENABLED (HAL_MEM_CLASS >= HAL_MEM_CLASS_500)  // keep decoded copies of commands in RAM
+#endif
+
 #define AP_MISSION_JUMP_REPEAT_FOREVER      -1      // when do-jump command's repeat count is -1 this means endless repeat
 
 #define AP_MISSION_CMD_ID_NONE              0       // mavlink cmd id of zero means invalid or missing command
@@ -715,6 +719,18 @@ private:
     /// check if the next nav command is a takeoff, skipping delays
     bool is_takeoff_next(uint16_t start_index);
 
+#if AP_MISSION_CMD_CACHE_ENABLED
+    /// init_cmd_cache - allocate the decoded command cache, runs without it if out of memory
+    void init_cmd_cache();
+
+    /// invalidate_cmd_cache - forget the cached copy of a command, called whenever it is written
+    void invalidate_cmd_cache(uint16_t index);
+
+    /// update_next_nav_index - rebuild the next nav index if the mission has changed
+    ///     returns false if the index is not available
+    bool update_next_nav_index();
+#endif
+
     // pointer to main program functions
     mission_cmd_fn_t        _cmd_start_fn;  // pointer to function which will be called when a new command is started
     mission_cmd_fn_t        _cmd_verify_fn; // pointer to function which will be called repeatedly to ensure a command is progressing
@@ -745,6 +761,24 @@ private:
     // last time that mission changed
     uint32_t _last_change_time_ms;
 
+#if AP_MISSION_CMD_CACHE_ENABLED
+    // decoded copies of commands read from storage, filled in as commands are read and
+    // invalidated as they are written.  Mutable as it is filled in by read_cmd_from_storage
+    mutable struct {
+        Mission_Command *cmds;      // decoded commands (num_commands_max elements)
+        uint32_t *valid;            // bitmask of elements in cmds holding a copy of storage
+        uint16_t size;              // number of commands the above arrays can hold
+    } _cmd_cache {};
+
+    // index of the first "navigation" or do-jump command at or after each command.
+    // Lets get_next_nav_cmd skip straight over runs of "do" commands
+    struct {
+        uint16_t *index;            // next nav or do-jump command (_cmd_cache.size elements)
+        uint16_t cmd_total;         // number of commands in the mission when the index was built
+        bool valid;                 // true if index matches the commands in storage
+    } _next_nav {};
+#endif
+
 
     // multi-thread support. This is static so it can be used from
     // const functions
@@ -10,6 +10,8 @@
 
 #include <new>
 
+extern const AP_HAL::HAL& hal;
+
 /*
   parameter defaults for different types of vehicle. The
   APM_BUILD_DIRECTORY is taken from the main vehicle directory name
@@ -719,7 +721,17 @@ const AP_Param::GroupInfo NavEKF3::var_info2[] = {
     // @Increment: 1
     // @User: Advanced
     AP_GROUPINFO("PRIMARY", 8, NavEKF3, _primary_core, EK3_PRIMARY_DEFAULT),
-    
+
+#if EK3_PARALLEL_CORES_ENABLED
+    // @Param: THREADS
+    // @DisplayName: Core update threads
+    // @Description: Number of additional threads used to update EKF cores in parallel. Only available on Linux and SITL builds. A value of 0 updates all cores one after another in the main thread. The estimates produced are identical either way. Takes effect on the next update after it is changed.
+    // @Range: 0 2
+    // @Increment: 1
+    // @User: Advanced
+    AP_GROUPINFO("THREADS", 9, NavEKF3, _core_threads, 0),
+#endif
+
     AP_GROUPEND
 };
 
@@ -876,6 +888,117 @@ bool NavEKF3::coreBetterScore(uint8_t new_core, uint8_t current_core) const
     return coreRelativeErrors[new_core] < coreRelativeErrors[current_core];
 }
 
+#if EK3_PARALLEL_CORES_ENABLED
+/*
+  start or stop core update threads to match EK3_THREADS and the
+  number of cores. Returns the number of threads available. If no
+  thread can be started the cores are updated in the main thread
+ */
+uint8_t NavEKF3::update_core_workers(void)
+{
+    const uint8_t want = num_cores > 1 ? MIN(uint8_t(MAX(_core_threads.get(), 0)), uint8_t(num_cores-1)) : 0;
+    if (want == workers.wanted) {
+        return workers.num_threads;
+    }
+    std::unique_lock<std::mutex> lock(workers.mutex);
+    workers.wanted = want;
+    while (!workers.init_failed && workers.num_threads < want) {
+        if (!hal.scheduler->thread_create(FUNCTOR_BIND_MEMBER(&NavEKF3::core_worker_thread, void),
+                                          "EKF3", 32*1024, AP_HAL::Scheduler::PRIORITY_MAIN, 0)) {
+            if (workers.num_threads == 0) {
+                workers.init_failed = true;
+                GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "EKF3 failed to start core threads");
+            }
+            break;
+        }
+        workers.num_threads++;
+    }
+    if (workers.num_threads > want) {
+        // wake the threads without publishing any cores so the extra
+        // ones exit
+        workers.next_core = num_cores;
+        workers.generation++;
+        lock.unlock();
+        workers.start_cond.notify_all();
+        return want;
+    }
+    return workers.num_threads;
+}
+
+void NavEKF3::core_worker_thread(void)
+{
+    uint32_t generation = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(workers.mutex);
+            workers.start_cond.wait(lock, [&]{ return workers.generation != generation; });
+            generation = workers.generation;
+            if (workers.num_threads > workers.wanted) {
+                // no longer needed
+                workers.num_threads--;
+                return;
+            }
+        }
+        update_claimed_cores();
+    }
+}
+
+/*
+  claim and update cores until none are left. Called from the worker
+  threads and from the main thread
+ */
+void NavEKF3::update_claimed_cores(void)
+{
+    uint8_t i;
+    while ((i = workers.next_core.fetch_add(1)) < num_cores) {
+        core[i].UpdateFilter(workers.allow_state_prediction[i]);
+        if (workers.cores_done.fetch_add(1) + 1 == num_cores) {
+            std::lock_guard<std::mutex> lock(workers.mutex);
+            workers.done_cond.notify_one();
+        }
+    }
+}
+
+void NavEKF3::update_cores_parallel(void)
+{
+    /*
+      the prediction decisions read DAL state which is only safe from
+      the main thread, so make them all before handing out cores. This
+      is only done when cores are updated in parallel; the serial
+      update decides for each core just before updating it
+     */
+    for (uint8_t i=0; i<num_cores; i++) {
+        workers.allow_state_prediction[i] = !(core[i].getFramesSincePredict() < (_framesPerPrediction+3) &&
+                                              AP::dal().ekf_low_time_remaining(AP_DAL::EKFType::EKF3, i));
+        // GCS and logging are main thread only, so cores queue
+        // their messages until all updates are done
+        core[i].set_defer_output(true);
+    }
+
+    workers.cores_done = 0;
+    workers.next_core = 0;
+    {
+        std::lock_guard<std::mutex> lock(workers.mutex);
+        workers.generation++;
+    }
+    workers.start_cond.notify_all();
+
+    update_claimed_cores();
+
+    // all cores must be complete before any are compared
+    {
+        std::unique_lock<std::mutex> lock(workers.mutex);
+        workers.done_cond.wait(lock, [&]{ return workers.cores_done == num_cores; });
+    }
+
+    // send queued messages in core order, as a serial update would
+    for (uint8_t i=0; i<num_cores; i++) {
+        core[i].set_defer_output(false);
+        core[i].send_deferred_output();
+    }
+}
+#endif // EK3_PARALLEL_CORES_ENABLED
+
 /* 
   Update Filter States - this should be called whenever new IMU data is available
   Execution speed governed by SCHED_LOOP_RATE
@@ -890,6 +1013,17 @@ void NavEKF3::UpdateFilter(void)
 
     imuSampleTime_us = AP::dal().micros64();
 
+#if EK3_PARALLEL_CORES_ENABLED
+    /*
+      cores only share state through the common origin, so once that
+      is set they can be updated concurrently without changing the
+      result. Until then run them in order so the first core to set
+      the origin is always the same one
+     */
+    if (update_core_workers() > 0 && common_origin_valid) {
+        update_cores_parallel();
+    } else
+#endif
     for (uint8_t i=0; i<num_cores; i++) {
         // if we have not overrun by more than 3 IMU frames, and we
         // have already used more than 1/3 of the CPU budget for this
@@ -26,6 +26,14 @@
 #include <AP_NavEKF/AP_Nav_Common.h>
 #include <AP_NavEKF/AP_NavEKF_Source.h>
 
+#include "AP_NavEKF3_feature.h"
+
+#if EK3_PARALLEL_CORES_ENABLED
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#endif
+
 class NavEKF3_core;
 class EKFGSF_yaw;
 
@@ -424,6 +432,9 @@ private:
     AP_Float _ognmTestScaleFactor;  // Scale factor applied to the thresholds used by the on ground not moving test
     AP_Float _baroGndEffectDeadZone;// Dead zone applied to positive baro height innovations when in ground effect (m)
     AP_Int8 _primary_core;          // initial core number
+#if EK3_PARALLEL_CORES_ENABLED
+    AP_Int8 _core_threads;          // number of worker threads used to update cores in parallel
+#endif
 
 // Possible values for _flowUse
 #define FLOW_USE_NONE    0
@@ -509,6 +520,40 @@ private:
     struct Location common_EKF_origin;
     bool common_origin_valid;
     
+#if EK3_PARALLEL_CORES_ENABLED
+    /*
+      worker pool for updating cores in parallel. The main thread
+      publishes a new generation, then claims cores alongside the
+      workers from a shared counter, and waits until every core is
+      done before core selection runs
+     */
+    struct {
+        std::mutex mutex;
+        std::condition_variable start_cond;
+        std::condition_variable done_cond;
+        uint32_t generation = 0;
+        std::atomic<uint8_t> next_core{0};
+        std::atomic<uint8_t> cores_done{0};
+        bool allow_state_prediction[MAX_EKF_CORES] {};
+        uint8_t num_threads = 0;    // threads running, protected by mutex
+        uint8_t wanted = 0;         // threads wanted, written by the main thread
+        bool init_failed = false;
+    } workers;
+
+    // start or stop worker threads to match EK3_THREADS and the
+    // number of cores, returns the number of threads available
+    uint8_t update_core_workers(void);
+
+    // worker thread main loop
+    void core_worker_thread(void);
+
+    // update unclaimed cores until there are none left
+    void update_claimed_cores(void);
+
+    // update all cores using the worker pool
+    void update_cores_parallel(void);
+#endif
+
     // update the yaw reset data to capture changes due to a lane switch
     // new_primary - index of the ekf instance that we are about to switch to as the primary
     // old_primary - index of the ekf instance that we are currently using as the primary
@@ -253,7 +253,7 @@ void NavEKF3_core::tryChangeCompass(void)
         // if the magnetometer is allowed to be used for yaw and has a different index, we start using it
         if (compass.healthy(tempIndex) && compass.use_for_yaw(tempIndex) && tempIndex != magSelectIndex) {
             magSelectIndex = tempIndex;
-            GCS_SEND_TEXT(MAV_SEVERITY_INFO, "EKF3 IMU%u switching to compass %u",(unsigned)imu_index,magSelectIndex);
+            send_text(MAV_SEVERITY_INFO, "EKF3 IMU%u switching to compass %u",(unsigned)imu_index,magSelectIndex);
             // reset the timeout flag and timer
             magTimeout = false;
             lastHealthyMagTime_ms = imuSampleTime_ms;
@@ -1399,7 +1399,7 @@ void NavEKF3_core::updateMovementCheck(void)
             gyro_diff_ratio    : float(gyro_diff_ratio),
             accel_diff_ratio   : float(accel_diff_ratio),
         };
-        AP::logger().WriteBlock(&pkt, sizeof(pkt));
+        write_log_block(&pkt, sizeof(pkt));
     }
 }
 
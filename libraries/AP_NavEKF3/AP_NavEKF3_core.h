@@ -127,6 +127,16 @@ public:
     // The predict flag is set true when a new prediction cycle can be started
     void UpdateFilter(bool predict);
 
+#if EK3_PARALLEL_CORES_ENABLED
+    // queue text and log messages instead of sending them, for when
+    // this core is updated on a worker thread
+    void set_defer_output(bool defer) { deferred.active = defer; }
+
+    // send text and log messages queued while output was deferred.
+    // Must be called from the main thread
+    void send_deferred_output(void);
+#endif
+
     // Check basic filter health metrics and return a consolidated health status
     bool healthy(void) const;
 
@@ -431,6 +441,31 @@ private:
     EKFGSF_yaw *yawEstimator;
     AP_DAL &dal;
 
+    // send a text message, queueing it if output is deferred
+    void send_text(MAV_SEVERITY severity, const char *fmt, ...) FMT_PRINTF(3, 4);
+
+    // write a log message, queueing it if output is deferred
+    void write_log_block(const void *pkt, uint8_t size);
+
+#if EK3_PARALLEL_CORES_ENABLED
+    /*
+      text and log messages queued during an update on a worker
+      thread, as neither GCS nor the logger front end can be used off
+      the main thread. Log messages are stored as a length byte
+      followed by the message
+     */
+    struct {
+        bool active;
+        uint8_t num_texts;
+        struct {
+            MAV_SEVERITY severity;
+            char text[MAVLINK_MSG_STATUSTEXT_FIELD_TEXT_LEN+1];
+        } texts[4];
+        uint8_t log_used;
+        uint8_t log_buf[128];
+    } deferred {};
+#endif
+
     // Reference to the global EKF frontend for parameters
     class NavEKF3 *frontend;
     uint8_t imu_index; // preferred IMU index
@@ -25,3 +25,8 @@
 #define EK3_FEATURE_DRAG_FUSION EK3_FEATURE_ALL || BOARD_FLASH_SIZE > 1024
 #endif
 
+
+// running cores on worker threads on multi-core hosts
+#ifndef EK3_PARALLEL_CORES_ENABLED
+#define EK3_PARALLEL_CORES_ENABLED (CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX)
+#endif
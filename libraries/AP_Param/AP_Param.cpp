@@ -24,6 +24,7 @@
 #include "AP_Param.h"
 
 #include <cmath>
+#include <ctype.h>
 #include <string.h>
 
 #include <AP_Common/AP_Common.h>
@@ -42,6 +43,7 @@
 extern const AP_HAL::HAL &hal;
 
 uint16_t AP_Param::sentinal_offset;
+uint32_t AP_Param::_load_all_time_us;
 
 // singleton instance
 AP_Param *AP_Param::_singleton;
@@ -89,6 +91,26 @@ uint16_t AP_Param::_count_marker;
 uint16_t AP_Param::_count_marker_done;
 HAL_Semaphore AP_Param::_count_sem;
 
+#if AP_PARAM_NAME_INDEX_ENABLED
+// hashed parameter name index
+struct AP_Param::name_index_entry *AP_Param::_name_index;
+uint16_t *AP_Param::_name_index_sorted;
+uint16_t AP_Param::_name_index_count;
+uint16_t AP_Param::_name_index_marker;
+uint32_t AP_Param::_name_index_build_ms;
+bool AP_Param::_name_index_enabled = true;
+HAL_Semaphore AP_Param::_name_index_sem;
+#endif
+
+#if AP_PARAM_STORAGE_INDEX_ENABLED
+// hash table of parameter offsets in storage
+uint16_t *AP_Param::_storage_index;
+uint16_t AP_Param::_storage_index_size;
+uint16_t AP_Param::_storage_index_count;
+bool AP_Param::_storage_index_valid;
+HAL_Semaphore AP_Param::_storage_index_sem;
+#endif
+
 // storage and naming information about all types that can be saved
 const AP_Param::Info *AP_Param::_var_info;
 
@@ -160,6 +182,11 @@ void AP_Param::erase_all(void)
 
     // add a sentinal directly after the header
     write_sentinal(sizeof(struct EEPROM_header));
+
+#if AP_PARAM_STORAGE_INDEX_ENABLED
+    // storage is now known to be empty
+    storage_index_reset(true);
+#endif
 }
 
 /* the 'group_id' of a element of a group is the 18 bit identifier
@@ -354,6 +381,9 @@ bool AP_Param::setup(void)
             hdr2.magic[1] == k_EEPROM_magic1 &&
             hdr2.revision == k_EEPROM_revision &&
             _storage.copy_area(_storage_bak)) {
+#if AP_PARAM_STORAGE_INDEX_ENABLED
+            storage_index_reset(false);
+#endif
             // restored from backup
             INTERNAL_ERROR(AP_InternalError::error_t::params_restored);
             return true;
@@ -736,6 +766,18 @@ bool AP_Param::is_sentinal(const Param_header &phdr)
 // if the sentinal isn't found either, the offset is set to 0xFFFF
 bool AP_Param::scan(const AP_Param::Param_header *target, uint16_t *pofs)
 {
+#if AP_PARAM_STORAGE_INDEX_ENABLED
+    {
+        WITH_SEMAPHORE(_storage_index_sem);
+        if (_storage_index_valid) {
+            if (storage_index_find(*target, *pofs)) {
+                return true;
+            }
+            *pofs = sentinal_offset;
+            return false;
+        }
+    }
+#endif
     struct Param_header phdr;
     uint16_t ofs = sizeof(AP_Param::EEPROM_header);
     while (ofs < _storage.size()) {
@@ -760,6 +802,120 @@ bool AP_Param::scan(const AP_Param::Param_header *target, uint16_t *pofs)
     return false;
 }
 
+#if AP_PARAM_STORAGE_INDEX_ENABLED
+/*
+  hash a Param_header into the storage index
+ */
+uint16_t AP_Param::storage_index_hash(const Param_header &phdr)
+{
+    const uint32_t v = (uint32_t(get_key(phdr)) << 23) ^ (uint32_t(phdr.group_element) << 5) ^ phdr.type;
+    return (v * 2654435761U) >> 16;
+}
+
+/*
+  find the storage offset of a header in the storage index. Must be
+  called with _storage_index_sem held
+ */
+bool AP_Param::storage_index_find(const Param_header &target, uint16_t &ofs)
+{
+    if (_storage_index_count == 0) {
+        return false;
+    }
+    const uint16_t mask = _storage_index_size - 1;
+    for (uint16_t slot = storage_index_hash(target) & mask; ; slot = (slot + 1) & mask) {
+        const uint16_t sofs = _storage_index[slot];
+        if (sofs == 0) {
+            return false;
+        }
+        struct Param_header phdr;
+        _storage.read_block(&phdr, sofs, sizeof(phdr));
+        if (phdr.type == target.type &&
+            get_key(phdr) == get_key(target) &&
+            phdr.group_element == target.group_element) {
+            ofs = sofs;
+            return true;
+        }
+    }
+}
+
+/*
+  add a header at the given storage offset to the storage index. The
+  first copy of a header in storage wins, matching the linear
+  scan. Must be called with _storage_index_sem held
+ */
+bool AP_Param::storage_index_insert(const Param_header &phdr, uint16_t ofs)
+{
+    // keep the load factor at or below 0.5
+    if ((_storage_index_count + 1U) * 2U > _storage_index_size &&
+        !storage_index_grow()) {
+        return false;
+    }
+    const uint16_t mask = _storage_index_size - 1;
+    uint16_t slot = storage_index_hash(phdr) & mask;
+    while (_storage_index[slot] != 0) {
+        struct Param_header phdr2;
+        _storage.read_block(&phdr2, _storage_index[slot], sizeof(phdr2));
+        if (phdr2.type == phdr.type &&
+            get_key(phdr2) == get_key(phdr) &&
+            phdr2.group_element == phdr.group_element) {
+            return true;
+        }
+        slot = (slot + 1) & mask;
+    }
+    _storage_index[slot] = ofs;
+    _storage_index_count++;
+    return true;
+}
+
+/*
+  double the size of the storage index and rehash. Must be called
+  with _storage_index_sem held
+ */
+bool AP_Param::storage_index_grow(void)
+{
+    const uint32_t new_size = _storage_index_size == 0 ? 64U : _storage_index_size * 2U;
+    if (new_size > 0x8000U) {
+        return false;
+    }
+    uint16_t *new_index = new uint16_t[new_size]();
+    if (new_index == nullptr) {
+        return false;
+    }
+    const uint16_t mask = new_size - 1;
+    for (uint16_t i=0; i<_storage_index_size; i++) {
+        const uint16_t sofs = _storage_index[i];
+        if (sofs == 0) {
+            continue;
+        }
+        struct Param_header phdr;
+        _storage.read_block(&phdr, sofs, sizeof(phdr));
+        uint16_t slot = storage_index_hash(phdr) & mask;
+        while (new_index[slot] != 0) {
+            slot = (slot + 1) & mask;
+        }
+        new_index[slot] = sofs;
+    }
+    delete[] _storage_index;
+    _storage_index = new_index;
+    _storage_index_size = new_size;
+    return true;
+}
+
+/*
+  empty the storage index, marking if it reflects the contents of
+  storage
+ */
+void AP_Param::storage_index_reset(bool valid)
+{
+    WITH_SEMAPHORE(_storage_index_sem);
+    if (_storage_index != nullptr) {
+        memset(_storage_index, 0, _storage_index_size * sizeof(_storage_index[0]));
+    }
+    _storage_index_count = 0;
+    _storage_index_valid = valid;
+}
+#endif // AP_PARAM_STORAGE_INDEX_ENABLED
+
 /**
  * add a _X, _Y, _Z suffix to the name of a Vector3f element
  * @param buffer
@@ -890,6 +1046,42 @@ AP_Param::find_group(const char *name, uint16_t vindex, ptrdiff_t group_offset,
 //
 AP_Param *
 AP_Param::find(const char *name, enum ap_var_type *ptype, uint16_t *flags)
+{
+    AP_Param *ap = nullptr;
+#if AP_PARAM_NAME_INDEX_ENABLED
+    {
+        WITH_SEMAPHORE(_name_index_sem);
+        if (name_index_update()) {
+            const struct name_index_entry *e = name_index_lookup(name);
+            if (e != nullptr) {
+                *ptype = (enum ap_var_type)e->type;
+                ap = e->ap;
+            }
+        }
+    }
+#endif
+    if (ap == nullptr) {
+        // the index only holds visible scalars, so hidden parameters
+        // and whole vectors need the full search
+        ap = find_linear(name, ptype);
+    }
+    if (ap != nullptr && flags != nullptr) {
+        uint32_t group_element = 0;
+        const struct GroupInfo *ginfo;
+        struct GroupNesting group_nesting {};
+        uint8_t idx;
+        ap->find_var_info(&group_element, ginfo, group_nesting, &idx);
+        if (ginfo != nullptr) {
+            *flags = ginfo->flags;
+        }
+    }
+    return ap;
+}
+
+// Find a variable by name, searching the whole var_info tree
+//
+AP_Param *
+AP_Param::find_linear(const char *name, enum ap_var_type *ptype)
 {
     for (uint16_t i=0; i<_num_vars; i++) {
         const auto &info = var_info(i);
@@ -905,16 +1097,6 @@ AP_Param::find(const char *name, enum ap_var_type *ptype, uint16_t *flags)
             }
             AP_Param *ap = find_group(name + len, i, 0, group_info, ptype);
             if (ap != nullptr) {
-                if (flags != nullptr) {
-                    uint32_t group_element = 0;
-                    const struct GroupInfo *ginfo;
-                    struct GroupNesting group_nesting {};
-                    uint8_t idx;
-                    ap->find_var_info(&group_element, ginfo, group_nesting, &idx);
-                    if (ginfo != nullptr) {
-                        *flags = ginfo->flags;
-                    }
-                }
                 return ap;
             }
             // we continue looking as we want to allow top level
@@ -932,11 +1114,28 @@ AP_Param::find(const char *name, enum ap_var_type *ptype, uint16_t *flags)
     return nullptr;
 }
 
-// Find a variable by index. Note that this is quite slow.
+// Find a variable by index. Note that this is quite slow without the
+// name index.
 //
 AP_Param *
 AP_Param::find_by_index(uint16_t idx, enum ap_var_type *ptype, ParamToken *token)
 {
+#if AP_PARAM_NAME_INDEX_ENABLED
+    {
+        WITH_SEMAPHORE(_name_index_sem);
+        if (name_index_update()) {
+            if (idx >= _name_index_count) {
+                return nullptr;
+            }
+            const struct name_index_entry &e = _name_index[idx];
+            *token = e.token;
+            if (ptype != nullptr) {
+                *ptype = (enum ap_var_type)e.type;
+            }
+            return e.ap;
+        }
+    }
+#endif
     AP_Param *ap;
     uint16_t count=0;
     for (ap=AP_Param::first(token, ptype);
@@ -950,6 +1149,21 @@ AP_Param::find_by_index(uint16_t idx, enum ap_var_type *ptype, ParamToken *token
 // by-name equivalent of find_by_index()
 AP_Param* AP_Param::find_by_name(const char* name, enum ap_var_type *ptype, ParamToken *token)
 {
+#if AP_PARAM_NAME_INDEX_ENABLED
+    {
+        WITH_SEMAPHORE(_name_index_sem);
+        if (name_index_update()) {
+            // the index holds exactly the parameters visited below
+            const struct name_index_entry *e = name_index_lookup(name);
+            if (e == nullptr) {
+                return nullptr;
+            }
+            *token = e->token;
+            *ptype = (enum ap_var_type)e->type;
+            return e->ap;
+        }
+    }
+#endif
     AP_Param *ap;
     uint16_t count = 0;
     for (ap = AP_Param::first(token, ptype);
@@ -968,6 +1182,156 @@ AP_Param* AP_Param::find_by_name(const char* name, enum ap_var_type *ptype, Para
     return ap;
 }
 
+#if AP_PARAM_NAME_INDEX_ENABLED
+/*
+  case-insensitive FNV-1a hash of a parameter name, truncated to fit
+  in name_index_entry
+ */
+uint32_t AP_Param::name_hash(const char *name)
+{
+    uint32_t hash = 2166136261U;
+    for (uint8_t i=0; i<AP_MAX_NAME_SIZE && name[i] != 0; i++) {
+        hash ^= (uint8_t)toupper(name[i]);
+        hash *= 16777619U;
+    }
+    return hash & ((1U<<27)-1);
+}
+
+/*
+  make sure the name index is up to date, rebuilding it if the
+  parameter tree has changed. Must be called with _name_index_sem
+  held. Returns false if the index can't be used
+ */
+bool AP_Param::name_index_update(void)
+{
+    if (!_name_index_enabled) {
+        return false;
+    }
+    if (_name_index != nullptr && _name_index_marker == _count_marker) {
+        return true;
+    }
+    const uint32_t now_ms = AP_HAL::millis();
+    if (_name_index != nullptr &&
+        now_ms - _name_index_build_ms < AP_PARAM_NAME_INDEX_REBUILD_MS) {
+        // the tree is still changing (eg. while loading pointer
+        // objects or scripting tables), use the linear search until
+        // it settles
+        return false;
+    }
+    _name_index_build_ms = now_ms;
+    return name_index_build();
+}
+
+/*
+  build the name index from a full walk of the parameter tree
+ */
+bool AP_Param::name_index_build(void)
+{
+    const uint16_t marker = _count_marker;
+
+    ParamToken token {};
+    enum ap_var_type type;
+    uint16_t count = 0;
+    for (AP_Param *ap = first(&token, &type);
+         ap != nullptr;
+         ap = next_scalar(&token, &type)) {
+        count++;
+    }
+    if (count == 0) {
+        return false;
+    }
+
+    if (_name_index == nullptr || count != _name_index_count) {
+        delete[] _name_index;
+        delete[] _name_index_sorted;
+        _name_index_count = 0;
+        _name_index = new name_index_entry[count];
+        _name_index_sorted = new uint16_t[count];
+        if (_name_index == nullptr || _name_index_sorted == nullptr) {
+            delete[] _name_index;
+            delete[] _name_index_sorted;
+            _name_index = nullptr;
+            _name_index_sorted = nullptr;
+            return false;
+        }
+    }
+
+    uint16_t n = 0;
+    char name[AP_MAX_NAME_SIZE+1];
+    for (AP_Param *ap = first(&token, &type);
+         ap != nullptr && n < count;
+         ap = next_scalar(&token, &type)) {
+        ap->copy_name_token(token, name, AP_MAX_NAME_SIZE);
+        name[AP_MAX_NAME_SIZE] = 0;
+        struct name_index_entry &e = _name_index[n];
+        e.ap = ap;
+        e.token = token;
+        e.hash = name_hash(name);
+        e.type = type;
+        _name_index_sorted[n] = n;
+        n++;
+    }
+    _name_index_count = n;
+
+    // shell sort of the hash order. Names are close to random in
+    // hash order so plain insertion sort would be O(n^2)
+    for (uint16_t gap = n/2; gap > 0; gap /= 2) {
+        for (uint16_t i = gap; i < n; i++) {
+            const uint16_t v = _name_index_sorted[i];
+            const uint32_t h = _name_index[v].hash;
+            uint16_t j = i;
+            while (j >= gap && _name_index[_name_index_sorted[j-gap]].hash > h) {
+                _name_index_sorted[j] = _name_index_sorted[j-gap];
+                j -= gap;
+            }
+            _name_index_sorted[j] = v;
+        }
+    }
+
+    _name_index_marker = marker;
+    return true;
+}
+
+/*
+  find a scalar parameter in the name index. Must be called with
+  _name_index_sem held and after a successful name_index_update()
+ */
+const struct AP_Param::name_index_entry *AP_Param::name_index_lookup(const char *name)
+{
+    const uint32_t hash = name_hash(name);
+
+    // bisect for the first entry with a matching hash
+    uint16_t lo = 0;
+    uint16_t hi = _name_index_count;
+    while (lo < hi) {
+        const uint16_t mid = (lo + hi) / 2;
+        if (_name_index[_name_index_sorted[mid]].hash < hash) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    // confirm the name, allowing for hash collisions
+    char buf[AP_MAX_NAME_SIZE+1];
+    for (; lo < _name_index_count; lo++) {
+        const struct name_index_entry &e = _name_index[_name_index_sorted[lo]];
+        if (e.hash != hash) {
+            break;
+        }
+        if (e.type > AP_PARAM_FLOAT) {
+            continue;
+        }
+        e.ap->copy_name_token(e.token, buf, AP_MAX_NAME_SIZE);
+        buf[AP_MAX_NAME_SIZE] = 0;
+        if (strncasecmp(name, buf, AP_MAX_NAME_SIZE) == 0) {
+            return &e;
+        }
+    }
+    return nullptr;
+}
+#endif // AP_PARAM_NAME_INDEX_ENABLED
+
 /*
   Find a variable by pointer, returning key. This is used for loading pointer variables
 */
@@ -1217,6 +1581,16 @@ void AP_Param::save_sync(bool force_save, bool send_to_gcs)
     eeprom_write_check(ap, ofs+sizeof(phdr), type_size((enum ap_var_type)phdr.type));
     eeprom_write_check(&phdr, ofs, sizeof(phdr));
 
+#if AP_PARAM_STORAGE_INDEX_ENABLED
+    {
+        WITH_SEMAPHORE(_storage_index_sem);
+        if (_storage_index_valid && !storage_index_insert(phdr, ofs)) {
+            // out of memory, go back to the linear scan
+            _storage_index_valid = false;
+        }
+    }
+#endif
+
     if (send_to_gcs) {
         send_parameter(name, (enum ap_var_type)phdr.type, idx);
     }
@@ -1508,6 +1882,7 @@ bool AP_Param::load_all()
 {
     struct Param_header phdr;
     uint16_t ofs = sizeof(AP_Param::EEPROM_header);
+    const uint32_t start_us = AP_HAL::micros();
 
     reload_defaults_file(false);
 
@@ -1515,15 +1890,32 @@ bool AP_Param::load_all()
         registered_save_handler = true;
         hal.scheduler->register_io_process(FUNCTOR_BIND((&save_dummy), &AP_Param::save_io_handler, void));
     }
-    
+
+#if AP_PARAM_STORAGE_INDEX_ENABLED
+    // rebuild the storage index as we walk storage
+    WITH_SEMAPHORE(_storage_index_sem);
+    storage_index_reset(false);
+    bool index_ok = true;
+#endif
+
     while (ofs < _storage.size()) {
         _storage.read_block(&phdr, ofs, sizeof(phdr));
         if (is_sentinal(phdr)) {
             // we've reached the sentinal
             sentinal_offset = ofs;
+#if AP_PARAM_STORAGE_INDEX_ENABLED
+            _storage_index_valid = index_ok;
+#endif
+            _load_all_time_us = AP_HAL::micros() - start_us;
             return true;
         }
 
+#if AP_PARAM_STORAGE_INDEX_ENABLED
+        if (index_ok) {
+            index_ok = storage_index_insert(phdr, ofs);
+        }
+#endif
+
         const struct AP_Param::Info *info;
         void *ptr;
 
@@ -1537,6 +1929,7 @@ bool AP_Param::load_all()
 
     // we didn't find the sentinal
     Debug("no sentinal in load_all");
+    _load_all_time_us = AP_HAL::micros() - start_us;
     return false;
 }
 
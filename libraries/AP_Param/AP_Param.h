@@ -55,6 +55,28 @@
 #endif
 #define AP_PARAM_DYNAMIC_KEY_BASE 300
 
+/*
+  hashed index of parameter names, giving fast find() and
+  find_by_index(). Costs 14 bytes of RAM per parameter
+ */
+#ifndef AP_PARAM_NAME_INDEX_ENABLED
+#define AP_PARAM_NAME_INDEX_ENABLED (HAL_MEM_CLASS >= HAL_MEM_CLASS_500)
+#endif
+
+// minimum time between rebuilds of the name index
+#ifndef AP_PARAM_NAME_INDEX_REBUILD_MS
+#define AP_PARAM_NAME_INDEX_REBUILD_MS 1000
+#endif
+
+/*
+  hash table of the storage offsets of saved parameters, avoiding a
+  linear walk of storage in scan(). Costs 4 bytes of RAM per saved
+  parameter
+ */
+#ifndef AP_PARAM_STORAGE_INDEX_ENABLED
+#define AP_PARAM_STORAGE_INDEX_ENABLED (HAL_MEM_CLASS >= HAL_MEM_CLASS_500)
+#endif
+
 /*
   flags for variables in var_info and group tables
  */
@@ -393,6 +415,10 @@ public:
     ///
     static bool load_all();
 
+    // returns time taken by the last load_all() in microseconds, shown
+    // in @SYS/storage.txt
+    static uint32_t load_all_time_us() { return _load_all_time_us; }
+
     // returns storage space used:
     static uint16_t storage_used() { return sentinal_offset; }
 
@@ -511,6 +537,12 @@ public:
 
     static void set_hide_disabled_groups(bool value) { _hide_disabled_groups = value; }
 
+#if AP_PARAM_NAME_INDEX_ENABLED
+    // enable or disable use of the name index. Disabling it is only
+    // useful to compare against the linear search in benchmarks
+    static void set_name_index_enabled(bool value) { _name_index_enabled = value; }
+#endif
+
     // set frame type flags. Used to unhide frame specific parameters
     static void set_frame_type_flags(uint16_t flags_to_set) {
         invalidate_count();
@@ -562,6 +594,7 @@ private:
     static_assert(sizeof(struct EEPROM_header) == 4, "Bad EEPROM_header size!");
 
     static uint16_t sentinal_offset;
+    static uint32_t _load_all_time_us;
 
 /* This header is prepended to a variable stored in EEPROM.
  *  The meaning is as follows:
@@ -662,6 +695,9 @@ private:
                                     ptrdiff_t group_offset,
                                     const struct GroupInfo *group_info,
                                     enum ap_var_type *ptype);
+    static AP_Param *           find_linear(
+                                    const char *name,
+                                    enum ap_var_type *ptype);
     static void                 write_sentinal(uint16_t ofs);
     static uint16_t             get_key(const Param_header &phdr);
     static void                 set_key(Param_header &phdr, uint16_t key);
@@ -669,6 +705,26 @@ private:
     static bool                 scan(
                                     const struct Param_header *phdr,
                                     uint16_t *pofs);
+
+#if AP_PARAM_STORAGE_INDEX_ENABLED
+    /*
+      open addressing hash table of storage offsets keyed by
+      Param_header. A zero offset marks an empty slot as offset zero
+      is always the EEPROM_header. The table is only used once a full
+      walk of storage has found the sentinal
+     */
+    static uint16_t *           _storage_index;
+    static uint16_t             _storage_index_size;
+    static uint16_t             _storage_index_count;
+    static bool                 _storage_index_valid;
+    static HAL_Semaphore        _storage_index_sem;
+
+    static uint16_t             storage_index_hash(const Param_header &phdr);
+    static bool                 storage_index_find(const Param_header &phdr, uint16_t &ofs);
+    static bool                 storage_index_insert(const Param_header &phdr, uint16_t ofs);
+    static bool                 storage_index_grow(void);
+    static void                 storage_index_reset(bool valid);
+#endif
     static void                 eeprom_write_check(
                                     const void *ptr,
                                     uint16_t ofs,
@@ -716,6 +772,32 @@ private:
     static HAL_Semaphore        _count_sem;
     static const struct Info *  _var_info;
 
+#if AP_PARAM_NAME_INDEX_ENABLED
+    /*
+      index of all scalar parameters in next_scalar() order, with a
+      second table giving that order sorted by hash of the name. The
+      index is rebuilt when the parameter count is invalidated
+     */
+    struct name_index_entry {
+        AP_Param *ap;
+        ParamToken token;
+        uint32_t hash : 27;
+        uint32_t type : 5;
+    };
+    static struct name_index_entry *_name_index;
+    static uint16_t *           _name_index_sorted;
+    static uint16_t             _name_index_count;
+    static uint16_t             _name_index_marker;
+    static uint32_t             _name_index_build_ms;
+    static bool                 _name_index_enabled;
+    static HAL_Semaphore        _name_index_sem;
+
+    static uint32_t             name_hash(const char *name);
+    static bool                 name_index_update(void);
+    static bool                 name_index_build(void);
+    static const struct name_index_entry *name_index_lookup(const char *name);
+#endif
+
 #if AP_PARAM_DYNAMIC_ENABLED
     // allow for a dynamically allocated var table
     static uint16_t             _num_vars_base;
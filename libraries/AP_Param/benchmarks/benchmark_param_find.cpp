@@ -0,0 +1,131 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_Param/AP_Param.h>
+#include <GCS_MAVLink/GCS_Dummy.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+const struct AP_Param::GroupInfo        GCS_MAVLINK_Parameters::var_info[] = {
+    AP_GROUPEND
+};
+GCS_Dummy _gcs;
+
+/*
+  a parameter tree of roughly the size of a Copter build: 32 top level
+  groups of 32 parameters each
+ */
+class BenchGroup {
+public:
+    static const struct AP_Param::GroupInfo var_info[];
+    AP_Float p[32];
+};
+
+#define BENCH_PARAM(n) AP_GROUPINFO("PARAM" #n, n+1, BenchGroup, p[n], 0)
+
+const struct AP_Param::GroupInfo BenchGroup::var_info[] = {
+    BENCH_PARAM(0),  BENCH_PARAM(1),  BENCH_PARAM(2),  BENCH_PARAM(3),
+    BENCH_PARAM(4),  BENCH_PARAM(5),  BENCH_PARAM(6),  BENCH_PARAM(7),
+    BENCH_PARAM(8),  BENCH_PARAM(9),  BENCH_PARAM(10), BENCH_PARAM(11),
+    BENCH_PARAM(12), BENCH_PARAM(13), BENCH_PARAM(14), BENCH_PARAM(15),
+    BENCH_PARAM(16), BENCH_PARAM(17), BENCH_PARAM(18), BENCH_PARAM(19),
+    BENCH_PARAM(20), BENCH_PARAM(21), BENCH_PARAM(22), BENCH_PARAM(23),
+    BENCH_PARAM(24), BENCH_PARAM(25), BENCH_PARAM(26), BENCH_PARAM(27),
+    BENCH_PARAM(28), BENCH_PARAM(29), BENCH_PARAM(30), BENCH_PARAM(31),
+    AP_GROUPEND
+};
+
+static BenchGroup groups[32];
+static AP_Int16 format_version;
+
+#define BENCH_GROUP(n, name) { AP_PARAM_GROUP, name, n+1, (const void *)&groups[n], {group_info : BenchGroup::var_info} }
+
+static const AP_Param::Info var_info[] = {
+    { AP_PARAM_INT16, "FORMAT_VERSION", 0, &format_version, {def_value : 0} },
+    BENCH_GROUP(0, "G00_"),  BENCH_GROUP(1, "G01_"),  BENCH_GROUP(2, "G02_"),  BENCH_GROUP(3, "G03_"),
+    BENCH_GROUP(4, "G04_"),  BENCH_GROUP(5, "G05_"),  BENCH_GROUP(6, "G06_"),  BENCH_GROUP(7, "G07_"),
+    BENCH_GROUP(8, "G08_"),  BENCH_GROUP(9, "G09_"),  BENCH_GROUP(10, "G10_"), BENCH_GROUP(11, "G11_"),
+    BENCH_GROUP(12, "G12_"), BENCH_GROUP(13, "G13_"), BENCH_GROUP(14, "G14_"), BENCH_GROUP(15, "G15_"),
+    BENCH_GROUP(16, "G16_"), BENCH_GROUP(17, "G17_"), BENCH_GROUP(18, "G18_"), BENCH_GROUP(19, "G19_"),
+    BENCH_GROUP(20, "G20_"), BENCH_GROUP(21, "G21_"), BENCH_GROUP(22, "G22_"), BENCH_GROUP(23, "G23_"),
+    BENCH_GROUP(24, "G24_"), BENCH_GROUP(25, "G25_"), BENCH_GROUP(26, "G26_"), BENCH_GROUP(27, "G27_"),
+    BENCH_GROUP(28, "G28_"), BENCH_GROUP(29, "G29_"), BENCH_GROUP(30, "G30_"), BENCH_GROUP(31, "G31_"),
+    AP_VAREND
+};
+
+static AP_Param param_loader(var_info);
+
+// a name near the end of the tree, the worst case for the linear search
+static const char *bench_name = "G30_PARAM17";
+
+static void BM_ParamFindLinear(benchmark::State& state)
+{
+    AP_Param::set_name_index_enabled(false);
+    enum ap_var_type ptype;
+    while (state.KeepRunning()) {
+        AP_Param *vp = AP_Param::find(bench_name, &ptype);
+        gbenchmark_escape(vp);
+    }
+}
+
+static void BM_ParamFindIndexed(benchmark::State& state)
+{
+    AP_Param::set_name_index_enabled(true);
+    enum ap_var_type ptype;
+    while (state.KeepRunning()) {
+        AP_Param *vp = AP_Param::find(bench_name, &ptype);
+        gbenchmark_escape(vp);
+    }
+}
+
+static void BM_ParamFindByNameLinear(benchmark::State& state)
+{
+    AP_Param::set_name_index_enabled(false);
+    enum ap_var_type ptype;
+    AP_Param::ParamToken token;
+    while (state.KeepRunning()) {
+        AP_Param *vp = AP_Param::find_by_name(bench_name, &ptype, &token);
+        gbenchmark_escape(vp);
+    }
+}
+
+static void BM_ParamFindByNameIndexed(benchmark::State& state)
+{
+    AP_Param::set_name_index_enabled(true);
+    enum ap_var_type ptype;
+    AP_Param::ParamToken token;
+    while (state.KeepRunning()) {
+        AP_Param *vp = AP_Param::find_by_name(bench_name, &ptype, &token);
+        gbenchmark_escape(vp);
+    }
+}
+
+static void BM_ParamFindByIndexLinear(benchmark::State& state)
+{
+    AP_Param::set_name_index_enabled(false);
+    enum ap_var_type ptype;
+    AP_Param::ParamToken token;
+    while (state.KeepRunning()) {
+        AP_Param *vp = AP_Param::find_by_index(1000, &ptype, &token);
+        gbenchmark_escape(vp);
+    }
+}
+
+static void BM_ParamFindByIndexIndexed(benchmark::State& state)
+{
+    AP_Param::set_name_index_enabled(true);
+    enum ap_var_type ptype;
+    AP_Param::ParamToken token;
+    while (state.KeepRunning()) {
+        AP_Param *vp = AP_Param::find_by_index(1000, &ptype, &token);
+        gbenchmark_escape(vp);
+    }
+}
+
+BENCHMARK(BM_ParamFindLinear);
+BENCHMARK(BM_ParamFindIndexed);
+BENCHMARK(BM_ParamFindByNameLinear);
+BENCHMARK(BM_ParamFindByNameIndexed);
+BENCHMARK(BM_ParamFindByIndexLinear);
+BENCHMARK(BM_ParamFindByIndexIndexed);
+
+BENCHMARK_MAIN();
@@ -28,6 +28,7 @@
 #include <AP_InternalError/AP_InternalError.h>
 #include <AP_Common/ExpandingString.h>
 #include <AP_HAL/SIMState.h>
+#include "LogStructure.h"
 
 #if CONFIG_HAL_BOARD == HAL_BOARD_SITL
 #include <SITL/SITL.h>
@@ -40,6 +41,10 @@
 #define SCHEDULER_DEFAULT_LOOP_RATE  50
 #endif
 
+#ifndef SCHEDULER_DEFAULT_SHED_PRIORITY
+#define SCHEDULER_DEFAULT_SHED_PRIORITY 110
+#endif
+
 #define debug(level, fmt, args...)   do { if ((level) <= _debug.get()) { hal.console->printf(fmt, ##args); }} while (0)
 
 extern const AP_HAL::HAL& hal;
@@ -63,10 +68,17 @@ const AP_Param::GroupInfo AP_Scheduler::var_info[] = {
     // @Param: OPTIONS
     // @DisplayName: Scheduling options
     // @Description: This controls optional aspects of the scheduler.
-    // @Bitmask: 0:Enable per-task perf info
+    // @Bitmask: 0:Enable per-task perf info,1:Adaptive scheduling
     // @User: Advanced
     AP_GROUPINFO("OPTIONS",  2, AP_Scheduler, _options, 0),
 
+    // @Param: SHED_PRI
+    // @DisplayName: Adaptive scheduling shed priority
+    // @Description: When adaptive scheduling is enabled in SCHED_OPTIONS, tasks are fitted into the remaining loop time using their measured run times rather than the budget from the task table, and while the main loop is running late, tasks with a priority number at or above this value are deferred, down to a quarter of their normal rate. Deferred tasks are recorded in the PMS log message.
+    // @Range: 0 255
+    // @User: Advanced
+    AP_GROUPINFO("SHED_PRI",  3, AP_Scheduler, _shed_priority, SCHEDULER_DEFAULT_SHED_PRIORITY),
+
     AP_GROUPEND
 };
 
@@ -127,6 +139,7 @@ void AP_Scheduler::init(const AP_Scheduler::Task *tasks, uint8_t num_tasks, uint
     if (_options & uint8_t(Options::RECORD_TASK_INFO)) {
         perf_info.allocate_task_info(_num_tasks);
     }
+    update_adaptive_state();
 
     _log_performance_bit = log_performance_bit;
 
@@ -180,6 +193,8 @@ void AP_Scheduler::run(uint32_t time_available)
     uint8_t vehicle_tasks_offset = 0;
     uint8_t common_tasks_offset = 0;
 
+    adaptive_task_t *adaptive = (_options & uint8_t(Options::ADAPTIVE_SCHEDULING)) ? _adaptive : nullptr;
+
     for (uint8_t i=0; i<_num_tasks; i++) {
         // determine which of the common task / vehicle task to run
         bool run_vehicle_task = false;
@@ -212,6 +227,8 @@ void AP_Scheduler::run(uint32_t time_available)
             common_tasks_offset++;
         }
 
+        // time from the start of the tick the task became due in
+        uint32_t jitter_us = now - run_started_usec;
         if (task.priority > MAX_FAST_TASK_PRIORITIES) {
             const uint16_t dt = _tick_counter - _last_run[i];
             // we allow 0 to mean loop rate
@@ -230,13 +247,35 @@ void AP_Scheduler::run(uint32_t time_available)
                 perf_info.task_slipped(i);
             }
 
+            jitter_us += (dt - interval_ticks) * get_loop_period_us();
+
             if (dt >= interval_ticks*max_task_slowdown) {
                 // we are going beyond the maximum slowdown factor for a
                 // task. This will trigger increasing the time budget
                 task_not_achieved++;
             }
 
-            if (_task_time_allowed > time_available) {
+            uint32_t time_needed = _task_time_allowed;
+            if (adaptive != nullptr) {
+                if (_under_pressure &&
+                    task.priority >= _shed_priority &&
+                    dt < interval_ticks*max_task_slowdown) {
+                    // the loop is running late; defer this low
+                    // priority task, at most until it reaches the
+                    // maximum slowdown
+                    if (adaptive[i].shed_count < UINT16_MAX) {
+                        adaptive[i].shed_count++;
+                    }
+                    debug(2, "Scheduler shed task[%u-%s]\n", (unsigned)i, task.name);
+                    continue;
+                }
+                // fit the task using what it has been measured to take
+                if (adaptive[i].avg_time_us != 0) {
+                    time_needed = adaptive[i].avg_time_us;
+                }
+            }
+
+            if (time_needed > time_available) {
                 // not enough time to run this task.  Continue loop -
                 // maybe another task will fit into time remaining
                 continue;
@@ -272,7 +311,19 @@ void AP_Scheduler::run(uint32_t time_available)
                   (unsigned)_task_time_allowed);
         }
 
-        perf_info.update_task_info(i, time_taken, overrun);
+        perf_info.update_task_info(i, time_taken, jitter_us, overrun);
+
+        if (adaptive != nullptr && task.priority > MAX_FAST_TASK_PRIORITIES) {
+            // move up quickly and down slowly, so the estimate follows
+            // the expensive runs of a task rather than its mean
+            uint16_t &avg = adaptive[i].avg_time_us;
+            const uint16_t t = MIN(time_taken, UINT16_MAX);
+            if (t > avg) {
+                avg += (t - avg + 1) / 2;
+            } else {
+                avg -= (avg - t) / 16;
+            }
+        }
 
         if (time_taken >= time_available) {
             time_available = 0;
@@ -365,6 +416,10 @@ void AP_Scheduler::loop()
     // add in extra loop time determined by not achieving scheduler tasks
     time_available += extra_loop_us;
 
+    // the loop is under pressure if we are already stretching it,
+    // or the last loop ran over its period by more than 10%
+    _under_pressure = extra_loop_us > 0 || _last_loop_time_s > get_loop_period_s() * 1.1f;
+
     // run the tasks
     run(time_available);
 
@@ -408,7 +463,15 @@ void AP_Scheduler::update_logging()
     if (_log_performance_bit != (uint32_t)-1 &&
         AP::logger().should_log(_log_performance_bit)) {
         Log_Write_Performance();
+        Log_Write_Task_Performance();
+        Log_Write_Task_Shedding();
+    }
+    if (_adaptive != nullptr) {
+        for (uint8_t i = 0; i < _num_tasks; i++) {
+            _adaptive[i].shed_count = 0;
+        }
     }
+    update_adaptive_state();
     perf_info.set_loop_rate(get_loop_rate_hz());
     perf_info.reset();
     // dynamically update the per-task perf counter
@@ -442,11 +505,87 @@ void AP_Scheduler::Log_Write_Performance()
     AP::logger().WriteCriticalBlock(&pkt, sizeof(pkt));
 }
 
+// write out the timing distribution of the main loop and each task that ran
+void AP_Scheduler::Log_Write_Task_Performance()
+{
+    const uint64_t now_us = AP_HAL::micros64();
+    const AP::PerfInfo::Histogram &loop_hist = perf_info.get_loop_time_hist();
+    const struct log_PerfTask loop_pkt = {
+        LOG_PACKET_HEADER_INIT(LOG_PERF_TASK_MSG),
+        time_us   : now_us,
+        task      : UINT8_MAX,
+        count     : perf_info.get_num_loops(),
+        p50       : loop_hist.percentile(0.5f),
+        p99       : loop_hist.percentile(0.99f),
+        p999      : loop_hist.percentile(0.999f),
+        max       : perf_info.get_max_time(),
+        jitter_p50 : 0,
+        jitter_p99 : 0,
+        overruns  : perf_info.get_num_long_running(),
+    };
+    AP::logger().WriteBlock(&loop_pkt, sizeof(loop_pkt));
+
+    for (uint8_t i = 0; i < _num_tasks; i++) {
+        const AP::PerfInfo::TaskInfo* ti = perf_info.get_task_info(i);
+        if (ti == nullptr) {
+            // per-task statistics are not enabled
+            return;
+        }
+        if (ti->tick_count == 0) {
+            continue;
+        }
+        const struct log_PerfTask pkt = {
+            LOG_PACKET_HEADER_INIT(LOG_PERF_TASK_MSG),
+            time_us   : now_us,
+            task      : i,
+            count     : ti->tick_count,
+            p50       : ti->time_hist.percentile(0.5f),
+            p99       : ti->time_hist.percentile(0.99f),
+            p999      : ti->time_hist.percentile(0.999f),
+            max       : ti->max_time_us,
+            jitter_p50 : ti->jitter_hist.percentile(0.5f),
+            jitter_p99 : ti->jitter_hist.percentile(0.99f),
+            overruns  : ti->overrun_count,
+        };
+        AP::logger().WriteBlock(&pkt, sizeof(pkt));
+    }
+}
+
+// write out the tasks deferred by adaptive scheduling since the last call
+void AP_Scheduler::Log_Write_Task_Shedding()
+{
+    if (_adaptive == nullptr) {
+        return;
+    }
+    const uint64_t now_us = AP_HAL::micros64();
+    for (uint8_t i = 0; i < _num_tasks; i++) {
+        if (_adaptive[i].shed_count == 0) {
+            continue;
+        }
+        const struct log_PerfShed pkt = {
+            LOG_PACKET_HEADER_INIT(LOG_PERF_SHED_MSG),
+            time_us   : now_us,
+            task      : i,
+            shed      : _adaptive[i].shed_count,
+            avg_time  : _adaptive[i].avg_time_us,
+        };
+        AP::logger().WriteBlock(&pkt, sizeof(pkt));
+    }
+}
+
+// allocate the adaptive scheduling state when it is first enabled
+void AP_Scheduler::update_adaptive_state()
+{
+    if (_adaptive == nullptr && (_options & uint8_t(Options::ADAPTIVE_SCHEDULING))) {
+        _adaptive = new adaptive_task_t[_num_tasks];
+    }
+}
+
 // display task statistics as text buffer for @SYS/tasks.txt
 void AP_Scheduler::task_info(ExpandingString &str)
 {
     // a header to allow for machine parsers to determine format
-    str.printf("TasksV2\n");
+    str.printf("TasksV3\n");
 
     // dynamically enable statistics collection
     if (!(_options & uint8_t(Options::RECORD_TASK_INFO))) {
@@ -458,6 +597,8 @@ void AP_Scheduler::task_info(ExpandingString &str)
         return;
     }
 
+    perf_info.print_loop_info(str);
+
     // baseline the total time taken by all tasks
     float total_time = 1.0f;
     for (uint8_t i = 0; i < _num_tasks + 1; i++) {
@@ -96,7 +96,8 @@ public:
     };
 
     enum class Options : uint8_t {
-        RECORD_TASK_INFO = 1 << 0
+        RECORD_TASK_INFO = 1 << 0,
+        ADAPTIVE_SCHEDULING = 1 << 1,
     };
 
     enum FastTaskPriorities {
@@ -119,6 +120,12 @@ public:
     // write out PERF message to logger
     void Log_Write_Performance();
 
+    // write out PMT messages with task timing distributions to logger
+    void Log_Write_Task_Performance();
+
+    // write out PMS messages for tasks deferred by adaptive scheduling
+    void Log_Write_Task_Shedding();
+
     // call when one tick has passed
     void tick(void);
 
@@ -198,6 +205,10 @@ private:
 
     // scheduler options
     AP_Int8 _options;
+
+    // tasks with a priority number at or above this may be shed by
+    // adaptive scheduling
+    AP_Int16 _shed_priority;
     
     // calculated loop period in usec
     uint16_t _loop_period_us;
@@ -257,6 +268,20 @@ private:
     // the loop rate in case we are well over budget
     uint32_t extra_loop_us;
 
+    // per-task state for adaptive scheduling, indexed as _last_run
+    struct adaptive_task_t {
+        uint16_t avg_time_us;   // average run time, tracking peaks quickly. 0 if not yet run
+        uint16_t shed_count;    // times deferred since last logged
+    };
+    adaptive_task_t *_adaptive;
+
+    // true if the loop is running late, so low priority tasks
+    // should be shed when adaptive scheduling is enabled
+    bool _under_pressure;
+
+    // allocate _adaptive if adaptive scheduling is enabled
+    void update_adaptive_state();
+
 
     // semaphore that is held while not waiting for ins samples
     HAL_Semaphore _rsem;
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <AP_Logger/LogStructure.h>
+
+#define LOG_IDS_FROM_SCHEDULER \
+    LOG_PERF_TASK_MSG, \
+    LOG_PERF_SHED_MSG
+
+// @LoggerMessage: PMT
+// @Description: Scheduler task and main loop timing distributions
+// @Field: TimeUS: Time since system startup
+// @Field: Task: task index in the scheduler table, 255 for the main loop
+// @Field: N: number of runs measured since the last message
+// @Field: P50: median run time, over recent messages with older runs weighted less
+// @Field: P99: 99th percentile run time, over recent messages with older runs weighted less
+// @Field: P999: 99.9th percentile run time, over recent messages with older runs weighted less; zero until there are enough runs
+// @Field: Max: maximum run time since the last message
+// @Field: J50: median delay from the start of the loop the task was due in to the task starting
+// @Field: J99: 99th percentile delay from the start of the loop the task was due in to the task starting
+// @Field: Ovr: number of overruns, or long loops for the main loop
+struct PACKED log_PerfTask {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    uint8_t task;
+    uint32_t count;
+    uint32_t p50;
+    uint32_t p99;
+    uint32_t p999;
+    uint32_t max;
+    uint32_t jitter_p50;
+    uint32_t jitter_p99;
+    uint16_t overruns;
+};
+
+// @LoggerMessage: PMS
+// @Description: Scheduler tasks deferred by adaptive scheduling
+// @Field: TimeUS: Time since system startup
+// @Field: Task: task index in the scheduler table
+// @Field: Shed: number of times the task was deferred since the last message
+// @Field: Avg: measured run time used to pack the task into the loop
+struct PACKED log_PerfShed {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    uint8_t task;
+    uint16_t shed;
+    uint16_t avg_time;
+};
+
+#define LOG_STRUCTURE_FROM_SCHEDULER                                    \
+    { LOG_PERF_TASK_MSG, sizeof(log_PerfTask),                          \
+      "PMT", "QBIIIIIIIH", "TimeUS,Task,N,P50,P99,P999,Max,J50,J99,Ovr", "s#-ssssss-", "F--FFFFFF-" }, \
+    { LOG_PERF_SHED_MSG, sizeof(log_PerfShed),                          \
+      "PMS", "QBHH", "TimeUS,Task,Shed,Avg", "s#-s", "F--F" },
@@ -22,8 +22,11 @@ void AP::PerfInfo::reset()
     long_running = 0;
     sigma_time = 0;
     sigmasquared_time = 0;
+    loop_time_hist.decay();
     if (_task_info != nullptr) {
-        memset(_task_info, 0, (_num_tasks) * sizeof(TaskInfo));
+        for (uint8_t i = 0; i < _num_tasks; i++) {
+            _task_info[i].reset();
+        }
     }
 }
 
@@ -53,7 +56,7 @@ void AP::PerfInfo::free_task_info()
 }
 
 // called after each run of a task to update its statistics based on measurements taken by the scheduler
-void AP::PerfInfo::update_task_info(uint8_t task_index, uint16_t task_time_us, bool overrun)
+void AP::PerfInfo::update_task_info(uint8_t task_index, uint16_t task_time_us, uint32_t jitter_us, bool overrun)
 {
     if (_task_info == nullptr) {
         return;
@@ -64,11 +67,64 @@ void AP::PerfInfo::update_task_info(uint8_t task_index, uint16_t task_time_us, b
         return;
     }
     TaskInfo& ti = _task_info[task_index];
-    ti.update(task_time_us, overrun);
+    ti.update(task_time_us, jitter_us, overrun);
 }
 
-void AP::PerfInfo::TaskInfo::update(uint16_t task_time_us, bool overrun)
+// add a time to a histogram, halving all counts when one would overflow
+void AP::PerfInfo::Histogram::add(uint32_t time_us)
 {
+    const uint8_t bucket = time_us == 0 ? 0 : MIN(32U - __builtin_clz(time_us), PERF_INFO_HIST_BUCKETS - 1U);
+    if (count[bucket] == UINT16_MAX) {
+        for (uint8_t i = 0; i < PERF_INFO_HIST_BUCKETS; i++) {
+            count[i] >>= 1;
+        }
+    }
+    count[bucket]++;
+}
+
+// age the recorded times, rounding the loss up so that rare times
+// are eventually forgotten
+void AP::PerfInfo::Histogram::decay()
+{
+    for (uint8_t i = 0; i < PERF_INFO_HIST_BUCKETS; i++) {
+        count[i] -= (count[i] + (1U << PERF_INFO_HIST_DECAY_SHIFT) - 1) >> PERF_INFO_HIST_DECAY_SHIFT;
+    }
+}
+
+// estimate a percentile, interpolating within the bucket it falls in
+uint32_t AP::PerfInfo::Histogram::percentile(float p) const
+{
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < PERF_INFO_HIST_BUCKETS; i++) {
+        total += count[i];
+    }
+    if ((1.0f - p) * total < 1.0f) {
+        // not a single time above the percentile
+        return 0;
+    }
+    const float target = p * total;
+    uint32_t cumulative = 0;
+    for (uint8_t i = 0; i < PERF_INFO_HIST_BUCKETS; i++) {
+        if (count[i] == 0) {
+            continue;
+        }
+        if (cumulative + count[i] >= target) {
+            if (i == 0) {
+                return 0;
+            }
+            const uint32_t lower = 1U << (i - 1);
+            const float frac = (target - cumulative) / count[i];
+            return lower + uint32_t(frac * lower);
+        }
+        cumulative += count[i];
+    }
+    return 1U << (PERF_INFO_HIST_BUCKETS - 1);
+}
+
+void AP::PerfInfo::TaskInfo::update(uint16_t task_time_us, uint32_t jitter_us, bool overrun)
+{
+    time_hist.add(task_time_us);
+    jitter_hist.add(jitter_us);
     max_time_us = MAX(max_time_us, task_time_us);
     if (min_time_us == 0) {
         min_time_us = task_time_us;
@@ -82,6 +138,19 @@ void AP::PerfInfo::TaskInfo::update(uint16_t task_time_us, bool overrun)
     }
 }
 
+// reset the task's counters, keeping its timing distributions
+void AP::PerfInfo::TaskInfo::reset()
+{
+    min_time_us = 0;
+    max_time_us = 0;
+    elapsed_time_us = 0;
+    tick_count = 0;
+    slip_count = 0;
+    overrun_count = 0;
+    time_hist.decay();
+    jitter_hist.decay();
+}
+
 void AP::PerfInfo::TaskInfo::print(const char* task_name, uint32_t total_time, ExpandingString& str) const
 {
     uint16_t avg = 0;
@@ -91,13 +160,29 @@ void AP::PerfInfo::TaskInfo::print(const char* task_name, uint32_t total_time, E
         avg = MIN(uint16_t(elapsed_time_us / tick_count), 9999);
     }
 #if HAL_MINIMIZE_FEATURES
-    const char* fmt = "%-16.16s MIN=%4u MAX=%4u AVG=%4u OVR=%3u SLP=%3u, TOT=%4.1f%%\n";
+    const char* fmt = "%-16.16s MIN=%4u MAX=%4u AVG=%4u OVR=%3u SLP=%3u, TOT=%4.1f%% P50=%4u P99=%4u P999=%4u JIT=%5u\n";
 #else
-    const char* fmt = "%-32.32s MIN=%4u MAX=%4u AVG=%4u OVR=%3u SLP=%3u, TOT=%4.1f%%\n";
+    const char* fmt = "%-32.32s MIN=%4u MAX=%4u AVG=%4u OVR=%3u SLP=%3u, TOT=%4.1f%% P50=%4u P99=%4u P999=%4u JIT=%5u\n";
 #endif
     str.printf(fmt, task_name,
                 unsigned(MIN(min_time_us, 9999)), unsigned(MIN(max_time_us, 9999)), unsigned(avg),
-                unsigned(MIN(overrun_count, 999)), unsigned(MIN(slip_count, 999)), pct);
+                unsigned(MIN(overrun_count, 999)), unsigned(MIN(slip_count, 999)), pct,
+                unsigned(MIN(time_hist.percentile(0.5f), 9999U)),
+                unsigned(MIN(time_hist.percentile(0.99f), 9999U)),
+                unsigned(MIN(time_hist.percentile(0.999f), 9999U)),
+                unsigned(MIN(jitter_hist.percentile(0.99f), 99999U)));
+}
+
+// print main loop statistics for @SYS/tasks.txt
+void AP::PerfInfo::print_loop_info(ExpandingString& str) const
+{
+    str.printf("LOOP MIN=%5u MAX=%5u AVG=%5u LONG=%3u P50=%5u P99=%5u P999=%5u\n",
+               unsigned(MIN(min_time, 99999U)), unsigned(MIN(max_time, 99999U)),
+               unsigned(loop_count > 0 ? MIN(get_avg_time(), 99999U) : 0),
+               unsigned(MIN(long_running, 999)),
+               unsigned(MIN(loop_time_hist.percentile(0.5f), 99999U)),
+               unsigned(MIN(loop_time_hist.percentile(0.99f), 99999U)),
+               unsigned(MIN(loop_time_hist.percentile(0.999f), 99999U)));
 }
 
 // check_loop_time - check latest loop time vs min, max and overtime threshold
@@ -122,6 +207,7 @@ void AP::PerfInfo::check_loop_time(uint32_t time_in_micros)
     }
     sigma_time += time_in_micros;
     sigmasquared_time += time_in_micros * time_in_micros;
+    loop_time_hist.add(time_in_micros);
 
     /* we keep a filtered loop time for use as G_Dt which is the
        predicted time for the next loop. We remove really excessive
@@ -3,12 +3,35 @@
 #include <stdint.h>
 #include <AP_Common/ExpandingString.h>
 
+// number of buckets in timing histograms. Bucket 0 counts times of
+// zero and bucket n times in [2^(n-1), 2^n) microseconds, with the
+// last bucket also counting everything longer
+#define PERF_INFO_HIST_BUCKETS 16
+
+// histograms are not cleared by reset(), instead each count loses
+// 1/2^PERF_INFO_HIST_DECAY_SHIFT of its value. This keeps enough
+// samples for high percentiles of slow tasks while still following
+// changes in timing
+#define PERF_INFO_HIST_DECAY_SHIFT 3
+
 namespace AP {
 
 class PerfInfo {
 public:
     PerfInfo() {}
 
+    // log2 histogram of times in microseconds
+    struct Histogram {
+        uint16_t count[PERF_INFO_HIST_BUCKETS];
+
+        void add(uint32_t time_us);
+        // age the recorded times, called from PerfInfo::reset()
+        void decay();
+        // estimate a percentile (0 to 1) of the recorded times, or 0
+        // if too few times are recorded to give that percentile
+        uint32_t percentile(float p) const;
+    };
+
     // per-task timing information
     struct TaskInfo {
         uint16_t min_time_us;
@@ -17,8 +40,13 @@ public:
         uint32_t tick_count;
         uint16_t slip_count;
         uint16_t overrun_count;
+        // distribution of task run times
+        Histogram time_hist;
+        // distribution of delays from the loop the task was due in to the task starting
+        Histogram jitter_hist;
 
-        void update(uint16_t task_time_us, bool overrun);
+        void update(uint16_t task_time_us, uint32_t jitter_us, bool overrun);
+        void reset();
         void print(const char* task_name, uint32_t total_time, ExpandingString& str) const;
     };
 
@@ -40,6 +68,11 @@ public:
 
     void update_logging() const;
 
+    // distribution of main loop times
+    const Histogram &get_loop_time_hist() const { return loop_time_hist; }
+    // print main loop statistics for @SYS/tasks.txt
+    void print_loop_info(ExpandingString& str) const;
+
     // allocate the array of task statistics for use by @SYS/tasks.txt
     void allocate_task_info(uint8_t num_tasks);
     void free_task_info();
@@ -50,7 +83,7 @@ public:
         return (_task_info && task_index < _num_tasks) ? &_task_info[task_index] : nullptr;
     }
     // called after each run of a task to update its statistics based on measurements taken by the scheduler
-    void update_task_info(uint8_t task_index, uint16_t task_time_us, bool overrun);
+    void update_task_info(uint8_t task_index, uint16_t task_time_us, uint32_t jitter_us, bool overrun);
     // record that a task slipped
     void task_slipped(uint8_t task_index) {
         if (_task_info && task_index < _num_tasks) {
@@ -69,6 +102,7 @@ private:
     uint16_t long_running;
     uint32_t last_check_us;
     float filtered_loop_time;
+    Histogram loop_time_hist;
     bool ignore_loop;
     // performance monitoring
     uint8_t _num_tasks;
@@ -1575,6 +1575,22 @@ function rangefinder:has_orientation(orientation) end
 function rangefinder:num_sensors() end
 
 
+-- desc
+---@class adsb
+adsb = {}
+
+-- desc
+---@param n integer
+---@return uint32_t_ud|nil
+---@return number|nil
+---@return Location_ud|nil
+function adsb:get_nearest(n) end
+
+-- desc
+---@return integer
+function adsb:get_nearest_count() end
+
+
 -- desc
 ---@class proximity
 proximity = {}
@@ -17,6 +17,8 @@
 #include <AP_Logger/AP_Logger.h>
 #include <GCS_MAVLink/GCS.h>
 
+static_assert(SMARTRTL_SIMPLIFY_SPAN_MAX <= UINT8_MAX, "simplify links must fit in 8 bit offsets");
+
 extern const AP_HAL::HAL& hal;
 
 const AP_Param::GroupInfo AP_SmartRTL::var_info[] = {
@@ -30,7 +32,7 @@ const AP_Param::GroupInfo AP_SmartRTL::var_info[] = {
 
     // @Param: POINTS
     // @DisplayName: SmartRTL maximum number of points on path
-    // @Description: SmartRTL maximum number of points on path. Set to 0 to disable SmartRTL.  100 points consumes about 3k of memory.
+    // @Description: SmartRTL maximum number of points on path. Set to 0 to disable SmartRTL. Each point uses about 30 bytes of memory, so 100 points consumes about 3k of memory. Boards with 500k of RAM or more accept up to 5000 points.
     // @Range: 0 500
     // @User: Advanced
     // @RebootRequired: True
@@ -62,10 +64,16 @@ const AP_Param::GroupInfo AP_SmartRTL::var_info[] = {
 *    points when their line segments get close. This algorithm will never
 *    compare two consecutive line segments. Obviously the segments (p1,p2) and
 *    (p2,p3) will get very close (they touch), but there would be nothing to
-*    trim between them.
+*    trim between them.  Segments which have been checked are held in a
+*    horizontal grid so each new segment is only compared with the segments
+*    near it.
 *
-*    2. Simplification uses the Ramer-Douglas-Peucker algorithm. See Wikipedia
-*    for a more complete description.
+*    2. Simplification is similar to the Visvalingam-Whyatt algorithm.  Each
+*    point is held in a min-heap by how far the path could be from where the
+*    vehicle has been if the point was removed, and the cheapest point is
+*    removed until that distance would be more than half of SRTL_ACCURACY.
+*    Points are added to the heap as they are added to the path, so each point
+*    costs O(log N) no matter how long the path is.
 *
 *    The simplification and pruning algorithms run in the background and do not
 *    alter the path in memory.  Two definitions, SMARTRTL_SIMPLIFY_TIME_US and
@@ -87,7 +95,6 @@ AP_SmartRTL::AP_SmartRTL(bool example_mode) :
     _example_mode(example_mode)
 {
     AP_Param::setup_object_defaults(this, var_info);
-    _simplify.bitmask.setall();
 }
 
 // initialise safe rtl including setting up background processes
@@ -112,16 +119,30 @@ void AP_SmartRTL::init()
     _prune.loops_max = _points_max * SMARTRTL_PRUNING_LOOP_BUFFER_LEN_MULT;
     _prune.loops = (prune_loop_t*)calloc(_prune.loops_max, sizeof(prune_loop_t));
 
-    _simplify.stack_max = _points_max * SMARTRTL_SIMPLIFY_STACK_LEN_MULT;
-    _simplify.stack = (simplify_start_finish_t*)calloc(_simplify.stack_max, sizeof(simplify_start_finish_t));
+    // one hash bucket for every two points, rounded up to a power of two
+    uint16_t num_buckets = 1;
+    while (num_buckets < _points_max / 2) {
+        num_buckets <<= 1;
+    }
+    _prune.cell_mask = num_buckets - 1;
+    _prune.cell_head = (uint16_t*)calloc(num_buckets, sizeof(uint16_t));
+    _prune.segment_next = (uint16_t*)calloc(_points_max, sizeof(uint16_t));
+
+    _simplify.points = (simplify_point_t*)calloc(_points_max, sizeof(simplify_point_t));
+    _simplify.heap = (uint16_t*)calloc(_points_max, sizeof(uint16_t));
 
     // check if memory allocation failed
-    if (_path == nullptr || _prune.loops == nullptr || _simplify.stack == nullptr) {
+    if (_path == nullptr || _prune.loops == nullptr || _prune.cell_head == nullptr || _prune.segment_next == nullptr ||
+        _simplify.points == nullptr || _simplify.heap == nullptr) {
         log_action(SRTL_DEACTIVATED_INIT_FAILED);
         gcs().send_text(MAV_SEVERITY_WARNING, "SmartRTL deactivated: init failed");
         free(_path);
         free(_prune.loops);
-        free(_simplify.stack);
+        free(_prune.cell_head);
+        free(_prune.segment_next);
+        free(_simplify.points);
+        free(_simplify.heap);
+        _path = nullptr;
         return;
     }
 
@@ -340,7 +361,8 @@ bool AP_SmartRTL::add_point(const Vector3f& point)
         return false;
     }
 
-    // add point to path
+    // add point to path, no points have been removed between it and the previous point yet
+    _simplify.points[_path_points_count].error = 0;
     _path[_path_points_count++] = point;
     log_action(SRTL_POINT_ADD, point);
 
@@ -408,7 +430,7 @@ void AP_SmartRTL::routine_cleanup(uint16_t path_points_count, uint16_t path_poin
 
     // remove simplified from path if required
     if (_simplify.removal_required) {
-        remove_points_by_simplify_bitmask();
+        remove_points_by_simplify();
         return;
     }
 
@@ -423,12 +445,7 @@ void AP_SmartRTL::routine_cleanup(uint16_t path_points_count, uint16_t path_poin
     }
 
     // detect path shrinkage and reduce simplify and prune path_points_completed count
-    if (_simplify.path_points_completed > path_points_completed_limit) {
-        _simplify.path_points_completed = path_points_completed_limit;
-    }
-    if (_prune.path_points_completed > path_points_completed_limit) {
-        _prune.path_points_completed = path_points_completed_limit;
-    }
+    truncate_cleanup(path_points_completed_limit);
 
     // calculate the number of points we could simplify
     const uint16_t points_to_simplify = (path_points_count > _simplify.path_points_completed) ? (path_points_count - _simplify.path_points_completed) : 0 ;
@@ -463,7 +480,7 @@ bool AP_SmartRTL::thorough_cleanup(uint16_t path_points_count, ThoroughCleanupTy
         }
         // remove simplified points from path if required
         if (_simplify.removal_required) {
-            remove_points_by_simplify_bitmask();
+            remove_points_by_simplify();
             return false;
         }
     }
@@ -487,123 +504,345 @@ bool AP_SmartRTL::thorough_cleanup(uint16_t path_points_count, ThoroughCleanupTy
     return true;
 }
 
-// Simplifies a 3D path, according to the Ramer-Douglas-Peucker algorithm.
+// Simplifies a 3D path by removing the points which take the path the least far from where the vehicle has been
+// Points are added to the simplify heap in the order they were added to the path
 // _simplify.complete is set to true when all simplifications on the path have been identified
 void AP_SmartRTL::detect_simplifications()
 {
-    // complete immediately if only one segment
-    if (_simplify.path_points_count < 3) {
-        _simplify.complete = true;
-        return;
-    }
-
-    // if not complete but also nothing to do, we must be restarting
-    if (_simplify.stack_count == 0) {
-        // reset to beginning state. add a single element in the array with:
-        //   start = first path point OR the index of the last already-simplified point
-        //   finish = final path point
-        _simplify.stack[0].start = (_simplify.path_points_completed > 0) ? _simplify.path_points_completed - 1 : 0;
-        _simplify.stack[0].finish = _simplify.path_points_count-1;
-        _simplify.stack_count++;
-    }
-
     const uint32_t start_time_us = AP_HAL::micros();
-    while (_simplify.stack_count > 0) { // while there is something to do
+    // rounded down, costs too large to hold never match
+    const uint16_t epsilon_mm = MIN(floorf(SMARTRTL_SIMPLIFY_EPSILON * 1000.0f), UINT16_MAX - 1);
+    while (_simplify.path_points_added < _simplify.path_points_count) {
 
         // if this method has run for long enough, exit
         if (AP_HAL::micros() - start_time_us > SMARTRTL_SIMPLIFY_TIME_US) {
             return;
         }
 
-        // pop last item off the simplify stack
-        const simplify_start_finish_t tmp = _simplify.stack[--_simplify.stack_count];
-        const uint16_t start_index = tmp.start;
-        const uint16_t end_index = tmp.finish;
-
-        // find the point between start and end points that is farthest from the start-end line segment
-        float max_dist = 0.0f;
-        uint16_t farthest_point_index = start_index;
-        for (uint16_t i = start_index + 1; i < end_index; i++) {
-            // only check points that have not already been flagged for simplification
-            if (_simplify.bitmask.get(i)) {
-                const float dist = _path[i].distance_to_segment(_path[start_index], _path[end_index]);
-                if (dist > max_dist) {
-                    farthest_point_index = i;
-                    max_dist = dist;
-                }
-            }
-        }
+        // add next point.  The previous point is now in the middle of the path so it may be possible to remove it
+        simplify_add_point(_simplify.path_points_added);
 
-        // if the farthest point is more than ACCURACY * 0.5 add two new elements to the _simplification_stack
-        // so that on the next iteration we will check between start-to-farthestpoint and farthestpoint-to-end
-        if (max_dist > SMARTRTL_SIMPLIFY_EPSILON) {
-            // if the to-do list is full, give up on simplifying. This should never happen.
-            if (_simplify.stack_count >= _simplify.stack_max) {
-                _simplify.complete = true;
-                return;
-            }
-            _simplify.stack[_simplify.stack_count++] = simplify_start_finish_t {start_index, farthest_point_index};
-            _simplify.stack[_simplify.stack_count++] = simplify_start_finish_t {farthest_point_index, end_index};
-        } else {
-            // if the farthest point was closer than ACCURACY * 0.5 we can simplify all points between start and end
-            for (uint16_t i = start_index + 1; i < end_index; i++) {
-                _simplify.bitmask.clear(i);
-                _simplify.removal_required = true;
-            }
+        // remove points while the path stays within ACCURACY * 0.5 of every point it has passed through
+        while ((_simplify.heap_count > 0) && (_simplify.points[_simplify.heap[0]].cost <= epsilon_mm)) {
+            simplify_remove_point(_simplify.heap[0]);
         }
     }
+
+    // points which could not be removed will not be checked again, so later simplifications do not invalidate pruning
+    heap_clear();
     _simplify.path_points_completed = _simplify.path_points_count;
     _simplify.complete = true;
 }
 
+// cost of removing a point from the path (the farthest any point the vehicle has passed through could be from the path)
+// points flagged for removal are still in the path, so every point between the neighbours of this point is checked
+float AP_SmartRTL::simplify_cost(uint16_t index) const
+{
+    const simplify_point_t &point = _simplify.points[index];
+    if (point.prev + point.next > SMARTRTL_SIMPLIFY_SPAN_MAX) {
+        return FLT_MAX;
+    }
+    return segment_error(index - point.prev, index + point.next);
+}
+
+// the farthest any point the vehicle has passed through between two points could be from the segment between them
+// points already removed from the path between i-1 and i are within error of the segment between i-1 and i,
+// which is within the larger of the distances of i-1 and i from the segment between start and end
+float AP_SmartRTL::segment_error(uint16_t start_index, uint16_t end_index) const
+{
+    const Vector3f &start = _path[start_index];
+    const Vector3f &end = _path[end_index];
+    float max_error = 0.0f;
+    float prev_dist = 0.0f;
+    for (uint16_t i = start_index + 1; i <= end_index; i++) {
+        const float dist = (i < end_index) ? _path[i].distance_to_segment(start, end) : 0.0f;
+        max_error = MAX(max_error, _simplify.points[i].error * 0.001f + MAX(prev_dist, dist));
+        prev_dist = dist;
+    }
+    return max_error;
+}
+
+// convert a distance in meters to the millimeters held in the simplify state
+// rounding up means the path never strays further than the distances held
+uint16_t AP_SmartRTL::simplify_dist_mm(float dist)
+{
+    if (dist >= UINT16_MAX * 0.001f) {
+        return UINT16_MAX;
+    }
+    return (uint16_t)ceilf(dist * 1000.0f);
+}
+
+// add point at the end of the simplify linked list
+void AP_SmartRTL::simplify_add_point(uint16_t index)
+{
+    simplify_point_t &point = _simplify.points[index];
+    // error is kept, points added again after popping still replace the points removed before them
+    point.cost = 0;
+    point.prev = (index > 0) ? 1 : 0;
+    point.next = 0;
+    point.heap_index = SMARTRTL_INDEX_NONE;
+    _simplify.path_points_added = index + 1;
+
+    if (index > 0) {
+        _simplify.points[index-1].next = 1;
+    }
+    // the first point (home) is never removed
+    if (index > 1) {
+        heap_push(index-1);
+    }
+}
+
+// flag point for removal and remove it from the simplify linked list
+void AP_SmartRTL::simplify_remove_point(uint16_t index)
+{
+    simplify_point_t &point = _simplify.points[index];
+    heap_remove(index);
+    point.heap_index = SMARTRTL_SIMPLIFY_REMOVED;
+
+    // the segment between the neighbouring points replaces this point and the segments either side of it
+    // the cost of removing this point was finite, so they are no more than SMARTRTL_SIMPLIFY_SPAN_MAX apart
+    const uint16_t prev_index = index - point.prev;
+    const uint16_t next_index = index + point.next;
+    simplify_point_t &prev = _simplify.points[prev_index];
+    simplify_point_t &next = _simplify.points[next_index];
+    prev.next = next_index - prev_index;
+    next.prev = next_index - prev_index;
+
+    // neighbours which could be removed now cost more to remove
+    if (prev.heap_index < _simplify.heap_count) {
+        heap_update(prev_index);
+    }
+    if (next.heap_index < _simplify.heap_count) {
+        heap_update(next_index);
+    }
+
+    if (index < _simplify.removed_min) {
+        _simplify.removed_min = index;
+    }
+    _simplify.removal_required = true;
+}
+
+// add point to the simplify heap
+void AP_SmartRTL::heap_push(uint16_t index)
+{
+    simplify_point_t &point = _simplify.points[index];
+    point.cost = simplify_dist_mm(simplify_cost(index));
+    point.heap_index = _simplify.heap_count;
+    _simplify.heap[_simplify.heap_count++] = index;
+    heap_sift_up(point.heap_index);
+}
+
+// remove point from the simplify heap
+void AP_SmartRTL::heap_remove(uint16_t index)
+{
+    const uint16_t heap_index = _simplify.points[index].heap_index;
+    _simplify.points[index].heap_index = SMARTRTL_INDEX_NONE;
+    _simplify.heap_count--;
+    if (heap_index == _simplify.heap_count) {
+        return;
+    }
+    // move last point into the gap
+    _simplify.heap[heap_index] = _simplify.heap[_simplify.heap_count];
+    _simplify.points[_simplify.heap[heap_index]].heap_index = heap_index;
+    heap_sift_up(heap_index);
+    heap_sift_down(_simplify.points[_simplify.heap[heap_index]].heap_index);
+}
+
+// recalculate the cost of a point in the simplify heap
+void AP_SmartRTL::heap_update(uint16_t index)
+{
+    simplify_point_t &point = _simplify.points[index];
+    point.cost = simplify_dist_mm(simplify_cost(index));
+    heap_sift_up(point.heap_index);
+    heap_sift_down(point.heap_index);
+}
+
+// remove all points from the simplify heap
+void AP_SmartRTL::heap_clear()
+{
+    for (uint16_t i = 0; i < _simplify.heap_count; i++) {
+        _simplify.points[_simplify.heap[i]].heap_index = SMARTRTL_INDEX_NONE;
+    }
+    _simplify.heap_count = 0;
+}
+
+void AP_SmartRTL::heap_sift_up(uint16_t heap_index)
+{
+    while (heap_index > 0) {
+        const uint16_t parent = (heap_index - 1) / 2;
+        if (_simplify.points[_simplify.heap[parent]].cost <= _simplify.points[_simplify.heap[heap_index]].cost) {
+            return;
+        }
+        heap_swap(parent, heap_index);
+        heap_index = parent;
+    }
+}
+
+void AP_SmartRTL::heap_sift_down(uint16_t heap_index)
+{
+    while (true) {
+        const uint16_t left = 2 * heap_index + 1;
+        if (left >= _simplify.heap_count) {
+            return;
+        }
+        uint16_t smallest = left;
+        const uint16_t right = left + 1;
+        if ((right < _simplify.heap_count) && (_simplify.points[_simplify.heap[right]].cost < _simplify.points[_simplify.heap[left]].cost)) {
+            smallest = right;
+        }
+        if (_simplify.points[_simplify.heap[heap_index]].cost <= _simplify.points[_simplify.heap[smallest]].cost) {
+            return;
+        }
+        heap_swap(heap_index, smallest);
+        heap_index = smallest;
+    }
+}
+
+void AP_SmartRTL::heap_swap(uint16_t heap_index1, uint16_t heap_index2)
+{
+    const uint16_t index1 = _simplify.heap[heap_index1];
+    const uint16_t index2 = _simplify.heap[heap_index2];
+    _simplify.heap[heap_index1] = index2;
+    _simplify.heap[heap_index2] = index1;
+    _simplify.points[index1].heap_index = heap_index2;
+    _simplify.points[index2].heap_index = heap_index1;
+}
+
 /**
 *   This method runs for the allotted time, and detects loops in a path. Any detected loops are added to _prune.loops,
 *   this function does not alter the path in memory. It works by comparing the line segment between any two sequential points
-*   to the line segment between any other two sequential points. If they get close enough, anything between them could be pruned.
+*   to the line segments between earlier sequential points which are near it in the grid. If they get close enough, anything
+*   between them could be pruned.
 *
-*   reset_pruning should have been called at least once before this function is called to setup the indexes (_prune.i, etc)
+*   restart_pruning should have been called at least once before this function is called to setup the grid and indexes (_prune.i, etc)
 */
 void AP_SmartRTL::detect_loops()
 {
-    // if there are less than 4 points (3 segments), mark complete
-    if (_prune.path_points_count < 4) {
-        _prune.complete = true;
-        return;
-    }
-
     // capture start time
     const uint32_t start_time_us = AP_HAL::micros();
 
     // run for defined amount of time
-    while (AP_HAL::micros() - start_time_us < SMARTRTL_PRUNING_LOOP_TIME_US) {
-
-        // advance inner loop
-        _prune.j++;
-        if (_prune.j > _prune.i - 2) {
-            // set inner loop back to first point
-            _prune.j = 1;
-            // reduce outer loop
-            _prune.i--;
-            // complete when outer loop has run out of new points to check
-            if (_prune.i < 4 || _prune.i < _prune.path_points_completed) {
+    while (_prune.i < _prune.path_points_count) {
+
+        // if this method has run for long enough, exit
+        if (AP_HAL::micros() - start_time_us > SMARTRTL_PRUNING_LOOP_TIME_US) {
+            return;
+        }
+
+        // only segments which have not already been checked need to be compared with earlier segments
+        if ((_prune.i >= 4) && (_prune.i >= _prune.path_points_completed)) {
+            Vector3f midpoint;
+            const uint16_t j = find_loop(_prune.i, midpoint);
+            // if there is a loop here, add to loop array
+            if ((j != SMARTRTL_INDEX_NONE) && !add_loop(j, _prune.i-1, midpoint)) {
+                // if the buffer is full, stop trying to prune
                 _prune.complete = true;
-                _prune.path_points_completed = _prune.path_points_count;
                 return;
             }
         }
 
+        // later segments are compared with this one
+        grid_add_segment(_prune.i);
+        _prune.i++;
+    }
+
+    _prune.complete = true;
+    _prune.path_points_completed = _prune.path_points_count;
+}
+
+// find the first segment which comes within SMARTRTL_PRUNING_DELTA of the segment ending at index
+// segment j is the segment between points j-1 and j
+// returns SMARTRTL_INDEX_NONE if there is none
+uint16_t AP_SmartRTL::find_loop(uint16_t index, Vector3f& midpoint) const
+{
+    const Vector3f &p1 = _path[index];
+    const Vector3f &p2 = _path[index-1];
+    const float delta = SMARTRTL_PRUNING_DELTA;
+
+    // segments which come within delta of this segment overlap this box
+    const Vector3f box_min = Vector3f(MIN(p1.x, p2.x), MIN(p1.y, p2.y), MIN(p1.z, p2.z)) - Vector3f(delta, delta, delta);
+    const Vector3f box_max = Vector3f(MAX(p1.x, p2.x), MAX(p1.y, p2.y), MAX(p1.z, p2.z)) + Vector3f(delta, delta, delta);
+
+    uint16_t found = SMARTRTL_INDEX_NONE;
+    auto check_segment = [&](uint16_t j) {
+        // never compare consecutive segments, and only the first segment that is close is needed
+        if ((j + 2 > index) || (j >= found)) {
+            return;
+        }
+        const Vector3f &p3 = _path[j-1];
+        const Vector3f &p4 = _path[j];
+        if (MAX(p3.x, p4.x) < box_min.x || MIN(p3.x, p4.x) > box_max.x ||
+            MAX(p3.y, p4.y) < box_min.y || MIN(p3.y, p4.y) > box_max.y ||
+            MAX(p3.z, p4.z) < box_min.z || MIN(p3.z, p4.z) > box_max.z) {
+            return;
+        }
         // find the closest distance between two line segments and the mid-point
-        dist_point dp = segment_segment_dist(_path[_prune.i], _path[_prune.i-1], _path[_prune.j-1], _path[_prune.j]);
-        if (dp.distance < SMARTRTL_PRUNING_DELTA) {
-            // if there is a loop here, add to loop array
-            if (!add_loop(_prune.j, _prune.i-1, dp.midpoint)) {
-                // if the buffer is full, stop trying to prune
-                _prune.complete = true;
+        const dist_point dp = segment_segment_dist(p1, p2, p3, p4);
+        if (dp.distance < delta) {
+            found = j;
+            midpoint = dp.midpoint;
+        }
+    };
+
+    // segments are held in the cell of their lowest corner, which is at most one cell below the box
+    const int32_t cell_x_min = grid_cell(box_min.x - _prune.cell_size);
+    const int32_t cell_x_max = grid_cell(box_max.x);
+    const int32_t cell_y_min = grid_cell(box_min.y - _prune.cell_size);
+    const int32_t cell_y_max = grid_cell(box_max.y);
+    const int32_t num_cells_x = cell_x_max - cell_x_min + 1;
+    const int32_t num_cells_y = cell_y_max - cell_y_min + 1;
+    if ((num_cells_x > SMARTRTL_PRUNING_QUERY_CELLS_MAX) || (num_cells_y > SMARTRTL_PRUNING_QUERY_CELLS_MAX) ||
+        (num_cells_x * num_cells_y > SMARTRTL_PRUNING_QUERY_CELLS_MAX)) {
+        // long segment, compare it with every earlier segment
+        for (uint16_t j = 1; (j + 2 <= index) && (found == SMARTRTL_INDEX_NONE); j++) {
+            check_segment(j);
+        }
+        return found;
+    }
+
+    for (int32_t x = cell_x_min; x <= cell_x_max; x++) {
+        for (int32_t y = cell_y_min; y <= cell_y_max; y++) {
+            // buckets are shared by many cells so segments from other cells are also checked
+            for (uint16_t j = _prune.cell_head[grid_bucket(x, y)]; j != SMARTRTL_INDEX_NONE; j = _prune.segment_next[j]) {
+                check_segment(j);
             }
-            // set inner loop forward to trigger outer loop move to next segment
-            _prune.j = _prune.i;
         }
     }
+    for (uint16_t j = _prune.long_head; j != SMARTRTL_INDEX_NONE; j = _prune.segment_next[j]) {
+        check_segment(j);
+    }
+    return found;
+}
+
+// add the segment ending at index to the pruning grid
+void AP_SmartRTL::grid_add_segment(uint16_t index)
+{
+    const Vector3f &p1 = _path[index-1];
+    const Vector3f &p2 = _path[index];
+    uint16_t *head;
+    if ((fabsf(p1.x - p2.x) > _prune.cell_size) || (fabsf(p1.y - p2.y) > _prune.cell_size)) {
+        head = &_prune.long_head;
+    } else {
+        head = &_prune.cell_head[grid_bucket(grid_cell(MIN(p1.x, p2.x)), grid_cell(MIN(p1.y, p2.y)))];
+    }
+    _prune.segment_next[index] = *head;
+    *head = index;
+}
+
+// remove all segments from the pruning grid
+void AP_SmartRTL::grid_clear()
+{
+    _prune.cell_size = _accuracy * SMARTRTL_PRUNING_CELL_SIZE_MULT;
+    for (uint16_t i = 0; i <= _prune.cell_mask; i++) {
+        _prune.cell_head[i] = SMARTRTL_INDEX_NONE;
+    }
+    _prune.long_head = SMARTRTL_INDEX_NONE;
+}
+
+// hash bucket of a grid cell
+uint16_t AP_SmartRTL::grid_bucket(int32_t x, int32_t y) const
+{
+    return (((uint32_t)x * 73856093U) ^ ((uint32_t)y * 19349663U)) & _prune.cell_mask;
 }
 
 // restart simplify if new points have been added to path
@@ -626,12 +865,10 @@ void AP_SmartRTL::restart_pruning_if_new_points()
 }
 
 // restart simplification algorithm so that it will check new points in the path
+// points already flagged for removal stay flagged
 void AP_SmartRTL::restart_simplification(uint16_t path_points_count)
 {
     _simplify.complete = false;
-    _simplify.removal_required = false;
-    _simplify.bitmask.setall();
-    _simplify.stack_count = 0;
     _simplify.path_points_count = path_points_count;
 }
 
@@ -639,16 +876,21 @@ void AP_SmartRTL::restart_simplification(uint16_t path_points_count)
 void AP_SmartRTL::reset_simplification()
 {
     restart_simplification(0);
+    heap_clear();
+    _simplify.removal_required = false;
+    _simplify.removed_min = SMARTRTL_INDEX_NONE;
+    _simplify.path_points_added = 0;
     _simplify.path_points_completed = 0;
 }
 
 // restart pruning algorithm to check new points that have arrived
+// the grid is rebuilt as points may have moved since it was built
 void AP_SmartRTL::restart_pruning(uint16_t path_points_count)
 {
     _prune.complete = false;
-    _prune.i = (path_points_count > 0) ? path_points_count - 1 : 0;
-    _prune.j = 0;
+    _prune.i = 1;
     _prune.path_points_count = path_points_count;
+    grid_clear();
 }
 
 // reset pruning algorithm so that it will re-check all points in the path
@@ -659,39 +901,91 @@ void AP_SmartRTL::reset_pruning()
     _prune.path_points_completed = 0;
 }
 
+// forget simplify and pruning results for points which have been popped from the path
+// should only be called when simplify has completed and its points have been removed
+void AP_SmartRTL::truncate_cleanup(uint16_t path_points_count)
+{
+    if (_simplify.path_points_completed > path_points_count) {
+        _simplify.path_points_completed = path_points_count;
+    }
+    if (_simplify.path_points_added > path_points_count) {
+        _simplify.path_points_added = path_points_count;
+        if (path_points_count > 0) {
+            _simplify.points[path_points_count-1].next = 0;
+        }
+    }
+    if (_prune.path_points_completed > path_points_count) {
+        _prune.path_points_completed = path_points_count;
+    }
+    // loops are in order along the path
+    while ((_prune.loops_count > 0) && (_prune.loops[_prune.loops_count-1].end_index >= path_points_count)) {
+        _prune.loops_count--;
+    }
+}
+
 // remove all simplify-able points from the path
-void AP_SmartRTL::remove_points_by_simplify_bitmask()
+void AP_SmartRTL::remove_points_by_simplify()
 {
     // get semaphore before modifying path
     if (!_path_sem.take_nonblocking()) {
         return;
     }
-    uint16_t dest = 1;
-    uint16_t removed = 0;
-    for (uint16_t src = 1; src < _path_points_count; src++) {
-        if (!_simplify.bitmask.get(src)) {
-            log_action(SRTL_POINT_SIMPLIFY, _path[src]);
-            removed++;
-        } else {
-            _path[dest] = _path[src];
-            dest++;
-        }
-    }
 
-    // reduce count of the number of points simplified
-    if (_path_points_count > removed && _simplify.path_points_count > removed) {
-        _path_points_count -= removed;
-        _simplify.path_points_count -= removed;
-        _simplify.path_points_completed = _simplify.path_points_count;
+    const uint16_t removed_min = _simplify.removed_min;
+
+    if (_path_points_count < _simplify.path_points_added) {
+        // points have been popped from the path since simplifying, so keep all points and simplify again
+        for (uint16_t i = removed_min; i < _simplify.path_points_added; i++) {
+            if (_simplify.points[i].heap_index == SMARTRTL_SIMPLIFY_REMOVED) {
+                _simplify.points[i].heap_index = SMARTRTL_INDEX_NONE;
+            }
+        }
+        // the point before the first removed point was never removed
+        _simplify.path_points_added = MIN(removed_min, _path_points_count);
+        _simplify.path_points_completed = _simplify.path_points_added;
+        _simplify.path_points_count = _simplify.path_points_added;
     } else {
-        // this is an error that should never happen so deactivate
-        deactivate(SRTL_DEACTIVATED_PROGRAM_ERROR, "program error");
+        // points before the first removed point do not move
+        uint16_t dest = removed_min;
+        for (uint16_t src = removed_min; src < _path_points_count; src++) {
+            if ((src < _simplify.path_points_added) && (_simplify.points[src].heap_index == SMARTRTL_SIMPLIFY_REMOVED)) {
+                log_action(SRTL_POINT_SIMPLIFY, _path[src]);
+            } else {
+                // remember how far the removed points were from the segment replacing them
+                if ((src < _simplify.path_points_added) && (_simplify.points[src].prev > 1)) {
+                    _simplify.points[src].error = simplify_dist_mm(segment_error(src - _simplify.points[src].prev, src));
+                }
+                move_point(dest, src);
+                dest++;
+            }
+        }
+        const uint16_t removed = _path_points_count - dest;
+
+        // reduce count of the number of points simplified
+        if (_path_points_count > removed && _simplify.path_points_count > removed) {
+            _path_points_count -= removed;
+            _simplify.path_points_count -= removed;
+            _simplify.path_points_added -= removed;
+            _simplify.path_points_completed = _simplify.path_points_count;
+            _simplify.points[_simplify.path_points_added-1].next = 0;
+        } else {
+            // this is an error that should never happen so deactivate
+            deactivate(SRTL_DEACTIVATED_PROGRAM_ERROR, "program error");
+        }
     }
 
     _path_sem.give();
 
+    // segments from the first removed point onwards have changed and must be checked for loops again
+    if (_prune.path_points_completed > removed_min) {
+        _prune.path_points_completed = removed_min;
+    }
+    if (_prune.i > removed_min) {
+        restart_pruning(_simplify.path_points_completed);
+    }
+
     // flag point removal is complete
-    _simplify.bitmask.setall();
+    _simplify.removed_min = SMARTRTL_INDEX_NONE;
     _simplify.removal_required = false;
 }
 
@@ -710,52 +1004,87 @@ bool AP_SmartRTL::remove_points_by_loops(uint16_t num_points_to_remove)
         return false;
     }
 
-    uint16_t removed_points = 0;
-    uint16_t i = _prune.loops_count;
-    while ((i > 0) && (removed_points < num_points_to_remove)) {
-        i--;
-        prune_loop_t loop = _prune.loops[i];
-
-        // midpoint goes into start_index (this is the end point of the first segment)
-        _path[loop.start_index] = loop.midpoint;
-
-        // shift points after the end of the loop down by the number of points in the loop
-        uint16_t loop_num_points_to_remove = loop.end_index - loop.start_index;
-        for (uint16_t dest = loop.start_index + 1; dest < _path_points_count - loop_num_points_to_remove; dest++) {
-            log_action(SRTL_POINT_PRUNE, _path[dest]);
-            _path[dest] = _path[dest + loop_num_points_to_remove];
-        }
+    // loops are in order along the path and do not overlap, so the last loops are removed
+    // and earlier loops are left where they are
+    uint16_t first_loop = _prune.loops_count;
+    uint32_t num_loop_points = 0;
+    while ((first_loop > 0) && (num_loop_points < num_points_to_remove)) {
+        first_loop--;
+        num_loop_points += _prune.loops[first_loop].end_index - _prune.loops[first_loop].start_index;
+    }
 
-        if (_path_points_count > loop_num_points_to_remove) {
-            _path_points_count -= loop_num_points_to_remove;
-            removed_points += loop_num_points_to_remove;
-        } else {
+    // check loops are in order and within the path
+    for (uint16_t i = first_loop; i < _prune.loops_count; i++) {
+        const prune_loop_t &loop = _prune.loops[i];
+        const bool in_order = (i == first_loop) || (loop.start_index > _prune.loops[i-1].end_index);
+        if (!in_order || (loop.end_index >= _path_points_count)) {
             // this is an error that should never happen so deactivate
             deactivate(SRTL_DEACTIVATED_PROGRAM_ERROR, "program error");
             _path_sem.give();
             // we return true so thorough_cleanup does not get stuck
             return true;
         }
+    }
 
-        // fix the indices of any existing prune loops
-        // we do not check for overlapping loops because add_loops should have caught them
-        for (uint16_t loop_cnt = 0; loop_cnt < i; loop_cnt++) {
-            if (_prune.loops[loop_cnt].start_index >= loop.end_index) {
-                _prune.loops[loop_cnt].start_index -= loop_num_points_to_remove;
-            }
-            if (_prune.loops[loop_cnt].end_index >= loop.end_index) {
-                _prune.loops[loop_cnt].end_index -= loop_num_points_to_remove;
-            }
+    // move points between and after the loops down the path in one pass
+    uint16_t dest = _prune.loops[first_loop].start_index;
+    uint16_t src = dest;
+    for (uint16_t i = first_loop; i < _prune.loops_count; i++) {
+        const prune_loop_t &loop = _prune.loops[i];
+        while (src < loop.start_index) {
+            move_point(dest++, src++);
         }
-
-        // remove last prune loop from array
-        _prune.loops_count--;
+        // midpoint goes into start_index (this is the end point of the first segment)
+        move_point(dest, src);
+        _path[dest++] = loop.midpoint;
+        for (src = loop.start_index + 1; src <= loop.end_index; src++) {
+            log_action(SRTL_POINT_PRUNE, _path[src]);
+        }
+    }
+    while (src < _path_points_count) {
+        move_point(dest++, src++);
     }
 
+    const uint16_t removed = _path_points_count - dest;
+    _path_points_count = dest;
+    _prune.loops_count = first_loop;
+
     _path_sem.give();
+
+    // all the loops were in points which have been simplified and checked
+    points_removed(removed);
+
     return true;
 }
 
+// move a point and its simplify state down the path while removing points
+void AP_SmartRTL::move_point(uint16_t dest, uint16_t src)
+{
+    _path[dest] = _path[src];
+    _simplify.points[dest] = _simplify.points[src];
+    _simplify.points[dest].prev = (dest > 0) ? 1 : 0;
+}
+
+// update simplify and pruning point counts after num_removed points have been removed from the path
+// all removed points must be before the first point that has not been simplified
+void AP_SmartRTL::points_removed(uint16_t num_removed)
+{
+    if (!_simplify.complete || _simplify.removal_required) {
+        // only happens when pruning without simplifying, so simplify the whole path again
+        reset_simplification();
+    }
+    _simplify.path_points_count = (_simplify.path_points_count > num_removed) ? _simplify.path_points_count - num_removed : 0;
+    _simplify.path_points_added = (_simplify.path_points_added > num_removed) ? _simplify.path_points_added - num_removed : 0;
+    _simplify.path_points_completed = (_simplify.path_points_completed > num_removed) ? _simplify.path_points_completed - num_removed : 0;
+    if (_simplify.path_points_added > 0) {
+        _simplify.points[_simplify.path_points_added-1].next = 0;
+    }
+    _prune.path_points_completed = (_prune.path_points_completed > num_removed) ? _prune.path_points_completed - num_removed : 0;
+
+    // rebuild the grid as segments after the removed points have moved
+    restart_pruning((_prune.path_points_count > num_removed) ? _prune.path_points_count - num_removed : 0);
+}
+
 // add loop to loops array
 //  returns true if loop added successfully, false if loop array is full
 //  checks if loop overlaps with an existing loop, keeps only the longer loop
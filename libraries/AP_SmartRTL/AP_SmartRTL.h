@@ -1,25 +1,29 @@
 #pragma once
 
 #include <AP_HAL/AP_HAL.h>
-#include <AP_Common/Bitmask.h>
 #include <AP_Math/AP_Math.h>
 
 // definitions and macros
 #define SMARTRTL_ACCURACY_DEFAULT        2.0f   // default _ACCURACY parameter value.  Points will be no closer than this distance (in meters) together.
-#define SMARTRTL_POINTS_DEFAULT          300    // default _POINTS parameter value.  High numbers improve path pruning but use more memory and CPU for cleanup. Memory used will be 20bytes * this number.
-#define SMARTRTL_POINTS_MAX              500    // the absolute maximum number of points this library can support.
+#define SMARTRTL_POINTS_DEFAULT          300    // default _POINTS parameter value.  High numbers improve path pruning but use more memory and CPU for cleanup. Memory used will be 30bytes * this number.
+#if HAL_MEM_CLASS >= HAL_MEM_CLASS_500
+#define SMARTRTL_POINTS_MAX              5000   // the absolute maximum number of points this library can support.
+#else
+#define SMARTRTL_POINTS_MAX              500
+#endif
 #define SMARTRTL_TIMEOUT                 15000  // the time in milliseconds with no points saved to the path (for whatever reason), before SmartRTL is disabled for the flight
 #define SMARTRTL_CLEANUP_POINT_TRIGGER   50     // simplification will trigger when this many points are added to the path
 #define SMARTRTL_CLEANUP_START_MARGIN    10     // routine cleanup algorithms begin when the path array has only this many empty slots remaining
 #define SMARTRTL_CLEANUP_POINT_MIN       10     // cleanup algorithms will remove points if they remove at least this many points
 #define SMARTRTL_SIMPLIFY_EPSILON (_accuracy * 0.5f)
-#define SMARTRTL_SIMPLIFY_STACK_LEN_MULT (2.0f/3.0f)+1  // simplify buffer size as compared to maximum number of points.
-                                                // The minimum is int((s/2-1)+min(s/2, SMARTRTL_POINTS_MAX-s)), where s = pow(2, floor(log(SMARTRTL_POINTS_MAX)/log(2)))
-                                                // To avoid this annoying math, a good-enough overestimate is ceil(SMARTRTL_POINTS_MAX*2.0f/3.0f)
 #define SMARTRTL_SIMPLIFY_TIME_US        200    // maximum time (in microseconds) the simplification algorithm will run before returning
+#define SMARTRTL_SIMPLIFY_SPAN_MAX       64     // simplification will not replace more than this many points with a single segment at once
 #define SMARTRTL_PRUNING_DELTA (_accuracy * 0.99)   // How many meters apart must two points be, such that we can assume that there is no obstacle between them.  must be smaller than _ACCURACY parameter
 #define SMARTRTL_PRUNING_LOOP_BUFFER_LEN_MULT 0.25f // pruning loop buffer size as compared to maximum number of points
 #define SMARTRTL_PRUNING_LOOP_TIME_US    200    // maximum time (in microseconds) that the loop finding algorithm will run before returning
+#define SMARTRTL_PRUNING_CELL_SIZE_MULT  8      // size of the grid cells used to find nearby segments as compared to the _ACCURACY parameter.  Longer segments are checked against every segment
+#define SMARTRTL_PRUNING_QUERY_CELLS_MAX 16     // segments near more grid cells than this are checked against the whole path
+#define SMARTRTL_INDEX_NONE              UINT16_MAX     // no point or segment
 
 class AP_SmartRTL {
 
@@ -146,14 +150,49 @@ private:
     // reset pruning algorithm so that it will re-check all points in the path
     void reset_pruning();
 
+    // forget simplify and pruning results for points which have been popped from the path
+    void truncate_cleanup(uint16_t path_points_count);
+
     // remove all simplify-able points from the path
-    void remove_points_by_simplify_bitmask();
+    void remove_points_by_simplify();
 
     // remove loops until at least num_point_to_remove have been removed from path
     // does not necessarily prune all loops
     // returns false if it failed to remove points (because it could not take semaphore)
     bool remove_points_by_loops(uint16_t num_points_to_remove);
 
+    // move a point and its simplify state down the path while removing points
+    void move_point(uint16_t dest, uint16_t src);
+
+    // update simplify and pruning point counts after num_removed points have been removed from the path
+    // all removed points must be before the first point that has not been simplified
+    void points_removed(uint16_t num_removed);
+
+    // simplify heap methods
+    // cost of removing a point from the path (the farthest any removed point could be from the path)
+    float simplify_cost(uint16_t index) const;
+    float segment_error(uint16_t start_index, uint16_t end_index) const;
+    // convert a distance in meters to the millimeters held in the simplify state, rounding up
+    static uint16_t simplify_dist_mm(float dist);
+    void simplify_add_point(uint16_t index);
+    void simplify_remove_point(uint16_t index);
+    void heap_push(uint16_t index);
+    void heap_remove(uint16_t index);
+    void heap_update(uint16_t index);
+    void heap_clear();
+    void heap_sift_up(uint16_t heap_index);
+    void heap_sift_down(uint16_t heap_index);
+    void heap_swap(uint16_t heap_index1, uint16_t heap_index2);
+
+    // pruning grid methods
+    // find the first segment which comes within SMARTRTL_PRUNING_DELTA of the segment ending at index
+    // returns SMARTRTL_INDEX_NONE if there is none
+    uint16_t find_loop(uint16_t index, Vector3f& midpoint) const;
+    void grid_add_segment(uint16_t index);
+    void grid_clear();
+    uint16_t grid_bucket(int32_t x, int32_t y) const;
+    int32_t grid_cell(float pos) const { return (int32_t)floorf(pos / _prune.cell_size); }
+
     // add loop to loops array
     //  returns true if loop added successfully, false on failure (because loop array is full)
     //  checks if loop overlaps with an existing loop, keeps only the longer loop
@@ -199,20 +238,29 @@ private:
     HAL_Semaphore _path_sem;   // semaphore for updating path
 
     // Simplify
-    // structure and buffer to hold the "to-do list" for the simplify algorithm.
+    // Points are added to a doubly linked list as they are added to the path.  Each point in the middle of the list is held
+    // in a min-heap by the cost of removing it, and points are removed from the list (but not yet the path) until the
+    // cheapest point would take the path further than SMARTRTL_SIMPLIFY_EPSILON from a point the vehicle has passed through
+    // distances are held in millimeters rounded up, and the links as offsets as points more than
+    // SMARTRTL_SIMPLIFY_SPAN_MAX apart are never joined
     typedef struct {
-        uint16_t start;
-        uint16_t finish;
-    } simplify_start_finish_t;
+        uint16_t error;         // the farthest any point already removed from the path before this point can be from the segment to this point
+        uint16_t cost;          // the farthest any point could be from the segment between prev and next if this point was removed
+        uint16_t heap_index;    // position in heap, SMARTRTL_INDEX_NONE if not in heap, SMARTRTL_SIMPLIFY_REMOVED if flagged for removal
+        uint8_t prev;           // offset back to the previous point not flagged for removal, zero for the first point
+        uint8_t next;           // offset forward to the next point not flagged for removal, zero for the latest point
+    } simplify_point_t;
+    static const uint16_t SMARTRTL_SIMPLIFY_REMOVED = UINT16_MAX - 1;
     struct {
         bool complete;          // true after simplify_detection has completed
-        bool removal_required;  // true if some simplify-able points have been found on the path, set true by detect_simplifications, set false by remove_points_by_simplify_bitmask
+        bool removal_required;  // true if some simplify-able points have been found on the path, set true by detect_simplifications, set false by remove_points_by_simplify
         uint16_t path_points_count; // copy of _path_points_count taken when the simply algorithm started
         uint16_t path_points_completed = SMARTRTL_POINTS_MAX; // number of points in that path that have already been simplified and should be ignored
-        simplify_start_finish_t* stack;
-        uint16_t stack_max;     // maximum number of elements in the _simplify_stack array
-        uint16_t stack_count;   // number of elements in _simplify_stack array
-        Bitmask<SMARTRTL_POINTS_MAX> bitmask;  // simplify algorithm clears bits for each point that can be removed
+        uint16_t path_points_added; // number of points that have been added to the linked list
+        uint16_t removed_min = SMARTRTL_INDEX_NONE;   // lowest index of a point flagged for removal, SMARTRTL_INDEX_NONE if none
+        simplify_point_t* points;
+        uint16_t* heap;         // indexes of points ordered by cost
+        uint16_t heap_count;    // number of elements in heap array
     } _simplify;
 
     // Pruning
@@ -226,11 +274,18 @@ private:
         bool complete;
         uint16_t path_points_count;  // copy of _path_points_count taken when the prune algorithm started
         uint16_t path_points_completed; // number of points in that path that have already been checked for loops and should be ignored
-        uint16_t i;     // loop search's outer loop index
-        uint16_t j;     // loop search's inner loop index
-        prune_loop_t* loops;// the result of the pruning algorithm
+        uint16_t i;     // next segment (identified by its end point) to check for loops and add to the grid
+        prune_loop_t* loops;// the result of the pruning algorithm, in order along the path
         uint16_t loops_max; // maximum number of elements in the _prunable_loops array
         uint16_t loops_count;   // number of elements in the _prunable_loops array
+
+        // horizontal grid of segments already checked, used to find segments that could come close to a new segment
+        // segments are held in the cell of their lowest corner, segments longer than cell_size are held in the long list
+        float cell_size;        // size of grid cells in meters, set when pruning restarts
+        uint16_t* cell_head;    // first segment in each hash bucket of cells
+        uint16_t cell_mask;     // number of hash buckets minus one
+        uint16_t* segment_next; // next segment in the same bucket or long list
+        uint16_t long_head;     // first segment which is too long to be held in a cell
     } _prune;
 
     // returns true if the two loops overlap (used within add_loop to determine which loops to keep or throw away)
@@ -342,10 +342,9 @@ std::vector<Vector3f> test_path_complete {
     {75.0, 55.0, 10.0},
     {100.0, 100.0, 100.0},
     {103.0, 100.0, 100.0},
-    {103.0, 100.0, 100.0},
     {200.0, 200.0, 200.0},
-    {203.0, 200.0, 200.0},  // 50
-    {203.0, 203.0, 200.0},
+    {203.0, 200.0, 200.0},
+    {203.0, 203.0, 200.0},  // 50
     {206.0, 203.0, 200.0},
     {206.0, 206.0, 200.0},
     {209.0, 206.0, 200.0},
@@ -354,8 +353,8 @@ std::vector<Vector3f> test_path_complete {
     {212.0, 212.0, 200.0},
     {220.0, 220.0, 200.0},
     {223.0, 220.0, 200.0},
-    {223.2368474, 220.0789542, 199.5263052}, // 60
-    {229.0, 220.0, 200.0},
+    {223.2368474, 220.0789542, 199.5263052},
+    {229.0, 220.0, 200.0},  // 60
     {300.1223662, 300.0, 300.0696305},
     {300.0, 300.0, 295.0},
 };
@@ -75,7 +75,15 @@ const AP_Param::GroupInfo AP_Terrain::var_info[] = {
     // @Range: 0 50
     // @User: Advanced
     AP_GROUPINFO("OFS_MAX",  4, AP_Terrain, offset_max, 15),
-    
+
+    // @Param: CACHE_SZ
+    // @DisplayName: Terrain cache size
+    // @Description: The number of terrain grid blocks to keep in memory. Each block takes about 2 kilobytes. A larger cache avoids waiting on SD card reads on long missions, and gives room for blocks ahead of the vehicle to be loaded before they are needed. The cache is limited to half of the free memory at startup.
+    // @Range: 12 128
+    // @RebootRequired: True
+    // @User: Advanced
+    AP_GROUPINFO("CACHE_SZ",  5, AP_Terrain, cache_size_max, TERRAIN_GRID_BLOCK_CACHE_SIZE),
+
     AP_GROUPEND
 };
 
@@ -347,6 +355,9 @@ void AP_Terrain::update(void)
     // check for pending rally data
     update_rally_data();
 
+    // load grids we are heading towards
+    update_prefetch();
+
     // update capabilities and status
     if (allocate()) {
         if (!pos_valid) {
@@ -396,6 +407,26 @@ void AP_Terrain::log_terrain_data()
         reference_offset : have_reference_offset?reference_offset:0,
     };
     AP::logger().WriteBlock(&pkt, sizeof(pkt));
+
+    uint16_t in_memory = 0;
+    for (uint16_t i=0; i<cache_size; i++) {
+        if (cache[i].state >= GRID_CACHE_VALID) {
+            in_memory++;
+        }
+    }
+    struct log_TERRAIN_CACHE cpkt = {
+        LOG_PACKET_HEADER_INIT(LOG_TERRAIN_CACHE_MSG),
+        time_us        : AP_HAL::micros64(),
+        size           : cache_size,
+        valid          : in_memory,
+        hits           : cache_stats.hits,
+        misses         : cache_stats.misses,
+        prefetched     : cache_stats.prefetched,
+        prefetch_used  : cache_stats.prefetch_used,
+        read_avg_ms    : (uint16_t)(cache_stats.reads ? cache_stats.read_total_ms / cache_stats.reads : 0),
+        read_max_ms    : (uint16_t)MIN(cache_stats.read_max_ms, UINT16_MAX),
+    };
+    AP::logger().WriteBlock(&cpkt, sizeof(cpkt));
 }
 
 /*
@@ -410,13 +441,24 @@ bool AP_Terrain::allocate(void)
     if (cache != nullptr) {
         return true;
     }
-    cache = (struct grid_cache *)calloc(TERRAIN_GRID_BLOCK_CACHE_SIZE, sizeof(cache[0]));
+    // take the configured number of blocks if that leaves at least
+    // half of the free memory for everything else
+    uint32_t blocks = constrain_int16(cache_size_max, TERRAIN_GRID_BLOCK_CACHE_SIZE, TERRAIN_GRID_BLOCK_CACHE_SIZE_MAX);
+    blocks = MIN(blocks, hal.util->available_memory() / (2 * sizeof(cache[0])));
+    blocks = MAX(blocks, uint32_t(TERRAIN_GRID_BLOCK_CACHE_SIZE));
+    while (true) {
+        cache = (struct grid_cache *)calloc(blocks, sizeof(cache[0]));
+        if (cache != nullptr || blocks == TERRAIN_GRID_BLOCK_CACHE_SIZE) {
+            break;
+        }
+        blocks = MAX(blocks/2, uint32_t(TERRAIN_GRID_BLOCK_CACHE_SIZE));
+    }
     if (cache == nullptr) {
         gcs().send_text(MAV_SEVERITY_CRITICAL, "Terrain: Allocation failed");
         memory_alloc_failed = true;
         return false;
     }
-    cache_size = TERRAIN_GRID_BLOCK_CACHE_SIZE;
+    cache_size = blocks;
     return true;
 }
 
@@ -53,9 +53,24 @@
 #define TERRAIN_GRID_BLOCK_SIZE_X (TERRAIN_GRID_MAVLINK_SIZE*TERRAIN_GRID_BLOCK_MUL_X)
 #define TERRAIN_GRID_BLOCK_SIZE_Y (TERRAIN_GRID_MAVLINK_SIZE*TERRAIN_GRID_BLOCK_MUL_Y)
 
-// number of grid_blocks in the LRU memory cache
+// default and minimum number of grid_blocks in the LRU memory cache
 #define TERRAIN_GRID_BLOCK_CACHE_SIZE 12
 
+// upper limit for TERRAIN_CACHE_SZ
+#ifndef TERRAIN_GRID_BLOCK_CACHE_SIZE_MAX
+#define TERRAIN_GRID_BLOCK_CACHE_SIZE_MAX 128
+#endif
+
+// how far ahead of the vehicle to prefetch grid_blocks into the
+// cache, in seconds of travel at the current ground speed
+#define TERRAIN_PREFETCH_TIME_S 60
+
+// blocks used more recently than this are never evicted by a prefetch
+#define TERRAIN_PREFETCH_MIN_AGE_MS 5000
+
+// most grid_blocks waiting for disk reads before prefetch backs off
+#define TERRAIN_PREFETCH_MAX_PENDING 2
+
 // format of grid on disk
 #define TERRAIN_GRID_FORMAT_VERSION 1
 
@@ -259,6 +274,12 @@ private:
 
         // the last time access was requested to this block, used for LRU
         uint32_t last_access_ms;
+
+        // time the block was queued for disk read
+        uint32_t read_start_ms;
+
+        // loaded by prefetch and not yet used
+        bool prefetched;
     };
 
     /*
@@ -298,6 +319,19 @@ private:
     */
     struct grid_cache &find_grid_cache(const struct grid_info &info);
 
+    bool grid_cache_matches(const struct grid_cache &gcache, const struct grid_info &info) const;
+
+    /*
+      return index of the cached grid for a grid_info, or -1
+     */
+    int16_t lookup_grid_cache(const struct grid_info &info);
+
+    // index of the least recently used grid
+    uint16_t oldest_grid_cache(void) const;
+
+    // reuse a cache entry for a grid_info, queueing a disk read
+    struct grid_cache &claim_grid_cache(uint16_t idx, const struct grid_info &info);
+
     /*
       calculate bit number in grid_block bitmap. This corresponds to a
       bit representing a 4x4 mavlink transmitted block
@@ -350,6 +384,13 @@ private:
      */
     void update_rally_data(void);
 
+    /*
+      load grids ahead of the vehicle into the cache
+     */
+    void update_prefetch(void);
+    bool prefetch_location(const Location &loc);
+    void prefetch_leg(const Location &from, const Location &to, float max_distance, uint8_t &count);
+
     /*
       calculate reference offset if needed
      */
@@ -362,15 +403,31 @@ private:
     AP_Int16 grid_spacing; // meters between grid points
     AP_Int16 options; // option bits
     AP_Float offset_max;
+    AP_Int16 cache_size_max;
 
     enum class Options {
         DisableDownload = (1U<<0),
     };
 
     // cache of grids in memory, LRU
-    uint8_t cache_size = 0;
+    uint16_t cache_size = 0;
     struct grid_cache *cache = nullptr;
 
+    // index of the most recently found grid, checked before the
+    // rest of the cache as most lookups are for the same grid
+    uint16_t last_cache_idx;
+
+    // cache performance, reported in the TERC log message
+    struct {
+        uint32_t hits;
+        uint32_t misses;
+        uint32_t prefetched;
+        uint32_t prefetch_used;
+        uint32_t reads;
+        uint32_t read_total_ms;
+        uint32_t read_max_ms;
+    } cache_stats;
+
     // a grid_cache block waiting for disk IO
     enum DiskIoState {
         DiskIoIdle      = 0,
@@ -92,6 +92,11 @@ void AP_Terrain::schedule_disk_io(void)
             }
             cache[cache_idx].state = GRID_CACHE_VALID;
             cache[cache_idx].last_access_ms = AP_HAL::millis();
+
+            const uint32_t read_ms = cache[cache_idx].last_access_ms - cache[cache_idx].read_start_ms;
+            cache_stats.reads++;
+            cache_stats.read_total_ms += read_ms;
+            cache_stats.read_max_ms = MAX(cache_stats.read_max_ms, read_ms);
         }
         disk_io_state = DiskIoIdle;
         break;
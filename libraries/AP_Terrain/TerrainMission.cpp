@@ -25,6 +25,7 @@
 #include <GCS_MAVLink/GCS.h>
 #include "AP_Terrain.h"
 #include <AP_GPS/AP_GPS.h>
+#include <AP_AHRS/AP_AHRS.h>
 
 #if AP_TERRAIN_AVAILABLE
 
@@ -172,4 +173,102 @@ void AP_Terrain::update_rally_data(void)
     }
 }
 
+/*
+  load grids the vehicle is heading towards into the cache before
+  they are needed, so flying into a new grid doesn't wait on the SD
+  card. Grids along the velocity vector and along the leg to the
+  current mission waypoint are loaded, looking ahead
+  TERRAIN_PREFETCH_TIME_S at the current ground speed
+ */
+void AP_Terrain::update_prefetch(void)
+{
+    if (!allocate()) {
+        return;
+    }
+    uint8_t count = 0;
+    for (uint16_t i=0; i<cache_size; i++) {
+        if (cache[i].state == GRID_CACHE_DISKWAIT) {
+            count++;
+        }
+    }
+    if (count >= TERRAIN_PREFETCH_MAX_PENDING) {
+        // the disk is already busy
+        return;
+    }
+
+    AP_AHRS &ahrs = AP::ahrs();
+    Location loc;
+    if (!ahrs.get_location(loc)) {
+        return;
+    }
+
+    // look at least one grid ahead, even when hovering
+    const float grid_m = TERRAIN_GRID_BLOCK_SPACING_X * grid_spacing;
+    const Vector2f groundspeed = ahrs.groundspeed_vector();
+    const float lookahead_m = MAX(groundspeed.length() * TERRAIN_PREFETCH_TIME_S, grid_m);
+
+    if (groundspeed.length() > 1) {
+        Location ahead = loc;
+        ahead.offset(groundspeed.x * TERRAIN_PREFETCH_TIME_S, groundspeed.y * TERRAIN_PREFETCH_TIME_S);
+        prefetch_leg(loc, ahead, lookahead_m, count);
+    }
+
+#if HAL_MISSION_ENABLED
+    const AP_Mission *mission = AP::mission();
+    if (mission != nullptr && mission->state() == AP_Mission::MISSION_RUNNING) {
+        const AP_Mission::Mission_Command &cmd = mission->get_current_nav_cmd();
+        if (cmd.content.location.lat != 0 || cmd.content.location.lng != 0) {
+            prefetch_leg(loc, cmd.content.location, lookahead_m, count);
+        }
+    }
+#endif
+}
+
+/*
+  prefetch grids along the line from one location towards another, up
+  to max_distance meters. Sample points are half a grid apart so none
+  are skipped
+ */
+void AP_Terrain::prefetch_leg(const Location &from, const Location &to, float max_distance, uint8_t &count)
+{
+    const float step = 0.5 * TERRAIN_GRID_BLOCK_SPACING_X * grid_spacing;
+    const float distance = MIN(from.get_distance(to), max_distance);
+    const float bearing = from.get_bearing_to(to) * 0.01;
+    float d = 0;
+    while (count < TERRAIN_PREFETCH_MAX_PENDING && d < distance) {
+        d = MIN(d + step, distance);
+        Location loc = from;
+        loc.offset_bearing(bearing, d);
+        if (prefetch_location(loc)) {
+            count++;
+        }
+    }
+}
+
+/*
+  start loading the grid for a location unless it is already cached.
+  Only grids which have not been used for a while are replaced, so a
+  cache that is too small for the current working set is not thrashed
+ */
+bool AP_Terrain::prefetch_location(const Location &loc)
+{
+    struct grid_info info;
+    calculate_grid_info(loc, info);
+    if (lookup_grid_cache(info) != -1) {
+        return false;
+    }
+    const uint16_t idx = oldest_grid_cache();
+    const struct grid_cache &oldest = cache[idx];
+    if (oldest.state == GRID_CACHE_DISKWAIT || oldest.state == GRID_CACHE_DIRTY) {
+        return false;
+    }
+    if (oldest.state != GRID_CACHE_INVALID &&
+        AP_HAL::millis() - oldest.last_access_ms < TERRAIN_PREFETCH_MIN_AGE_MS) {
+        return false;
+    }
+    claim_grid_cache(idx, info).prefetched = true;
+    cache_stats.prefetched++;
+    return true;
+}
+
 #endif // AP_TERRAIN_AVAILABLE
@@ -105,28 +105,53 @@ void AP_Terrain::calculate_grid_info(const Location &loc, struct grid_info &info
 
 
 /*
-  find a grid structure given a grid_info
+  return true if a cached grid is the one described by a grid_info
  */
-AP_Terrain::grid_cache &AP_Terrain::find_grid_cache(const struct grid_info &info)
+bool AP_Terrain::grid_cache_matches(const struct grid_cache &gcache, const struct grid_info &info) const
 {
-    uint16_t oldest_i = 0;
+    return TERRAIN_LATLON_EQUAL(gcache.grid.lat,info.grid_lat) &&
+        TERRAIN_LATLON_EQUAL(gcache.grid.lon,info.grid_lon) &&
+        gcache.grid.spacing == grid_spacing;
+}
 
-    // see if we have that grid
+/*
+  return index of the cached grid for a grid_info, or -1 if not cached
+ */
+int16_t AP_Terrain::lookup_grid_cache(const struct grid_info &info)
+{
+    if (last_cache_idx < cache_size && grid_cache_matches(cache[last_cache_idx], info)) {
+        return last_cache_idx;
+    }
     for (uint16_t i=0; i<cache_size; i++) {
-        if (TERRAIN_LATLON_EQUAL(cache[i].grid.lat,info.grid_lat) &&
-            TERRAIN_LATLON_EQUAL(cache[i].grid.lon,info.grid_lon) &&
-            cache[i].grid.spacing == grid_spacing) {
-            cache[i].last_access_ms = AP_HAL::millis();
-            return cache[i];
+        if (grid_cache_matches(cache[i], info)) {
+            last_cache_idx = i;
+            return i;
         }
+    }
+    return -1;
+}
+
+/*
+  find the least recently used grid
+ */
+uint16_t AP_Terrain::oldest_grid_cache(void) const
+{
+    uint16_t oldest_i = 0;
+    for (uint16_t i=1; i<cache_size; i++) {
         if (cache[i].last_access_ms < cache[oldest_i].last_access_ms) {
             oldest_i = i;
         }
     }
+    return oldest_i;
+}
 
-    // Not found. Use the oldest grid and make it this grid,
-    // initially unpopulated
-    struct grid_cache &grid = cache[oldest_i];
+/*
+  make cache entry idx this grid, initially unpopulated and waiting
+  for a disk read
+ */
+AP_Terrain::grid_cache &AP_Terrain::claim_grid_cache(uint16_t idx, const struct grid_info &info)
+{
+    struct grid_cache &grid = cache[idx];
     memset(&grid, 0, sizeof(grid));
 
     grid.grid.lat = info.grid_lat;
@@ -138,6 +163,8 @@ AP_Terrain::grid_cache &AP_Terrain::find_grid_cache(const struct grid_info &info
     grid.grid.lon_degrees = info.lon_degrees;
     grid.grid.version = TERRAIN_GRID_FORMAT_VERSION;
     grid.last_access_ms = AP_HAL::millis();
+    grid.read_start_ms = grid.last_access_ms;
+    last_cache_idx = idx;
 
     // mark as waiting for disk read
     grid.state = GRID_CACHE_DISKWAIT;
@@ -145,6 +172,29 @@ AP_Terrain::grid_cache &AP_Terrain::find_grid_cache(const struct grid_info &info
     return grid;
 }
 
+/*
+  find a grid structure given a grid_info
+ */
+AP_Terrain::grid_cache &AP_Terrain::find_grid_cache(const struct grid_info &info)
+{
+    // see if we have that grid
+    const int16_t idx = lookup_grid_cache(info);
+    if (idx != -1) {
+        struct grid_cache &grid = cache[idx];
+        grid.last_access_ms = AP_HAL::millis();
+        cache_stats.hits++;
+        if (grid.prefetched) {
+            grid.prefetched = false;
+            cache_stats.prefetch_used++;
+        }
+        return grid;
+    }
+
+    // Not found. Use the oldest grid and make it this grid
+    cache_stats.misses++;
+    return claim_grid_cache(oldest_grid_cache(), info);
+}
+
 /*
   find cache index of disk_block
  */
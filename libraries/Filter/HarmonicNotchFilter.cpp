@@ -98,7 +98,9 @@ const AP_Param::GroupInfo HarmonicNotchFilterParams::var_info[] = {
  */
 template <class T>
 HarmonicNotchFilter<T>::~HarmonicNotchFilter() {
-    delete[] _filters;
+    delete[] _coeffs;
+    delete[] _center_freq_hz;
+    delete[] _state;
     _num_filters = 0;
     _num_enabled_filters = 0;
 }
@@ -111,7 +113,7 @@ template <class T>
 void HarmonicNotchFilter<T>::init(float sample_freq_hz, float center_freq_hz, float bandwidth_hz, float attenuation_dB)
 {
     // sanity check the input
-    if (_filters == nullptr || is_zero(sample_freq_hz) || isnan(sample_freq_hz)) {
+    if (_coeffs == nullptr || is_zero(sample_freq_hz) || isnan(sample_freq_hz)) {
         return;
     }
 
@@ -133,6 +135,11 @@ void HarmonicNotchFilter<T>::init(float sample_freq_hz, float center_freq_hz, fl
         NotchFilter<T>::calculate_A_and_Q(center_freq_hz, bandwidth_hz, attenuation_dB, _A, _Q);
     }
 
+    // force recalculation of all coefficients with the new A & Q
+    for (uint8_t i = 0; i < _num_filters; i++) {
+        _center_freq_hz[i] = 0;
+    }
+
     _initialised = true;
     update(center_freq_hz);
 }
@@ -149,14 +156,41 @@ void HarmonicNotchFilter<T>::allocate_filters(uint8_t num_notches, uint8_t harmo
     _harmonics = harmonics;
 
     if (_num_filters > 0) {
-        _filters = new NotchFilter<T>[_num_filters];
-        if (_filters == nullptr) {
-            GCS_SEND_TEXT(MAV_SEVERITY_ERROR, "Failed to allocate %u bytes for notch filter", (unsigned int)(_num_filters * sizeof(NotchFilter<T>)));
+        _coeffs = new NotchFilterCoeffs[_num_filters];
+        _center_freq_hz = new float[_num_filters]();
+        _state = new NotchState[_num_filters+1]();
+        if (_coeffs == nullptr || _center_freq_hz == nullptr || _state == nullptr) {
+            GCS_SEND_TEXT(MAV_SEVERITY_ERROR, "Failed to allocate %u bytes for notch filter",
+                          (unsigned int)(_num_filters * (sizeof(NotchFilterCoeffs) + sizeof(float)) + (_num_filters+1) * sizeof(NotchState)));
+            delete[] _coeffs;
+            delete[] _center_freq_hz;
+            delete[] _state;
+            _coeffs = nullptr;
+            _center_freq_hz = nullptr;
+            _state = nullptr;
             _num_filters = 0;
         }
     }
 }
 
+/*
+  set the center frequency of a single notch. The coefficients need
+  trigonometric functions so are only recalculated when the frequency
+  changes
+ */
+template <class T>
+void HarmonicNotchFilter<T>::set_notch_center(uint8_t idx, float center_freq_hz)
+{
+    if (is_equal(_center_freq_hz[idx], center_freq_hz)) {
+        return;
+    }
+    _center_freq_hz[idx] = center_freq_hz;
+    if (!_coeffs[idx].calculate(_sample_freq_hz, center_freq_hz, _A, _Q)) {
+        // out of range notches pass the signal through
+        _coeffs[idx].set_passthrough();
+    }
+}
+
 /*
   update the underlying filters' center frequency using the current attenuation and quality
   this function is cheaper than init() because A & Q do not need to be recalculated
@@ -180,19 +214,19 @@ void HarmonicNotchFilter<T>::update(float center_freq_hz)
             if (!_double_notch) {
                 // only enable the filter if its center frequency is below the nyquist frequency
                 if (notch_center < nyquist_limit) {
-                    _filters[_num_enabled_filters++].init_with_A_and_Q(_sample_freq_hz, notch_center, _A, _Q);
+                    set_notch_center(_num_enabled_filters++, notch_center);
                 }
             } else {
                 float notch_center_double;
                 // only enable the filter if its center frequency is below the nyquist frequency
                 notch_center_double = notch_center * (1.0 - _notch_spread);
                 if (notch_center_double < nyquist_limit) {
-                    _filters[_num_enabled_filters++].init_with_A_and_Q(_sample_freq_hz, notch_center_double, _A, _Q);
+                    set_notch_center(_num_enabled_filters++, notch_center_double);
                 }
                 // only enable the filter if its center frequency is below the nyquist frequency
                 notch_center_double = notch_center * (1.0 + _notch_spread);
                 if (notch_center_double < nyquist_limit) {
-                    _filters[_num_enabled_filters++].init_with_A_and_Q(_sample_freq_hz, notch_center_double, _A, _Q);
+                    set_notch_center(_num_enabled_filters++, notch_center_double);
                 }
             }
         }
@@ -229,19 +263,19 @@ void HarmonicNotchFilter<T>::update(uint8_t num_centers, const float center_freq
         if (!_double_notch) {
             // only enable the filter if its center frequency is below the nyquist frequency
             if (notch_center < nyquist_limit) {
-                _filters[_num_enabled_filters++].init_with_A_and_Q(_sample_freq_hz, notch_center, _A, _Q);
+                set_notch_center(_num_enabled_filters++, notch_center);
             }
         } else {
             float notch_center_double;
             // only enable the filter if its center frequency is below the nyquist frequency
             notch_center_double = notch_center * (1.0 - _notch_spread);
             if (notch_center_double < nyquist_limit) {
-                _filters[_num_enabled_filters++].init_with_A_and_Q(_sample_freq_hz, notch_center_double, _A, _Q);
+                set_notch_center(_num_enabled_filters++, notch_center_double);
             }
             // only enable the filter if its center frequency is below the nyquist frequency
             notch_center_double = notch_center * (1.0 + _notch_spread);
             if (notch_center_double < nyquist_limit) {
-                _filters[_num_enabled_filters++].init_with_A_and_Q(_sample_freq_hz, notch_center_double, _A, _Q);
+                set_notch_center(_num_enabled_filters++, notch_center_double);
             }
         }
     }
@@ -249,6 +283,9 @@ void HarmonicNotchFilter<T>::update(uint8_t num_centers, const float center_freq
 
 /*
   apply a sample to each of the underlying filters in turn and return the output
+  each notch depends on the output of the previous one, so the
+  notches are run one after another and the axes of T are filtered
+  by the plain vector operations of each notch
  */
 template <class T>
 T HarmonicNotchFilter<T>::apply(const T &sample)
@@ -257,11 +294,22 @@ T HarmonicNotchFilter<T>::apply(const T &sample)
         return sample;
     }
 
-    T output = sample;
+    T input = sample;
     for (uint8_t i = 0; i < _num_enabled_filters; i++) {
-        output = _filters[i].apply(output);
+        const NotchFilterCoeffs &c = _coeffs[i];
+        NotchState &in = _state[i];
+        const NotchState &out = _state[i+1];
+        const T output = (input*c.b0 + in.sig1*c.b1 + in.sig2*c.b2 - out.sig1*c.a1 - out.sig2*c.a2) * c.a0_inv;
+        // the output history of this notch is updated as the input history of the next
+        in.sig2 = in.sig1;
+        in.sig1 = input;
+        input = output;
     }
-    return output;
+    NotchState &last = _state[_num_enabled_filters];
+    last.sig2 = last.sig1;
+    last.sig1 = input;
+
+    return input;
 }
 
 /*
@@ -274,8 +322,8 @@ void HarmonicNotchFilter<T>::reset()
         return;
     }
 
-    for (uint8_t i = 0; i < _num_filters; i++) {
-        _filters[i].reset();
+    for (uint8_t i = 0; i <= _num_filters; i++) {
+        _state[i].sig1 = _state[i].sig2 = T();
     }
 }
 
@@ -43,8 +43,26 @@ public:
     void reset();
 
 private:
-    // underlying bank of notch filters
-    NotchFilter<T>*  _filters;
+    // set the center frequency of one notch, only recalculating coefficients on a change
+    void set_notch_center(uint8_t idx, float center_freq_hz);
+
+    // signal history between two notches in the cascade
+    struct NotchState {
+        T sig1;
+        T sig2;
+    };
+
+    /*
+      the notches are run as a cascade of biquads with the
+      coefficients and history held in separate arrays. The output of
+      each notch is the input of the next so the history is shared:
+      _state[0] is the input history and _state[i+1] is the output
+      history of notch i
+     */
+    NotchFilterCoeffs* _coeffs;
+    // center frequency the coefficients of each notch were calculated for
+    float* _center_freq_hz;
+    NotchState* _state;
     // sample frequency for each filter
     float _sample_freq_hz;
     // base double notch bandwidth for each filter
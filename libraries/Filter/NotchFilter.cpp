@@ -52,6 +52,14 @@ void NotchFilter<T>::init(float sample_freq_hz, float center_freq_hz, float band
 
 template <class T>
 void NotchFilter<T>::init_with_A_and_Q(float sample_freq_hz, float center_freq_hz, float A, float Q)
+{
+    initialised = coeffs.calculate(sample_freq_hz, center_freq_hz, A, Q);
+}
+
+/*
+  calculate the biquad coefficients
+ */
+bool NotchFilterCoeffs::calculate(float sample_freq_hz, float center_freq_hz, float A, float Q)
 {
     if ((center_freq_hz > 0.0) && (center_freq_hz < 0.5 * sample_freq_hz) && (Q > 0.0)) {
         float omega = 2.0 * M_PI * center_freq_hz / sample_freq_hz;
@@ -62,10 +70,20 @@ void NotchFilter<T>::init_with_A_and_Q(float sample_freq_hz, float center_freq_h
         a0_inv =  1.0/(1.0 + alpha);
         a1 = b1;
         a2 =  1.0 - alpha;
-        initialised = true;
-    } else {
-        initialised = false;
+        return true;
     }
+    return false;
+}
+
+/*
+  coefficients giving output equal to input
+ */
+void NotchFilterCoeffs::set_passthrough()
+{
+    b0 = 1.0;
+    b1 = b2 = 0.0;
+    a1 = a2 = 0.0;
+    a0_inv = 1.0;
 }
 
 /*
@@ -87,7 +105,7 @@ T NotchFilter<T>::apply(const T &sample)
     ntchsig2 = ntchsig1;
     ntchsig1 = ntchsig;
     ntchsig = sample;
-    T output = (ntchsig*b0 + ntchsig1*b1 + ntchsig2*b2 - signal1*a1 - signal2*a2) * a0_inv;
+    T output = (ntchsig*coeffs.b0 + ntchsig1*coeffs.b1 + ntchsig2*coeffs.b2 - signal1*coeffs.a1 - signal2*coeffs.a2) * coeffs.a0_inv;
     signal2 = signal1;
     signal1 = output;
     return output;
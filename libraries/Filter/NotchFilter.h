@@ -26,6 +26,18 @@
 #include <AP_Param/AP_Param.h>
 
 
+/*
+  biquad coefficients of a notch filter
+ */
+struct NotchFilterCoeffs {
+    // calculate coefficients from the attenuation and quality, returning false if out of range
+    bool calculate(float sample_freq_hz, float center_freq_hz, float A, float Q);
+    // set coefficients that pass the input through unchanged
+    void set_passthrough();
+
+    float b0, b1, b2, a1, a2, a0_inv;
+};
+
 template <class T>
 class NotchFilter {
 public:
@@ -41,7 +53,7 @@ public:
 private:
 
     bool initialised;
-    float b0, b1, b2, a1, a2, a0_inv;
+    NotchFilterCoeffs coeffs;
     T ntchsig, ntchsig1, ntchsig2, signal2, signal1;
 };
 
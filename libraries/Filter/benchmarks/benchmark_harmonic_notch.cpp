@@ -0,0 +1,75 @@
+#include <AP_gbenchmark.h>
+
+#include <Filter/HarmonicNotchFilter.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+/*
+  compare the harmonic notch cascade against applying a bank of
+  independent notch filters, using the worst case configuration of 8
+  harmonics with double notches on a 2kHz gyro
+ */
+static const float sample_freq_hz = 2000;
+static const float center_freq_hz = 80;
+static const float bandwidth_hz = 40;
+static const float attenuation_dB = 40;
+
+static void BM_NotchFilterBank(benchmark::State& state)
+{
+    NotchFilterVector3f filters[16];
+    for (uint8_t i = 0; i < 8; i++) {
+        filters[i*2].init(sample_freq_hz, center_freq_hz * (i+1) * 0.97, bandwidth_hz * 0.5, attenuation_dB);
+        filters[i*2+1].init(sample_freq_hz, center_freq_hz * (i+1) * 1.03, bandwidth_hz * 0.5, attenuation_dB);
+    }
+    Vector3f sample(0.1f, -0.2f, 0.3f);
+    while (state.KeepRunning()) {
+        Vector3f output = sample;
+        for (uint8_t i = 0; i < 16; i++) {
+            output = filters[i].apply(output);
+        }
+        gbenchmark_escape(&output);
+    }
+}
+
+static void BM_HarmonicNotchApply(benchmark::State& state)
+{
+    HarmonicNotchFilterVector3f filter;
+    filter.allocate_filters(1, 0xFF, true);
+    filter.init(sample_freq_hz, center_freq_hz, bandwidth_hz, attenuation_dB);
+    Vector3f sample(0.1f, -0.2f, 0.3f);
+    while (state.KeepRunning()) {
+        Vector3f output = filter.apply(sample);
+        gbenchmark_escape(&output);
+    }
+}
+
+static void BM_HarmonicNotchUpdateUnchanged(benchmark::State& state)
+{
+    HarmonicNotchFilterVector3f filter;
+    filter.allocate_filters(1, 0xFF, true);
+    filter.init(sample_freq_hz, center_freq_hz, bandwidth_hz, attenuation_dB);
+    while (state.KeepRunning()) {
+        filter.update(center_freq_hz);
+        gbenchmark_clobber();
+    }
+}
+
+static void BM_HarmonicNotchUpdateChanged(benchmark::State& state)
+{
+    HarmonicNotchFilterVector3f filter;
+    filter.allocate_filters(1, 0xFF, true);
+    filter.init(sample_freq_hz, center_freq_hz, bandwidth_hz, attenuation_dB);
+    float freq = center_freq_hz;
+    while (state.KeepRunning()) {
+        freq = freq > 100 ? center_freq_hz : freq + 0.1f;
+        filter.update(freq);
+        gbenchmark_clobber();
+    }
+}
+
+BENCHMARK(BM_NotchFilterBank);
+BENCHMARK(BM_HarmonicNotchApply);
+BENCHMARK(BM_HarmonicNotchUpdateUnchanged);
+BENCHMARK(BM_HarmonicNotchUpdateChanged);
+
+BENCHMARK_MAIN();
@@ -37,6 +37,17 @@
 #define HAL_MAVLINK_INTERVALS_FROM_FILES_ENABLED (HAVE_FILESYSTEM_SUPPORT && BOARD_FLASH_SIZE > 1024)
 #endif
 
+// share encoded stream message payloads between channels sending the
+// same message in the same update
+#ifndef HAL_MAVLINK_SHARED_PAYLOADS_ENABLED
+#define HAL_MAVLINK_SHARED_PAYLOADS_ENABLED (HAL_MEM_CLASS >= HAL_MEM_CLASS_500)
+#endif
+
+// size of each of the blocks an FTP burst read is read ahead into
+#ifndef FTP_BURST_BLOCK_SIZE
+#define FTP_BURST_BLOCK_SIZE 2048
+#endif
+
 // macros used to determine if a message will fit in the space available.
 
 void gcs_out_of_space_to_send_count(mavlink_channel_t chan);
@@ -133,6 +144,7 @@ class GCS_MAVLINK
 {
 public:
     friend class GCS;
+    friend class GCS_MAVLINK_FTP_Bench;
 
     GCS_MAVLINK(GCS_MAVLINK_Parameters &parameters, AP_HAL::UARTDriver &uart);
     virtual ~GCS_MAVLINK() {}
@@ -706,19 +718,51 @@ private:
     // cache of which deferred message should be sent next:
     int8_t next_deferred_message_to_send_cache = -1;
 
+    // stream-rated messages are grouped into buckets of similar
+    // interval.  Buckets with messages in them are kept in a binary
+    // heap ordered by the time they are next due, so finding the next
+    // bucket to send does not need to look at every bucket.  Bucket
+    // send times are aligned to multiples of their interval so that
+    // channels streaming at the same rates send together, allowing
+    // GCS to share encoded payloads between them
     struct deferred_message_bucket_t {
         Bitmask<MSG_LAST> ap_message_ids;
         uint16_t interval_ms;
-        uint16_t last_sent_ms; // from AP_HAL::millis16()
+        uint32_t last_sent_ms; // from AP_HAL::millis()
+        uint32_t due_ms;       // last_sent_ms plus reschedule interval
+        uint8_t heap_index;    // index in deferred_bucket_heap
     };
-    deferred_message_bucket_t deferred_message_bucket[10];
+    static const uint8_t num_deferred_message_buckets = 10;
+    deferred_message_bucket_t deferred_message_bucket[num_deferred_message_buckets];
     static const uint8_t no_bucket_to_send = -1;
     static const ap_message no_message_to_send = (ap_message)-1;
     uint8_t sending_bucket_id = no_bucket_to_send;
     Bitmask<MSG_LAST> bucket_message_ids_to_send;
+    uint8_t bucket_message_ids_to_send_count;
 
-    ap_message next_deferred_bucket_message_to_send(uint16_t now16_ms);
-    void find_next_bucket_to_send(uint16_t now16_ms);
+    // ids of used buckets, ordered by due_ms
+    uint8_t deferred_bucket_heap[num_deferred_message_buckets];
+    uint8_t deferred_bucket_heap_count;
+    bool deferred_bucket_due_before(uint8_t a, uint8_t b) const {
+        return int32_t(deferred_message_bucket[a].due_ms - deferred_message_bucket[b].due_ms) < 0;
+    }
+    void deferred_bucket_heap_swap(uint8_t i, uint8_t j);
+    void deferred_bucket_heap_sift_up(uint8_t i);
+    void deferred_bucket_heap_sift_down(uint8_t i);
+    void deferred_bucket_heap_push(uint8_t bucket);
+    void deferred_bucket_heap_remove(uint8_t bucket);
+    // recalculate due time of a bucket after its interval or
+    // last-sent time has changed
+    void deferred_bucket_reschedule(uint8_t bucket);
+
+    // slowdown and multiplier applied to bucket intervals by
+    // get_reschedule_interval_ms, updated once per update_send
+    uint16_t reschedule_slowdown_ms;
+    uint8_t reschedule_multiplier = 1;
+    void update_reschedule_intervals();
+
+    ap_message next_deferred_bucket_message_to_send(uint32_t now_ms);
+    void find_next_bucket_to_send();
     void remove_message_from_bucket(int8_t bucket, ap_message id);
 
     // bitmask of IDs the code has spontaneously decided it wants to
@@ -865,9 +909,36 @@ private:
         Write,
     };
 
+    // a block of file data read ahead by the FTP thread for a burst read
+    struct ftp_burst_block {
+        uint8_t *data;
+        uint32_t offset;
+        int16_t length;     // -1 on read failure
+        bool filled;
+        bool last;          // end of file or read failure, nothing follows
+    };
+
+    // an in-progress burst read. The FTP thread reads the file ahead
+    // into blocks and the sending channel builds replies directly
+    // from them as transmit space allows
+    struct ftp_burst_state {
+        bool active;
+        mavlink_channel_t chan;
+        uint8_t sysid;
+        uint8_t compid;
+        uint8_t session;
+        uint8_t max_read;
+        uint16_t seq_number;
+        uint32_t offset;        // offset of the next reply to send
+        uint32_t end_offset;    // the reply reaching this offset completes the burst
+        ftp_burst_block blocks[2];
+        HAL_Semaphore sem;
+    };
+
     struct ftp_state {
         ObjectBuffer<pending_ftp> *requests;
         ObjectBuffer<pending_ftp> *replies;
+        ftp_burst_state burst;
 
         // session specific info, currently only support a single session over all links
         int fd = -1;
@@ -887,6 +958,10 @@ private:
     void send_ftp_replies(void);
     void ftp_worker(void);
     void ftp_push_replies(pending_ftp &reply);
+    static void ftp_burst_start(const pending_ftp &request, uint8_t max_read);
+    static void ftp_burst_stop(void);
+    static bool ftp_burst_fill(void);
+    void send_ftp_burst(void);
 
     void send_distance_sensor(const class AP_RangeFinder_Backend *sensor, const uint8_t instance) const;
 
@@ -1039,6 +1114,26 @@ public:
 
     void send_to_active_channels(uint32_t msgid, const char *pkt);
 
+#if HAL_MAVLINK_SHARED_PAYLOADS_ENABLED
+    // payloads of stream messages encoded during the current
+    // update_send, which may be sent as-is on other channels
+    static const uint8_t shared_payload_max_len = 64;
+    struct shared_payload_t {
+        const mavlink_msg_entry_t *entry;
+        ap_message id;
+        uint8_t payload[shared_payload_max_len];
+    };
+    // returns true if the payload of id does not depend on the
+    // channel it is sent on
+    bool payload_shareable(ap_message id) const;
+    const shared_payload_t *find_shared_payload(ap_message id) const;
+    // start capturing the payload of a message about to be sent on
+    // chan, returns false if there is no room to keep it
+    bool start_shared_payload(mavlink_channel_t chan);
+    // save the payload captured since start_shared_payload
+    void save_shared_payload(ap_message id);
+#endif
+
     void send_text(MAV_SEVERITY severity, const char *fmt, ...) FMT_PRINTF(3, 4);
     void send_textv(MAV_SEVERITY severity, const char *fmt, va_list arg_list);
     virtual void send_textv(MAV_SEVERITY severity, const char *fmt, va_list arg_list, uint8_t mask);
@@ -1187,6 +1282,12 @@ private:
     // timer called to implement pass-thru
     void passthru_timer();
 
+#if HAL_MAVLINK_SHARED_PAYLOADS_ENABLED
+    static const uint8_t max_shared_payloads = 16;
+    shared_payload_t _shared_payloads[max_shared_payloads];
+    uint8_t _shared_payload_count;
+#endif
+
     // this contains the index of the GCS_MAVLINK backend we will
     // first call update_send on.  It is incremented each time
     // GCS::update_send is called so we don't starve later links of
@@ -959,66 +959,144 @@ bool GCS_MAVLINK::should_send_message_in_delay_callback(const ap_message id) con
 
 uint16_t GCS_MAVLINK::get_reschedule_interval_ms(const deferred_message_bucket_t &deferred) const
 {
-    uint32_t interval_ms = deferred.interval_ms;
+    const uint32_t interval_ms = (deferred.interval_ms + reschedule_slowdown_ms) * uint32_t(reschedule_multiplier);
 
-    interval_ms += stream_slowdown_ms;
+    if (interval_ms > 60000) {
+        return 60000;
+    }
+
+    return interval_ms;
+}
+
+// work out how much bucket intervals should be stretched.  Buckets
+// are rescheduled if this changes
+void GCS_MAVLINK::update_reschedule_intervals()
+{
+    uint8_t multiplier = 1;
 
     // slow most messages down if we're transfering parameters or
     // waypoints:
     if (_queued_parameter) {
         // we are sending parameters, penalize streams:
-        interval_ms *= 4;
+        multiplier *= 4;
     }
     if (requesting_mission_items()) {
         // we are sending requests for waypoints, penalize streams:
-        interval_ms *= 4;
+        multiplier *= 4;
     }
     if (ftp.replies && AP_HAL::millis() - ftp.last_send_ms < 500) {
         // we are sending ftp replies
-        interval_ms *= 4;
+        multiplier *= 4;
     }
 
-    if (interval_ms > 60000) {
-        return 60000;
+    if (multiplier == reschedule_multiplier && stream_slowdown_ms == reschedule_slowdown_ms) {
+        return;
     }
+    reschedule_multiplier = multiplier;
+    reschedule_slowdown_ms = stream_slowdown_ms;
 
-    return interval_ms;
+    for (uint8_t i=0; i<deferred_bucket_heap_count; i++) {
+        deferred_message_bucket_t &bucket = deferred_message_bucket[deferred_bucket_heap[i]];
+        bucket.due_ms = bucket.last_sent_ms + get_reschedule_interval_ms(bucket);
+    }
+    // re-heapify
+    for (int8_t i=deferred_bucket_heap_count/2-1; i>=0; i--) {
+        deferred_bucket_heap_sift_down(i);
+    }
 }
 
-// typical runtime on fmuv3: 5 microseconds for 3 buckets
-void GCS_MAVLINK::find_next_bucket_to_send(uint16_t now16_ms)
+void GCS_MAVLINK::deferred_bucket_heap_swap(uint8_t i, uint8_t j)
 {
-#if GCS_DEBUG_SEND_MESSAGE_TIMINGS
-    void *data = hal.scheduler->disable_interrupts_save();
-    uint32_t start_us = AP_HAL::micros();
-#endif
+    const uint8_t tmp = deferred_bucket_heap[i];
+    deferred_bucket_heap[i] = deferred_bucket_heap[j];
+    deferred_bucket_heap[j] = tmp;
+    deferred_message_bucket[deferred_bucket_heap[i]].heap_index = i;
+    deferred_message_bucket[deferred_bucket_heap[j]].heap_index = j;
+}
 
-    // all done sending this bucket... find another bucket...
-    sending_bucket_id = no_bucket_to_send;
-    uint16_t ms_before_send_next_bucket_to_send = UINT16_MAX;
-    for (uint8_t i=0; i<ARRAY_SIZE(deferred_message_bucket); i++) {
-        if (deferred_message_bucket[i].ap_message_ids.count() == 0) {
-            // no entries
-            continue;
+void GCS_MAVLINK::deferred_bucket_heap_sift_up(uint8_t i)
+{
+    while (i > 0) {
+        const uint8_t parent = (i - 1) / 2;
+        if (!deferred_bucket_due_before(deferred_bucket_heap[i], deferred_bucket_heap[parent])) {
+            return;
         }
-        const uint16_t interval = get_reschedule_interval_ms(deferred_message_bucket[i]);
-        const uint16_t ms_since_last_sent = now16_ms - deferred_message_bucket[i].last_sent_ms;
-        uint16_t ms_before_send_this_bucket;
-        if (ms_since_last_sent > interval) {
-            // should already have sent this bucket!
-            ms_before_send_this_bucket = 0;
-        } else {
-            ms_before_send_this_bucket = interval - ms_since_last_sent;
+        deferred_bucket_heap_swap(i, parent);
+        i = parent;
+    }
+}
+
+void GCS_MAVLINK::deferred_bucket_heap_sift_down(uint8_t i)
+{
+    while (true) {
+        const uint8_t left = 2 * i + 1;
+        if (left >= deferred_bucket_heap_count) {
+            return;
         }
-        if (ms_before_send_this_bucket < ms_before_send_next_bucket_to_send) {
-            sending_bucket_id = i;
-            ms_before_send_next_bucket_to_send = ms_before_send_this_bucket;
+        uint8_t smallest = left;
+        const uint8_t right = left + 1;
+        if (right < deferred_bucket_heap_count &&
+            deferred_bucket_due_before(deferred_bucket_heap[right], deferred_bucket_heap[left])) {
+            smallest = right;
         }
+        if (!deferred_bucket_due_before(deferred_bucket_heap[smallest], deferred_bucket_heap[i])) {
+            return;
+        }
+        deferred_bucket_heap_swap(i, smallest);
+        i = smallest;
+    }
+}
+
+void GCS_MAVLINK::deferred_bucket_heap_push(uint8_t bucket)
+{
+    const uint8_t i = deferred_bucket_heap_count++;
+    deferred_bucket_heap[i] = bucket;
+    deferred_message_bucket[bucket].heap_index = i;
+    deferred_message_bucket[bucket].due_ms = deferred_message_bucket[bucket].last_sent_ms + get_reschedule_interval_ms(deferred_message_bucket[bucket]);
+    deferred_bucket_heap_sift_up(i);
+}
+
+void GCS_MAVLINK::deferred_bucket_heap_remove(uint8_t bucket)
+{
+    const uint8_t i = deferred_message_bucket[bucket].heap_index;
+    deferred_bucket_heap_count--;
+    if (i == deferred_bucket_heap_count) {
+        return;
     }
-    if (sending_bucket_id != no_bucket_to_send) {
+    // move the last item into the hole and restore heap order
+    const uint8_t moved = deferred_bucket_heap[deferred_bucket_heap_count];
+    deferred_bucket_heap_swap(i, deferred_bucket_heap_count);
+    deferred_bucket_heap_sift_up(i);
+    deferred_bucket_heap_sift_down(deferred_message_bucket[moved].heap_index);
+}
+
+void GCS_MAVLINK::deferred_bucket_reschedule(uint8_t bucket)
+{
+    const uint32_t old_due_ms = deferred_message_bucket[bucket].due_ms;
+    deferred_message_bucket[bucket].due_ms = deferred_message_bucket[bucket].last_sent_ms + get_reschedule_interval_ms(deferred_message_bucket[bucket]);
+    if (int32_t(deferred_message_bucket[bucket].due_ms - old_due_ms) < 0) {
+        deferred_bucket_heap_sift_up(deferred_message_bucket[bucket].heap_index);
+    } else {
+        deferred_bucket_heap_sift_down(deferred_message_bucket[bucket].heap_index);
+    }
+}
+
+void GCS_MAVLINK::find_next_bucket_to_send()
+{
+#if GCS_DEBUG_SEND_MESSAGE_TIMINGS
+    void *data = hal.scheduler->disable_interrupts_save();
+    uint32_t start_us = AP_HAL::micros();
+#endif
+
+    // all done sending this bucket... the next bucket is the one due first
+    if (deferred_bucket_heap_count > 0) {
+        sending_bucket_id = deferred_bucket_heap[0];
         bucket_message_ids_to_send = deferred_message_bucket[sending_bucket_id].ap_message_ids;
+        bucket_message_ids_to_send_count = bucket_message_ids_to_send.count();
     } else {
+        sending_bucket_id = no_bucket_to_send;
         bucket_message_ids_to_send.clearall();
+        bucket_message_ids_to_send_count = 0;
     }
 
 #if GCS_DEBUG_SEND_MESSAGE_TIMINGS
@@ -1030,15 +1108,14 @@ void GCS_MAVLINK::find_next_bucket_to_send(uint16_t now16_ms)
 #endif
 }
 
-ap_message GCS_MAVLINK::next_deferred_bucket_message_to_send(uint16_t now16_ms)
+ap_message GCS_MAVLINK::next_deferred_bucket_message_to_send(uint32_t now_ms)
 {
     if (sending_bucket_id == no_bucket_to_send) {
         // could happen if all streamrates are zero?
         return no_message_to_send;
     }
 
-    const uint16_t ms_since_last_sent = now16_ms - deferred_message_bucket[sending_bucket_id].last_sent_ms;
-    if (ms_since_last_sent < get_reschedule_interval_ms(deferred_message_bucket[sending_bucket_id])) {
+    if (int32_t(now_ms - deferred_message_bucket[sending_bucket_id].due_ms) < 0) {
         // not time to send this bucket
         return no_message_to_send;
     }
@@ -1049,7 +1126,7 @@ ap_message GCS_MAVLINK::next_deferred_bucket_message_to_send(uint16_t now16_ms)
 #if CONFIG_HAL_BOARD == HAL_BOARD_SITL
         AP_HAL::panic("next_deferred_bucket_message_to_send called on empty bucket");
 #endif
-        find_next_bucket_to_send(now16_ms);
+        find_next_bucket_to_send();
         return no_message_to_send;
     }
     return (ap_message)next;
@@ -1068,11 +1145,33 @@ bool GCS_MAVLINK::do_try_send_message(const ap_message id)
         return false;
     }
     WITH_SEMAPHORE(comm_chan_lock(chan));
+#if HAL_MAVLINK_SHARED_PAYLOADS_ENABLED
+    // another channel may already have encoded this message
+    bool capturing = false;
+    if (gcs().payload_shareable(id)) {
+        const GCS::shared_payload_t *shared = gcs().find_shared_payload(id);
+        if (shared != nullptr) {
+            if (txspace() < unsigned(packet_overhead() + shared->entry->max_msg_len)) {
+                gcs_out_of_space_to_send_count(chan);
+                return false;
+            }
+            send_message((const char *)shared->payload, shared->entry);
+            return true;
+        }
+        capturing = gcs().start_shared_payload(chan);
+    }
+#endif
 #if GCS_DEBUG_SEND_MESSAGE_TIMINGS
     void *data = hal.scheduler->disable_interrupts_save();
     uint32_t start_send_message_us = AP_HAL::micros();
 #endif
-    if (!try_send_message(id)) {
+    const bool sent = try_send_message(id);
+#if HAL_MAVLINK_SHARED_PAYLOADS_ENABLED
+    if (capturing) {
+        gcs().save_shared_payload(id);
+    }
+#endif
+    if (!sent) {
         // didn't fit in buffer...
 #if GCS_DEBUG_SEND_MESSAGE_TIMINGS
         try_send_message_stats.no_space_for_message++;
@@ -1164,6 +1263,8 @@ void GCS_MAVLINK::update_send()
     uint32_t retry_deferred_body_start = AP_HAL::micros();
 #endif
 
+    update_reschedule_intervals();
+
     const uint32_t start = AP_HAL::millis();
     const uint16_t start16 = start & 0xFFFF;
     while (AP_HAL::millis() - start < 5) { // spend a max of 5ms sending messages.  This should never trigger - out_of_time() should become true
@@ -1226,23 +1327,27 @@ void GCS_MAVLINK::update_send()
             continue;
         }
 
-        ap_message next = next_deferred_bucket_message_to_send(start16);
+        ap_message next = next_deferred_bucket_message_to_send(start);
         if (next != no_message_to_send) {
             if (!do_try_send_message(next)) {
                 break;
             }
             bucket_message_ids_to_send.clear(next);
-            if (bucket_message_ids_to_send.count() == 0) {
+            bucket_message_ids_to_send_count--;
+            if (bucket_message_ids_to_send_count == 0) {
                 // we sent everything in the bucket.  Reschedule it.
                 // we try to keep output on a regular clock to avoid
                 // user support questions:
-                const uint16_t interval_ms = get_reschedule_interval_ms(deferred_message_bucket[sending_bucket_id]);
-                deferred_message_bucket[sending_bucket_id].last_sent_ms += interval_ms;
-                // but we do not want to try to catch up too much:
-                if (uint16_t(start16 - deferred_message_bucket[sending_bucket_id].last_sent_ms) > interval_ms) {
-                    deferred_message_bucket[sending_bucket_id].last_sent_ms = start16;
+                deferred_message_bucket_t &bucket = deferred_message_bucket[sending_bucket_id];
+                const uint16_t interval_ms = get_reschedule_interval_ms(bucket);
+                bucket.last_sent_ms += interval_ms;
+                // but we do not want to try to catch up too much;
+                // restart on the same clock as other channels:
+                if (start - bucket.last_sent_ms > interval_ms) {
+                    bucket.last_sent_ms = start - (start % interval_ms);
                 }
-                find_next_bucket_to_send(start16);
+                deferred_bucket_reschedule(sending_bucket_id);
+                find_next_bucket_to_send();
             }
 #if GCS_DEBUG_SEND_MESSAGE_TIMINGS
                 const uint32_t stop = AP_HAL::micros();
@@ -1280,14 +1385,18 @@ void GCS_MAVLINK::remove_message_from_bucket(int8_t bucket, ap_message id)
     deferred_message_bucket[bucket].ap_message_ids.clear(id);
     if (deferred_message_bucket[bucket].ap_message_ids.count() == 0) {
         // bucket empty.  Free it:
+        deferred_bucket_heap_remove(bucket);
         deferred_message_bucket[bucket].interval_ms = 0;
         deferred_message_bucket[bucket].last_sent_ms = 0;
     }
 
     if (bucket == sending_bucket_id) {
-        bucket_message_ids_to_send.clear(id);
-        if (bucket_message_ids_to_send.count() == 0) {
-            find_next_bucket_to_send(AP_HAL::millis16());
+        if (bucket_message_ids_to_send.get(id)) {
+            bucket_message_ids_to_send.clear(id);
+            bucket_message_ids_to_send_count--;
+        }
+        if (bucket_message_ids_to_send_count == 0) {
+            find_next_bucket_to_send();
         } else {
 #if CONFIG_HAL_BOARD == HAL_BOARD_SITL
             if (deferred_message_bucket[bucket].interval_ms == 0 &&
@@ -1393,17 +1502,20 @@ bool GCS_MAVLINK::set_ap_message_interval(enum ap_message id, uint16_t interval_
 
     if (closest_bucket_interval_delta != 0 &&
         empty_bucket_id != -1) {
-        // allocate a bucket for this interval
+        // allocate a bucket for this interval.  Its clock is aligned
+        // to the interval so it is in step with the same interval on
+        // other channels
+        const uint32_t now_ms = AP_HAL::millis();
         deferred_message_bucket[empty_bucket_id].interval_ms = interval_ms;
-        deferred_message_bucket[empty_bucket_id].last_sent_ms = AP_HAL::millis16();
+        deferred_message_bucket[empty_bucket_id].last_sent_ms = now_ms - (now_ms % interval_ms);
+        deferred_bucket_heap_push(empty_bucket_id);
         closest_bucket = empty_bucket_id;
     }
 
     deferred_message_bucket[closest_bucket].ap_message_ids.set(id);
 
     if (sending_bucket_id == no_bucket_to_send) {
-        sending_bucket_id = closest_bucket;
-        bucket_message_ids_to_send = deferred_message_bucket[closest_bucket].ap_message_ids;
+        find_next_bucket_to_send();
     }
 
     return true;
@@ -2148,6 +2260,10 @@ void GCS::update_send()
         _missionitemprotocol_fence->update();
     }
 #endif // HAL_BUILD_AP_PERIPH
+#if HAL_MAVLINK_SHARED_PAYLOADS_ENABLED
+    // payloads are only shared within one update
+    _shared_payload_count = 0;
+#endif
     // round-robin the GCS_MAVLINK backend that gets to go first so
     // one backend doesn't monopolise all of the time allowed for sending
     // messages
@@ -2166,6 +2282,70 @@ void GCS::update_send()
     }
 }
 
+#if HAL_MAVLINK_SHARED_PAYLOADS_ENABLED
+bool GCS::payload_shareable(ap_message id) const
+{
+    if (num_gcs() < 2) {
+        return false;
+    }
+    // these messages are sent as a single mavlink message whose
+    // contents do not depend on the channel
+    switch (id) {
+    case MSG_ATTITUDE:
+    case MSG_ATTITUDE_QUATERNION:
+    case MSG_GLOBAL_POSITION_INT:
+    case MSG_LOCAL_POSITION:
+    case MSG_VFR_HUD:
+    case MSG_AHRS:
+    case MSG_RAW_IMU:
+    case MSG_SCALED_IMU2:
+    case MSG_SCALED_PRESSURE:
+    case MSG_GPS_RAW:
+    case MSG_RC_CHANNELS:
+    case MSG_SERVO_OUTPUT_RAW:
+    case MSG_SYSTEM_TIME:
+    case MSG_VIBRATION:
+        return true;
+    default:
+        return false;
+    }
+}
+
+const GCS::shared_payload_t *GCS::find_shared_payload(ap_message id) const
+{
+    for (uint8_t i=0; i<_shared_payload_count; i++) {
+        if (_shared_payloads[i].id == id) {
+            return &_shared_payloads[i];
+        }
+    }
+    return nullptr;
+}
+
+bool GCS::start_shared_payload(mavlink_channel_t chan_m)
+{
+    if (_shared_payload_count >= max_shared_payloads) {
+        return false;
+    }
+    comm_capture_start(chan_m);
+    return true;
+}
+
+void GCS::save_shared_payload(ap_message id)
+{
+    uint32_t msgid;
+    shared_payload_t &shared = _shared_payloads[_shared_payload_count];
+    if (!comm_capture_finish(msgid, shared.payload, sizeof(shared.payload))) {
+        return;
+    }
+    shared.entry = mavlink_get_msg_entry(msgid);
+    if (shared.entry == nullptr || shared.entry->max_msg_len > sizeof(shared.payload)) {
+        return;
+    }
+    shared.id = id;
+    _shared_payload_count++;
+}
+#endif  // HAL_MAVLINK_SHARED_PAYLOADS_ENABLED
+
 void GCS::update_receive(void)
 {
     for (uint8_t i=0; i<num_gcs(); i++) {
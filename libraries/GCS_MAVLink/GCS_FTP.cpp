@@ -29,6 +29,9 @@ struct GCS_MAVLINK::ftp_state GCS_MAVLINK::ftp;
 // timeout for session inactivity
 #define FTP_SESSION_TIMEOUT 3000
 
+// number of replies in a burst read
+#define FTP_BURST_LENGTH 100
+
 bool GCS_MAVLINK::ftp_init(void) {
 
     // check if ftp is disabled for memory savings
@@ -47,11 +50,20 @@ bool GCS_MAVLINK::ftp_init(void) {
     if (ftp.requests == nullptr) {
         goto failed;
     }
-    ftp.replies = new ObjectBuffer<pending_ftp>(30);
+    // burst reads don't go through the reply queue, so it only has
+    // to keep up with the request queue
+    ftp.replies = new ObjectBuffer<pending_ftp>(5);
     if (ftp.replies == nullptr) {
         goto failed;
     }
 
+    for (auto &block : ftp.burst.blocks) {
+        block.data = new uint8_t[FTP_BURST_BLOCK_SIZE];
+        if (block.data == nullptr) {
+            goto failed;
+        }
+    }
+
     if (!hal.scheduler->thread_create(FUNCTOR_BIND_MEMBER(&GCS_MAVLINK::ftp_worker, void),
                                       "FTP", 2560, AP_HAL::Scheduler::PRIORITY_IO, 0)) {
         goto failed;
@@ -64,6 +76,10 @@ failed:
     ftp.requests = nullptr;
     delete ftp.replies;
     ftp.replies = nullptr;
+    for (auto &block : ftp.burst.blocks) {
+        delete[] block.data;
+        block.data = nullptr;
+    }
     gcs().send_text(MAV_SEVERITY_WARNING, "failed to initialize MAVFTP");
 
     return false;
@@ -106,6 +122,10 @@ void GCS_MAVLINK::send_ftp_replies(void)
         send_banner();
     }
     
+    if (ftp.burst.active && ftp.burst.chan == chan) {
+        send_ftp_burst();
+    }
+
     if (ftp.replies == nullptr || ftp.replies->is_empty()) {
         return;
     }
@@ -142,6 +162,181 @@ void GCS_MAVLINK::send_ftp_replies(void)
     }
 }
 
+/*
+  send as much of a burst read as the channel has space for, building
+  each reply directly from the blocks read ahead by the FTP thread
+ */
+void GCS_MAVLINK::send_ftp_burst(void)
+{
+    WITH_SEMAPHORE(ftp.burst.sem);
+
+    ftp_burst_state &burst = ftp.burst;
+    const uint16_t packet_len = packet_overhead() + MAVLINK_MSG_ID_FILE_TRANSFER_PROTOCOL_LEN;
+
+    for (uint8_t i = 0; burst.active; i++) {
+        if (!HAVE_PAYLOAD_SPACE(chan, FILE_TRANSFER_PROTOCOL)) {
+            return;
+        }
+        if ((i > 0) && comm_get_txspace(chan) < 2 * packet_len) {
+            // if this isn't the first packet we have to leave deadspace for the next message
+            return;
+        }
+
+        // find the block holding the next reply
+        const ftp_burst_block *block = nullptr;
+        for (const auto &b : burst.blocks) {
+            const uint32_t block_end = b.offset + MAX(b.length, 0);
+            if (b.filled && burst.offset >= b.offset &&
+                (burst.offset < block_end || (b.last && burst.offset == block_end))) {
+                block = &b;
+                break;
+            }
+        }
+        if (block == nullptr) {
+            // the FTP thread hasn't read it yet
+            return;
+        }
+
+        uint8_t payload[251] = {};
+        put_le16_ptr(payload, burst.seq_number);
+        payload[2] = burst.session;
+        payload[5] = static_cast<uint8_t>(FTP_OP::BurstReadFile);
+        put_le32_ptr(&payload[8], burst.offset);
+
+        const uint32_t block_end = block->offset + MAX(block->length, 0);
+        if (burst.offset == block_end) {
+            // end of file or a read failure, either way the burst is over
+            payload[3] = static_cast<uint8_t>(FTP_OP::Nack);
+            payload[4] = 1;
+            payload[12] = static_cast<uint8_t>(block->length < 0 ? FTP_ERROR::Fail : FTP_ERROR::EndOfFile);
+            burst.active = false;
+        } else {
+            const uint8_t size = MIN(uint32_t(burst.max_read), block_end - burst.offset);
+            payload[3] = static_cast<uint8_t>(FTP_OP::Ack);
+            payload[4] = size;
+            memcpy(&payload[12], &block->data[burst.offset - block->offset], size);
+            burst.offset += size;
+            if (burst.offset >= burst.end_offset) {
+                payload[6] = 1;
+                burst.active = false;
+            }
+        }
+
+        mavlink_msg_file_transfer_protocol_send(
+            chan,
+            0, burst.sysid, burst.compid,
+            payload);
+        burst.seq_number++;
+        ftp.last_send_ms = AP_HAL::millis();
+    }
+}
+
+// start a burst read from the open file, replacing any burst in progress
+void GCS_MAVLINK::ftp_burst_start(const pending_ftp &request, uint8_t max_read)
+{
+    WITH_SEMAPHORE(ftp.burst.sem);
+
+    ftp_burst_state &burst = ftp.burst;
+    burst.chan = request.chan;
+    burst.sysid = request.sysid;
+    burst.compid = request.compid;
+    burst.session = request.session;
+    burst.max_read = max_read;
+    burst.seq_number = request.seq_number + 1;
+    burst.offset = request.offset;
+    burst.end_offset = request.offset + FTP_BURST_LENGTH * max_read;
+    for (auto &block : burst.blocks) {
+        block.filled = false;
+    }
+    burst.active = true;
+}
+
+// stop any burst read in progress, must be called before the file is closed
+void GCS_MAVLINK::ftp_burst_stop(void)
+{
+    WITH_SEMAPHORE(ftp.burst.sem);
+
+    ftp.burst.active = false;
+    for (auto &block : ftp.burst.blocks) {
+        block.filled = false;
+    }
+}
+
+/*
+  read the file ahead of the burst read being sent. This is called
+  from the FTP thread, which also starts and stops bursts, so only the
+  sender runs concurrently. Returns true if a block was read
+ */
+bool GCS_MAVLINK::ftp_burst_fill(void)
+{
+    ftp_burst_block *block = nullptr;
+    uint32_t offset;
+    uint16_t length;
+    {
+        WITH_SEMAPHORE(ftp.burst.sem);
+
+        ftp_burst_state &burst = ftp.burst;
+        if (!burst.active) {
+            return false;
+        }
+
+        // release blocks that have been sent
+        for (auto &b : burst.blocks) {
+            if (b.filled && !b.last && b.offset + b.length <= burst.offset) {
+                b.filled = false;
+            }
+        }
+
+        // find the end of the data already read ahead
+        offset = burst.offset;
+        for (uint8_t i = 0; i < ARRAY_SIZE(burst.blocks); i++) {
+            for (const auto &b : burst.blocks) {
+                if (b.filled && offset >= b.offset && offset < b.offset + MAX(b.length, 0)) {
+                    offset = b.offset + b.length;
+                    break;
+                }
+            }
+        }
+        for (const auto &b : burst.blocks) {
+            if (b.filled && b.last) {
+                // nothing more to read
+                return false;
+            }
+        }
+        if (offset >= burst.end_offset) {
+            return false;
+        }
+
+        for (auto &b : burst.blocks) {
+            if (!b.filled) {
+                block = &b;
+                break;
+            }
+        }
+        if (block == nullptr) {
+            // waiting for the sender to catch up
+            return false;
+        }
+
+        // read whole replies so they never straddle blocks
+        length = MIN(uint32_t(FTP_BURST_BLOCK_SIZE - FTP_BURST_BLOCK_SIZE % burst.max_read), burst.end_offset - offset);
+    }
+
+    // blocks which are not filled belong to this thread, so the read
+    // doesn't hold up the sender
+    ssize_t read_bytes = -1;
+    if (AP::FS().lseek(ftp.fd, offset, SEEK_SET) != -1) {
+        read_bytes = AP::FS().read(ftp.fd, block->data, length);
+    }
+
+    WITH_SEMAPHORE(ftp.burst.sem);
+    block->offset = offset;
+    block->length = read_bytes;
+    block->last = read_bytes < length;
+    block->filled = true;
+    return true;
+}
+
 void GCS_MAVLINK::ftp_error(struct pending_ftp &response, FTP_ERROR error) {
     response.opcode = FTP_OP::Nack;
     response.data[0] = static_cast<uint8_t>(error);
@@ -182,12 +377,17 @@ void GCS_MAVLINK::ftp_worker(void) {
         bool skip_push_reply = false;
 
         while (!ftp.requests->pop(request)) {
+            // keep reading ahead for any burst in progress
+            if (ftp_burst_fill()) {
+                continue;
+            }
             // nothing to handle, delay ourselves a bit then check again. Ideally we'd use conditional waits here
             hal.scheduler->delay(2);
         }
 
         // if it's a rerequest and we still have the last response then send it
-        if ((request.sysid == reply.sysid) && (request.compid = reply.compid) &&
+        if ((reply.opcode != FTP_OP::None) &&
+            (request.sysid == reply.sysid) && (request.compid = reply.compid) &&
             (request.session == reply.session) && (request.seq_number + 1 == reply.seq_number)) {
             ftp_push_replies(reply);
             continue;
@@ -228,6 +428,7 @@ void GCS_MAVLINK::ftp_worker(void) {
                 // if a new session appears and the old session has
                 // been idle for more than the timeout then force
                 // close the old session
+                ftp_burst_stop();
                 AP::FS().close(ftp.fd);
                 ftp.fd = -1;
                 ftp.current_session = -1;
@@ -241,6 +442,7 @@ void GCS_MAVLINK::ftp_worker(void) {
                 case FTP_OP::ResetSessions:
                     // we already handled this, just listed for completeness
                     if (ftp.fd != -1) {
+                        ftp_burst_stop();
                         AP::FS().close(ftp.fd);
                         ftp.fd = -1;
                     }
@@ -257,6 +459,7 @@ void GCS_MAVLINK::ftp_worker(void) {
                             // no activity for 3s, assume client has
                             // timed out receiving open reply, close
                             // the file
+                            ftp_burst_stop();
                             AP::FS().close(ftp.fd);
                             ftp.fd = -1;
                             ftp.current_session = -1;
@@ -486,7 +689,7 @@ void GCS_MAVLINK::ftp_worker(void) {
                     }
                 case FTP_OP::BurstReadFile:
                     {
-                        const uint16_t max_read = (request.size == 0?sizeof(reply.data):request.size);
+                        const uint8_t max_read = (request.size == 0?sizeof(reply.data):request.size);
                         // must actually be working on a file
                         if (ftp.fd == -1) {
                             ftp_error(reply, FTP_ERROR::FileNotFound);
@@ -499,52 +702,10 @@ void GCS_MAVLINK::ftp_worker(void) {
                             break;
                         }
 
-                        // seek to requested offset
-                        if (AP::FS().lseek(ftp.fd, request.offset, SEEK_SET) == -1) {
-                            ftp_error(reply, FTP_ERROR::FailErrno);
-                            break;
-                        }
-
-                        const uint32_t transfer_size = 100;
-                        for (uint32_t i = 0; (i < transfer_size); i++) {
-                            // fill the buffer
-                            const ssize_t read_bytes = AP::FS().read(ftp.fd, reply.data, MIN(sizeof(reply.data), max_read));
-                            if (read_bytes == -1) {
-                                ftp_error(reply, FTP_ERROR::FailErrno);
-                                break;
-                            }
-
-                            if (read_bytes != sizeof(reply.data)) {
-                                // don't send any old data
-                                memset(reply.data + read_bytes, 0, sizeof(reply.data) - read_bytes);
-                            }
-
-                            if (read_bytes == 0) {
-                                ftp_error(reply, FTP_ERROR::EndOfFile);
-                                break;
-                            }
-
-                            reply.opcode = FTP_OP::Ack;
-                            reply.offset = request.offset + i * max_read;
-                            reply.burst_complete = (i == (transfer_size - 1));
-                            reply.size = (uint8_t)read_bytes;
-
-                            ftp_push_replies(reply);
-
-                            if (read_bytes < max_read) {
-                                // ensure the NACK which we send next is at the right offset
-                                reply.offset += read_bytes;
-                            }
-
-                            // prep the reply to be used again
-                            reply.seq_number++;
-                        }
-
-                        if (reply.opcode != FTP_OP::Nack) {
-                            // prevent a duplicate packet send for
-                            // normal replies of burst reads
-                            skip_push_reply = true;
-                        }
+                        // the replies are sent by the requesting channel
+                        // as it has space, reading ahead as they go
+                        ftp_burst_start(request, max_read);
+                        skip_push_reply = true;
                         break;
                     }
                 case FTP_OP::TruncateFile:
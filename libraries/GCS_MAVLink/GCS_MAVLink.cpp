@@ -45,6 +45,18 @@ static bool chan_discard[MAVLINK_COMM_NUM_BUFFERS];
 
 mavlink_system_t mavlink_system = {7,1};
 
+// state of payload capture, see comm_capture_start()
+static struct {
+    mavlink_channel_t chan;
+    bool active;
+    bool ok;                // message framing seen so far is capturable
+    uint8_t messages;       // messages started on chan since capture started
+    uint8_t writes;         // writes for current message
+    uint32_t msgid;
+    uint8_t len;
+    uint8_t payload[MAVLINK_MAX_PAYLOAD_LEN];
+} capture;
+
 // routing table
 MAVLink_routing GCS_MAVLINK::routing;
 
@@ -91,6 +103,21 @@ uint16_t comm_get_txspace(mavlink_channel_t chan)
  */
 void comm_send_buffer(mavlink_channel_t chan, const uint8_t *buf, uint8_t len)
 {
+    if (capture.active && capture.chan == chan) {
+        // the mavlink helpers write the header, then the payload,
+        // then the checksum and signature
+        if (capture.writes == 0) {
+            if (len == MAVLINK_NUM_HEADER_BYTES && buf[0] == MAVLINK_STX) {
+                capture.msgid = buf[7] | (buf[8]<<8) | (uint32_t(buf[9])<<16);
+            } else {
+                capture.ok = false;
+            }
+        } else if (capture.writes == 1) {
+            memcpy(capture.payload, buf, len);
+            capture.len = len;
+        }
+        capture.writes++;
+    }
     if (!valid_channel(chan) || mavlink_comm_port[chan] == nullptr || chan_discard[chan]) {
         return;
     }
@@ -125,6 +152,10 @@ void comm_send_lock(mavlink_channel_t chan_m, uint16_t size)
 {
     const uint8_t chan = uint8_t(chan_m);
     chan_locks[chan].take_blocking();
+    if (capture.active && capture.chan == chan_m) {
+        capture.messages++;
+        capture.writes = 0;
+    }
     if (mavlink_comm_port[chan]->txspace() < size) {
         chan_discard[chan] = true;
         gcs_out_of_space_to_send_count(chan_m);
@@ -141,6 +172,34 @@ void comm_send_unlock(mavlink_channel_t chan_m)
     chan_locks[chan].give();
 }
 
+/*
+  start capturing the payload of messages sent on a channel
+ */
+void comm_capture_start(mavlink_channel_t chan)
+{
+    capture.chan = chan;
+    capture.active = true;
+    capture.ok = true;
+    capture.messages = 0;
+    capture.writes = 0;
+}
+
+/*
+  stop capturing, returning the payload of the single message sent
+  since comm_capture_start()
+ */
+bool comm_capture_finish(uint32_t &msgid, uint8_t *payload, uint8_t payload_len)
+{
+    capture.active = false;
+    if (!capture.ok || capture.messages != 1 || capture.writes < 3 || capture.len > payload_len) {
+        return false;
+    }
+    msgid = capture.msgid;
+    memcpy(payload, capture.payload, capture.len);
+    memset(&payload[capture.len], 0, payload_len - capture.len);
+    return true;
+}
+
 /*
   return reference to GCS channel lock, allowing for
   HAVE_PAYLOAD_SPACE() to be run with a locked channel
@@ -74,4 +74,13 @@ void comm_send_lock(mavlink_channel_t chan, uint16_t size);
 void comm_send_unlock(mavlink_channel_t chan);
 HAL_Semaphore &comm_chan_lock(mavlink_channel_t chan);
 
+// capture the payload of the next message sent on a channel, so it
+// can be sent on other channels without being packed again.  Only
+// MAVLink2 framed messages are captured as MAVLink1 drops extension
+// fields.  comm_capture_finish returns true if exactly one message
+// was sent since comm_capture_start and its payload fitted in
+// payload_len bytes; the payload is zero-filled to payload_len
+void comm_capture_start(mavlink_channel_t chan);
+bool comm_capture_finish(uint32_t &msgid, uint8_t *payload, uint8_t payload_len);
+
 #pragma GCC diagnostic pop
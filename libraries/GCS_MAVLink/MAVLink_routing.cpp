@@ -27,7 +27,7 @@ extern const AP_HAL::HAL& hal;
 #define ROUTING_DEBUG 0
 
 // constructor
-MAVLink_routing::MAVLink_routing(void) : num_routes(0) {}
+MAVLink_routing::MAVLink_routing(void) : num_routes(0), route_channels(0) {}
 
 /*
   forward a MAVLink message to the right port. This also
@@ -139,41 +139,42 @@ bool MAVLink_routing::check_and_forward(mavlink_channel_t in_channel, const mavl
         return true;
     }
 
+    // find channels matching the targets
+    uint8_t mask;
+    if (broadcast_system) {
+        mask = route_channels & ~GCS_MAVLINK::private_channel_mask();
+    } else if (broadcast_component || !match_system) {
+        // any component of the target system.  Private channels only
+        // get messages for a sysid/compid seen on them
+        mask = sysid_channels[target_system];
+        const uint8_t private_mask = mask & GCS_MAVLINK::private_channel_mask();
+        mask &= ~private_mask;
+        if (private_mask != 0 && target_component != -1) {
+            mask |= private_mask & channels_for(target_system, target_component);
+        }
+    } else {
+        mask = channels_for(target_system, target_component);
+    }
+    mask &= ~(1U<<(in_channel-MAVLINK_COMM_0));
+
     // forward on any channels matching the targets
-    bool forwarded = false;
-    bool sent_to_chan[MAVLINK_COMM_NUM_BUFFERS];
-    memset(sent_to_chan, 0, sizeof(sent_to_chan));
-    for (uint8_t i=0; i<num_routes; i++) {
-
-        // Skip if channel is private and the target system or component IDs do not match
-        if ((GCS_MAVLINK::is_private(routes[i].channel)) &&
-            (target_system != routes[i].sysid ||
-             target_component != routes[i].compid)) {
+    const bool forwarded = (mask != 0);
+    for (uint8_t i=0; mask != 0; i++, mask >>= 1) {
+        if ((mask & 1U) == 0) {
             continue;
         }
-
-        if (broadcast_system || (target_system == routes[i].sysid &&
-                                 (broadcast_component || 
-                                  target_component == routes[i].compid ||
-                                  !match_system))) {
-
-            if (in_channel != routes[i].channel && !sent_to_chan[routes[i].channel]) {
-                
-                if (comm_get_txspace(routes[i].channel) >= ((uint16_t)msg.len) +
-                    GCS_MAVLINK::packet_overhead_chan(routes[i].channel)) {
+        const mavlink_channel_t channel = (mavlink_channel_t)(MAVLINK_COMM_0 + i);
+        if (comm_get_txspace(channel) >= ((uint16_t)msg.len) +
+            GCS_MAVLINK::packet_overhead_chan(channel)) {
 #if ROUTING_DEBUG
-                    ::printf("fwd msg %u from chan %u on chan %u sysid=%d compid=%d\n",
-                             msg.msgid,
-                             (unsigned)in_channel,
-                             (unsigned)routes[i].channel,
-                             (int)target_system,
-                             (int)target_component);
+            ::printf("fwd msg %u from chan %u on chan %u sysid=%d compid=%d\n",
+                     msg.msgid,
+                     (unsigned)in_channel,
+                     (unsigned)channel,
+                     (int)target_system,
+                     (int)target_component);
 #endif
-                    _mavlink_resend_uart(routes[i].channel, &msg);
-                }
-                sent_to_chan[routes[i].channel] = true;
-                forwarded = true;
-            }
+            _mavlink_resend_uart(channel, &msg);
         }
     }
 
@@ -201,29 +202,23 @@ void MAVLink_routing::send_to_components(uint32_t msgid, const char *pkt, uint8_
 
 void MAVLink_routing::send_to_components(const char *pkt, const mavlink_msg_entry_t *entry, const uint8_t pkt_len)
 {
-    bool sent_to_chan[MAVLINK_COMM_NUM_BUFFERS] {};
+    // channels our system ID has been seen on
+    uint8_t mask = sysid_channels[mavlink_system.sysid];
 
-    // check learned routes
-    for (uint8_t i=0; i<num_routes; i++) {
-        if (routes[i].sysid != mavlink_system.sysid) {
-            // our system ID hasn't been seen on this link
+    for (uint8_t i=0; mask != 0; i++, mask >>= 1) {
+        if ((mask & 1U) == 0) {
             continue;
         }
-        if (sent_to_chan[routes[i].channel]) {
-            // we've already send it on this link
-            continue;
-        }
-        if (comm_get_txspace(routes[i].channel) <
-            ((uint16_t)entry->max_msg_len) + GCS_MAVLINK::packet_overhead_chan(routes[i].channel)) {
+        const mavlink_channel_t channel = (mavlink_channel_t)(MAVLINK_COMM_0 + i);
+        if (comm_get_txspace(channel) <
+            ((uint16_t)entry->max_msg_len) + GCS_MAVLINK::packet_overhead_chan(channel)) {
             // it doesn't fit on this channel
             continue;
         }
 #if ROUTING_DEBUG
-        ::printf("send msg %u on chan %u sysid=%u compid=%u\n",
+        ::printf("send msg %u on chan %u\n",
                  entry->msgid,
-                 (unsigned)routes[i].channel,
-                 (unsigned)routes[i].sysid,
-                 (unsigned)routes[i].compid);
+                 (unsigned)channel);
 #endif
 #if CONFIG_HAL_BOARD == HAL_BOARD_SITL
         if (entry->max_msg_len > pkt_len) {
@@ -231,13 +226,12 @@ void MAVLink_routing::send_to_components(const char *pkt, const mavlink_msg_entr
                           entry->max_msg_len, pkt_len);
         }
 #endif
-        _mav_finalize_message_chan_send(routes[i].channel,
+        _mav_finalize_message_chan_send(channel,
                                         entry->msgid,
                                         pkt,
                                         entry->min_msg_len,
                                         MIN(entry->max_msg_len, pkt_len),
                                         entry->crc_extra);
-        sent_to_chan[routes[i].channel] = true;
     }
 }
 
@@ -248,8 +242,8 @@ void MAVLink_routing::send_to_components(const char *pkt, const mavlink_msg_entr
 bool MAVLink_routing::find_by_mavtype(uint8_t mavtype, uint8_t &sysid, uint8_t &compid, mavlink_channel_t &channel)
 {
     // check learned routes
-    for (uint8_t i=0; i<num_routes; i++) {
-        if (routes[i].mavtype == mavtype) {
+    for (uint16_t i=0; i<ROUTE_TABLE_SIZE; i++) {
+        if (routes[i].sysid != 0 && routes[i].mavtype == mavtype) {
             sysid = routes[i].sysid;
             compid = routes[i].compid;
             channel = routes[i].channel;
@@ -261,12 +255,135 @@ bool MAVLink_routing::find_by_mavtype(uint8_t mavtype, uint8_t &sysid, uint8_t &
     return false;
 }
 
+/*
+  return packet and byte counts for the n'th route in the table
+ */
+bool MAVLink_routing::get_route_stats(uint16_t n, route_stats &stats) const
+{
+    for (uint16_t i=0; i<ROUTE_TABLE_SIZE; i++) {
+        if (routes[i].sysid == 0) {
+            continue;
+        }
+        if (n-- == 0) {
+            stats.sysid = routes[i].sysid;
+            stats.compid = routes[i].compid;
+            stats.channel = routes[i].channel;
+            stats.last_seen_ms = routes[i].last_seen_ms;
+            stats.packets = routes[i].packets;
+            stats.bytes = routes[i].bytes;
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+  return slot holding the route for sysid/compid on channel, or the
+  empty slot ending its probe sequence if there is no such route
+*/
+uint16_t MAVLink_routing::find_slot(uint8_t sysid, uint8_t compid, mavlink_channel_t channel) const
+{
+    uint16_t slot = route_hash(sysid, compid);
+    while (routes[slot].sysid != 0) {
+        if (routes[slot].sysid == sysid &&
+            routes[slot].compid == compid &&
+            routes[slot].channel == channel) {
+            break;
+        }
+        slot = (slot + 1) & (ROUTE_TABLE_SIZE-1);
+    }
+    return slot;
+}
+
+/*
+  return mask of channels a sysid/compid has been seen on
+*/
+uint8_t MAVLink_routing::channels_for(uint8_t sysid, uint8_t compid) const
+{
+    if (sysid_channels[sysid] == 0) {
+        return 0;
+    }
+    uint8_t mask = 0;
+    for (uint16_t slot = route_hash(sysid, compid);
+         routes[slot].sysid != 0;
+         slot = (slot + 1) & (ROUTE_TABLE_SIZE-1)) {
+        if (routes[slot].sysid == sysid && routes[slot].compid == compid) {
+            mask |= 1U<<(routes[slot].channel-MAVLINK_COMM_0);
+        }
+    }
+    return mask;
+}
+
+/*
+  remove a route, moving later routes in the same probe sequence back
+  so they can still be found
+*/
+void MAVLink_routing::remove_route(uint16_t slot)
+{
+    const uint8_t sysid = routes[slot].sysid;
+    uint16_t hole = slot;
+    uint16_t next = (slot + 1) & (ROUTE_TABLE_SIZE-1);
+    while (routes[next].sysid != 0) {
+        const uint16_t home = route_hash(routes[next].sysid, routes[next].compid);
+        // the route in next can fill the hole if its home slot is not
+        // cyclically within (hole, next]
+        if (((next - home) & (ROUTE_TABLE_SIZE-1)) >= ((next - hole) & (ROUTE_TABLE_SIZE-1))) {
+            routes[hole] = routes[next];
+            hole = next;
+        }
+        next = (next + 1) & (ROUTE_TABLE_SIZE-1);
+    }
+    routes[hole] = {};
+    num_routes--;
+
+    // recalculate channel masks
+    sysid_channels[sysid] = 0;
+    route_channels = 0;
+    for (uint16_t i=0; i<ROUTE_TABLE_SIZE; i++) {
+        if (routes[i].sysid != 0) {
+            const uint8_t chan_bit = 1U<<(routes[i].channel-MAVLINK_COMM_0);
+            route_channels |= chan_bit;
+            if (routes[i].sysid == sysid) {
+                sysid_channels[sysid] |= chan_bit;
+            }
+        }
+    }
+}
+
+/*
+  remove the least recently seen route if it has expired
+*/
+bool MAVLink_routing::expire_oldest_route(uint32_t now_ms)
+{
+    uint16_t oldest = ROUTE_TABLE_SIZE;
+    for (uint16_t i=0; i<ROUTE_TABLE_SIZE; i++) {
+        if (routes[i].sysid == 0) {
+            continue;
+        }
+        if (oldest == ROUTE_TABLE_SIZE ||
+            now_ms - routes[i].last_seen_ms > now_ms - routes[oldest].last_seen_ms) {
+            oldest = i;
+        }
+    }
+    if (oldest == ROUTE_TABLE_SIZE ||
+        now_ms - routes[oldest].last_seen_ms < MAVLINK_ROUTE_EXPIRE_MS) {
+        return false;
+    }
+#if ROUTING_DEBUG
+    ::printf("expired route %u %u via %u\n",
+             (unsigned)routes[oldest].sysid,
+             (unsigned)routes[oldest].compid,
+             (unsigned)routes[oldest].channel);
+#endif
+    remove_route(oldest);
+    return true;
+}
+
 /*
   see if the message is for a new route and learn it
 */
 void MAVLink_routing::learn_route(mavlink_channel_t in_channel, const mavlink_message_t &msg)
 {
-    uint8_t i;
     if (msg.sysid == 0) {
         // don't learn routes to the broadcast system
         return;
@@ -283,24 +400,24 @@ void MAVLink_routing::learn_route(mavlink_channel_t in_channel, const mavlink_me
         // should also process them locally.
         return;
     }
-    for (i=0; i<num_routes; i++) {
-        if (routes[i].sysid == msg.sysid &&
-            routes[i].compid == msg.compid &&
-            routes[i].channel == in_channel) {
-            if (routes[i].mavtype == 0 && msg.msgid == MAVLINK_MSG_ID_HEARTBEAT) {
-                routes[i].mavtype = mavlink_msg_heartbeat_get_type(&msg);
+    const uint32_t now_ms = AP_HAL::millis();
+    uint16_t slot = find_slot(msg.sysid, msg.compid, in_channel);
+    if (routes[slot].sysid == 0) {
+        // new route
+        if (num_routes >= MAVLINK_MAX_ROUTES) {
+            if (!expire_oldest_route(now_ms)) {
+                return;
             }
-            break;
-        }
-    }
-    if (i == num_routes && i<MAVLINK_MAX_ROUTES) {
-        routes[i].sysid = msg.sysid;
-        routes[i].compid = msg.compid;
-        routes[i].channel = in_channel;
-        if (msg.msgid == MAVLINK_MSG_ID_HEARTBEAT) {
-            routes[i].mavtype = mavlink_msg_heartbeat_get_type(&msg);
+            // removal may have moved routes around
+            slot = find_slot(msg.sysid, msg.compid, in_channel);
         }
+        routes[slot].sysid = msg.sysid;
+        routes[slot].compid = msg.compid;
+        routes[slot].channel = in_channel;
         num_routes++;
+        const uint8_t chan_bit = 1U<<(in_channel-MAVLINK_COMM_0);
+        sysid_channels[msg.sysid] |= chan_bit;
+        route_channels |= chan_bit;
 #if ROUTING_DEBUG
         ::printf("learned route %u %u via %u\n",
                  (unsigned)msg.sysid,
@@ -308,6 +425,13 @@ void MAVLink_routing::learn_route(mavlink_channel_t in_channel, const mavlink_me
                  (unsigned)in_channel);
 #endif
     }
+    route &r = routes[slot];
+    if (r.mavtype == 0 && msg.msgid == MAVLINK_MSG_ID_HEARTBEAT) {
+        r.mavtype = mavlink_msg_heartbeat_get_type(&msg);
+    }
+    r.last_seen_ms = now_ms;
+    r.packets++;
+    r.bytes += mavlink_msg_get_send_buffer_length(&msg);
 }
 
 
@@ -328,11 +452,7 @@ void MAVLink_routing::handle_heartbeat(mavlink_channel_t in_channel, const mavli
     mask &= ~no_route_mask;
     
     // mask out channels that are known sources for this sysid/compid
-    for (uint8_t i=0; i<num_routes; i++) {
-        if (routes[i].sysid == msg.sysid && routes[i].compid == msg.compid) {
-            mask &= ~(1U<<((unsigned)(routes[i].channel-MAVLINK_COMM_0)));
-        }
-    }
+    mask &= ~channels_for(msg.sysid, msg.compid);
 
     if (mask == 0) {
         // nothing to send to
@@ -5,9 +5,28 @@
 #include <AP_Common/AP_Common.h>
 #include "GCS_MAVLink.h"
 
-// 20 routes should be enough for now. This may need to increase as
-// we make more extensive use of MAVLink forwarding
+// maximum number of routes learned.  Boards with more memory may be
+// on companion networks with many vehicles and components
+#ifndef MAVLINK_MAX_ROUTES
+#if HAL_MEM_CLASS >= HAL_MEM_CLASS_500
+#define MAVLINK_MAX_ROUTES 128
+#else
 #define MAVLINK_MAX_ROUTES 20
+#endif
+#endif
+
+// when the routing table is full, a route which has not been seen for
+// this long may be replaced by a new one
+#ifndef MAVLINK_ROUTE_EXPIRE_MS
+#define MAVLINK_ROUTE_EXPIRE_MS 30000
+#endif
+
+// size of the routing hash table; a power of two keeping the table
+// at most two thirds full
+static constexpr uint16_t mavlink_route_table_size(uint16_t max_routes, uint16_t size=8)
+{
+    return size >= max_routes + max_routes/2 ? size : mavlink_route_table_size(max_routes, size*2);
+}
 
 /*
   object to handle MAVLink packet routing
@@ -43,17 +62,62 @@ public:
      */
     bool find_by_mavtype(uint8_t mavtype, uint8_t &sysid, uint8_t &compid, mavlink_channel_t &channel);
 
+    /*
+      packet and byte counts for traffic received from the n'th route
+      in the table.  Returns false if there is no such route
+     */
+    struct route_stats {
+        uint8_t sysid;
+        uint8_t compid;
+        mavlink_channel_t channel;
+        uint32_t last_seen_ms;
+        uint32_t packets;
+        uint32_t bytes;
+    };
+    bool get_route_stats(uint16_t n, route_stats &stats) const;
+
+    // number of routes learned
+    uint16_t get_num_routes() const { return num_routes; }
+
 private:
-    // a simple linear routing table. We don't expect to have a lot of
-    // routes, so a scalable structure isn't worthwhile yet.
-    uint8_t num_routes;
+    // routes are held in an open addressing hash table keyed on
+    // sysid and compid, with linear probing.  The same sysid/compid
+    // may be seen on several channels, each of which is a separate
+    // route in the same probe sequence
+    static const uint16_t ROUTE_TABLE_SIZE = mavlink_route_table_size(MAVLINK_MAX_ROUTES);
+    uint16_t num_routes;
     struct route {
-        uint8_t sysid;
+        uint8_t sysid;          // zero if slot is empty
         uint8_t compid;
         mavlink_channel_t channel;
         uint8_t mavtype;
-    } routes[MAVLINK_MAX_ROUTES];
-    
+        uint32_t last_seen_ms;
+        uint32_t packets;
+        uint32_t bytes;
+    } routes[ROUTE_TABLE_SIZE] {};
+
+    // mask of channels each sysid has been seen on, and of channels
+    // any route has been seen on
+    uint8_t sysid_channels[256] {};
+    uint8_t route_channels;
+
+    static uint16_t route_hash(uint8_t sysid, uint8_t compid) {
+        return ((((uint32_t)sysid << 8) | compid) * 2654435761U >> 16) & (ROUTE_TABLE_SIZE-1);
+    }
+
+    // return slot of route for sysid/compid on channel, or slot
+    // where it should be added if it is not present
+    uint16_t find_slot(uint8_t sysid, uint8_t compid, mavlink_channel_t channel) const;
+
+    // mask of channels sysid/compid has been seen on
+    uint8_t channels_for(uint8_t sysid, uint8_t compid) const;
+
+    // remove the least recently seen route if it has not been seen
+    // for MAVLINK_ROUTE_EXPIRE_MS, returns false if none was removed
+    bool expire_oldest_route(uint32_t now_ms);
+    // remove the route in slot, keeping probe sequences intact
+    void remove_route(uint16_t slot);
+
     // a channel mask to block routing as required
     uint8_t no_route_mask;
     
@@ -0,0 +1,226 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_HAL/utility/sparse-endian.h>
+#include <AP_Filesystem/AP_Filesystem.h>
+#include <GCS_MAVLink/GCS.h>
+#include <GCS_MAVLink/GCS_Dummy.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+const struct AP_Param::GroupInfo        GCS_MAVLINK_Parameters::var_info[] = {
+    AP_GROUPEND
+};
+
+/*
+  a dummy GCS with the benchmark link as its only channel, so the
+  transmit space checks of the FTP code find it
+ */
+class GCS_FTPBench : public GCS_Dummy
+{
+public:
+    using GCS_Dummy::GCS_Dummy;
+
+    void set_link(GCS_MAVLINK *link) {
+        _chan[0] = link;
+        _num_gcs = link != nullptr ? 1 : 0;
+    }
+};
+GCS_FTPBench _gcs;
+
+/*
+  burst read a log file through the FTP burst read path: the read
+  ahead done by the FTP thread in ftp_burst_fill() and the replies
+  built by send_ftp_burst() on a channel with a limited amount of
+  transmit space each loop. The replies are parsed on the far side
+  of the link into a copy of the file, and the next burst is
+  requested when each one completes, as a GCS does
+ */
+static const char *bench_file = "ftp_bench.bin";
+static const uint32_t file_size = 256*1024;
+static const mavlink_channel_t link_chan = MAVLINK_COMM_0;
+static const mavlink_channel_t rx_chan = MAVLINK_COMM_1;
+
+/*
+  a UART taking a limited number of bytes each loop, passing what it
+  is given to the receiving end of the link
+ */
+class FTPBenchUART : public AP_HAL::UARTDriver {
+public:
+    void begin(uint32_t baud) override {}
+    void begin(uint32_t baud, uint16_t rxSpace, uint16_t txSpace) override {}
+    void end() override {}
+    void flush() override {}
+    bool is_initialized() override { return true; }
+    void set_blocking_writes(bool blocking) override {}
+    bool tx_pending() override { return false; }
+    uint32_t available() override { return 0; }
+    uint32_t txspace() override { return space; }
+    int16_t read() override { return -1; }
+    bool discard_input() override { return true; }
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t *buffer, size_t size) override;
+
+    // bytes the link can take until the next loop
+    uint32_t space;
+
+    // receiving end of the link
+    uint8_t *dest;
+    uint32_t next_offset;
+    uint16_t last_seq;
+    bool end_of_file;
+    bool failed;
+};
+
+size_t FTPBenchUART::write(const uint8_t *buffer, size_t size)
+{
+    size = MIN(size, space);
+    space -= size;
+    mavlink_message_t msg;
+    mavlink_status_t status;
+    for (size_t i = 0; i < size; i++) {
+        if (!mavlink_parse_char(rx_chan, buffer[i], &msg, &status) ||
+            msg.msgid != MAVLINK_MSG_ID_FILE_TRANSFER_PROTOCOL) {
+            continue;
+        }
+        mavlink_file_transfer_protocol_t packet;
+        mavlink_msg_file_transfer_protocol_decode(&msg, &packet);
+        const uint32_t offset = le32toh_ptr(&packet.payload[8]);
+        const uint8_t data_size = packet.payload[4];
+        last_seq = le16toh_ptr(packet.payload);
+        if (packet.payload[3] != 128) { // not an Ack
+            // a Nack ends the read, it should be for the end of the file
+            end_of_file = true;
+            failed |= packet.payload[12] != 6; // EndOfFile
+        } else if (offset != next_offset || offset + data_size > file_size) {
+            end_of_file = true;
+            failed = true;
+        } else {
+            memcpy(&dest[offset], &packet.payload[12], data_size);
+            next_offset += data_size;
+        }
+    }
+    return size;
+}
+
+/*
+  runs the FTP burst read of GCS_MAVLINK on the benchmark link
+ */
+class GCS_MAVLINK_FTP_Bench {
+public:
+    GCS_MAVLINK_FTP_Bench();
+    ~GCS_MAVLINK_FTP_Bench();
+
+    // read the whole file, returning false if the copy is not identical
+    bool read_file(uint32_t link_bytes_per_loop);
+
+    // true if the file and buffers were set up
+    bool ok() const { return fd != -1 && buffers_ok; }
+
+private:
+    GCS_MAVLINK_Parameters params;
+    FTPBenchUART uart;
+    GCS_MAVLINK_Dummy link{params, uart};
+    uint8_t *expected;
+    int fd = -1;
+    bool buffers_ok;
+};
+
+GCS_MAVLINK_FTP_Bench::GCS_MAVLINK_FTP_Bench()
+{
+    link.chan = link_chan;
+    mavlink_comm_port[link_chan] = &uart;
+    _gcs.set_link(&link);
+
+    expected = new uint8_t[file_size];
+    uart.dest = new uint8_t[file_size];
+    buffers_ok = expected != nullptr && uart.dest != nullptr;
+    for (auto &block : GCS_MAVLINK::ftp.burst.blocks) {
+        block.data = new uint8_t[FTP_BURST_BLOCK_SIZE];
+        buffers_ok &= block.data != nullptr;
+    }
+    if (!buffers_ok) {
+        return;
+    }
+
+    fd = AP::FS().open(bench_file, O_WRONLY|O_CREAT|O_TRUNC);
+    if (fd == -1) {
+        return;
+    }
+    for (uint32_t i = 0; i < file_size; i++) {
+        expected[i] = i * 7;
+    }
+    const bool written = AP::FS().write(fd, expected, file_size) == ssize_t(file_size);
+    AP::FS().close(fd);
+    fd = written ? AP::FS().open(bench_file, O_RDONLY) : -1;
+    GCS_MAVLINK::ftp.fd = fd;
+}
+
+GCS_MAVLINK_FTP_Bench::~GCS_MAVLINK_FTP_Bench()
+{
+    GCS_MAVLINK::ftp_burst_stop();
+    if (fd != -1) {
+        AP::FS().close(fd);
+    }
+    GCS_MAVLINK::ftp.fd = -1;
+    for (auto &block : GCS_MAVLINK::ftp.burst.blocks) {
+        delete[] block.data;
+        block.data = nullptr;
+    }
+    delete[] uart.dest;
+    delete[] expected;
+    mavlink_comm_port[link_chan] = nullptr;
+    _gcs.set_link(nullptr);
+}
+
+bool GCS_MAVLINK_FTP_Bench::read_file(uint32_t link_bytes_per_loop)
+{
+    uart.next_offset = 0;
+    uart.last_seq = 0;
+    uart.end_of_file = false;
+    uart.failed = false;
+
+    GCS_MAVLINK::pending_ftp request {};
+    request.chan = link_chan;
+    request.opcode = GCS_MAVLINK::FTP_OP::BurstReadFile;
+    request.sysid = 255;
+    request.compid = 190;
+
+    while (!uart.end_of_file) {
+        if (!GCS_MAVLINK::ftp.burst.active) {
+            // the last burst is complete, ask for the next one
+            request.seq_number = uart.last_seq + 1;
+            request.offset = uart.next_offset;
+            GCS_MAVLINK::ftp_burst_start(request, sizeof(request.data));
+        }
+        // the FTP thread reads ahead while the main loop runs
+        while (GCS_MAVLINK::ftp_burst_fill()) {
+        }
+        uart.space = link_bytes_per_loop;
+        link.send_ftp_burst();
+    }
+
+    return !uart.failed && uart.next_offset == file_size &&
+           memcmp(uart.dest, expected, file_size) == 0;
+}
+
+static void BM_FTPBurstRead(benchmark::State& state)
+{
+    GCS_MAVLINK_FTP_Bench bench;
+    if (!bench.ok()) {
+        state.SkipWithError("failed to create file");
+        return;
+    }
+    while (state.KeepRunning()) {
+        if (!bench.read_file(state.range(0))) {
+            state.SkipWithError("file read back incorrectly");
+            return;
+        }
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * file_size);
+}
+
+// bytes the link can take each loop
+BENCHMARK(BM_FTPBurstRead)->Arg(512)->Arg(2048)->Arg(8192);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,94 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_HAL/AP_HAL.h>
+#include <GCS_MAVLink/GCS.h>
+#include <GCS_MAVLink/GCS_Dummy.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+const struct AP_Param::GroupInfo        GCS_MAVLINK_Parameters::var_info[] = {
+    AP_GROUPEND
+};
+GCS_Dummy _gcs;
+
+/*
+  replay one second of traffic from a swarm of vehicles on a companion
+  network, each with an autopilot, camera, gimbal and onboard
+  computer, plus a ground station on another link sending commands to
+  individual vehicles and components
+ */
+static const mavlink_channel_t gcs_chan = MAVLINK_COMM_0;
+static const mavlink_channel_t swarm_chan = MAVLINK_COMM_1;
+static const uint8_t gcs_sysid = 255;
+static const uint8_t first_vehicle_sysid = 10;
+static const uint8_t components[] {
+    MAV_COMP_ID_AUTOPILOT1,
+    MAV_COMP_ID_CAMERA,
+    MAV_COMP_ID_GIMBAL,
+    MAV_COMP_ID_ONBOARD_COMPUTER,
+};
+
+struct trace_packet {
+    mavlink_channel_t chan;
+    mavlink_message_t msg;
+};
+
+static void build_trace(uint8_t num_vehicles, trace_packet *trace, uint32_t &count)
+{
+    count = 0;
+    mavlink_heartbeat_t heartbeat {};
+    mavlink_attitude_t attitude {};
+    mavlink_global_position_int_t position {};
+    mavlink_command_long_t command {};
+    mavlink_param_request_read_t param_request {};
+    param_request.param_index = -1;
+
+    for (uint8_t v=0; v<num_vehicles; v++) {
+        const uint8_t sysid = first_vehicle_sysid + v;
+        for (uint8_t c=0; c<ARRAY_SIZE(components); c++) {
+            trace[count].chan = swarm_chan;
+            mavlink_msg_heartbeat_encode(sysid, components[c], &trace[count++].msg, &heartbeat);
+        }
+        for (uint8_t i=0; i<10; i++) {
+            trace[count].chan = swarm_chan;
+            mavlink_msg_attitude_encode(sysid, MAV_COMP_ID_AUTOPILOT1, &trace[count++].msg, &attitude);
+            trace[count].chan = swarm_chan;
+            mavlink_msg_global_position_int_encode(sysid, MAV_COMP_ID_AUTOPILOT1, &trace[count++].msg, &position);
+        }
+        // ground station commands to this vehicle and its camera
+        trace[count].chan = gcs_chan;
+        mavlink_msg_heartbeat_encode(gcs_sysid, MAV_COMP_ID_MISSIONPLANNER, &trace[count++].msg, &heartbeat);
+        command.target_system = sysid;
+        command.target_component = MAV_COMP_ID_AUTOPILOT1;
+        trace[count].chan = gcs_chan;
+        mavlink_msg_command_long_encode(gcs_sysid, MAV_COMP_ID_MISSIONPLANNER, &trace[count++].msg, &command);
+        param_request.target_system = sysid;
+        param_request.target_component = MAV_COMP_ID_CAMERA;
+        trace[count].chan = gcs_chan;
+        mavlink_msg_param_request_read_encode(gcs_sysid, MAV_COMP_ID_MISSIONPLANNER, &trace[count++].msg, &param_request);
+    }
+}
+
+static void BM_RoutingReplay(benchmark::State& state)
+{
+    const uint8_t num_vehicles = state.range(0);
+    trace_packet *trace = new trace_packet[num_vehicles * 27];
+    uint32_t count;
+    build_trace(num_vehicles, trace, count);
+
+    MAVLink_routing *routing = new MAVLink_routing();
+    while (state.KeepRunning()) {
+        for (uint32_t i=0; i<count; i++) {
+            bool process_locally = routing->check_and_forward(trace[i].chan, trace[i].msg);
+            gbenchmark_escape(&process_locally);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+
+    delete routing;
+    delete[] trace;
+}
+
+BENCHMARK(BM_RoutingReplay)->Arg(1)->Arg(8)->Arg(24);
+
+BENCHMARK_MAIN();